@@ -0,0 +1,128 @@
+#include "activity-stage.h"
+
+#include <android/log.h>
+
+#include <algorithm>
+#include <chrono>
+
+ActivityStage::ActivityStage()
+        : model_(nullptr), estimator_(nullptr), options_(nullptr), stride_(1), frame_counter_(0),
+          total_us_(0), processed_(0) {}
+
+ActivityStage::~ActivityStage() {
+    stop();
+}
+
+void ActivityStage::start(wrActivityModelHandle model, wrPoseEstimatorHandle estimator,
+                          wrPoseEstimatorOptionsHandle options, unsigned int stride) {
+    stop();
+
+    model_ = model;
+    estimator_ = estimator;
+    options_ = options;
+
+    const int num_classes = wrActivityModel_NumClasses(model_);
+    std::vector<const char*> names(num_classes);
+    wrActivityModel_ClassNames(model_, names.data());
+    class_names_.assign(names.begin(), names.end());
+
+    stride_ = std::max(stride, 1u);
+    frame_counter_ = 0;
+    results_.reset();
+    total_us_ = 0;
+    processed_ = 0;
+
+    worker_.start([this](Job& job) { process(job); });
+}
+
+void ActivityStage::stop() {
+    worker_.stop();
+    if (model_) {
+        wrActivityModel_Destroy(model_);
+        model_ = nullptr;
+    }
+    if (options_) {
+        wrPoseEstimatorOptions_Destroy(options_);
+        options_ = nullptr;
+    }
+    if (estimator_) {
+        wrPoseEstimator_Destroy(estimator_);
+        estimator_ = nullptr;
+    }
+}
+
+void ActivityStage::submit(int64_t timestamp_us, const unsigned char* bgr, int cols, int rows,
+                           const Pose2dRef* poses, size_t num_poses) {
+    if (frame_counter_++ % stride_ != 0) {
+        return;
+    }
+
+    worker_.submit([&](Job& job) {
+        job.timestamp_us = timestamp_us;
+        job.cols = cols;
+        job.rows = rows;
+        job.bgr.assign(bgr, bgr + (size_t) cols * rows * 3);
+        job.poses.assign(poses, poses + num_poses);
+    });
+}
+
+// False if own_id was not seen in the frame just processed.
+bool ActivityStage::matchId(const Job& job, int own_id, int* id) const {
+    auto it = wrPoseEstimator_GetHumans2DBegin(estimator_);
+    for (unsigned int i = 0; i < wrPoseEstimator_GetNumHumans2D(estimator_); i++) {
+        if (wrPose2d_GetId(it) == own_id) {
+            auto box = wrPose2d_GetBoundingBox(it);
+            const float own[4] = { wrBox2d_GetMinX(box), wrBox2d_GetMinY(box), wrBox2d_GetWidth(box), wrBox2d_GetHeight(box) };
+            *id = matchPose2dRef(own, job.poses);
+            return true;
+        }
+        it = wrPoseEstimator_GetPose2DNext(it);
+    }
+    return false;
+}
+
+void ActivityStage::process(Job& job) {
+    auto start = std::chrono::steady_clock::now();
+
+    auto rc = wrPoseEstimator_ProcessFrame(estimator_, job.bgr.data(), job.cols, job.rows, options_);
+    if (rc != wrReturnCode_OK) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Activity wrPoseEstimator_ProcessFrame: %s", wrReturnCode_Translate(rc));
+        return;
+    }
+    wrActivityModel_ProcessPoses(model_, estimator_, job.cols, job.rows);
+
+    ActivityResult& out = results_.back();
+    out.timestamp_us = job.timestamp_us;
+    out.num_classes = (int) class_names_.size();
+    out.ids.clear();
+    out.probabilities.clear();
+
+    // the model keeps individual models around for a while after a person is lost; only
+    // report people seen in this frame
+    person_ids_.resize(wrActivityModel_NumIndividualModels(model_));
+    wrActivityModel_PersonIds(model_, person_ids_.data());
+    for (int person_id : person_ids_) {
+        int id;
+        if (!matchId(job, person_id, &id)) continue;
+
+        auto individual = wrActivityModel_IndividualModel(model_, person_id);
+        if (!individual) continue;
+
+        const float* probabilities = wrIndividualActivityModel_Probabilities(individual);
+        out.ids.push_back(id);
+        out.probabilities.insert(out.probabilities.end(), probabilities, probabilities + out.num_classes);
+    }
+    results_.publish();
+
+    total_us_ += (long long) std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    processed_++;
+}
+
+ActivityTiming ActivityStage::timing() const {
+    ActivityTiming t;
+    const long processed = processed_;
+    t.mean_us = processed > 0 ? (double) total_us_ / processed : 0.0;
+    t.processed = processed;
+    t.dropped = worker_.dropped();
+    return t;
+}
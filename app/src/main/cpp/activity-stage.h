@@ -0,0 +1,88 @@
+#ifndef ACTIVITY_STAGE_H
+#define ACTIVITY_STAGE_H
+
+#include <wrnch/engine.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "latest-value.h"
+#include "pose2d-ref.h"
+#include "stage-worker.h"
+
+// Activity (exercise) classification decoupled from the 2D path.
+//
+// wrActivityModel_ProcessPoses reads the poses straight out of a pose estimator, so the
+// stage owns an estimator of its own that satisfies the model's requirements and runs both
+// on its own thread. Like the 3D stage it takes every stride-th frame and drops a pending
+// frame when it falls behind. Per-person class probabilities, labelled with the 2D tracker
+// ids, are published through a lock-free latest-value slot so readers never block it.
+
+struct ActivityResult {
+    int64_t timestamp_us;
+    int num_classes;
+    std::vector<int> ids;               // 2D tracker id per person, -1 if unmatched
+    std::vector<float> probabilities;   // num_classes per person
+
+    size_t numPeople() const { return ids.size(); }
+};
+
+struct ActivityTiming {
+    double mean_us;
+    long processed;
+    long dropped;
+};
+
+class ActivityStage {
+public:
+    ActivityStage();
+    ~ActivityStage();
+
+    // Takes ownership of model, estimator and options; options must be compatible with the
+    // model's requirements.
+    void start(wrActivityModelHandle model, wrPoseEstimatorHandle estimator,
+               wrPoseEstimatorOptionsHandle options, unsigned int stride);
+    void stop();
+    bool isRunning() const { return worker_.isRunning(); }
+
+    void submit(int64_t timestamp_us, const unsigned char* bgr, int cols, int rows,
+                const Pose2dRef* poses, size_t num_poses);
+
+    // Most recent results or nullptr before the first one; valid until the next call. Must
+    // only be called from one thread at a time.
+    const ActivityResult* latest() { return results_.latest(); }
+
+    // Class names in probability order, fixed while the stage runs.
+    const std::vector<std::string>& classNames() const { return class_names_; }
+
+    ActivityTiming timing() const;
+
+private:
+    struct Job {
+        int64_t timestamp_us;
+        int cols;
+        int rows;
+        std::vector<unsigned char> bgr;
+        std::vector<Pose2dRef> poses;
+    };
+
+    void process(Job& job);
+    bool matchId(const Job& job, int own_id, int* id) const;
+
+    StageWorker<Job> worker_;
+    wrActivityModelHandle model_;
+    wrPoseEstimatorHandle estimator_;
+    wrPoseEstimatorOptionsHandle options_;
+    unsigned int stride_;
+    unsigned int frame_counter_;
+    std::vector<std::string> class_names_;
+    std::vector<int> person_ids_;
+
+    LatestValue<ActivityResult> results_;
+    std::atomic<long long> total_us_;
+    std::atomic<long> processed_;
+};
+
+#endif // ACTIVITY_STAGE_H
@@ -0,0 +1,149 @@
+// Host benchmark for the streaming DTW matcher: a live stream following one of many synthetic
+// joint-angle templates with a varying tempo and noise. Checks the incremental costs against
+// a full banded DTW matrix, that the followed template comes out best with and without
+// pruning, and reports the cost per frame and the share of cells pruning skips. Exits
+// non-zero on a mismatch.
+
+#include "../dtw-matcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const size_t DIM = 10;
+static const float FPS = 30.0f;
+
+struct Sequence {
+    std::vector<float> features;    // frames x DIM
+    size_t frames() const { return features.size() / DIM; }
+};
+
+// Smooth angle curves from a few random sinusoids per dimension.
+static Sequence makeTemplate(std::mt19937& rng, size_t frames) {
+    std::uniform_real_distribution<float> freq(0.2f, 1.2f), phase(0.0f, 6.283f), amp(0.1f, 0.5f);
+    Sequence s;
+    s.features.resize(frames * DIM);
+    for (size_t d = 0; d < DIM; d++) {
+        const float f0 = freq(rng), f1 = freq(rng), p0 = phase(rng), p1 = phase(rng), a0 = amp(rng), a1 = amp(rng);
+        for (size_t i = 0; i < frames; i++) {
+            const float t = i / FPS;
+            s.features[i * DIM + d] = 1.57f + a0 * std::sin(6.283f * f0 * t + p0) + a1 * std::sin(6.283f * f1 * t + p1);
+        }
+    }
+    return s;
+}
+
+// The template replayed with a tempo drifting +-15% around real time, plus noise.
+static Sequence follow(std::mt19937& rng, const Sequence& ref, std::vector<int64_t>& timestamps) {
+    std::normal_distribution<float> noise(0.0f, 0.05f);
+    Sequence s;
+    float pos = 0.0f;
+    for (size_t i = 0; pos < ref.frames() - 1; i++) {
+        const size_t j = (size_t) pos;
+        const float w = pos - j;
+        for (size_t d = 0; d < DIM; d++) {
+            const float a = ref.features[j * DIM + d];
+            const float b = ref.features[std::min(j + 1, ref.frames() - 1) * DIM + d];
+            s.features.push_back(a + (b - a) * w + noise(rng));
+        }
+        timestamps.push_back((int64_t) (i * 1e6 / FPS));
+        pos += 1.0f + 0.15f * std::sin(i * 0.05f);
+    }
+    return s;
+}
+
+// Open-ended banded DTW cost per live frame after each live frame, from the full matrix.
+static std::vector<float> referenceCosts(const Sequence& live, const std::vector<int64_t>& timestamps,
+                                         const Sequence& ref, int band) {
+    const float inf = std::numeric_limits<float>::infinity();
+    const int m = (int) ref.frames();
+    std::vector<std::vector<float>> cost(live.frames(), std::vector<float>(m, inf));
+    std::vector<float> out;
+    for (size_t i = 0; i < live.frames(); i++) {
+        const int center = (int) std::lround((timestamps[i] - timestamps[0]) * 1e-6 * FPS);
+        const int lo = std::max(center - band, 0), hi = std::min(center + band, m - 1);
+        if (lo > m - 1) break;
+        float best = inf;
+        for (int j = lo; j <= hi; j++) {
+            float c = 0.0f;
+            for (size_t d = 0; d < DIM; d++) {
+                const float diff = live.features[i * DIM + d] - ref.features[j * DIM + d];
+                c += diff * diff;
+            }
+            float from = i == 0 ? (j == 0 ? 0.0f : inf) : std::min(cost[i - 1][j], j > 0 ? cost[i - 1][j - 1] : inf);
+            if (j > 0) from = std::min(from, cost[i][j - 1]);
+            cost[i][j] = c + from;
+            best = std::min(best, cost[i][j]);
+        }
+        out.push_back(best / (i + 1));
+    }
+    return out;
+}
+
+int main() {
+    const size_t num_templates = 48;
+    const size_t target = 17;
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<size_t> length(150, 300);
+
+    std::vector<Sequence> templates;
+    for (size_t k = 0; k < num_templates; k++) templates.push_back(makeTemplate(rng, length(rng)));
+    std::vector<int64_t> timestamps;
+    const Sequence live = follow(rng, templates[target], timestamps);
+
+    bool ok = true;
+    for (float ratio : { 0.0f, 2.0f }) {
+        DtwMatcherConfig config;
+        config.band = 15;
+        config.prune_ratio = ratio;
+        DtwMatcher matcher(DIM);
+        matcher.setConfig(config);
+        for (const Sequence& t : templates) matcher.addTemplate(t.features.data(), t.frames(), FPS);
+
+        std::vector<std::vector<float>> reference;
+        if (ratio == 0.0f) {
+            for (const Sequence& t : templates) reference.push_back(referenceCosts(live, timestamps, t, (int) config.band));
+        }
+
+        const int reps = 20;
+        double elapsed_ns = 0.0;
+        size_t cells = 0;
+        float max_err = 0.0f;
+        for (int r = 0; r < reps; r++) {
+            matcher.start();
+            for (size_t i = 0; i < live.frames(); i++) {
+                const auto start = Clock::now();
+                matcher.update(timestamps[i], &live.features[i * DIM]);
+                elapsed_ns += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+                cells += matcher.lastCells();
+
+                if (r > 0 || reference.empty()) continue;
+                for (size_t k = 0; k < num_templates; k++) {
+                    if (matcher.score(k).state != DtwScore::ACTIVE) continue;
+                    const float expected = reference[k][i];
+                    max_err = std::max(max_err, std::fabs(matcher.score(k).cost - expected) / std::max(expected, 1e-3f));
+                }
+            }
+        }
+
+        size_t pruned = 0;
+        for (size_t k = 0; k < num_templates; k++) pruned += matcher.score(k).state == DtwScore::PRUNED;
+        const size_t full_cells = reps * live.frames() * num_templates * (2 * config.band + 1);
+        printf("%s: %zu templates, %zu live frames, %.2f us/frame, %.1f%% of band cells computed, "
+               "%zu pruned, best %d (cost %.4f, expected %zu)",
+               ratio == 0.0f ? "no pruning" : "LB_Keogh pruning", num_templates, live.frames(),
+               elapsed_ns / (reps * live.frames()) * 1e-3, 100.0 * cells / full_cells, pruned,
+               matcher.best(), matcher.best() >= 0 ? matcher.score(matcher.best()).cost : 0.0f, target);
+        if (!reference.empty()) printf(", max relative error vs full matrix %.1e", max_err);
+        printf("\n");
+
+        if (matcher.best() != (int) target || max_err > 1e-4f) ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+// Evaluation of joint gap filling: holes of 1 to 8 frames are punched into joints of a pose
+// stream, the stream is fed through a PoseHistory and every frame is filled delay frames
+// behind, as the live path does. Reports how many of the punched joints came back and how
+// far they are from the real ones, for linear and Hermite interpolation, and the cost per
+// frame. Exits non-zero if Hermite is worse than linear on the synthetic stream.
+//
+//   gap-filler-bench [-d delay_frames] [-b look_back_frames] [-w width] [-h height] [track.wptk ...]
+//
+// Recorded tracks are evaluated the same way, the holes going only into joints the
+// estimator did see. Errors are in pixels of a width x height display.
+
+#include "../gap-filler.h"
+#include "pose-streams.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static Stream syntheticStream(size_t frames) {
+    const unsigned int num_joints = 23;
+    Stream s;
+    s.num_joints = num_joints;
+
+    std::mt19937 rng(11);
+    std::normal_distribution<float> noise(0.0f, 0.001f);
+    std::uniform_int_distribution<int> jitter(-2000, 2000);
+
+    for (size_t f = 0; f < frames; f++) {
+        const int64_t ts = (int64_t) f * 33333 + jitter(rng);
+        const float t = ts * 1e-6f;
+        // arms and legs swinging at about one rep per second on top of a slow drift
+        const float swing = std::sin(t * 6.0f);
+        for (unsigned int j = 0; j < num_joints; j++) {
+            const float limb = (j % 4) * 0.05f;
+            const float x = 0.5f + 0.1f * std::sin(t * 0.3f) + (j % 2 ? 1 : -1) * limb * swing + noise(rng);
+            const float y = 0.3f + 0.02f * j + 0.5f * limb * std::cos(t * 6.0f) + noise(rng);
+            s.joints.push_back(x);
+            s.joints.push_back(y);
+            s.scores.push_back(0.9f);
+        }
+        s.timestamps.push_back(ts);
+        s.masks.push_back((1u << num_joints) - 1);
+    }
+    return s;
+}
+
+// Masks of s with holes of 1 to 8 frames, starting on average every 50 frames per joint.
+static std::vector<uint32_t> punchHoles(const Stream& s) {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> start(0, 49);
+    std::uniform_int_distribution<int> length(1, 8);
+    std::vector<uint32_t> masks = s.masks;
+    for (unsigned int j = 0; j < s.num_joints; j++) {
+        for (size_t f = 0; f < s.size(); f++) {
+            if (start(rng) != 0) continue;
+            const size_t end = std::min(f + length(rng), s.size());
+            for (; f < end; f++) masks[f] &= ~(1u << j);
+        }
+    }
+    return masks;
+}
+
+struct Result {
+    size_t punched = 0;
+    size_t filled = 0;
+    double error_px = 0;
+    double ns_per_frame = 0;
+};
+
+static Result run(const Stream& s, const std::vector<uint32_t>& masks, const GapFillConfig& config,
+                  float width, float height) {
+    const unsigned int n = s.num_joints;
+    PoseHistory history(n, 1);
+    std::vector<float> joints(n * 2);
+    Result result;
+    double total_ns = 0;
+    const float bbox[4] = { 0, 0, 1, 1 };
+
+    for (size_t f = 0; f < s.size(); f++) {
+        history.append(0, s.timestamps[f], &s.joints[f * n * 2], &s.scores[f * n], bbox, masks[f]);
+
+        PoseFrameView frame;
+        uint32_t valid, filled;
+        const auto start = Clock::now();
+        const bool ok = fillDelayedFrame(history, 0, config, &frame, joints.data(), &valid, &filled);
+        total_ns += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        if (!ok) continue;
+
+        const size_t g = f - config.delay_frames;
+        const uint32_t punched = s.masks[g] & ~masks[g];
+        const float* truth = &s.joints[g * n * 2];
+        for (unsigned int j = 0; j < n; j++) {
+            if (!(punched & (1u << j))) continue;
+            result.punched++;
+            if (!(filled & (1u << j))) continue;
+            result.filled++;
+            result.error_px += std::hypot((joints[j * 2] - truth[j * 2]) * width, (joints[j * 2 + 1] - truth[j * 2 + 1]) * height);
+        }
+    }
+    if (result.filled > 0) result.error_px /= result.filled;
+    result.ns_per_frame = total_ns / s.size();
+    return result;
+}
+
+// Whether Hermite filled anything at least as well as linear.
+static bool evaluate(const char* name, const Stream& s, GapFillConfig config, float width, float height) {
+    const std::vector<uint32_t> masks = punchHoles(s);
+    config.interpolation = GAP_LINEAR;
+    const Result linear = run(s, masks, config, width, height);
+    config.interpolation = GAP_HERMITE;
+    const Result hermite = run(s, masks, config, width, height);
+
+    printf("%-24s %7zu frames, delay %zu: %zu joints punched, %.1f%% filled | "
+           "linear %6.2f px %4.0f ns/frame | Hermite %6.2f px %4.0f ns/frame\n",
+           name, s.size(), config.delay_frames, linear.punched,
+           linear.punched ? 100.0 * linear.filled / linear.punched : 0.0,
+           linear.error_px, linear.ns_per_frame, hermite.error_px, hermite.ns_per_frame);
+    return linear.filled > 0 && hermite.error_px <= linear.error_px;
+}
+
+int main(int argc, char** argv) {
+    GapFillConfig config;
+    float width = 1920, height = 1080;
+    int first = 1;
+    for (; first + 1 < argc && argv[first][0] == '-'; first += 2) {
+        if (!strcmp(argv[first], "-d")) config.delay_frames = atoi(argv[first + 1]);
+        else if (!strcmp(argv[first], "-b")) config.look_back_frames = atoi(argv[first + 1]);
+        else if (!strcmp(argv[first], "-w")) width = atoi(argv[first + 1]);
+        else if (!strcmp(argv[first], "-h")) height = atoi(argv[first + 1]);
+    }
+
+    if (first >= argc) {
+        const Stream s = syntheticStream(30 * 600);
+        bool ok = true;
+        for (size_t delay : { 1, 2, 4, 8 }) {
+            GapFillConfig c = config;
+            c.delay_frames = delay;
+            ok = evaluate("synthetic", s, c, width, height) && ok;
+        }
+        return ok ? 0 : 1;
+    }
+
+    for (int i = first; i < argc; i++) {
+        for (const auto& it : recordedStreams(argv[i])) {
+            char name[256];
+            snprintf(name, sizeof(name), "%s#%d", argv[i], it.first);
+            if (it.second.size() > config.delay_frames) evaluate(name, it.second, config, width, height);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+// Replay evaluation of Kalman latency compensation: how far the drawn skeleton is from
+// the true pose when it is shown `latency` after the frame it was estimated from, without
+// prediction (last pose as is) and with constant velocity / acceleration prediction.
+//
+//   kalman-eval [-l latency_ms] [-w width] [-h height] [track.wptk ...]
+//
+// The reference is the estimated pose of the frame nearest to display time, so estimator
+// noise is included in all numbers. Errors are in pixels of a width x height display.
+// Without tracks a synthetic exercise-like motion at 30 fps is evaluated.
+
+#include "../kalman-predictor.h"
+#include "pose-streams.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Errors {
+    std::vector<float> px;
+
+    void add(float e) { px.push_back(e); }
+    double mean() const {
+        double sum = 0;
+        for (float e : px) sum += e;
+        return px.empty() ? 0.0 : sum / px.size();
+    }
+    float percentile(double p) {
+        if (px.empty()) return 0.0f;
+        const size_t k = std::min((size_t) (p * px.size()), px.size() - 1);
+        std::nth_element(px.begin(), px.begin() + k, px.end());
+        return px[k];
+    }
+};
+
+static Stream syntheticStream(size_t frames) {
+    const unsigned int num_joints = 23;
+    Stream s;
+    s.num_joints = num_joints;
+
+    std::mt19937 rng(11);
+    std::normal_distribution<float> noise(0.0f, 0.003f);
+    std::uniform_int_distribution<int> jitter(-2000, 2000);
+
+    for (size_t f = 0; f < frames; f++) {
+        const int64_t ts = (int64_t) f * 33333 + jitter(rng);
+        const float t = ts * 1e-6f;
+        // arms and legs swinging at about one rep per second on top of a slow drift
+        const float swing = std::sin(t * 6.0f);
+        for (unsigned int j = 0; j < num_joints; j++) {
+            const float limb = (j % 4) * 0.05f;
+            const float x = 0.5f + 0.1f * std::sin(t * 0.3f) + (j % 2 ? 1 : -1) * limb * swing + noise(rng);
+            const float y = 0.3f + 0.02f * j + 0.5f * limb * std::fabs(swing) + noise(rng);
+            s.joints.push_back(x);
+            s.joints.push_back(y);
+            s.scores.push_back(0.9f);
+        }
+        s.timestamps.push_back(ts);
+        s.masks.push_back((1u << num_joints) - 1);
+    }
+    return s;
+}
+
+static void run(const char* name, const Stream& s, int64_t latency_us, float width, float height) {
+    const unsigned int n = s.num_joints;
+    KalmanPosePredictor cv(n, 1, KalmanModel::CONSTANT_VELOCITY);
+    KalmanPosePredictor ca(n, 1, KalmanModel::CONSTANT_ACCELERATION);
+    Errors none, cv_err, ca_err;
+    std::vector<float> cv_pred(n * 2), ca_pred(n * 2);
+    double update_ns = 0;
+
+    size_t g = 0;
+    for (size_t f = 0; f < s.size(); f++) {
+        const float* joints = &s.joints[f * n * 2];
+        auto start = Clock::now();
+        cv.update(0, s.timestamps[f], joints, s.masks[f]);
+        ca.update(0, s.timestamps[f], joints, s.masks[f]);
+        update_ns += std::chrono::duration<double, std::nano>(Clock::now() - start).count() / 2;
+
+        // frame nearest to the display time
+        const int64_t display_us = s.timestamps[f] + latency_us;
+        g = std::max(g, f);
+        while (g + 1 < s.size() && std::llabs(s.timestamps[g + 1] - display_us) <= std::llabs(s.timestamps[g] - display_us)) g++;
+        if (g == f || std::llabs(s.timestamps[g] - display_us) > latency_us / 2) continue;
+        const float* truth = &s.joints[g * n * 2];
+
+        uint32_t cv_mask, ca_mask;
+        cv.predict(0, display_us, cv_pred.data(), &cv_mask);
+        ca.predict(0, display_us, ca_pred.data(), &ca_mask);
+
+        const uint32_t mask = s.masks[f] & s.masks[g] & cv_mask & ca_mask;
+        for (unsigned int j = 0; j < n; j++) {
+            if (!(mask & (1u << j))) continue;
+            auto px = [&](const float* p) {
+                return std::hypot((p[j * 2] - truth[j * 2]) * width, (p[j * 2 + 1] - truth[j * 2 + 1]) * height);
+            };
+            none.add(px(joints));
+            cv_err.add(px(cv_pred.data()));
+            ca_err.add(px(ca_pred.data()));
+        }
+    }
+
+    printf("%-24s %7zu frames, %3lld ms latency: no prediction mean %6.2f px p95 %6.2f | "
+           "CV mean %6.2f px p95 %6.2f | CA mean %6.2f px p95 %6.2f | update %.0f ns/frame\n",
+           name, s.size(), (long long) (latency_us / 1000),
+           none.mean(), none.percentile(0.95), cv_err.mean(), cv_err.percentile(0.95),
+           ca_err.mean(), ca_err.percentile(0.95), update_ns / s.size());
+}
+
+int main(int argc, char** argv) {
+    int64_t latency_us = 0;
+    float width = 1920, height = 1080;
+    int first = 1;
+    for (; first + 1 < argc && argv[first][0] == '-'; first += 2) {
+        if (!strcmp(argv[first], "-l")) latency_us = atoi(argv[first + 1]) * 1000;
+        else if (!strcmp(argv[first], "-w")) width = atoi(argv[first + 1]);
+        else if (!strcmp(argv[first], "-h")) height = atoi(argv[first + 1]);
+    }
+
+    if (first >= argc) {
+        // without a latency given, sweep a few frame intervals
+        const Stream s = syntheticStream(30 * 600);
+        if (latency_us > 0) {
+            run("synthetic", s, latency_us, width, height);
+        } else {
+            for (int64_t l : { 33333, 66667, 100000, 150000 }) {
+                run("synthetic", s, l, width, height);
+            }
+        }
+        return 0;
+    }
+
+    if (latency_us <= 0) latency_us = 100000;
+    for (int i = first; i < argc; i++) {
+        for (const auto& it : recordedStreams(argv[i])) {
+            char name[256];
+            snprintf(name, sizeof(name), "%s#%d", argv[i], it.first);
+            if (it.second.size() > 0) run(name, it.second, latency_us, width, height);
+        }
+    }
+    return 0;
+}
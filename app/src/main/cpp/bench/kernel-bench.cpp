@@ -0,0 +1,519 @@
+// Microbenchmarks of the native frame and pose kernels, to track regressions between
+// releases.
+//
+// Pixel kernels (RGBA and YUV to BGR, bilinear resize to the estimator's 244x128, quarter
+// turn rotation, mask overlay, annotation blend) run at every frame size from 244x128 to
+// 1920x1080 and report ns per pixel and GB/s, counting the bytes the kernel has to read and
+// write once each. Resize counts output pixels, as only their sources are read. Pose kernels
+// (SoA packing, pose codec, One-Euro and Kalman filters, bones and joint angles, and
+// native-lib's own extraction and result packing over the stub estimator) report ns per
+// pose. Every figure is the median of BATCHES timed batches of at least -min-ms each, after
+// a warm-up. The vectorized kernels are checked against their scalar references first;
+// exits non-zero on a mismatch.
+//
+// -cpu n pins the run to CPU n. -performance also sets that CPU's cpufreq governor to
+// "performance" for the run and restores it afterwards, where that is allowed (root). The
+// governor and current frequency are recorded either way. -json writes the results to a
+// file as well; -filter runs only the kernels whose name contains the string.
+//
+//   kernel-bench [-json path] [-cpu n] [-performance] [-min-ms ms] [-filter name]
+
+#include "../frame-kernels.h"
+#include "../kalman-predictor.h"
+#include "../mask-kernels.h"
+#include "../one-euro-filter.h"
+#include "../pose-codec.h"
+#include "../skeleton-kernels.h"
+#include "../video-annotator.h"
+
+#include "wrnch-natives.h"
+#include "wrnch-stub.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static const int BATCHES = 7;
+static double min_batch_ms = 20.0;
+static const char* kernel_filter = nullptr;
+
+struct Result {
+    std::string kernel;
+    std::string size;
+    const char* unit;
+    double units;           // per call
+    double ns_per_call;
+    double bytes;           // per call, 0 if not meaningful
+};
+static std::vector<Result> results;
+
+static bool selected(const char* kernel) {
+    return !kernel_filter || strstr(kernel, kernel_filter);
+}
+
+// Median ns per call over BATCHES batches, each sized to take at least min_batch_ms.
+template <typename F>
+static double timeCall(F&& fn) {
+    fn();
+    long calls = 1;
+    for (;;) {
+        const auto start = Clock::now();
+        for (long i = 0; i < calls; i++) fn();
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (ms >= min_batch_ms / 4) {
+            calls = std::max(1L, (long) std::ceil(calls * min_batch_ms / std::max(ms, 1e-3)));
+            break;
+        }
+        calls *= 4;
+    }
+    double ns[BATCHES];
+    for (int b = 0; b < BATCHES; b++) {
+        const auto start = Clock::now();
+        for (long i = 0; i < calls; i++) fn();
+        ns[b] = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / calls;
+    }
+    std::sort(ns, ns + BATCHES);
+    return ns[BATCHES / 2];
+}
+
+static void report(const char* kernel, const std::string& size, const char* unit, double units, double ns_per_call,
+                   double bytes) {
+    results.push_back(Result{ kernel, size, unit, units, ns_per_call, bytes });
+    printf("%-22s %-10s %12.2f us/call %10.3f ns/%-6s", kernel, size.c_str(), ns_per_call / 1000.0, ns_per_call / units, unit);
+    if (bytes > 0) printf(" %8.2f GB/s", bytes / ns_per_call);
+    printf("\n");
+}
+
+// pixels is what the kernel's cost scales with, the frame's for most, the output's for resize
+template <typename F>
+static void benchPixels(const char* kernel, int width, int height, double pixels, double bytes, F&& fn) {
+    if (!selected(kernel)) return;
+    const std::string size = std::to_string(width) + "x" + std::to_string(height);
+    report(kernel, size, "pixel", pixels, timeCall(fn), bytes);
+}
+
+template <typename F>
+static void benchPoses(const char* kernel, size_t poses, F&& fn) {
+    if (!selected(kernel)) return;
+    report(kernel, std::to_string(poses) + (poses == 1 ? " pose" : " poses"), "pose", (double) poses, timeCall(fn), 0);
+}
+
+// Checks
+
+static bool checkFrameKernels(std::mt19937& rng) {
+    const int w = 333, h = 197;     // odd sizes reach the tails and tile edges
+    std::vector<uint8_t> rgba(w * h * 4), bgr(w * h * 3), ref(w * h * 3), turned(w * h * 3), back(w * h * 3);
+    for (uint8_t& v : rgba) v = (uint8_t) rng();
+
+    rgbaToBgr(rgba.data(), w * h, bgr.data());
+    rgbaToBgrScalar(rgba.data(), w * h, ref.data());
+    const bool convert_ok = bgr == ref;
+
+    bool rotate_ok = true;
+    for (int turns = 0; turns < 4; turns++) {
+        const int tw = turns % 2 ? h : w, th = turns % 2 ? w : h;
+        rotateBgr(bgr.data(), w, h, w * 3, turns, turned.data(), tw * 3);
+        rotateBgr(turned.data(), tw, th, tw * 3, 4 - turns, back.data(), w * 3);
+        rotate_ok = rotate_ok && back == bgr;
+    }
+    // one corner pixel by hand: clockwise, the bottom left comes to the top left
+    rotateBgr(bgr.data(), w, h, w * 3, 1, turned.data(), h * 3);
+    rotate_ok = rotate_ok && memcmp(&turned[0], &bgr[(size_t) (h - 1) * w * 3], 3) == 0;
+
+    BgrResizer same;
+    same.configure(w, h, w, h);
+    same.resize(bgr.data(), w * 3, back.data(), w * 3);
+    const bool resize_ok = back == bgr;
+
+    // black, mid grey and white in limited range, then pure red
+    const uint8_t ys[4] = { 16, 128, 235, 81 }, us[4] = { 128, 128, 128, 90 }, vs[4] = { 128, 128, 128, 240 };
+    bool yuv_ok = true;
+    for (int i = 0; i < 4; i++) {
+        uint8_t y[4] = { ys[i], ys[i], ys[i], ys[i] }, out[12];
+        const Yuv420Image img = { y, &us[i], &vs[i], 2, 1, 1, 2, 2 };
+        yuv420ToBgr(img, out, 6);
+        const int expected_grey[3] = { 0, 130, 255 };
+        if (i < 3) {
+            for (int c = 0; c < 12; c++) yuv_ok = yuv_ok && std::abs(out[c] - expected_grey[i]) <= 1;
+        } else {
+            // BT.601 red: 255, 0, 0 give or take rounding
+            yuv_ok = yuv_ok && out[2] >= 250 && out[1] <= 5 && out[0] <= 5;
+        }
+    }
+
+    std::vector<uint8_t> alpha(4099), dst(4099), dst_ref(4099);
+    uint8_t pattern[16];
+    for (uint8_t& v : alpha) v = (uint8_t) rng();
+    for (uint8_t& v : dst) v = (uint8_t) rng();
+    for (uint8_t& v : pattern) v = (uint8_t) rng();
+    dst_ref = dst;
+    videoBlend(alpha.data(), pattern, dst.size(), dst.data());
+    videoBlendScalar(alpha.data(), pattern, dst_ref.size(), dst_ref.data());
+    const bool blend_ok = dst == dst_ref;
+
+    // twice over the same buffer with new contents, and a single column and row
+    bool upsample_ok = true;
+    const int mask_sizes[][2] = { { 61, 32 }, { 61, 32 }, { 1, 1 }, { 7, 1 } };
+    MaskUpsampler upsampler;
+    std::vector<uint8_t> mask(61 * 32), up(w * h), up_ref(w * h);
+    for (const auto& m : mask_sizes) {
+        for (uint8_t& v : mask) v = (uint8_t) rng();
+        upsampler.configure(m[0], m[1], w, h);
+        for (int y = 0; y < h; y++) upsampler.upsampleRow(mask.data(), y, &up[(size_t) y * w]);
+        maskUpsampleScalar(mask.data(), m[0], m[1], w, h, up_ref.data());
+        upsample_ok = upsample_ok && up == up_ref;
+    }
+
+    printf("checks: rgba to bgr %s, rotation %s, resize %s, yuv to bgr %s, blend %s, mask upsample %s\n",
+           convert_ok ? "ok" : "MISMATCH", rotate_ok ? "ok" : "MISMATCH", resize_ok ? "ok" : "MISMATCH",
+           yuv_ok ? "ok" : "MISMATCH", blend_ok ? "ok" : "MISMATCH", upsample_ok ? "ok" : "MISMATCH");
+    return convert_ok && rotate_ok && resize_ok && yuv_ok && blend_ok && upsample_ok;
+}
+
+static bool checkOneEuro(std::mt19937& rng) {
+    const size_t n = 46;
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+    std::vector<float> x(n), a_hat(n), a_dx(n, 0.0f), b_dx(n, 0.0f), min_cutoff(n, 1.0f), beta(n, 0.01f), a(n), b(n);
+    for (size_t i = 0; i < n; i++) a_hat[i] = uni(rng);
+    std::vector<float> b_hat = a_hat;
+    float worst = 0.0f;
+    for (int step = 0; step < 100; step++) {
+        for (float& v : x) v = uni(rng);
+        const float alpha_d = oneEuroAlpha(1.0f, 1.0f / 30);
+        oneEuroStep(x.data(), a_hat.data(), a_dx.data(), min_cutoff.data(), beta.data(), n, 1.0f / 30, alpha_d, a.data());
+        oneEuroStepScalar(x.data(), b_hat.data(), b_dx.data(), min_cutoff.data(), beta.data(), n, 1.0f / 30, alpha_d, b.data());
+        for (size_t i = 0; i < n; i++) worst = std::max(worst, std::fabs(a[i] - b[i]));
+    }
+    printf("checks: one euro step off the scalar reference by %g\n", worst);
+    return worst < 1e-5f;
+}
+
+// Pixel kernels
+
+static void benchFrames(std::mt19937& rng) {
+    static const int SIZES[][2] = { { 244, 128 }, { 640, 360 }, { 1280, 720 }, { 1920, 1080 } };
+    const int net_w = 244, net_h = 128;
+    const int mask_w = 61, mask_h = 32;
+
+    for (const auto& s : SIZES) {
+        const int w = s[0], h = s[1];
+        const size_t pixels = (size_t) w * h;
+        std::vector<uint8_t> rgba(pixels * 4), bgr(pixels * 3), out(pixels * 4), yuv(pixels * 3 / 2 + w);
+        for (uint8_t& v : rgba) v = (uint8_t) rng();
+        for (uint8_t& v : yuv) v = (uint8_t) rng();
+        rgbaToBgr(rgba.data(), pixels, bgr.data());
+
+        benchPixels("rgba-to-bgr", w, h, pixels, pixels * 7.0, [&]() { rgbaToBgr(rgba.data(), pixels, out.data()); });
+        benchPixels("rgba-to-bgr-scalar", w, h, pixels, pixels * 7.0, [&]() { rgbaToBgrScalar(rgba.data(), pixels, out.data()); });
+
+        const Yuv420Image img = { yuv.data(), yuv.data() + pixels, yuv.data() + pixels + pixels / 4,
+                                  (size_t) w, (size_t) w / 2, 1, w, h };
+        benchPixels("yuv420-to-bgr", w, h, pixels, pixels * 4.5, [&]() { yuv420ToBgr(img, out.data(), w * 3); });
+
+        BgrResizer resizer;
+        resizer.configure(w, h, net_w, net_h);
+        // four source pixels read and one written per output pixel
+        benchPixels("resize-bgr-244x128", w, h, net_w * net_h, net_w * net_h * 15.0, [&]() {
+            resizer.resize(bgr.data(), w * 3, out.data(), net_w * 3);
+        });
+
+        benchPixels("rotate-bgr-90", w, h, pixels, pixels * 6.0, [&]() { rotateBgr(bgr.data(), w, h, w * 3, 1, out.data(), h * 3); });
+        benchPixels("rotate-bgr-180", w, h, pixels, pixels * 6.0, [&]() { rotateBgr(bgr.data(), w, h, w * 3, 2, out.data(), w * 3); });
+
+        std::vector<uint8_t> mask(mask_w * mask_h);
+        for (uint8_t& v : mask) v = (uint8_t) rng();
+        MaskUpsampler upsampler;
+        benchPixels("mask-overlay", w, h, pixels, pixels * 4.0, [&]() {
+            renderMaskOverlay(upsampler, mask.data(), mask_w, mask_h, out.data(), w, h, w * 4, 128, 0x80ff8000u);
+        });
+        benchPixels("mask-upsample-scalar", w, h, pixels, pixels * 1.0, [&]() {
+            maskUpsampleScalar(mask.data(), mask_w, mask_h, w, h, out.data());
+        });
+
+        // a whole BGR frame as one span: alpha and dst read, dst written
+        std::vector<uint8_t> alpha(pixels * 3);
+        for (uint8_t& v : alpha) v = (uint8_t) rng();
+        uint8_t pattern[16];
+        for (uint8_t& v : pattern) v = (uint8_t) rng();
+        benchPixels("video-blend", w, h, pixels, pixels * 9.0, [&]() { videoBlend(alpha.data(), pattern, pixels * 3, out.data()); });
+    }
+}
+
+// Pose kernels
+
+static void benchPoseKernels(std::mt19937& rng) {
+    const unsigned int num_joints = 23;
+    const size_t count = 64;
+    std::uniform_real_distribution<float> uni(0.2f, 0.8f);
+    std::vector<float> joints(count * num_joints * 2), scores(count * num_joints, 0.9f);
+    for (float& v : joints) v = uni(rng);
+    std::vector<uint32_t> masks(count, (1u << num_joints) - 1);
+
+    const size_t stride = count;
+    std::vector<float> x(num_joints * stride), y(num_joints * stride);
+    benchPoses("transpose-poses", count, [&]() {
+        transposePoses(joints.data(), count, num_joints, x.data(), y.data(), stride);
+    });
+
+    PoseEncoder encoder(num_joints);
+    std::vector<uint8_t> encoded;
+    int64_t t = 0;
+    size_t frame = 0;
+    benchPoses("pose-encode", 1, [&]() {
+        if (encoded.size() > (1 << 20)) encoded.clear();
+        encoder.encode(t += 33333, &joints[(frame++ % count) * num_joints * 2], scores.data(), masks[0], encoded);
+    });
+
+    const size_t channels = num_joints * 2;
+    std::vector<float> x_hat(joints.begin(), joints.begin() + channels), dx_hat(channels, 0.0f);
+    std::vector<float> min_cutoff(channels, 1.0f), beta(channels, 0.01f), filtered(channels);
+    const float alpha_d = oneEuroAlpha(1.0f, 1.0f / 30);
+    benchPoses("one-euro-step", 1, [&]() {
+        oneEuroStep(&joints[(frame++ % count) * channels], x_hat.data(), dx_hat.data(), min_cutoff.data(), beta.data(),
+                    channels, 1.0f / 30, alpha_d, filtered.data());
+    });
+    benchPoses("one-euro-step-scalar", 1, [&]() {
+        oneEuroStepScalar(&joints[(frame++ % count) * channels], x_hat.data(), dx_hat.data(), min_cutoff.data(),
+                          beta.data(), channels, 1.0f / 30, alpha_d, filtered.data());
+    });
+
+    OneEuroFilterBank bank(num_joints, 32);
+    bank.setParams(1.0f, 0.01f, 1.0f);
+    benchPoses("one-euro-bank", 1, [&]() {
+        bank.filter(1, t += 33333, &joints[(frame++ % count) * channels], masks[0], filtered.data());
+    });
+
+    KalmanPosePredictor kalman(num_joints, 32);
+    benchPoses("kalman-update", 1, [&]() {
+        kalman.update(1, t += 33333, &joints[(frame++ % count) * channels], masks[0]);
+    });
+
+    transposePoses(joints.data(), count, num_joints, x.data(), y.data(), stride);
+    const PoseBatch batch = { x.data(), y.data(), masks.data(), count, stride };
+    const size_t num_bones = TopologyTraits<J23Topology>::NUM_BONES;
+    std::vector<float> dx(num_bones * stride), dy(num_bones * stride), len(num_bones * stride);
+    const BoneFeatures bones = { dx.data(), dy.data(), len.data(), stride };
+    benchPoses("bones-j23", count, [&]() { computeBones<J23Topology>(batch, bones, 16.0f / 9.0f); });
+    benchPoses("bones-runtime", count, [&]() {
+        computeBones(TopologyTraits<J23Topology>::pairs(), num_bones, batch, bones, 16.0f / 9.0f);
+    });
+
+    // elbows, shoulders, hips, knees, ankles
+    const JointAngleDef angles[] = {
+        { 10, 11, 12 }, { 13, 14, 15 }, { 11, 12, 2 }, { 14, 13, 3 }, { 12, 2, 1 }, { 13, 3, 4 },
+        { 2, 1, 0 }, { 3, 4, 5 }, { 1, 0, 21 }, { 4, 5, 22 },
+    };
+    const size_t num_angles = sizeof(angles) / sizeof(angles[0]);
+    std::vector<float> angle_out(num_angles * stride);
+    benchPoses("joint-angles", count, [&]() {
+        computeJointAngles(angles, num_angles, batch, angle_out.data(), stride, 16.0f / 9.0f);
+    });
+}
+
+// native-lib's per-frame work after the estimator, reading the people out and packing the
+// JNI result, from its own stage histograms with the stub estimator taking no time.
+static void benchResultPacking() {
+    if (!selected("result-extraction") && !selected("result-marshal")) return;
+
+    WrnchStubConfig stub = wrnchStubDefaults();
+    stub.latency_us = 0;
+    stub.jitter_us = 0;
+    JNIEnv env;
+    env.PushLocalFrame(4);
+    const jsize bones = env.GetArrayLength(
+            Java_com_samsungnext_audiovideoplayersample_Wrnch_initWrnchJNI(&env, nullptr, env.NewStringUTF("/tmp")));
+    env.PopLocalFrame(nullptr);
+    if (bones == 0) return;
+
+    const int width = 244, height = 128;
+    jbyteArray img = env.NewByteArray(width * height * 3);
+    for (int people : { 1, 4 }) {
+        stub.num_people = people;
+        setWrnchStubConfig(stub);
+        Java_com_samsungnext_audiovideoplayersample_Wrnch_resetStatsJNI(&env, nullptr);
+        int64_t t = 0;
+        const double call_ns = timeCall([&]() {
+            env.PushLocalFrame(2);
+            Java_com_samsungnext_audiovideoplayersample_Wrnch_processWrnchJNI(&env, nullptr, img, width, height, t += 33333);
+            env.PopLocalFrame(nullptr);
+        });
+
+        float stats[WRNCH_STATS_LENGTH];
+        env.PushLocalFrame(2);
+        env.GetFloatArrayRegion(Java_com_samsungnext_audiovideoplayersample_Wrnch_getStatsJNI(&env, nullptr), 0,
+                                WRNCH_STATS_LENGTH, stats);
+        env.PopLocalFrame(nullptr);
+        const std::string size = std::to_string(people) + (people == 1 ? " pose" : " poses");
+        const double extraction_ns = stats[WRNCH_STAGE_EXTRACTION * WRNCH_STATS_PER_STAGE + 1] * 1000.0;
+        const double marshal_ns = stats[WRNCH_STAGE_MARSHAL * WRNCH_STATS_PER_STAGE + 1] * 1000.0;
+        if (selected("result-extraction")) report("result-extraction", size, "pose", people, extraction_ns, 0);
+        if (selected("result-marshal")) report("result-marshal", size, "pose", people, marshal_ns, 0);
+        if (selected("process-frame-stub")) report("process-frame-stub", size, "pose", people, call_ns, 0);
+    }
+}
+
+// Machine
+
+static std::string readFirstLine(const std::string& path) {
+    std::string line;
+    if (FILE* f = fopen(path.c_str(), "r")) {
+        char buf[256];
+        if (fgets(buf, sizeof(buf), f)) line = buf;
+        fclose(f);
+    }
+    while (!line.empty() && (line.back() == '\n' || line.back() == ' ')) line.pop_back();
+    return line;
+}
+
+static bool writeLine(const std::string& path, const std::string& value) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    const bool ok = fputs(value.c_str(), f) >= 0;
+    return fclose(f) == 0 && ok;
+}
+
+static std::string cpuModel() {
+    std::string model;
+    if (FILE* f = fopen("/proc/cpuinfo", "r")) {
+        char line[512];
+        while (fgets(line, sizeof(line), f)) {
+            // "model name" on x86, "Hardware" or "CPU part" on ARM
+            if (!strncmp(line, "model name", 10) || !strncmp(line, "Hardware", 8)) {
+                const char* colon = strchr(line, ':');
+                if (colon) model = colon + 2;
+                break;
+            }
+        }
+        fclose(f);
+    }
+    while (!model.empty() && model.back() == '\n') model.pop_back();
+    return model;
+}
+
+static std::string cpufreqPath(int cpu, const char* file) {
+    return "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/" + file;
+}
+
+static bool pinToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+static std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char) c >= 0x20) out += c;
+    }
+    return out + "\"";
+}
+
+static const char* simdName() {
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    return "neon";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "none";
+#endif
+}
+
+static bool writeJson(const char* path, const std::string& model, int cpu, bool pinned, const std::string& governor,
+                      const std::string& freq_khz, bool performance) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "{\n  \"benchmark\": \"kernel-bench\",\n  \"compiler\": %s,\n  \"simd\": \"%s\",\n",
+            jsonString(__VERSION__).c_str(), simdName());
+    fprintf(f, "  \"cpu\": { \"model\": %s, \"cpu\": %d, \"pinned\": %s, \"governor\": %s, \"freq_khz\": %s, "
+               "\"performance_governor_set\": %s },\n",
+            jsonString(model).c_str(), cpu, pinned ? "true" : "false", jsonString(governor).c_str(),
+            freq_khz.empty() ? "null" : freq_khz.c_str(), performance ? "true" : "false");
+    fprintf(f, "  \"batches\": %d,\n  \"min_batch_ms\": %g,\n  \"results\": [\n", BATCHES, min_batch_ms);
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        fprintf(f, "    { \"kernel\": \"%s\", \"size\": \"%s\", \"unit\": \"%s\", \"units\": %.0f, \"ns_per_call\": %.1f, "
+                   "\"ns_per_unit\": %.4f, \"gb_per_s\": ",
+                r.kernel.c_str(), r.size.c_str(), r.unit, r.units, r.ns_per_call, r.ns_per_call / r.units);
+        if (r.bytes > 0) {
+            fprintf(f, "%.3f }", r.bytes / r.ns_per_call);
+        } else {
+            fprintf(f, "null }");
+        }
+        fprintf(f, "%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+int main(int argc, char** argv) {
+    const char* json = nullptr;
+    int cpu = -1;
+    bool performance = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-json") && i + 1 < argc) {
+            json = argv[++i];
+        } else if (!strcmp(argv[i], "-cpu") && i + 1 < argc) {
+            cpu = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-performance")) {
+            performance = true;
+        } else if (!strcmp(argv[i], "-min-ms") && i + 1 < argc) {
+            min_batch_ms = std::max(atof(argv[++i]), 0.1);
+        } else if (!strcmp(argv[i], "-filter") && i + 1 < argc) {
+            kernel_filter = argv[++i];
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    const bool pinned = cpu >= 0 && pinToCpu(cpu);
+    if (cpu >= 0 && !pinned) fprintf(stderr, "could not pin to cpu %d\n", cpu);
+#ifdef __linux__
+    if (cpu < 0) cpu = sched_getcpu();
+#endif
+    const std::string old_governor = readFirstLine(cpufreqPath(cpu, "scaling_governor"));
+    const bool governor_set = performance && !old_governor.empty() &&
+                              writeLine(cpufreqPath(cpu, "scaling_governor"), "performance");
+    if (performance && !governor_set) fprintf(stderr, "could not set the performance governor on cpu %d\n", cpu);
+    const std::string governor = readFirstLine(cpufreqPath(cpu, "scaling_governor"));
+    const std::string model = cpuModel();
+    const std::string freq_khz = readFirstLine(cpufreqPath(cpu, "scaling_cur_freq"));
+    printf("cpu %d%s: %s, governor %s, frequency %s kHz, %s\n", cpu, pinned ? " (pinned)" : "", model.c_str(),
+           governor.empty() ? "unknown" : governor.c_str(), freq_khz.empty() ? "unknown" : freq_khz.c_str(),
+           simdName());
+
+    std::mt19937 rng(9);
+    bool ok = checkFrameKernels(rng);
+    ok = checkOneEuro(rng) && ok;
+
+    benchFrames(rng);
+    benchPoseKernels(rng);
+    benchResultPacking();
+
+    // the frequency at the end, after the load
+    const std::string freq = readFirstLine(cpufreqPath(cpu, "scaling_cur_freq"));
+    if (governor_set) writeLine(cpufreqPath(cpu, "scaling_governor"), old_governor);
+    if (json && !writeJson(json, model, cpu, pinned, governor, freq, governor_set)) {
+        fprintf(stderr, "could not write %s\n", json);
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
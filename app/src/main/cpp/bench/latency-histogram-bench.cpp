@@ -0,0 +1,146 @@
+// Host benchmark for the per-stage latency histograms.
+//
+// Buckets: every value from 0 to MAX_VALUE (sampled) falls inside the range of its bucket.
+// Accuracy: percentiles of log-normal frame times against the exact ones from the sorted
+// samples. Concurrency: a reader polls and resets while the writer records, and no sample
+// is lost. Cost: time per record(), alone and with the clock read of recordSince(). Exits
+// non-zero on a bucket error, a percentile off by more than half a bucket or above the
+// maximum, a lost sample or a reset that does not read as empty.
+//
+//   latency-histogram-bench [samples]
+
+#include "../latency-histogram.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static bool bucketCheck() {
+    const uint64_t max_value = LatencyHistogram::MAX_VALUE;
+    const size_t num_buckets = LatencyHistogram::NUM_BUCKETS;
+    std::mt19937_64 rng(1);
+    long errors = 0;
+    for (int i = 0; i < 2000000; i++) {
+        // every magnitude equally often
+        const int bits = (int) (rng() % 38);
+        const uint64_t v = std::min(bits ? rng() >> (64 - bits) : 0, max_value);
+        const size_t b = LatencyHistogram::bucketOf(v);
+        const bool inside = b < num_buckets && LatencyHistogram::bucketStart(b) <= v &&
+                            (b + 1 == num_buckets || v < LatencyHistogram::bucketStart(b + 1));
+        errors += !inside;
+    }
+    printf("buckets: %zu, %ld values outside their bucket\n", num_buckets, errors);
+    return errors == 0;
+}
+
+static bool accuracyCheck(size_t n) {
+    std::mt19937 rng(2);
+    // frame times around 8 ms with a long tail
+    std::lognormal_distribution<double> frame_ns(std::log(8e6), 0.5);
+    std::vector<uint64_t> samples(n);
+    LatencyHistogram h;
+    for (uint64_t& s : samples) {
+        s = (uint64_t) frame_ns(rng);
+        h.record(s);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    const double quantiles[5] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+    uint64_t p[5];
+    h.percentiles(quantiles, 5, p);
+    bool ok = h.count() == n && h.max() == samples.back();
+    printf("accuracy, %zu samples, mean %.3f ms (exact %.3f):\n", n, h.mean() / 1e6,
+           std::accumulate(samples.begin(), samples.end(), 0.0) / n / 1e6);
+    for (int q = 0; q < 5; q++) {
+        const size_t rank = std::min(std::max((size_t) (quantiles[q] * n + 0.5), (size_t) 1), n);
+        const double exact = (double) samples[rank - 1];
+        const double error = std::fabs(p[q] - exact) / exact;
+        // half a bucket, which is at most 1 / SUB_BUCKETS of the value
+        ok = ok && error <= 1.0 / LatencyHistogram::SUB_BUCKETS && p[q] <= h.max();
+        printf("  p%-5g %8.3f ms, exact %8.3f ms, %.2f%% off\n", quantiles[q] * 100, p[q] / 1e6, exact / 1e6,
+               error * 100);
+    }
+    return ok;
+}
+
+// The writer records while a reader polls: counts only grow and none are lost; a reset
+// reads as empty at once and only later samples are counted after it.
+static bool concurrencyCheck(size_t n) {
+    LatencyHistogram h;
+    std::atomic<bool> done(false);
+    long reads = 0, went_back = 0;
+    std::thread reader([&]() {
+        const double quantiles[2] = { 0.5, 0.99 };
+        uint64_t last = 0, p[2];
+        while (!done.load()) {
+            const uint64_t c = h.count();
+            h.percentiles(quantiles, 2, p);
+            went_back += c < last;
+            last = c;
+            reads++;
+        }
+    });
+    for (size_t i = 0; i < n; i++) h.record(1000 + (i * 7919) % 5000000);
+    done = true;
+    reader.join();
+    const uint64_t counted = h.count();
+    bool ok = counted == n && went_back == 0;
+
+    h.reset();
+    const uint64_t after_reset = h.count();
+    for (int i = 0; i < 10; i++) h.record(5000);
+    const double q = 0.5;
+    uint64_t median;
+    h.percentiles(&q, 1, &median);
+    ok = ok && after_reset == 0 && h.count() == 10 && h.max() == 5000 && median / 100 == 50;
+    printf("concurrency: %llu of %zu samples counted, %ld reads, %ld saw the count go back; "
+           "after reset %llu, then %llu\n", (unsigned long long) counted, n, reads, went_back,
+           (unsigned long long) after_reset, (unsigned long long) h.count());
+    return ok;
+}
+
+static void cost(size_t n) {
+    LatencyHistogram h;
+    std::vector<uint64_t> values(4096);
+    std::mt19937 rng(3);
+    std::lognormal_distribution<double> frame_ns(std::log(8e6), 0.5);
+    for (uint64_t& v : values) v = (uint64_t) frame_ns(rng);
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < n; i++) h.record(values[i & 4095]);
+    const double record_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+
+    start = Clock::now();
+    auto t = start;
+    for (size_t i = 0; i < n; i++) t = h.recordSince(t);
+    const double since_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+
+    const double quantiles[4] = { 0.5, 0.9, 0.99, 0.999 };
+    uint64_t p[4];
+    start = Clock::now();
+    const int reads = 1000;
+    for (int i = 0; i < reads; i++) h.percentiles(quantiles, 4, p);
+    const double read_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / reads;
+
+    printf("cost: record %.1f ns, recordSince (with clock) %.1f ns, 4 percentiles %.2f us, %zu bytes\n",
+           record_ns, since_ns, read_us, sizeof(LatencyHistogram));
+}
+
+int main(int argc, char** argv) {
+    const size_t samples = argc > 1 ? atol(argv[1]) : 1000000;
+
+    bool ok = bucketCheck();
+    ok = accuracyCheck(samples) && ok;
+    ok = concurrencyCheck(samples) && ok;
+    cost(samples * 10);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,377 @@
+// Offline evaluation of fall and velocity spike detection.
+//
+// Scripted synthetic scenes: standing, walking, jumping jacks, squats and a slow sit-down
+// must not raise a fall; a topple, a collapse and a topple / get up / topple again must
+// raise exactly one fall per fall; an arm punch must raise one velocity spike. Each scene
+// runs with several noise seeds, some joint dropouts, at 30 and 15 fps. Reports detection
+// and false alarm counts, latency from the start of each fall (mean, sd, max) and the
+// update cost per person and frame. A producer / consumer run checks the event queue.
+// Exits non-zero on a missed or extra fall, a missed spike, or a queue error.
+//
+//   motion-events-eval [-s seeds] [-a aspect] [track.wptk ...]
+//
+// Recorded tracks are fed person by person and their events listed with timestamps.
+
+#include "../motion-events.h"
+#include "pose-streams.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const unsigned int NUM_JOINTS = 23;
+static const float ASPECT = 16.0f / 9.0f;
+
+static NormalizerSkeleton j23Skeleton() {
+    NormalizerSkeleton s;
+    s.num_joints = NUM_JOINTS;
+    s.right_hip = 2;
+    s.left_hip = 3;
+    s.right_shoulder = 12;
+    s.left_shoulder = 13;
+    for (unsigned int j = 0; j < NUM_JOINTS; j++) s.reflected[j] = j;
+    return s;
+}
+
+// j23 standing, facing the camera, in torso lengths with y down: hips middle at 0, ankles
+// at 1.8.
+static const float CANONICAL[NUM_JOINTS][2] = {
+    { -0.2f, 1.8f }, { -0.2f, 0.9f }, { -0.2f, 0.0f }, { 0.2f, 0.0f }, { 0.2f, 0.9f }, { 0.2f, 1.8f },
+    { 0.0f, 0.0f }, { 0.0f, -0.6f }, { 0.0f, -1.1f }, { 0.0f, -1.5f },
+    { -0.35f, 0.0f }, { -0.35f, -0.5f }, { -0.3f, -1.0f }, { 0.3f, -1.0f }, { 0.35f, -0.5f }, { 0.35f, 0.0f },
+    { 0.0f, -1.35f }, { -0.05f, -1.4f }, { -0.12f, -1.38f }, { 0.05f, -1.4f }, { 0.12f, -1.38f },
+    { -0.25f, 1.9f }, { 0.25f, 1.9f },
+};
+
+// Body pose of a scene at one instant.
+struct Body {
+    float x = 0.0f;         // sideways, torso lengths
+    float tilt = 0.0f;      // radians, rotated about the middle of the ankles
+    float sink = 0.0f;      // hips and above lowered by this, torso lengths (negative jumps)
+    float arms = 0.0f;      // both arms raised sideways by this, radians
+    float punch = 0.0f;     // right arm raised forward by this, radians
+};
+
+static void bodyJoints(const Body& b, float torso_px, float* joints) {
+    for (unsigned int j = 0; j < NUM_JOINTS; j++) {
+        float x = CANONICAL[j][0], y = CANONICAL[j][1];
+        // arms: elbow and wrist about their shoulder
+        const bool right_arm = j == 10 || j == 11, left_arm = j == 14 || j == 15;
+        if (right_arm || left_arm) {
+            const int shoulder = right_arm ? 12 : 13;
+            const float a = right_arm ? b.arms + b.punch : -b.arms;
+            const float dx = x - CANONICAL[shoulder][0], dy = y - CANONICAL[shoulder][1];
+            x = CANONICAL[shoulder][0] + std::cos(a) * dx - std::sin(a) * dy;
+            y = CANONICAL[shoulder][1] + std::sin(a) * dx + std::cos(a) * dy;
+        }
+        if (y <= 0.0f) {
+            y += b.sink;
+        } else if (j == 1 || j == 4) {
+            y += b.sink * 0.5f;
+            x += (j == 1 ? -1.0f : 1.0f) * std::max(b.sink, 0.0f) * 0.3f;
+        }
+        const float c = std::cos(b.tilt), s = std::sin(b.tilt);
+        const float dy = y - 1.8f;
+        x += b.x;
+        joints[j * 2] = (0.9f + torso_px * (c * x - s * dy)) / ASPECT;
+        joints[j * 2 + 1] = 0.85f + torso_px * (s * x + c * dy);
+    }
+}
+
+static float smoothstep(float u) {
+    u = std::min(std::max(u, 0.0f), 1.0f);
+    return u * u * (3.0f - 2.0f * u);
+}
+
+// Tilt of a person toppling over from start_s, hitting the ground after 0.7 s.
+static float topple(float t, float start_s) {
+    const float u = std::min(std::max((t - start_s) / 0.7f, 0.0f), 1.0f);
+    return 1.45f * u * u;
+}
+
+struct Scene {
+    const char* name;
+    int falls;                      // expected
+    int spikes;                     // expected, -1 for don't care
+    std::vector<float> fall_starts_s;
+    Body (*body)(float t);
+};
+
+static const Scene SCENES[] = {
+    { "standing", 0, 0, {}, [](float t) {
+        Body b;
+        b.x = 0.05f * std::sin(t * 0.7f);
+        b.arms = 0.1f * std::sin(t * 0.5f);
+        return b;
+    } },
+    { "walking", 0, 0, {}, [](float t) {
+        Body b;
+        b.x = -1.5f + 0.4f * t;
+        b.sink = -0.03f * std::fabs(std::sin(t * 6.0f));
+        b.arms = 0.25f * std::sin(t * 3.0f);
+        return b;
+    } },
+    { "jumping jacks", 0, 0, {}, [](float t) {
+        Body b;
+        const float w = 2.0f * 3.14159265f * 0.9f;
+        b.arms = 1.4f * 0.5f * (1.0f - std::cos(w * t));
+        b.sink = -0.2f * std::fabs(std::sin(w * t * 0.5f));
+        return b;
+    } },
+    { "squats", 0, 0, {}, [](float t) {
+        Body b;
+        b.sink = 0.6f * 0.5f * (1.0f - std::cos(2.0f * 3.14159265f * 0.5f * t));
+        b.arms = 0.5f * b.sink;
+        return b;
+    } },
+    { "sit down", 0, 0, {}, [](float t) {
+        Body b;
+        b.sink = 1.1f * smoothstep((t - 4.0f) / 1.2f);
+        return b;
+    } },
+    { "punch", 0, 1, {}, [](float t) {
+        Body b;
+        // right arm thrown up and back within 0.25 s
+        const float u = (t - 4.0f) / 0.25f;
+        b.punch = u > 0.0f && u < 1.0f ? 1.6f * std::sin(u * 3.14159265f) : 0.0f;
+        return b;
+    } },
+    { "topple", 1, -1, { 4.0f }, [](float t) {
+        Body b;
+        b.tilt = topple(t, 4.0f);
+        b.sink = 0.3f * smoothstep((t - 4.0f) / 0.7f);
+        return b;
+    } },
+    { "collapse", 1, -1, { 4.0f }, [](float t) {
+        Body b;
+        b.sink = 1.7f * smoothstep((t - 4.0f) / 0.5f);
+        b.tilt = 0.3f * smoothstep((t - 4.2f) / 0.5f);
+        return b;
+    } },
+    { "fall twice", 2, -1, { 3.0f, 9.0f }, [](float t) {
+        Body b;
+        // down at 3 s, slowly back up from 6 s, down again at 9 s
+        if (t < 6.0f) {
+            b.tilt = topple(t, 3.0f);
+        } else if (t < 9.0f) {
+            b.tilt = 1.45f * (1.0f - smoothstep((t - 6.0f) / 2.0f));
+        } else {
+            b.tilt = topple(t, 9.0f);
+        }
+        return b;
+    } },
+};
+
+struct Result {
+    int falls, spikes, impacts;
+    std::vector<int64_t> fall_us;
+};
+
+// Runs scene with one noise seed; frame_us apart, jittered.
+static Result runScene(const Scene& scene, int64_t frame_us, unsigned int seed, double* update_ns, long* updates) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 0.002f);
+    std::uniform_int_distribution<int> jitter(-2000, 2000);
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+
+    MotionEventDetector detector(4);
+    detector.setSkeleton(j23Skeleton());
+    const float torso_px = 0.12f + 0.06f * uni(rng);
+    std::vector<float> joints(NUM_JOINTS * 2);
+    Result r = { 0, 0, 0, {} };
+    MotionEvent events[16];
+    double ns = 0;
+    long n = 0;
+    for (int64_t ts = 0; ts < 12000000; ts += frame_us) {
+        const int64_t t_us = ts + jitter(rng);
+        bodyJoints(scene.body(t_us * 1e-6f), torso_px, joints.data());
+        uint32_t mask = (1u << NUM_JOINTS) - 1;
+        for (unsigned int j = 0; j < NUM_JOINTS; j++) {
+            joints[j * 2] += noise(rng);
+            joints[j * 2 + 1] += noise(rng);
+            if (uni(rng) < 0.03f) mask &= ~(1u << j);
+        }
+
+        const auto start = Clock::now();
+        detector.update(7, t_us, joints.data(), mask, ASPECT);
+        ns += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        n++;
+
+        const size_t count = detector.drain(events, 16);
+        for (size_t i = 0; i < count; i++) {
+            if (events[i].type == MOTION_FALL) {
+                r.falls++;
+                r.fall_us.push_back(events[i].timestamp_us);
+            } else if (events[i].type == MOTION_VELOCITY_SPIKE) {
+                r.spikes++;
+            } else {
+                r.impacts++;
+            }
+        }
+    }
+    *update_ns += ns;
+    *updates += n;
+    return r;
+}
+
+static bool evaluate(int seeds) {
+    bool ok = true;
+    double update_ns = 0;
+    long updates = 0;
+    const int64_t intervals[] = { 33333, 66667 };
+    for (int64_t frame_us : intervals) {
+        printf("%.0f fps, %d seeds:\n", 1e6 / frame_us, seeds);
+        for (const Scene& scene : SCENES) {
+            int falls = 0, spikes = 0, impacts = 0, missed = 0, extra = 0, spike_errors = 0;
+            std::vector<double> latency_ms;
+            for (int seed = 0; seed < seeds; seed++) {
+                const Result r = runScene(scene, frame_us, 100 + seed, &update_ns, &updates);
+                falls += r.falls;
+                spikes += r.spikes;
+                impacts += r.impacts;
+                if (r.falls < scene.falls) missed += scene.falls - r.falls;
+                if (r.falls > scene.falls) extra += r.falls - scene.falls;
+                if (scene.spikes >= 0 && r.spikes != scene.spikes) spike_errors++;
+                // each detected fall against the closest preceding fall start
+                for (int64_t us : r.fall_us) {
+                    double best = -1;
+                    for (float start : scene.fall_starts_s) {
+                        const double ms = (us - start * 1e6) * 1e-3;
+                        if (ms >= 0 && (best < 0 || ms < best)) best = ms;
+                    }
+                    if (best >= 0) latency_ms.push_back(best);
+                }
+            }
+
+            printf("  %-14s falls %3d (missed %d, extra %d)  spikes %3d  impacts %3d", scene.name, falls, missed, extra, spikes, impacts);
+            if (!latency_ms.empty()) {
+                double mean = 0, var = 0, worst = 0;
+                for (double l : latency_ms) mean += l;
+                mean /= latency_ms.size();
+                for (double l : latency_ms) {
+                    var += (l - mean) * (l - mean);
+                    worst = std::max(worst, l);
+                }
+                printf("  latency %.0f +- %.0f ms, max %.0f ms", mean, std::sqrt(var / latency_ms.size()), worst);
+            }
+            printf("\n");
+            if (missed || extra || spike_errors) ok = false;
+        }
+    }
+    printf("update: %.0f ns per person and frame\n", update_ns / updates);
+    return ok;
+}
+
+// One thread updates as fast as it can with an event every fourth frame while another
+// drains; every event must arrive once, in order, or be counted as dropped.
+static bool queueCheck() {
+    MotionEventDetector detector(1);
+    detector.setSkeleton(j23Skeleton());
+    MotionEventConfig config;
+    config.spike_speed = 1.0f;
+    config.spike_release = 0.99f;
+    config.refractory_s = 0.0f;
+    config.cutoff_hz = 1e9f;
+    detector.configure(config);
+
+    const long frames = 400000;
+    std::atomic<bool> done(false);
+    long received = 0, out_of_order = 0;
+    std::thread consumer([&] {
+        MotionEvent events[32];
+        int64_t last = -1;
+        for (;;) {
+            const bool finished = done.load(std::memory_order_acquire);
+            const size_t n = detector.drain(events, 32);
+            for (size_t i = 0; i < n; i++) {
+                if (events[i].timestamp_us <= last) out_of_order++;
+                last = events[i].timestamp_us;
+            }
+            received += n;
+            if (finished && n == 0) break;
+        }
+    });
+
+    // the right wrist thrown off and back, then still for two frames: a spike, then
+    // re-armed once it stops
+    std::vector<float> still(NUM_JOINTS * 2), moved(NUM_JOINTS * 2);
+    bodyJoints(Body(), 0.15f, still.data());
+    moved = still;
+    moved[10 * 2] += 0.2f;
+    const uint32_t all = (1u << NUM_JOINTS) - 1;
+    const auto start = Clock::now();
+    for (long f = 0; f < frames; f++) {
+        detector.update(1, (f + 1) * 1000, f % 4 == 1 ? moved.data() : still.data(), all, ASPECT);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / frames;
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    const long expected = frames / 4;
+    printf("queue: %ld events, %ld received, %llu dropped, %ld out of order, %.0f ns per update\n",
+           expected, received, (unsigned long long) detector.dropped(), out_of_order, ns);
+    return received + (long) detector.dropped() == expected && out_of_order == 0;
+}
+
+static void replay(const char* path, float aspect) {
+    const std::map<int, Stream> streams = recordedStreams(path);
+    if (streams.empty()) return;
+
+    NormalizerSkeleton skeleton = j23Skeleton();
+    skeleton.num_joints = streams.begin()->second.num_joints;
+    if (skeleton.num_joints != NUM_JOINTS) {
+        fprintf(stderr, "%s: %u joints, only j23 is supported\n", path, skeleton.num_joints);
+        return;
+    }
+    MotionEventDetector detector(1);
+    detector.setSkeleton(skeleton);
+    const char* names[] = { "velocity spike", "impact", "fall" };
+    MotionEvent events[16];
+    double ns = 0;
+    long frames = 0;
+    for (const auto& it : streams) {
+        const Stream& s = it.second;
+        detector.reset();
+        for (size_t f = 0; f < s.size(); f++) {
+            const auto start = Clock::now();
+            detector.update(it.first, s.timestamps[f], &s.joints[f * s.num_joints * 2], s.masks[f], aspect);
+            ns += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            frames++;
+            const size_t n = detector.drain(events, 16);
+            for (size_t i = 0; i < n; i++) {
+                printf("  id %d  %8.3f s  %-14s %6.2f\n", events[i].id, (events[i].timestamp_us - s.timestamps[0]) * 1e-6,
+                       names[events[i].type], events[i].value);
+            }
+        }
+    }
+    printf("%s: %zu people, %ld frames, %.0f ns per person and frame\n", path, streams.size(), frames, frames ? ns / frames : 0.0);
+}
+
+int main(int argc, char** argv) {
+    int seeds = 20;
+    float aspect = ASPECT;
+    std::vector<const char*> tracks;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            seeds = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-a") && i + 1 < argc) {
+            aspect = (float) atof(argv[++i]);
+        } else {
+            tracks.push_back(argv[i]);
+        }
+    }
+
+    bool ok = evaluate(seeds);
+    ok = queueCheck() && ok;
+    for (const char* path : tracks) replay(path, aspect);
+    return ok ? 0 : 1;
+}
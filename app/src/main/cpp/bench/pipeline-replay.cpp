@@ -0,0 +1,568 @@
+// Replays recorded frames through the whole native frame path and reports its throughput,
+// to compare pipeline changes on the same input.
+//
+// An ingest thread reads the frames into a queue -queue frames deep. -threads preprocess
+// workers convert them to BGR, resize them to the estimator size (-size, 244x128 like the
+// app) and turn them upright (-rotate quarter turns clockwise). The frame thread then takes
+// them in order through processWrnchJNI over the stub estimator (-people, -latency,
+// -jitter, -busy as in native-host) and reads the result out, the output stage, writing the
+// results to -o if given. Ingest and conversion are reported through recordStageLatencyJNI
+// as PlayerTextureView does, so getStatsJNI has every stage.
+//
+// When the queue is full, -skip block holds ingest back, drop-oldest drops the oldest
+// queued frame and drop-newest the incoming one. -fps paces ingest like a live source;
+// unpaced, ingest reads as fast as it can, which with the dropping policies drops most
+// frames.
+//
+// Input is a .y4m file ("-" for stdin) or a directory of raw frames, one file each in name
+// order, -format rgba or i420 at -frame-size WxH. The app's clip in res/raw converts with
+// ffmpeg:
+//
+//   ffmpeg -i easter_egg_nexus9_small.mp4 -pix_fmt yuv420p clip.y4m
+//   ffmpeg -i easter_egg_nexus9_small.mp4 -pix_fmt rgba -c:v rawvideo -f image2 frames/%05d.rgba
+//
+// Without input, -frames synthetic 1280x720 I420 frames are replayed. -loops replays the
+// input that many times. Prints end-to-end frames per second, per-stage and end-to-end
+// latency percentiles, process CPU time and peak RSS. Exits non-zero if frames go missing.
+//
+//   pipeline-replay [-threads n] [-queue n] [-skip block|drop-oldest|drop-newest] [-fps f]
+//                   [-size WxH] [-rotate n] [-format rgba|i420] [-frame-size WxH]
+//                   [-frames n] [-loops n] [-people n] [-latency us] [-jitter us] [-busy]
+//                   [-smoothing mode] [-tracking] [-o results.txt] [input.y4m | frames/]
+
+#include "../frame-kernels.h"
+#include "../latency-histogram.h"
+#include "../video-io.h"
+
+#include "wrnch-natives.h"
+#include "wrnch-stub.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+using Clock = std::chrono::steady_clock;
+
+enum SkipPolicy {
+    SKIP_BLOCK = 0,
+    SKIP_DROP_OLDEST = 1,
+    SKIP_DROP_NEWEST = 2,
+};
+
+struct Frame {
+    std::vector<uint8_t> raw;       // as read, I420 or RGBA
+    std::vector<uint8_t> full;      // BGR at the source size
+    std::vector<uint8_t> turned;    // BGR at the estimator size before rotation
+    std::vector<uint8_t> bgr;       // the estimator's input
+    int64_t timestamp_us;
+    Clock::time_point start;        // ingest began
+    uint64_t ingest_ns;
+    uint64_t conversion_ns;
+};
+
+static uint64_t elapsedNs(Clock::time_point start, Clock::time_point end) {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// Frames from a .y4m, a directory of raw frames or a synthetic pattern, all one size.
+class FrameSource {
+public:
+    bool openY4m(const char* path) {
+        path_ = path;
+        if (!y4m_.open(path)) return false;
+        format_ = VIDEO_FRAME_YUV420;
+        width_ = y4m_.width();
+        height_ = y4m_.height();
+        frame_us_ = 1000000LL * y4m_.fpsDen() / y4m_.fpsNum();
+        return true;
+    }
+
+    bool openDirectory(const char* path, int format, int width, int height) {
+        path_ = path;
+        DIR* dir = opendir(path);
+        if (!dir) return false;
+        while (const dirent* entry = readdir(dir)) {
+            const std::string file = path_ + "/" + entry->d_name;
+            struct stat st;
+            if (entry->d_name[0] != '.' && stat(file.c_str(), &st) == 0 && S_ISREG(st.st_mode)) files_.push_back(file);
+        }
+        closedir(dir);
+        std::sort(files_.begin(), files_.end());
+        format_ = format;
+        width_ = width;
+        height_ = height;
+        frame_us_ = 33333;
+        return !files_.empty() && width > 0 && height > 0;
+    }
+
+    // A few distinct frames of moving gradients, cycled.
+    void openSynthetic(int width, int height, long frames) {
+        format_ = VIDEO_FRAME_YUV420;
+        width_ = width;
+        height_ = height;
+        frame_us_ = 33333;
+        synthetic_frames_ = frames;
+        synthetic_.resize(8);
+        for (size_t k = 0; k < synthetic_.size(); k++) {
+            synthetic_[k].resize(frameSize());
+            uint8_t* p = synthetic_[k].data();
+            for (int y = 0; y < height; y++) {
+                for (int x = 0; x < width; x++) *p++ = (uint8_t) (16 + (x + y + k * 16) % 220);
+            }
+            std::fill(p, synthetic_[k].data() + synthetic_[k].size(), (uint8_t) (96 + k * 8));
+        }
+    }
+
+    int format() const { return format_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int64_t frameUs() const { return frame_us_; }
+
+    size_t frameSize() const {
+        if (format_ == VIDEO_FRAME_RGBA) return (size_t) width_ * height_ * 4;
+        return (size_t) width_ * height_ + 2 * (size_t) ((width_ + 1) / 2) * ((height_ + 1) / 2);
+    }
+
+    // Next frame into data, frameSize() bytes. False at the end.
+    bool read(uint8_t* data) {
+        if (!synthetic_.empty()) {
+            if (next_ >= synthetic_frames_) return false;
+            memcpy(data, synthetic_[next_++ % synthetic_.size()].data(), frameSize());
+            return true;
+        }
+        if (!files_.empty()) {
+            if (next_ >= (long) files_.size()) return false;
+            FILE* f = fopen(files_[next_++].c_str(), "rb");
+            if (!f) return false;
+            const bool ok = fread(data, frameSize(), 1, f) == 1;
+            fclose(f);
+            return ok;
+        }
+        VideoFrame frame;
+        return y4m_.read(data, &frame);
+    }
+
+    // Back to the first frame, for another loop.
+    bool rewind() {
+        next_ = 0;
+        if (!synthetic_.empty() || !files_.empty()) return true;
+        y4m_.close();
+        return path_ != "-" && y4m_.open(path_.c_str());
+    }
+
+private:
+    std::string path_;
+    Y4mReader y4m_;
+    std::vector<std::string> files_;
+    std::vector<std::vector<uint8_t>> synthetic_;
+    long synthetic_frames_ = 0;
+    long next_ = 0;
+    int format_ = VIDEO_FRAME_YUV420;
+    int width_ = 0;
+    int height_ = 0;
+    int64_t frame_us_ = 33333;
+};
+
+// The frames between the stages. Frames come from a fixed pool, so the steady state does
+// not allocate; ingest waits for a free one, which bounds everything in flight.
+class ReplayPipeline {
+public:
+    ReplayPipeline(size_t pool_size, size_t queue_depth, int policy)
+            : frames_(pool_size), depth_(queue_depth), policy_(policy), ingest_done_(false), workers_left_(0),
+              next_seq_(0), next_out_(0), dropped_(0) {
+        for (Frame& f : frames_) free_.push_back(&f);
+    }
+
+    std::vector<Frame>& frames() { return frames_; }
+    long dropped() const { return dropped_; }
+
+    // Ingest side.
+    Frame* acquire() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        free_cond_.wait(lock, [this] { return !free_.empty(); });
+        Frame* f = free_.back();
+        free_.pop_back();
+        return f;
+    }
+
+    void push(Frame* f) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (queue_.size() >= depth_) {
+            if (policy_ == SKIP_DROP_NEWEST) {
+                dropLocked(f);
+                return;
+            }
+            if (policy_ == SKIP_DROP_OLDEST) {
+                dropLocked(queue_.front());
+                queue_.pop_front();
+            } else {
+                space_cond_.wait(lock, [this] { return queue_.size() < depth_; });
+            }
+        }
+        queue_.push_back(f);
+        work_cond_.notify_one();
+    }
+
+    void finishIngest(int workers) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ingest_done_ = true;
+        workers_left_ = workers;
+        work_cond_.notify_all();
+    }
+
+    // Worker side: the next queued frame and its place in the output order, null when done.
+    Frame* take(long* seq) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_cond_.wait(lock, [this] { return !queue_.empty() || ingest_done_; });
+        if (queue_.empty()) return nullptr;
+        Frame* f = queue_.front();
+        queue_.pop_front();
+        *seq = next_seq_++;
+        space_cond_.notify_one();
+        return f;
+    }
+
+    // Hands a converted frame on, waiting while it is more than a queue ahead of the frame
+    // thread. The next frame in order is always let through, so this cannot deadlock.
+    void ready(Frame* f, long seq) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_cond_.wait(lock, [this, seq] { return seq < next_out_ + (long) depth_; });
+        converted_[seq] = f;
+        out_cond_.notify_one();
+    }
+
+    void workerDone() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        workers_left_--;
+        out_cond_.notify_one();
+    }
+
+    // Frame thread: converted frames in ingest order, null when all are through.
+    Frame* next() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        out_cond_.wait(lock, [this] {
+            return converted_.count(next_out_) || (ingest_done_ && workers_left_ == 0 && converted_.empty());
+        });
+        auto it = converted_.find(next_out_);
+        if (it == converted_.end()) return nullptr;
+        Frame* f = it->second;
+        converted_.erase(it);
+        next_out_++;
+        ready_cond_.notify_all();
+        return f;
+    }
+
+    void release(Frame* f) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(f);
+        free_cond_.notify_one();
+    }
+
+private:
+    void dropLocked(Frame* f) {
+        dropped_++;
+        free_.push_back(f);
+        free_cond_.notify_one();
+    }
+
+    std::vector<Frame> frames_;
+    const size_t depth_;
+    const int policy_;
+
+    std::mutex mutex_;
+    std::condition_variable free_cond_;
+    std::condition_variable space_cond_;
+    std::condition_variable work_cond_;
+    std::condition_variable ready_cond_;
+    std::condition_variable out_cond_;
+    std::vector<Frame*> free_;
+    std::deque<Frame*> queue_;
+    std::map<long, Frame*> converted_;
+    bool ingest_done_;
+    int workers_left_;
+    long next_seq_;
+    long next_out_;
+    long dropped_;
+};
+
+static void convertFrame(const FrameSource& source, const BgrResizer& resizer, int turns, int net_width,
+                         Frame& f) {
+    const int w = source.width(), h = source.height();
+    if (source.format() == VIDEO_FRAME_RGBA) {
+        rgbaToBgr(f.raw.data(), (size_t) w * h, f.full.data());
+    } else {
+        const size_t luma = (size_t) w * h, chroma_stride = (w + 1) / 2;
+        const Yuv420Image img = { f.raw.data(), f.raw.data() + luma, f.raw.data() + luma + chroma_stride * ((h + 1) / 2),
+                                  (size_t) w, chroma_stride, 1, w, h };
+        yuv420ToBgr(img, f.full.data(), (size_t) w * 3);
+    }
+    // resized to the estimator size turned back, then turned, so the rotation is a small one
+    if (turns == 0) {
+        resizer.resize(f.full.data(), (size_t) w * 3, f.bgr.data(), (size_t) net_width * 3);
+    } else {
+        const int rw = resizer.dstWidth(), rh = resizer.dstHeight();
+        resizer.resize(f.full.data(), (size_t) w * 3, f.turned.data(), (size_t) rw * 3);
+        rotateBgr(f.turned.data(), rw, rh, (size_t) rw * 3, turns, f.bgr.data(), (size_t) net_width * 3);
+    }
+}
+
+static void printRow(const char* name, const float* h) {
+    printf("%-11s %8.0f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", name, h[0], h[1], h[2], h[3], h[4], h[5], h[6]);
+}
+
+// A local histogram in getStatsJNI's per-stage layout, microseconds.
+static void histogramRow(const LatencyHistogram& h, float* out) {
+    static const double QUANTILES[4] = { 0.5, 0.9, 0.99, 0.999 };
+    uint64_t p[4];
+    h.percentiles(QUANTILES, 4, p);
+    out[0] = (float) h.count();
+    out[1] = (float) (h.mean() / 1000.0);
+    for (int i = 0; i < 4; i++) out[2 + i] = p[i] / 1000.0f;
+    out[6] = h.max() / 1000.0f;
+}
+
+static double seconds(const timeval& tv) {
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int main(int argc, char** argv) {
+    int threads = 1;
+    size_t queue_depth = 4;
+    int policy = SKIP_BLOCK;
+    double fps = 0;
+    int net_width = 244, net_height = 128;
+    int turns = 0;
+    int format = VIDEO_FRAME_RGBA;
+    int frame_width = 0, frame_height = 0;
+    long frames = 300;
+    int loops = 1;
+    int smoothing = WRNCH_SMOOTHING_LIBRARY;
+    bool tracking = false;
+    const char* output = nullptr;
+    const char* input = nullptr;
+    WrnchStubConfig stub = wrnchStubDefaults();
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-threads") && i + 1 < argc) {
+            threads = std::max(atoi(argv[++i]), 1);
+        } else if (!strcmp(argv[i], "-queue") && i + 1 < argc) {
+            queue_depth = (size_t) std::max(atoi(argv[++i]), 1);
+        } else if (!strcmp(argv[i], "-skip") && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (!strcmp(name, "block")) {
+                policy = SKIP_BLOCK;
+            } else if (!strcmp(name, "drop-oldest")) {
+                policy = SKIP_DROP_OLDEST;
+            } else if (!strcmp(name, "drop-newest")) {
+                policy = SKIP_DROP_NEWEST;
+            } else {
+                fprintf(stderr, "unknown skip policy %s\n", name);
+                return 2;
+            }
+        } else if (!strcmp(argv[i], "-fps") && i + 1 < argc) {
+            fps = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "-size") && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &net_width, &net_height);
+        } else if (!strcmp(argv[i], "-rotate") && i + 1 < argc) {
+            turns = ((atoi(argv[++i]) % 4) + 4) % 4;
+        } else if (!strcmp(argv[i], "-format") && i + 1 < argc) {
+            format = strcmp(argv[++i], "i420") ? VIDEO_FRAME_RGBA : VIDEO_FRAME_YUV420;
+        } else if (!strcmp(argv[i], "-frame-size") && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &frame_width, &frame_height);
+        } else if (!strcmp(argv[i], "-frames") && i + 1 < argc) {
+            frames = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "-loops") && i + 1 < argc) {
+            loops = std::max(atoi(argv[++i]), 1);
+        } else if (!strcmp(argv[i], "-people") && i + 1 < argc) {
+            stub.num_people = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-latency") && i + 1 < argc) {
+            stub.latency_us = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-jitter") && i + 1 < argc) {
+            stub.jitter_us = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-busy")) {
+            stub.busy_wait = true;
+        } else if (!strcmp(argv[i], "-smoothing") && i + 1 < argc) {
+            smoothing = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-tracking")) {
+            tracking = true;
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            output = argv[++i];
+        } else if (argv[i][0] != '-' || !strcmp(argv[i], "-")) {
+            input = argv[i];
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    FrameSource source;
+    struct stat st;
+    if (!input) {
+        source.openSynthetic(1280, 720, frames);
+    } else if (strcmp(input, "-") && stat(input, &st) == 0 && S_ISDIR(st.st_mode)) {
+        if (!source.openDirectory(input, format, frame_width, frame_height)) {
+            fprintf(stderr, "no frames in %s, or no -frame-size\n", input);
+            return 1;
+        }
+    } else if (!source.openY4m(input)) {
+        fprintf(stderr, "could not open %s\n", input);
+        return 1;
+    }
+    FILE* results = nullptr;
+    if (output && !(results = fopen(output, "w"))) {
+        fprintf(stderr, "could not write %s\n", output);
+        return 1;
+    }
+
+    setWrnchStubConfig(stub);
+    JNIEnv env;
+    Java_com_samsungnext_audiovideoplayersample_Wrnch_setNativeTrackingJNI(&env, nullptr, tracking ? JNI_TRUE : JNI_FALSE);
+    Java_com_samsungnext_audiovideoplayersample_Wrnch_setSmoothingJNI(&env, nullptr, smoothing);
+    env.PushLocalFrame(4);
+    const jsize num_bone_ints = env.GetArrayLength(
+            Java_com_samsungnext_audiovideoplayersample_Wrnch_initWrnchJNI(&env, nullptr, env.NewStringUTF("/tmp")));
+    env.PopLocalFrame(nullptr);
+    if (num_bone_ints == 0) return 1;
+
+    // the estimator size turned back by the rotation, what the resize produces
+    BgrResizer resizer;
+    const bool odd = turns % 2 != 0;
+    resizer.configure(source.width(), source.height(), odd ? net_height : net_width, odd ? net_width : net_height);
+
+    // queued, being converted, waiting in order, one being read and one being processed
+    ReplayPipeline pipeline(queue_depth * 2 + threads + 2, queue_depth, policy);
+    for (Frame& f : pipeline.frames()) {
+        f.raw.resize(source.frameSize());
+        f.full.resize((size_t) source.width() * source.height() * 3);
+        f.turned.resize((size_t) net_width * net_height * 3);
+        f.bgr.resize((size_t) net_width * net_height * 3);
+    }
+
+    rusage usage_start;
+    getrusage(RUSAGE_SELF, &usage_start);
+    const auto run_start = Clock::now();
+
+    long frames_read = 0;
+    std::thread ingest([&]() {
+        const int64_t interval_us = fps > 0 ? (int64_t) (1e6 / fps) : 0;
+        for (int loop = 0; loop < loops && (loop == 0 || source.rewind()); loop++) {
+            for (;;) {
+                Frame* f = pipeline.acquire();
+                if (interval_us > 0) std::this_thread::sleep_until(run_start + std::chrono::microseconds(frames_read * interval_us));
+                f->start = Clock::now();
+                if (!source.read(f->raw.data())) {
+                    pipeline.release(f);
+                    break;
+                }
+                f->timestamp_us = frames_read * source.frameUs();
+                f->ingest_ns = elapsedNs(f->start, Clock::now());
+                frames_read++;
+                pipeline.push(f);
+            }
+        }
+        pipeline.finishIngest(threads);
+    });
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&]() {
+            long seq;
+            while (Frame* f = pipeline.take(&seq)) {
+                const auto start = Clock::now();
+                convertFrame(source, resizer, turns, net_width, *f);
+                f->conversion_ns = elapsedNs(start, Clock::now());
+                pipeline.ready(f, seq);
+            }
+            pipeline.workerDone();
+        });
+    }
+
+    // the frame thread: the app's Java array, reused for every frame
+    LatencyHistogram output_latency, end_to_end;
+    jbyteArray img = env.NewByteArray(net_width * net_height * 3);
+    std::vector<float> result;
+    long processed = 0, without_main = 0;
+    while (Frame* f = pipeline.next()) {
+        const auto start = Clock::now();
+        env.SetByteArrayRegion(img, 0, (jsize) f->bgr.size(), (const jbyte*) f->bgr.data());
+        const uint64_t copy_ns = elapsedNs(start, Clock::now());
+        Java_com_samsungnext_audiovideoplayersample_Wrnch_recordStageLatencyJNI(&env, nullptr, WRNCH_STAGE_INGEST, (jlong) f->ingest_ns);
+        Java_com_samsungnext_audiovideoplayersample_Wrnch_recordStageLatencyJNI(&env, nullptr, WRNCH_STAGE_CONVERSION,
+                                                                                (jlong) (f->conversion_ns + copy_ns));
+
+        env.PushLocalFrame(4);
+        jfloatArray out = Java_com_samsungnext_audiovideoplayersample_Wrnch_processWrnchJNI(
+                &env, nullptr, img, net_width, net_height, f->timestamp_us);
+        const auto output_start = Clock::now();
+        const jsize n = env.GetArrayLength(out);
+        result.resize(n);
+        if (n > 0) env.GetFloatArrayRegion(out, 0, n, result.data());
+        env.PopLocalFrame(nullptr);
+        if (n == 0) without_main++;
+        if (results) {
+            fprintf(results, "%lld", (long long) f->timestamp_us);
+            for (float v : result) fprintf(results, " %g", v);
+            fprintf(results, "\n");
+        }
+        const auto end = output_latency.recordSince(output_start);
+        end_to_end.record(elapsedNs(f->start, end));
+        processed++;
+        pipeline.release(f);
+    }
+    ingest.join();
+    for (std::thread& t : workers) t.join();
+
+    const double wall = std::chrono::duration<double>(Clock::now() - run_start).count();
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    const double user = seconds(usage.ru_utime) - seconds(usage_start.ru_utime);
+    const double sys = seconds(usage.ru_stime) - seconds(usage_start.ru_stime);
+    if (results) fclose(results);
+
+    float stats[WRNCH_STATS_LENGTH];
+    env.PushLocalFrame(4);
+    env.GetFloatArrayRegion(Java_com_samsungnext_audiovideoplayersample_Wrnch_getStatsJNI(&env, nullptr), 0,
+                            WRNCH_STATS_LENGTH, stats);
+    env.PopLocalFrame(nullptr);
+
+    static const char* const POLICIES[] = { "block", "drop-oldest", "drop-newest" };
+    char pacing[32] = "unpaced";
+    if (fps > 0) snprintf(pacing, sizeof(pacing), "paced at %g fps", fps);
+    printf("%s: %dx%d %s to %dx%d, %d quarter turns; %d threads, queue %zu, skip %s, %s\n",
+           input ? input : "synthetic", source.width(), source.height(),
+           source.format() == VIDEO_FRAME_RGBA ? "RGBA" : "I420", net_width, net_height, turns, threads, queue_depth,
+           POLICIES[policy], pacing);
+    printf("stub: %d people, latency %u +- %u us%s\n", stub.num_people, stub.latency_us, stub.jitter_us,
+           stub.busy_wait ? " busy" : "");
+    printf("frames: %ld read, %ld dropped, %ld processed, %ld without a main person\n", frames_read, pipeline.dropped(),
+           processed, without_main);
+    printf("throughput: %.1f fps end to end over %.2f s\n", processed / wall, wall);
+    printf("cpu: %.2f s user, %.2f s system, %.2f cores busy, %.2f ms per frame\n", user, sys, (user + sys) / wall,
+           processed ? (user + sys) * 1000.0 / processed : 0.0);
+    printf("peak rss: %.1f MB\n", usage.ru_maxrss / 1024.0);     // kB on Linux
+
+    static const char* const STAGES[WRNCH_NUM_STAGES] = { "ingest", "conversion", "process", "extraction", "marshal" };
+    printf("%-11s %8s %9s %9s %9s %9s %9s %9s\n", "stage", "samples", "mean us", "p50", "p90", "p99", "p99.9", "max");
+    for (int s = 0; s < WRNCH_NUM_STAGES; s++) printRow(STAGES[s], stats + s * WRNCH_STATS_PER_STAGE);
+    float row[WRNCH_STATS_PER_STAGE];
+    histogramRow(output_latency, row);
+    printRow("output", row);
+    histogramRow(end_to_end, row);
+    printRow("end to end", row);
+
+    const bool ok = frames_read == processed + pipeline.dropped() && stats[WRNCH_STATS_FRAMES] == processed &&
+                    (policy != SKIP_BLOCK || pipeline.dropped() == 0);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+// Host benchmark for the pose codec: compression ratio, encode/decode throughput and
+// seek cost against raw float storage (timestamp, mask, joints and scores as floats).
+//
+//   pose-codec-bench [track.wptk ...]
+//
+// Without arguments only the synthetic track is measured; recorded tracks are split into
+// one stream per tracker id.
+
+#include "../pose-codec.h"
+#include "pose-streams.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static Stream syntheticStream(size_t frames) {
+    const unsigned int num_joints = 23;
+    Stream s;
+    s.num_joints = num_joints;
+
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 0.002f);
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+
+    for (size_t f = 0; f < frames; f++) {
+        const float t = f / 30.0f;
+        s.timestamps.push_back((int64_t) f * 33333);
+        uint32_t mask = 0;
+        for (unsigned int j = 0; j < num_joints; j++) {
+            const float phase = j * 0.7f;
+            const float x = 0.5f + 0.2f * std::sin(t * 1.3f + phase) + 0.02f * j / num_joints + noise(rng);
+            const float y = 0.5f + 0.3f * std::cos(t * 0.9f + phase) + noise(rng);
+            const bool valid = uni(rng) > 0.05f;
+            s.joints.push_back(valid ? x : -1.0f);
+            s.joints.push_back(valid ? y : -1.0f);
+            s.scores.push_back(valid ? 0.6f + 0.3f * uni(rng) : 0.05f);
+            mask |= (uint32_t) valid << j;
+        }
+        s.masks.push_back(mask);
+    }
+    return s;
+}
+
+static void run(const char* name, const Stream& s) {
+    const unsigned int n = s.num_joints;
+    const size_t raw_bytes = s.size() * (sizeof(int64_t) + sizeof(uint32_t) + sizeof(float) * n * 3);
+
+    PoseEncoder encoder(n, 30);
+    std::vector<uint8_t> encoded;
+    encoded.reserve(raw_bytes);
+
+    auto start = Clock::now();
+    for (size_t f = 0; f < s.size(); f++) {
+        encoder.encode(s.timestamps[f], &s.joints[f * n * 2], &s.scores[f * n], s.masks[f], encoded);
+    }
+    const double encode_s = secondsSince(start);
+
+    PoseDecoder decoder(n);
+    std::vector<float> joints(n * 2), scores(n);
+    int64_t ts;
+    uint32_t mask;
+    float max_error = 0.0f;
+
+    start = Clock::now();
+    size_t pos = 0;
+    for (size_t f = 0; f < s.size(); f++) {
+        pos += decoder.decode(&encoded[pos], encoded.size() - pos, &ts, joints.data(), scores.data(), &mask);
+        if ((f & 63) == 0) {
+            for (unsigned int j = 0; j < n; j++) {
+                if (mask & (1u << j)) {
+                    max_error = std::max(max_error, std::fabs(joints[j * 2] - s.joints[f * n * 2 + j * 2]));
+                }
+            }
+        }
+    }
+    const double decode_s = secondsSince(start);
+
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<size_t> pick(0, s.size() - 1);
+    const int seeks = 10000;
+    start = Clock::now();
+    for (int q = 0; q < seeks; q++) {
+        const int64_t target = s.timestamps[pick(rng)];
+        const PoseKeyframe* key = poseCodecSeek(encoder.keyframes(), target);
+        decoder.reset();
+        size_t p = key->offset;
+        do {
+            p += decoder.decode(&encoded[p], encoded.size() - p, &ts, joints.data(), scores.data(), &mask);
+        } while (ts < target);
+    }
+    const double seek_s = secondsSince(start);
+
+    const double raw_mb = raw_bytes / 1e6;
+    printf("%-24s %8zu frames  raw %8.2f MB  encoded %7.2f MB  ratio %5.2fx  "
+           "encode %7.1f MB/s (%5.0f ns/frame)  decode %7.1f MB/s (%5.0f ns/frame)  seek %5.2f us  max err %.1e\n",
+           name, s.size(), raw_mb, encoded.size() / 1e6, (double) raw_bytes / encoded.size(),
+           raw_mb / encode_s, encode_s * 1e9 / s.size(), raw_mb / decode_s, decode_s * 1e9 / s.size(),
+           seek_s * 1e6 / seeks, max_error);
+}
+
+int main(int argc, char** argv) {
+    // one hour at 30 fps
+    run("synthetic", syntheticStream(30 * 3600));
+
+    for (int i = 1; i < argc; i++) {
+        for (const auto& it : recordedStreams(argv[i])) {
+            char name[256];
+            snprintf(name, sizeof(name), "%s#%d", argv[i], it.first);
+            if (it.second.size() > 0) run(name, it.second);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Host benchmark for PoseHistory: 20 tracked people fed at 30-120 Hz, measuring append
+// and the three query kinds against a 4 MB budget.
+
+#include "../pose-history.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double nsSince(Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+static void run(int rate_hz, int num_people, int seconds) {
+    const unsigned int num_joints = 23;
+    PoseHistory history(num_joints, 32);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+    std::vector<float> joints(num_joints * 2), scores(num_joints);
+    for (auto& v : joints) v = uni(rng);
+    for (auto& v : scores) v = uni(rng);
+    const float bbox[4] = { 0.1f, 0.1f, 0.5f, 0.8f };
+
+    const int64_t frame_us = 1000000 / rate_hz;
+    const size_t frames = (size_t) rate_hz * seconds;
+
+    auto start = Clock::now();
+    for (size_t f = 0; f < frames; f++) {
+        for (int p = 0; p < num_people; p++) {
+            joints[p % joints.size()] += 0.001f;
+            history.append(p, f * frame_us, joints.data(), scores.data(), bbox, 0x7fffff);
+        }
+    }
+    const double append_ns = nsSince(start, frames * num_people);
+
+    const int64_t now_us = (frames - 1) * frame_us;
+    const int queries = 100000;
+    volatile float sink = 0;
+
+    start = Clock::now();
+    for (int q = 0; q < queries; q++) {
+        PoseFrameView view;
+        if (history.latest(q % num_people, &view)) sink = sink + view.joints[0];
+    }
+    const double latest_ns = nsSince(start, queries);
+
+    size_t window_frames = 0;
+    start = Clock::now();
+    for (int q = 0; q < queries; q++) {
+        PoseWindow w = history.windowByTime(q % num_people, now_us - 2000000, now_us);
+        window_frames = w.size();
+        sink = sink + w.at(w.size() / 2).joints[0];
+    }
+    const double by_time_ns = nsSince(start, queries);
+
+    start = Clock::now();
+    for (int q = 0; q < queries; q++) {
+        PoseWindow w = history.windowByCount(q % num_people, rate_hz);
+        sink = sink + w.at(0).scores[0];
+    }
+    const double by_count_ns = nsSince(start, queries);
+
+    printf("%4d Hz x %2d people: capacity %zu frames/track (%.1f s), append %.1f ns, latest %.1f ns, "
+           "2 s window (%zu frames) %.1f ns, count window %.1f ns\n",
+           rate_hz, num_people, history.capacity(), history.capacity() / (double) rate_hz,
+           append_ns, latest_ns, window_frames, by_time_ns, by_count_ns);
+}
+
+int main() {
+    const int rates[] = { 30, 60, 120 };
+    for (int rate : rates) {
+        run(rate, 20, 60);
+    }
+    return 0;
+}
@@ -0,0 +1,332 @@
+// Offline builder and recall/latency benchmark for the reference pose index.
+//
+//   pose-index-bench [-o index.wpix] [-a aspect] [-k k] [label=track.wptk ...]
+//
+// With tracks, every record with all joints valid becomes a reference pose labelled with
+// the label of its track, and the index is written to -o for the app to map. Without tracks
+// a synthetic library of j23 poses from a few joint angle clusters is used. Either way 1 in
+// 20 poses is held out as queries and searched exactly by full scan, exactly through the
+// tree and through the tree with a budget of leaves, reporting latency, recall@k against the
+// full scan and how often the nearest pose has the query's label.
+//
+// The same queries are then searched with joints missing, the legs for one in three and up
+// to four random joints otherwise, normalized over the joints left. Each search reports
+// recall@k against the exact partial distance by full scan and against the neighbours of
+// the full pose the joints were dropped from. Exits non-zero if the exact tree search misses
+// any full-pose match, or if the completed tree search recovers less than 0.9 of what the
+// full scan recovers of the full-pose neighbours.
+
+#include "../pose-index.h"
+#include "../pose-track.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+enum {
+    RANKLE = 0, RKNEE, RHIP, LHIP, LKNEE, LANKLE, PELV, THRX, NECK, HEAD,
+    RWRIST, RELBOW, RSHOULDER, LSHOULDER, LELBOW, LWRIST,
+    NOSE, REYE, REAR, LEYE, LEAR, RFOOT, LFOOT, NUM_JOINTS
+};
+
+struct Library {
+    std::vector<float> poses;       // normalized, poseIndexDim floats each
+    std::vector<uint32_t> labels;
+    std::vector<std::string> names;
+};
+
+static void setJoint(float* joints, int j, float x, float y) {
+    joints[j * 2] = x;
+    joints[j * 2 + 1] = y;
+}
+
+// Forward kinematics of a 2d skeleton from a torso lean and two angles per limb, y down.
+static void skeleton(const float* p, float* joints) {
+    const float ux = std::sin(p[0]), uy = -std::cos(p[0]);    // torso up
+    setJoint(joints, PELV, 0.0f, 0.0f);
+    setJoint(joints, THRX, ux * 0.5f, uy * 0.5f);
+    setJoint(joints, NECK, ux * 0.6f, uy * 0.6f);
+    setJoint(joints, HEAD, ux * 0.72f, uy * 0.72f);
+    setJoint(joints, NOSE, ux * 0.7f - 0.03f, uy * 0.7f);
+    setJoint(joints, REYE, ux * 0.74f - 0.02f, uy * 0.74f);
+    setJoint(joints, LEYE, ux * 0.74f + 0.02f, uy * 0.74f);
+    setJoint(joints, REAR, ux * 0.73f - 0.05f, uy * 0.73f);
+    setJoint(joints, LEAR, ux * 0.73f + 0.05f, uy * 0.73f);
+
+    const int shoulders[2] = { RSHOULDER, LSHOULDER }, elbows[2] = { RELBOW, LELBOW }, wrists[2] = { RWRIST, LWRIST };
+    const int hips[2] = { RHIP, LHIP }, knees[2] = { RKNEE, LKNEE }, ankles[2] = { RANKLE, LANKLE }, feet[2] = { RFOOT, LFOOT };
+    for (int s = 0; s < 2; s++) {
+        const float side = s == 0 ? -1.0f : 1.0f;
+        const float sx = ux * 0.5f - uy * 0.13f * side, sy = uy * 0.5f + ux * 0.13f * side;
+        const float a1 = p[1 + s * 2] * side, a2 = a1 + p[2 + s * 2] * side;
+        setJoint(joints, shoulders[s], sx, sy);
+        setJoint(joints, elbows[s], sx + std::sin(a1) * 0.28f, sy + std::cos(a1) * 0.28f);
+        setJoint(joints, wrists[s], joints[elbows[s] * 2] + std::sin(a2) * 0.25f, joints[elbows[s] * 2 + 1] + std::cos(a2) * 0.25f);
+
+        const float hx = 0.1f * side, hy = 0.0f;
+        const float l1 = p[5 + s * 2] * side, l2 = l1 - p[6 + s * 2] * side;
+        setJoint(joints, hips[s], hx, hy);
+        setJoint(joints, knees[s], hx + std::sin(l1) * 0.42f, hy + std::cos(l1) * 0.42f);
+        setJoint(joints, ankles[s], joints[knees[s] * 2] + std::sin(l2) * 0.4f, joints[knees[s] * 2 + 1] + std::cos(l2) * 0.4f);
+        setJoint(joints, feet[s], joints[ankles[s] * 2] + 0.06f * side, joints[ankles[s] * 2 + 1] + 0.03f);
+    }
+}
+
+static Library syntheticLibrary(size_t count) {
+    const size_t num_classes = 16, num_params = 9;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> lean(-0.6f, 0.6f), limb(0.0f, 2.6f), place(0.1f, 0.9f), size(0.3f, 0.9f);
+    std::normal_distribution<float> spread(0.0f, 0.25f), noise(0.0f, 0.01f);
+
+    std::vector<std::vector<float>> centers(num_classes, std::vector<float>(num_params));
+    Library lib;
+    for (size_t c = 0; c < num_classes; c++) {
+        centers[c][0] = lean(rng);
+        for (size_t i = 1; i < num_params; i++) centers[c][i] = limb(rng);
+        lib.names.push_back("pose" + std::to_string(c));
+    }
+
+    const size_t dim = poseIndexDim(NUM_JOINTS);
+    std::vector<float> params(num_params), joints(NUM_JOINTS * 2);
+    lib.poses.resize(count * dim);
+    for (size_t i = 0; i < count; i++) {
+        const size_t c = rng() % num_classes;
+        for (size_t k = 0; k < num_params; k++) params[k] = centers[c][k] + spread(rng);
+        skeleton(params.data(), joints.data());
+        // arbitrary place and size in the frame, which normalization takes out again
+        const float s = size(rng), x = place(rng), y = place(rng);
+        for (int j = 0; j < NUM_JOINTS; j++) {
+            joints[j * 2] = x + (joints[j * 2] + noise(rng)) * s;
+            joints[j * 2 + 1] = y + (joints[j * 2 + 1] + noise(rng)) * s;
+        }
+        normalizePose(joints.data(), (1u << NUM_JOINTS) - 1, NUM_JOINTS, 1.0f, &lib.poses[i * dim]);
+        lib.labels.push_back(c);
+    }
+    return lib;
+}
+
+static bool trackLibrary(int argc, char** argv, int first, float aspect, Library* lib, unsigned int* num_joints) {
+    for (int a = first; a < argc; a++) {
+        const char* eq = strchr(argv[a], '=');
+        if (!eq) {
+            fprintf(stderr, "expected label=track.wptk, got %s\n", argv[a]);
+            return false;
+        }
+        PoseTrackReader reader;
+        if (!reader.open(eq + 1)) {
+            fprintf(stderr, "can't read %s\n", eq + 1);
+            return false;
+        }
+        *num_joints = reader.numJoints();
+        const uint32_t all = *num_joints >= 32 ? 0xffffffff : (1u << *num_joints) - 1;
+        const size_t dim = poseIndexDim(*num_joints);
+        const uint32_t label = lib->names.size();
+        lib->names.push_back(std::string(argv[a], eq - argv[a]));
+
+        size_t used = 0;
+        for (size_t r = 0; r < reader.numRecords(); r++) {
+            const PoseTrackRecord* rec = reader.record(r);
+            if ((rec->valid_mask & all) != all) continue;
+            lib->poses.resize(lib->poses.size() + dim);
+            if (!normalizePose(poseTrackJoints(rec), all, *num_joints, aspect, &lib->poses[lib->poses.size() - dim])) {
+                lib->poses.resize(lib->poses.size() - dim);
+                continue;
+            }
+            lib->labels.push_back(label);
+            used++;
+        }
+        printf("%s: %zu of %zu records\n", argv[a], used, reader.numRecords());
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* path = "/tmp/pose-index-bench.wpix";
+    float aspect = 1.0f;
+    size_t k = 5;
+    int a = 1;
+    for (; a + 1 < argc && argv[a][0] == '-'; a += 2) {
+        if (!strcmp(argv[a], "-o")) path = argv[a + 1];
+        else if (!strcmp(argv[a], "-a")) aspect = (float) atof(argv[a + 1]);
+        else if (!strcmp(argv[a], "-k")) k = std::max(atoi(argv[a + 1]), 1);
+    }
+
+    Library lib;
+    unsigned int num_joints = NUM_JOINTS;
+    if (a < argc) {
+        if (!trackLibrary(argc, argv, a, aspect, &lib, &num_joints)) return 1;
+    } else {
+        lib = syntheticLibrary(42000);
+    }
+    const size_t dim = poseIndexDim(num_joints);
+
+    // hold out every 20th pose as a query
+    Library refs;
+    std::vector<float> queries;
+    std::vector<uint32_t> query_labels;
+    for (size_t i = 0; i < lib.labels.size(); i++) {
+        if (i % 20 == 19) {
+            queries.insert(queries.end(), &lib.poses[i * dim], &lib.poses[i * dim] + dim);
+            query_labels.push_back(lib.labels[i]);
+        } else {
+            refs.poses.insert(refs.poses.end(), &lib.poses[i * dim], &lib.poses[i * dim] + dim);
+            refs.labels.push_back(lib.labels[i]);
+        }
+    }
+    const size_t num_queries = query_labels.size();
+    if (num_queries == 0) {
+        fprintf(stderr, "not enough poses\n");
+        return 1;
+    }
+
+    auto start = Clock::now();
+    if (!buildPoseIndex(path, refs.poses.data(), refs.labels.data(), refs.labels.size(), num_joints, lib.names)) {
+        fprintf(stderr, "can't write %s\n", path);
+        return 1;
+    }
+    const double build_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    PoseIndex index;
+    start = Clock::now();
+    if (!index.open(path)) {
+        fprintf(stderr, "can't open %s\n", path);
+        return 1;
+    }
+    const double open_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    printf("%zu reference poses, %zu labels, %zu queries: built in %.0f ms, opened in %.0f us (%s)\n",
+           index.size(), index.numLabels(), num_queries, build_ms, open_us, path);
+
+    std::vector<PoseMatch> exact(num_queries * k), found(k);
+    start = Clock::now();
+    for (size_t q = 0; q < num_queries; q++) {
+        index.searchFlat(&queries[q * dim], k, &exact[q * k]);
+    }
+    const double flat_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / num_queries;
+
+    size_t label_hits = 0;
+    for (size_t q = 0; q < num_queries; q++) label_hits += exact[q * k].label == query_labels[q];
+    printf("  full scan        %7.1f us/query, recall@%zu 1.000, top-1 label %.3f\n",
+           flat_us, k, (double) label_hits / num_queries);
+
+    bool ok = true;
+    for (size_t max_leaves : { 0, 256, 64, 16, 4 }) {
+        std::vector<double> times(num_queries);
+        size_t hits = 0;
+        label_hits = 0;
+        for (size_t q = 0; q < num_queries; q++) {
+            start = Clock::now();
+            const size_t n = index.search(&queries[q * dim], k, found.data(), max_leaves);
+            times[q] = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            for (size_t i = 0; i < n; i++) {
+                for (size_t e = 0; e < k; e++) {
+                    if (found[i].id == exact[q * k + e].id) {
+                        hits++;
+                        break;
+                    }
+                }
+            }
+            label_hits += n > 0 && found[0].label == query_labels[q];
+        }
+        std::sort(times.begin(), times.end());
+        double mean = 0;
+        for (double t : times) mean += t;
+        mean /= num_queries;
+        const double recall = (double) hits / (num_queries * k);
+
+        char name[32];
+        if (max_leaves == 0) snprintf(name, sizeof(name), "tree, exact");
+        else snprintf(name, sizeof(name), "tree, %zu leaves", max_leaves);
+        printf("  %-16s %7.1f us/query (p99 %.1f), recall@%zu %.3f, top-1 label %.3f\n", name, mean,
+               times[num_queries * 99 / 100], k, recall, (double) label_hits / num_queries);
+        if (max_leaves == 0 && recall < 0.9999) ok = false;
+    }
+
+    // Partial queries keep the neighbours of their full pose in truth to measure how much of
+    // the person's actual neighbourhood each search recovers from the joints left.
+    std::vector<PoseMatch> truth = exact;
+    std::vector<size_t> origin(num_queries);
+    const uint32_t all = num_joints >= 32 ? 0xffffffff : (1u << num_joints) - 1;
+    uint32_t legs = 0;
+    if (num_joints == NUM_JOINTS) {
+        for (int j : { RKNEE, LKNEE, RANKLE, LANKLE, RFOOT, LFOOT }) legs |= 1u << j;
+    }
+    std::mt19937 rng(5);
+    std::vector<float> partial(num_queries * dim);
+    std::vector<uint32_t> masks(num_queries);
+    size_t num_partial = 0;
+    for (size_t q = 0; q < num_queries; q++) {
+        uint32_t mask = all;
+        if (q % 3 == 0 && legs) {
+            mask &= ~legs;
+        } else {
+            for (size_t d = 1 + rng() % 4; d > 0; d--) mask &= ~(1u << (rng() % num_joints));
+        }
+        if (normalizePose(&queries[q * dim], mask, num_joints, 1.0f, &partial[num_partial * dim])) {
+            masks[num_partial] = mask;
+            origin[num_partial] = q;
+            query_labels[num_partial] = query_labels[q];
+            num_partial++;
+        }
+    }
+
+    auto countHits = [&](const PoseMatch* got, size_t n, const PoseMatch* want) {
+        size_t hits = 0;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t e = 0; e < k; e++) {
+                if (got[i].id == want[e].id) {
+                    hits++;
+                    break;
+                }
+            }
+        }
+        return hits;
+    };
+
+    start = Clock::now();
+    for (size_t q = 0; q < num_partial; q++) {
+        index.searchFlat(&partial[q * dim], k, &exact[q * k], masks[q]);
+    }
+    const double partial_flat_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / num_partial;
+    size_t flat_truth_hits = 0;
+    label_hits = 0;
+    for (size_t q = 0; q < num_partial; q++) {
+        flat_truth_hits += countHits(&exact[q * k], k, &truth[origin[q] * k]);
+        label_hits += exact[q * k].label == query_labels[q];
+    }
+    const double flat_truth_recall = (double) flat_truth_hits / (num_partial * k);
+    printf("partial queries, %zu:\n  full scan        %7.1f us/query, recall@%zu 1.000, full pose %.3f, top-1 label %.3f\n",
+           num_partial, partial_flat_us, k, flat_truth_recall, (double) label_hits / num_partial);
+
+    for (size_t max_leaves : { 0, 64, 16 }) {
+        size_t hits = 0;
+        size_t truth_hits = 0;
+        label_hits = 0;
+        double total_us = 0.0;
+        for (size_t q = 0; q < num_partial; q++) {
+            start = Clock::now();
+            const size_t n = index.search(&partial[q * dim], k, found.data(), max_leaves, masks[q]);
+            total_us += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            hits += countHits(found.data(), n, &exact[q * k]);
+            truth_hits += countHits(found.data(), n, &truth[origin[q] * k]);
+            label_hits += n > 0 && found[0].label == query_labels[q];
+        }
+        const double truth_recall = (double) truth_hits / (num_partial * k);
+
+        char name[32];
+        if (max_leaves == 0) snprintf(name, sizeof(name), "tree, completed");
+        else snprintf(name, sizeof(name), "tree, %zu leaves", max_leaves);
+        printf("  %-16s %7.1f us/query, recall@%zu %.3f, full pose %.3f, top-1 label %.3f\n", name,
+               total_us / num_partial, k, (double) hits / (num_partial * k), truth_recall,
+               (double) label_hits / num_partial);
+        if (max_leaves == 0 && truth_recall < 0.9 * flat_truth_recall) ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+// Host benchmark for the display rate pose resampler.
+//
+// Smoothness: a swinging synthetic skeleton is estimated at 15 fps, each frame available
+// 50 ms after capture, and drawn at 120 Hz. Reports the distance to the true pose at display
+// time and the p99 jump between consecutive vsyncs, for drawing the last frame as is (what
+// the overlay does without resampling), extrapolating from it and interpolating one
+// inference interval behind.
+//
+// Concurrency: a writer thread pushes frames as fast as it can while readers sample; every
+// sample must come from one consistent set of frames. Reports the cost per sample and how
+// often a read had to be repeated.
+//
+// Exits non-zero on a torn read or if interpolation jumps more than drawing the last frame.
+//
+//   pose-resampler-bench [readers] [seconds]
+
+#include "../pose-resampler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const unsigned int NUM_JOINTS = 23;
+
+static void truePose(int64_t t_us, float* joints) {
+    const float t = t_us * 1e-6f;
+    const float swing = std::sin(t * 6.0f);
+    for (unsigned int j = 0; j < NUM_JOINTS; j++) {
+        const float limb = (j % 4) * 0.05f;
+        joints[j * 2] = 0.5f + 0.1f * std::sin(t * 0.3f) + (j % 2 ? 1 : -1) * limb * swing;
+        joints[j * 2 + 1] = 0.3f + 0.02f * j + 0.5f * limb * std::cos(t * 6.0f);
+    }
+}
+
+struct Track {
+    std::vector<float> error_px;
+    std::vector<float> jump_px;
+    std::vector<float> last;
+
+    void add(const float* joints, const float* truth, float width, float height) {
+        float err = 0, jump = 0;
+        for (unsigned int j = 0; j < NUM_JOINTS; j++) {
+            err += std::hypot((joints[j * 2] - truth[j * 2]) * width, (joints[j * 2 + 1] - truth[j * 2 + 1]) * height);
+            if (!last.empty()) {
+                jump = std::max(jump, std::hypot((joints[j * 2] - last[j * 2]) * width, (joints[j * 2 + 1] - last[j * 2 + 1]) * height));
+            }
+        }
+        error_px.push_back(err / NUM_JOINTS);
+        if (!last.empty()) jump_px.push_back(jump);
+        last.assign(joints, joints + NUM_JOINTS * 2);
+    }
+
+    double meanError() const {
+        double sum = 0;
+        for (float e : error_px) sum += e;
+        return sum / error_px.size();
+    }
+
+    float p99Jump() {
+        std::sort(jump_px.begin(), jump_px.end());
+        return jump_px[jump_px.size() * 99 / 100];
+    }
+};
+
+// p99 vsync jump of interpolation, to compare with drawing the last frame.
+static bool smoothness(double seconds) {
+    const float width = 1920, height = 1080;
+    const int64_t frame_us = 66667, latency_us = 50000, vsync_us = 8333;
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> jitter(-3000, 3000);
+    std::normal_distribution<float> noise(0.0f, 0.001f);
+
+    PoseResampler extrapolated, interpolated;
+    Track hold, extra, inter;
+    std::vector<float> frame(NUM_JOINTS * 2), last(NUM_JOINTS * 2), truth(NUM_JOINTS * 2), out(NUM_JOINTS * 2);
+    bool have_last = false;
+    int64_t next_capture = 0, capture = 0;
+    int64_t next_arrival = latency_us;
+    const uint32_t all = (1u << NUM_JOINTS) - 1;
+
+    for (int64_t t = 0; t < (int64_t) (seconds * 1e6); t += vsync_us) {
+        while (next_arrival <= t) {
+            capture = next_capture;
+            truePose(capture, frame.data());
+            for (float& v : frame) v += noise(rng);
+            extrapolated.push(0, capture, frame.data(), all, NUM_JOINTS);
+            interpolated.push(0, capture, frame.data(), all, NUM_JOINTS);
+            last = frame;
+            have_last = true;
+            next_capture += frame_us;
+            next_arrival = next_capture + latency_us + jitter(rng);
+        }
+        if (!have_last) continue;
+
+        truePose(t, truth.data());
+        hold.add(last.data(), truth.data(), width, height);
+
+        uint32_t mask;
+        int id;
+        unsigned int n;
+        extrapolated.sample(t, 100000, out.data(), &mask, &id, &n);
+        extra.add(out.data(), truth.data(), width, height);
+        interpolated.sample(t - latency_us - frame_us, 0, out.data(), &mask, &id, &n);
+        inter.add(out.data(), truth.data(), width, height);
+    }
+
+    const float hold_jump = hold.p99Jump(), inter_jump = inter.p99Jump();
+    printf("15 fps estimate drawn at 120 Hz, 50 ms latency:\n");
+    printf("  last frame      mean error %6.1f px, p99 jump %5.1f px\n", hold.meanError(), hold_jump);
+    printf("  extrapolated    mean error %6.1f px, p99 jump %5.1f px\n", extra.meanError(), extra.p99Jump());
+    printf("  interpolated    mean error %6.1f px, p99 jump %5.1f px\n", inter.meanError(), inter_jump);
+    return inter_jump < hold_jump;
+}
+
+// Frames on a straight line: every joint of frame k is at (k, -k), so any sample mixing two
+// pushes shows as joints that disagree.
+static bool concurrency(int readers, double seconds) {
+    PoseResampler resampler;
+    {
+        // uncontended, with a full ring
+        float joints[PoseResampler::MAX_JOINTS * 2] = {};
+        for (int64_t k = 0; k < (int64_t) PoseResampler::DEPTH; k++) {
+            resampler.push(0, k * 66667, joints, (1u << NUM_JOINTS) - 1, NUM_JOINTS);
+        }
+        uint32_t mask;
+        int id;
+        unsigned int n;
+        const long count = 1000000;
+        const auto start = Clock::now();
+        for (long i = 0; i < count; i++) {
+            resampler.sample(100000 + i % 100000, 0, joints, &mask, &id, &n);
+        }
+        printf("uncontended: %.0f ns/sample\n", std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count);
+        resampler.clear();
+    }
+    std::atomic<bool> stop(false);
+    std::atomic<long> torn(0), samples(0);
+    std::atomic<int64_t> newest(-1);
+
+    std::thread writer([&] {
+        std::vector<float> joints(NUM_JOINTS * 2);
+        for (int64_t k = 0; !stop.load(std::memory_order_relaxed); k++) {
+            for (unsigned int j = 0; j < NUM_JOINTS; j++) {
+                joints[j * 2] = (float) (k % 100000);
+                joints[j * 2 + 1] = -(float) (k % 100000);
+            }
+            // restart on wrap so the line stays straight
+            if (k % 100000 == 0) resampler.clear();
+            resampler.push(0, (k % 100000) * 1000, joints.data(), (1u << NUM_JOINTS) - 1, NUM_JOINTS);
+            newest.store((k % 100000) * 1000, std::memory_order_relaxed);
+        }
+    });
+
+    double total_ns = 0;
+    std::vector<std::thread> threads;
+    std::vector<double> reader_ns(readers);
+    for (int r = 0; r < readers; r++) {
+        threads.emplace_back([&, r] {
+            float joints[PoseResampler::MAX_JOINTS * 2];
+            uint32_t mask;
+            int id;
+            unsigned int n;
+            long count = 0;
+            const auto start = Clock::now();
+            while (!stop.load(std::memory_order_relaxed)) {
+                const int64_t t = newest.load(std::memory_order_relaxed) - 1500;
+                if (!resampler.sample(t, 0, joints, &mask, &id, &n)) continue;
+                count++;
+                for (unsigned int j = 1; j < n; j++) {
+                    if (joints[j * 2] != joints[0] || joints[j * 2 + 1] != joints[1] || joints[1] != -joints[0]) {
+                        torn++;
+                        break;
+                    }
+                }
+            }
+            reader_ns[r] = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / std::max(count, 1L);
+            samples += count;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    writer.join();
+    for (std::thread& t : threads) t.join();
+    for (double ns : reader_ns) total_ns += ns;
+
+    printf("%d readers against a writer pushing nonstop: %ld samples, %.0f ns/sample, %llu retries, %ld torn\n",
+           readers, samples.load(), total_ns / readers, (unsigned long long) resampler.retries(), torn.load());
+    return torn == 0;
+}
+
+int main(int argc, char** argv) {
+    const int readers = argc > 1 ? atoi(argv[1]) : 2;
+    const double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+
+    bool ok = smoothness(60.0);
+    ok = concurrency(readers, seconds) && ok;
+    return ok ? 0 : 1;
+}
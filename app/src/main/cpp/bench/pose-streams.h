@@ -0,0 +1,45 @@
+#ifndef BENCH_POSE_STREAMS_H
+#define BENCH_POSE_STREAMS_H
+
+// Pose streams for the host benchmarks: one tracked person's frames in flat arrays, loaded
+// from recorded pose tracks.
+
+#include "../pose-track.h"
+
+#include <cstdio>
+#include <map>
+#include <vector>
+
+struct Stream {
+    unsigned int num_joints;
+    std::vector<int64_t> timestamps;
+    std::vector<float> joints;
+    std::vector<float> scores;
+    std::vector<uint32_t> masks;
+
+    size_t size() const { return timestamps.size(); }
+};
+
+// One stream per tracker id of a recorded .wptk track.
+inline std::map<int, Stream> recordedStreams(const char* path) {
+    std::map<int, Stream> streams;
+    PoseTrackReader reader;
+    if (!reader.open(path)) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return streams;
+    }
+
+    const unsigned int n = reader.numJoints();
+    for (size_t i = 0; i < reader.numRecords(); i++) {
+        const PoseTrackRecord* r = reader.record(i);
+        Stream& s = streams[r->id];
+        s.num_joints = n;
+        s.timestamps.push_back(r->timestamp_us);
+        s.joints.insert(s.joints.end(), poseTrackJoints(r), poseTrackJoints(r) + n * 2);
+        s.scores.insert(s.scores.end(), poseTrackScores(r, n), poseTrackScores(r, n) + n);
+        s.masks.push_back(r->valid_mask);
+    }
+    return streams;
+}
+
+#endif // BENCH_POSE_STREAMS_H
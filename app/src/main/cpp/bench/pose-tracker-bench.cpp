@@ -0,0 +1,183 @@
+// Host benchmark for the native multi-person tracker: people walking and crossing in front of
+// the camera at 60 fps, with joint noise, dropped joints, missed detections and shuffled
+// detection order. Reports the cost per frame and id switches against ground truth, next to a
+// greedy best-IoU association as a baseline. Exits non-zero if the tracker is slower than
+// a 60 fps frame budget allows for, or switches ids more often than the baseline.
+//
+//   pose-tracker-bench [people] [seconds]
+//
+// The library's own tracker runs inside wrPoseEstimator_ProcessFrame and can't be timed on a
+// host; on device compare getProcessTimingJNI with tracking on and off.
+
+#include "../pose-tracker.h"
+#include "../pose2d-ref.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const unsigned int NUM_JOINTS = 23;
+
+struct Person {
+    float x, y;                     // box center
+    float vx, vy;                   // per second
+    float w, h;
+    std::vector<float> offsets;     // joint positions relative to the box, 0..1
+};
+
+struct Frame {
+    std::vector<float> boxes;       // 4 per detection
+    std::vector<float> joints;
+    std::vector<uint32_t> masks;
+    std::vector<int> truth;         // person per detection
+};
+
+static std::vector<Frame> simulate(size_t people, double seconds, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+
+    std::vector<Person> crowd(people);
+    for (Person& p : crowd) {
+        p.x = 0.1f + 0.8f * uni(rng);
+        p.y = 0.3f + 0.4f * uni(rng);
+        p.vx = (uni(rng) - 0.5f) * 0.4f;
+        p.vy = (uni(rng) - 0.5f) * 0.1f;
+        p.h = 0.25f + 0.2f * uni(rng);
+        p.w = p.h * 0.4f;
+        for (unsigned int j = 0; j < NUM_JOINTS * 2; j++) p.offsets.push_back(0.1f + 0.8f * uni(rng));
+    }
+
+    const float dt = 1.0f / 60.0f;
+    std::vector<Frame> frames;
+    std::vector<size_t> order(people);
+    for (double t = 0; t < seconds; t += dt) {
+        Frame f;
+        for (size_t i = 0; i < people; i++) order[i] = i;
+        std::shuffle(order.begin(), order.end(), rng);
+        for (size_t i : order) {
+            Person& p = crowd[i];
+            p.vx += noise(rng) * 0.02f;
+            p.x += p.vx * dt;
+            p.y += p.vy * dt;
+            if (p.x < 0.05f || p.x > 0.95f) p.vx = -p.vx;
+            if (p.y < 0.25f || p.y > 0.75f) p.vy = -p.vy;
+            if (uni(rng) < 0.03f) continue;     // missed detection
+
+            const float bx = p.x - p.w * 0.5f + noise(rng) * 0.003f;
+            const float by = p.y - p.h * 0.5f + noise(rng) * 0.003f;
+            f.boxes.insert(f.boxes.end(), { bx, by, p.w, p.h });
+            uint32_t mask = 0;
+            for (unsigned int j = 0; j < NUM_JOINTS; j++) {
+                f.joints.push_back(bx + p.offsets[j * 2] * p.w + noise(rng) * 0.004f);
+                f.joints.push_back(by + p.offsets[j * 2 + 1] * p.h + noise(rng) * 0.004f);
+                if (uni(rng) > 0.1f) mask |= 1u << j;
+            }
+            f.masks.push_back(mask);
+            f.truth.push_back((int) i);
+        }
+        frames.push_back(f);
+    }
+    return frames;
+}
+
+struct Result {
+    double us_per_frame;
+    double p99_us;
+    int switches;
+};
+
+static Result summarize(std::vector<double>& times, int switches) {
+    double total = 0;
+    for (double t : times) total += t;
+    std::sort(times.begin(), times.end());
+    return { total / times.size(), times[times.size() * 99 / 100], switches };
+}
+
+// Counts how often a person's id changes from one detection of them to the next.
+struct SwitchCounter {
+    std::map<int, int> last_id;
+    int switches = 0;
+
+    void add(int person, int id) {
+        auto it = last_id.find(person);
+        if (it != last_id.end() && it->second != id) switches++;
+        last_id[person] = id;
+    }
+};
+
+static Result runTracker(const std::vector<Frame>& frames) {
+    PoseTracker tracker(NUM_JOINTS, 64);
+    SwitchCounter counter;
+    std::vector<TrackerDetection> dets;
+    std::vector<int> ids;
+    std::vector<double> times;
+    int64_t t_us = 0;
+    for (const Frame& f : frames) {
+        const size_t n = f.truth.size();
+        dets.resize(n);
+        ids.resize(n);
+        for (size_t d = 0; d < n; d++) {
+            dets[d].bbox = &f.boxes[d * 4];
+            dets[d].joints = &f.joints[d * NUM_JOINTS * 2];
+            dets[d].valid_mask = f.masks[d];
+        }
+        const auto start = Clock::now();
+        tracker.update(t_us, dets.data(), n, ids.data());
+        times.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        for (size_t d = 0; d < n; d++) counter.add(f.truth[d], ids[d]);
+        t_us += 16667;
+    }
+    return summarize(times, counter.switches);
+}
+
+// Baseline: each detection takes the id of the best overlapping box of the previous frame,
+// greedily, with no memory of people missed for a frame.
+static Result runGreedy(const std::vector<Frame>& frames) {
+    SwitchCounter counter;
+    std::vector<Pose2dRef> previous, current;
+    int next_id = 0;
+    std::vector<double> times;
+    for (const Frame& f : frames) {
+        const auto start = Clock::now();
+        current.clear();
+        for (size_t d = 0; d < f.truth.size(); d++) {
+            Pose2dRef ref;
+            std::copy(&f.boxes[d * 4], &f.boxes[d * 4] + 4, ref.bbox);
+            ref.id = matchPose2dRef(ref.bbox, previous);
+            if (ref.id < 0) ref.id = next_id++;
+            previous.erase(std::remove_if(previous.begin(), previous.end(),
+                                          [&](const Pose2dRef& p) { return p.id == ref.id; }), previous.end());
+            current.push_back(ref);
+        }
+        previous.swap(current);
+        times.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        for (size_t d = 0; d < f.truth.size(); d++) counter.add(f.truth[d], previous[d].id);
+    }
+    return summarize(times, counter.switches);
+}
+
+int main(int argc, char** argv) {
+    const size_t people = argc > 1 ? atoi(argv[1]) : 20;
+    const double seconds = argc > 2 ? atof(argv[2]) : 60.0;
+
+    bool ok = true;
+    for (unsigned int seed : { 1, 2, 3 }) {
+        const std::vector<Frame> frames = simulate(people, seconds, seed);
+        const Result tracker = runTracker(frames);
+        const Result greedy = runGreedy(frames);
+        printf("seed %u, %zu people, %zu frames: tracker %.1f us/frame (p99 %.0f), %d id switches; "
+               "greedy IoU %.1f us/frame, %d id switches\n",
+               seed, people, frames.size(), tracker.us_per_frame, tracker.p99_us, tracker.switches,
+               greedy.us_per_frame, greedy.switches);
+        if (tracker.us_per_frame > 1000.0 || tracker.switches > greedy.switches) ok = false;
+    }
+    return ok ? 0 : 1;
+}
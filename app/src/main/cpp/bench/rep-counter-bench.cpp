@@ -0,0 +1,158 @@
+// Host benchmark for the rep counter on synthetic periodic pose tracks: jumping jacks and
+// lunges at varying tempo with joint noise, dropped joints and timestamp jitter. Reports
+// counted against true repetitions and the cost per frame; exits non-zero on a miscount.
+
+#include "../rep-counter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// j23 joint indices
+enum {
+    RANKLE = 0, RKNEE, RHIP, LHIP, LKNEE, LANKLE, PELV, THRX, NECK, HEAD,
+    RWRIST, RELBOW, RSHOULDER, LSHOULDER, LELBOW, LWRIST, NUM_JOINTS = 23
+};
+
+struct Exercise {
+    const char* name;
+    RepCounterConfig config;
+    // fills joints for cycle phase (0..1 per repetition, 0 at rest)
+    void (*pose)(float phase, float* joints);
+};
+
+static void setJoint(float* joints, int j, float x, float y) {
+    joints[j * 2] = x;
+    joints[j * 2 + 1] = y;
+}
+
+static void standing(float* joints) {
+    for (int j = 0; j < NUM_JOINTS; j++) setJoint(joints, j, 0.5f, 0.5f);
+    setJoint(joints, HEAD, 0.5f, 0.15f);
+    setJoint(joints, NECK, 0.5f, 0.22f);
+    setJoint(joints, THRX, 0.5f, 0.3f);
+    setJoint(joints, PELV, 0.5f, 0.5f);
+    setJoint(joints, RSHOULDER, 0.45f, 0.25f);
+    setJoint(joints, LSHOULDER, 0.55f, 0.25f);
+    setJoint(joints, RHIP, 0.46f, 0.5f);
+    setJoint(joints, LHIP, 0.54f, 0.5f);
+}
+
+// arms swing from the sides to overhead, legs apart
+static void jumpingJack(float phase, float* joints) {
+    standing(joints);
+    const float lift = 0.5f - 0.5f * std::cos(phase * 6.2831853f);     // 0 at rest, 1 at the top
+    const float a = 0.15f + lift * 2.8f;                                // arm angle from straight down
+    const float r = 0.12f;
+    setJoint(joints, RELBOW, 0.45f - std::sin(a) * r * 0.5f, 0.25f + std::cos(a) * r * 0.5f);
+    setJoint(joints, RWRIST, 0.45f - std::sin(a) * r, 0.25f + std::cos(a) * r);
+    setJoint(joints, LELBOW, 0.55f + std::sin(a) * r * 0.5f, 0.25f + std::cos(a) * r * 0.5f);
+    setJoint(joints, LWRIST, 0.55f + std::sin(a) * r, 0.25f + std::cos(a) * r);
+    const float spread = 0.02f + lift * 0.08f;
+    setJoint(joints, RKNEE, 0.46f - spread * 0.5f, 0.68f);
+    setJoint(joints, RANKLE, 0.46f - spread, 0.86f);
+    setJoint(joints, LKNEE, 0.54f + spread * 0.5f, 0.68f);
+    setJoint(joints, LANKLE, 0.54f + spread, 0.86f);
+}
+
+// alternating lunges: the front knee bends to about 90 degrees and straightens again
+static void lunge(float phase, float* joints) {
+    standing(joints);
+    setJoint(joints, RELBOW, 0.44f, 0.35f);
+    setJoint(joints, RWRIST, 0.44f, 0.45f);
+    setJoint(joints, LELBOW, 0.56f, 0.35f);
+    setJoint(joints, LWRIST, 0.56f, 0.45f);
+    const float bend = 0.5f - 0.5f * std::cos(phase * 6.2831853f);
+    const float k = bend * 1.45f;                                       // knee bend in radians
+    const float thigh = 0.18f, shin = 0.18f;
+    // front leg, alternating sides by rep parity handled by the caller through phase > 1
+    const bool right = std::fmod(phase, 2.0f) < 1.0f;
+    const int hip = right ? RHIP : LHIP, knee = right ? RKNEE : LKNEE, ankle = right ? RANKLE : LANKLE;
+    const int bhip = right ? LHIP : RHIP, bknee = right ? LKNEE : RKNEE, bankle = right ? LANKLE : RANKLE;
+    const float hx = joints[hip * 2], hy = joints[hip * 2 + 1];
+    const float kx = hx + std::sin(k * 0.7f) * thigh * 0.6f, ky = hy + std::cos(k * 0.7f) * thigh;
+    setJoint(joints, knee, kx, ky);
+    setJoint(joints, ankle, kx - std::sin(k * 0.3f) * shin * 0.2f, ky + shin);
+    setJoint(joints, bknee, joints[bhip * 2] - bend * 0.05f, 0.68f);
+    setJoint(joints, bankle, joints[bhip * 2] - bend * 0.1f, 0.86f);
+}
+
+static bool run(const Exercise& ex, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 0.004f);
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+    std::uniform_int_distribution<int> jitter(-3000, 3000);
+
+    RepCounter counter;
+    counter.configure(ex.config);
+
+    // 3 s standing, then 40 reps with the tempo drifting between 0.7 and 1.6 s per rep
+    const int true_reps = 40;
+    std::vector<float> joints(NUM_JOINTS * 2);
+    double phase = -3.0 / 1.2;
+    int64_t t_us = 0;
+    size_t frames = 0;
+    double update_ns = 0;
+    while (phase < true_reps + 0.5) {
+        const double period = 1.15 + 0.45 * std::sin(t_us * 1e-6 * 0.2);
+        ex.pose(phase < 0 || phase > true_reps ? 0.0f : (float) phase, joints.data());
+        uint32_t mask = 0;
+        for (int j = 0; j < NUM_JOINTS; j++) {
+            joints[j * 2] += noise(rng);
+            joints[j * 2 + 1] += noise(rng);
+            if (uni(rng) > 0.02f) mask |= 1u << j;
+        }
+
+        auto start = Clock::now();
+        counter.update(1, t_us + jitter(rng), joints.data(), mask, 16.0f / 9.0f);
+        update_ns += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        frames++;
+
+        t_us += 33333;
+        phase += 0.033333 / period;
+    }
+
+    RepEvent events[RepCounter::MAX_PENDING_EVENTS];
+    const size_t n = counter.drainEvents(events, RepCounter::MAX_PENDING_EVENTS);
+    float min_conf = 1.0f, sum_conf = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        min_conf = std::min(min_conf, events[i].confidence);
+        sum_conf += events[i].confidence;
+    }
+
+    printf("%-14s %d reps, counted %d, confidence mean %.2f min %.2f, %.0f ns/frame over %zu frames\n",
+           ex.name, true_reps, counter.count(), n ? sum_conf / n : 0.0f, n ? min_conf : 0.0f,
+           update_ns / frames, frames);
+    if (getenv("REP_DEBUG")) for (size_t i = 0; i < n; i++) printf("  %.2f-%.2f amp %.1f conf %.2f\n", events[i].start_us * 1e-6, events[i].end_us * 1e-6, events[i].amplitude_deg, events[i].confidence);
+    return counter.count() == true_reps;
+}
+
+int main() {
+    Exercise jacks;
+    jacks.name = "jumping jacks";
+    jacks.config.angles = { { RHIP, RSHOULDER, RELBOW }, { LHIP, LSHOULDER, LELBOW } };
+    jacks.config.combine = RepCounterConfig::MEAN;
+    jacks.config.rest_high = false;
+    jacks.config.min_amplitude_deg = 60.0f;
+    jacks.pose = jumpingJack;
+
+    Exercise lunges;
+    lunges.name = "lunges";
+    lunges.config.angles = { { RHIP, RKNEE, RANKLE }, { LHIP, LKNEE, LANKLE } };
+    lunges.config.combine = RepCounterConfig::MIN;
+    lunges.config.rest_high = true;
+    lunges.config.min_amplitude_deg = 35.0f;
+    lunges.pose = lunge;
+
+    bool ok = true;
+    for (unsigned int seed = 1; seed <= 3; seed++) {
+        ok &= run(jacks, seed);
+        ok &= run(lunges, seed);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+// Host benchmark for the skeleton kernels: bone vectors, lengths and joint angles of many j23
+// poses, naive per-pose scalar loops over interleaved joints against the SoA kernels with
+// the compile time and the runtime topology.
+
+#include "../skeleton-kernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double nsPerPose(Clock::time_point start, size_t poses, int reps) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ((double) poses * reps);
+}
+
+// the naive reference: one pose at a time, one bone and angle at a time
+static void naive(const float* joints, size_t count, const unsigned int* pairs, size_t num_bones,
+                  const JointAngleDef* angles, size_t num_angles, float aspect,
+                  float* dx, float* dy, float* len, float* ang) {
+    const unsigned int num_joints = 23;
+    for (size_t p = 0; p < count; p++) {
+        const float* j = joints + p * num_joints * 2;
+        for (size_t b = 0; b < num_bones; b++) {
+            const float vx = (j[pairs[b * 2 + 1] * 2] - j[pairs[b * 2] * 2]) * aspect;
+            const float vy = j[pairs[b * 2 + 1] * 2 + 1] - j[pairs[b * 2] * 2 + 1];
+            dx[p * num_bones + b] = vx;
+            dy[p * num_bones + b] = vy;
+            len[p * num_bones + b] = std::sqrt(vx * vx + vy * vy);
+        }
+        for (size_t i = 0; i < num_angles; i++) {
+            const JointAngleDef& a = angles[i];
+            const float ux = (j[a.a * 2] - j[a.b * 2]) * aspect, uy = j[a.a * 2 + 1] - j[a.b * 2 + 1];
+            const float vx = (j[a.c * 2] - j[a.b * 2]) * aspect, vy = j[a.c * 2 + 1] - j[a.b * 2 + 1];
+            ang[p * num_angles + i] = std::atan2(std::fabs(ux * vy - uy * vx), ux * vx + uy * vy);
+        }
+    }
+}
+
+int main() {
+    const unsigned int num_joints = 23;
+    const float aspect = 16.0f / 9.0f;
+    const unsigned int* pairs = TopologyTraits<J23Topology>::pairs();
+    const size_t num_bones = TopologyTraits<J23Topology>::NUM_BONES;
+    // elbows, shoulders, hips, knees, ankles
+    const JointAngleDef angles[] = {
+        { 10, 11, 12 }, { 13, 14, 15 }, { 11, 12, 2 }, { 14, 13, 3 }, { 12, 2, 1 }, { 13, 3, 4 },
+        { 2, 1, 0 }, { 3, 4, 5 }, { 1, 0, 21 }, { 4, 5, 22 },
+    };
+    const size_t num_angles = sizeof(angles) / sizeof(angles[0]);
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+
+    for (size_t count : { 16, 256, 4096 }) {
+        std::vector<float> joints(count * num_joints * 2);
+        for (auto& v : joints) v = uni(rng);
+        std::vector<uint32_t> masks(count, 0x7fffff);
+
+        const size_t stride = (count + 3) & ~(size_t) 3;
+        std::vector<float> x(num_joints * stride), y(num_joints * stride);
+        std::vector<float> dx(num_bones * stride), dy(num_bones * stride), len(num_bones * stride), ang(num_angles * stride);
+        std::vector<float> ndx(count * num_bones), ndy(count * num_bones), nlen(count * num_bones), nang(count * num_angles);
+
+        const int reps = (int) std::max<size_t>(1, 2000000 / count);
+        PoseBatch batch = { x.data(), y.data(), masks.data(), count, stride };
+        BoneFeatures bones = { dx.data(), dy.data(), len.data(), stride };
+
+        auto start = Clock::now();
+        for (int r = 0; r < reps; r++) {
+            naive(joints.data(), count, pairs, num_bones, angles, num_angles, aspect,
+                  ndx.data(), ndy.data(), nlen.data(), nang.data());
+        }
+        const double naive_ns = nsPerPose(start, count, reps);
+
+        start = Clock::now();
+        for (int r = 0; r < reps; r++) {
+            transposePoses(joints.data(), count, num_joints, x.data(), y.data(), stride);
+        }
+        const double transpose_ns = nsPerPose(start, count, reps);
+
+        start = Clock::now();
+        for (int r = 0; r < reps; r++) {
+            computeBones(pairs, num_bones, batch, bones, aspect);
+            computeJointAngles(angles, num_angles, batch, ang.data(), stride, aspect);
+        }
+        const double runtime_ns = nsPerPose(start, count, reps);
+
+        start = Clock::now();
+        for (int r = 0; r < reps; r++) {
+            computeBones<J23Topology>(batch, bones, aspect);
+            computeJointAngles(angles, num_angles, batch, ang.data(), stride, aspect);
+        }
+        const double templated_ns = nsPerPose(start, count, reps);
+
+        float max_len_err = 0.0f, max_angle_err = 0.0f;
+        for (size_t p = 0; p < count; p++) {
+            for (size_t b = 0; b < num_bones; b++) {
+                max_len_err = std::max(max_len_err, std::fabs(len[b * stride + p] - nlen[p * num_bones + b]));
+            }
+            for (size_t i = 0; i < num_angles; i++) {
+                max_angle_err = std::max(max_angle_err, std::fabs(ang[i * stride + p] - nang[p * num_angles + i]));
+            }
+        }
+
+        printf("%5zu poses, %zu bones + %zu angles: naive %6.1f ns/pose, SoA runtime %6.1f (%.2fx), "
+               "SoA j23 template %6.1f (%.2fx), transpose %5.1f ns/pose, max err length %.1e angle %.1e rad\n",
+               count, num_bones, num_angles, naive_ns, runtime_ns, naive_ns / runtime_ns,
+               templated_ns, naive_ns / templated_ns, transpose_ns, max_len_err, max_angle_err);
+    }
+    return 0;
+}
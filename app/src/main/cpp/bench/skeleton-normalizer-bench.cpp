@@ -0,0 +1,292 @@
+// Host benchmark for skeleton normalization: checks the SoA kernels against a plain per pose
+// implementation for every mode, checks that normalization undoes translation, scale,
+// rotation and facing away from the camera, and times per pose cost and the threaded
+// batch mode over a recorded track. Exits non-zero on a mismatch.
+//
+//   skeleton-normalizer-bench [poses] [threads]
+//
+// The skeleton is j23 in the joint order of J23Topology (skeleton-kernels.h); on device the
+// hip, shoulder and mirror indices come from the joint definition instead.
+
+#include "../skeleton-normalizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const unsigned int NUM_JOINTS = 23;
+static const float ASPECT = 16.0f / 9.0f;
+
+static NormalizerSkeleton j23Skeleton() {
+    NormalizerSkeleton s;
+    s.num_joints = NUM_JOINTS;
+    s.right_hip = 2;
+    s.left_hip = 3;
+    s.right_shoulder = 12;
+    s.left_shoulder = 13;
+    for (unsigned int j = 0; j < NUM_JOINTS; j++) s.reflected[j] = j;
+    const int pairs[][2] = { { 0, 5 }, { 1, 4 }, { 2, 3 }, { 10, 15 }, { 11, 14 }, { 12, 13 },
+                             { 17, 19 }, { 18, 20 }, { 21, 22 } };
+    for (const auto& p : pairs) {
+        s.reflected[p[0]] = p[1];
+        s.reflected[p[1]] = p[0];
+    }
+    return s;
+}
+
+// Upright, facing the camera, hips middle at 0 and unit torso; asymmetric so mirroring shows.
+static const float CANONICAL[NUM_JOINTS][2] = {
+    { -0.2f, 1.8f }, { -0.2f, 0.9f }, { -0.2f, 0.0f }, { 0.2f, 0.0f }, { 0.25f, 0.9f }, { 0.3f, 1.8f },
+    { 0.0f, 0.0f }, { 0.0f, -0.6f }, { 0.0f, -1.1f }, { 0.0f, -1.5f },
+    { -0.6f, -0.2f }, { -0.5f, -0.6f }, { -0.3f, -1.0f }, { 0.3f, -1.0f }, { 0.55f, -0.5f }, { 0.7f, -0.1f },
+    { 0.0f, -1.35f }, { -0.05f, -1.4f }, { -0.12f, -1.38f }, { 0.05f, -1.4f }, { 0.12f, -1.38f },
+    { -0.25f, 1.9f }, { 0.35f, 1.9f },
+};
+
+struct Poses {
+    std::vector<float> joints;      // interleaved, pose after pose
+    std::vector<uint32_t> masks;
+    size_t size() const { return masks.size(); }
+};
+
+// The canonical pose moved, scaled, rotated and for half the poses seen from the back, in
+// normalized image coordinates. With drop, some joints are invalid.
+static Poses makePoses(size_t count, float noise_sd, bool drop, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+    std::normal_distribution<float> noise(0.0f, noise_sd);
+    Poses poses;
+    for (size_t p = 0; p < count; p++) {
+        const float scale = 0.1f + 0.15f * uni(rng);
+        const float angle = (uni(rng) - 0.5f) * 1.0f;
+        const float cx = 0.3f + 0.4f * uni(rng), cy = 0.3f + 0.4f * uni(rng);
+        const float facing = uni(rng) < 0.5f ? 1.0f : -1.0f;
+        const float c = std::cos(angle), s = std::sin(angle);
+        uint32_t mask = (1u << NUM_JOINTS) - 1;
+        for (unsigned int j = 0; j < NUM_JOINTS; j++) {
+            const float x = CANONICAL[j][0] * facing, y = CANONICAL[j][1];
+            const float ix = cx + scale * (c * x - s * y) + noise(rng);
+            const float iy = cy + scale * (s * x + c * y) + noise(rng);
+            poses.joints.push_back(ix / ASPECT);
+            poses.joints.push_back(iy);
+            if (drop && uni(rng) < 0.1f) mask &= ~(1u << j);
+        }
+        poses.masks.push_back(mask);
+    }
+    return poses;
+}
+
+// Plain per pose normalization, features interleaved per pose.
+static void normalizeReference(const NormalizerSkeleton& sk, const NormalizeConfig& config, const float* joints,
+                               uint32_t mask, float* out, uint32_t* out_mask) {
+    auto px = [&](int j) { return joints[j * 2] * ASPECT; };
+    auto py = [&](int j) { return joints[j * 2 + 1]; };
+    const float hx = (px(sk.left_hip) + px(sk.right_hip)) * 0.5f, hy = (py(sk.left_hip) + py(sk.right_hip)) * 0.5f;
+    const float tx = (px(sk.left_shoulder) + px(sk.right_shoulder)) * 0.5f - hx;
+    const float ty = (py(sk.left_shoulder) + py(sk.right_shoulder)) * 0.5f - hy;
+    const float len = std::sqrt(tx * tx + ty * ty);
+    float nx[32], ny[32];
+    for (unsigned int j = 0; j < sk.num_joints; j++) {
+        const float dx = px(j) - hx, dy = py(j) - hy;
+        if (config.rotate) {
+            // unit torso direction u; x across it, y against it
+            const float ux = tx / len, uy = ty / len;
+            nx[j] = (-uy * dx + ux * dy) / len;
+            ny[j] = -(ux * dx + uy * dy) / len;
+        } else {
+            nx[j] = dx / len;
+            ny[j] = dy / len;
+        }
+    }
+    const bool mirror = config.mirror;
+    const float flip = config.face_camera && nx[sk.left_shoulder] < nx[sk.right_shoulder] ? -1.0f : 1.0f;
+
+    const uint32_t reference = (1u << sk.left_hip) | (1u << sk.right_hip) | (1u << sk.left_shoulder) | (1u << sk.right_shoulder);
+    uint32_t m = 0;
+    if ((mask & reference) == reference && len * len >= 1e-8f) {
+        for (unsigned int j = 0; j < sk.num_joints; j++) {
+            const int src = mirror ? sk.reflected[j] : (int) j;
+            if (mask & (1u << src)) m |= 1u << j;
+        }
+    }
+    for (unsigned int j = 0; j < sk.num_joints; j++) {
+        const int src = mirror ? sk.reflected[j] : (int) j;
+        const bool valid = (m >> j) & 1u;
+        out[j * 2] = valid ? (mirror ? -nx[src] : nx[src]) * flip : 0.0f;
+        out[j * 2 + 1] = valid ? ny[src] : 0.0f;
+    }
+    *out_mask = m;
+}
+
+struct Batch {
+    std::vector<float> x, y, features;
+    std::vector<uint32_t> out_masks;
+    size_t stride;
+
+    explicit Batch(const Poses& poses) : stride((poses.size() + 3) & ~(size_t) 3) {
+        x.assign(NUM_JOINTS * stride, 0.0f);
+        y.assign(NUM_JOINTS * stride, 0.0f);
+        features.resize(NUM_JOINTS * 2 * stride);
+        out_masks.resize(poses.size());
+        transposePoses(poses.joints.data(), poses.size(), NUM_JOINTS, x.data(), y.data(), stride);
+    }
+
+    size_t run(const NormalizerSkeleton& sk, const NormalizeConfig& config, const Poses& poses) {
+        const PoseBatch batch = { x.data(), y.data(), poses.masks.data(), poses.size(), stride };
+        const FeatureMatrix out = { features.data(), out_masks.data(), stride };
+        return normalizeSkeletons(sk, config, batch, out, ASPECT);
+    }
+};
+
+static const char* modeName(const NormalizeConfig& c) {
+    static char buf[64];
+    snprintf(buf, sizeof(buf), "rotate %d, face camera %d, mirror %d", c.rotate, c.face_camera, c.mirror);
+    return buf;
+}
+
+// Kernel against the reference for every mode.
+static bool checkModes(const NormalizerSkeleton& sk) {
+    const Poses poses = makePoses(1001, 0.002f, true, 1);
+    Batch batch(poses);
+    bool ok = true;
+    for (int mode = 0; mode < 8; mode++) {
+        NormalizeConfig config;
+        config.rotate = mode & 1;
+        config.face_camera = mode & 2;
+        config.mirror = mode & 4;
+        batch.run(sk, config, poses);
+        float max_error = 0;
+        size_t mask_mismatches = 0;
+        float ref[NUM_JOINTS * 2];
+        for (size_t p = 0; p < poses.size(); p++) {
+            uint32_t m;
+            normalizeReference(sk, config, &poses.joints[p * NUM_JOINTS * 2], poses.masks[p], ref, &m);
+            if (m != batch.out_masks[p]) mask_mismatches++;
+            for (unsigned int f = 0; f < NUM_JOINTS * 2; f++) {
+                max_error = std::max(max_error, std::fabs(ref[f] - batch.features[f * batch.stride + p]));
+            }
+        }
+        printf("%-36s max error vs reference %.2g, %zu mask mismatches\n", modeName(config), max_error, mask_mismatches);
+        if (max_error > 1e-4f || mask_mismatches > 0) ok = false;
+    }
+    return ok;
+}
+
+// Normalization facing the camera of noiseless poses must give back the canonical pose.
+static bool checkInvariance(const NormalizerSkeleton& sk) {
+    const Poses poses = makePoses(1000, 0.0f, false, 2);
+    Batch batch(poses);
+    NormalizeConfig config;
+    config.face_camera = true;
+    const size_t normalized = batch.run(sk, config, poses);
+    float max_error = 0;
+    for (size_t p = 0; p < poses.size(); p++) {
+        for (unsigned int j = 0; j < NUM_JOINTS; j++) {
+            max_error = std::max(max_error, std::fabs(batch.features[(j * 2) * batch.stride + p] - CANONICAL[j][0]));
+            max_error = std::max(max_error, std::fabs(batch.features[(j * 2 + 1) * batch.stride + p] - CANONICAL[j][1]));
+        }
+    }
+    printf("moved, scaled, rotated and back-facing poses: %zu/%zu normalized, max error to canonical %.2g\n",
+           normalized, poses.size(), max_error);
+    return normalized == poses.size() && max_error < 1e-3f;
+}
+
+static void timeKernels(const NormalizerSkeleton& sk, size_t count) {
+    const Poses poses = makePoses(count, 0.002f, true, 3);
+    NormalizeConfig config;
+    config.face_camera = true;
+    std::vector<float> ref(NUM_JOINTS * 2 * count);
+    std::vector<uint32_t> ref_masks(count);
+
+    const int reps = std::max<int>(1, (int) (2000000 / count));
+    auto start = Clock::now();
+    for (int r = 0; r < reps; r++) {
+        for (size_t p = 0; p < count; p++) {
+            normalizeReference(sk, config, &poses.joints[p * NUM_JOINTS * 2], poses.masks[p], &ref[p * NUM_JOINTS * 2], &ref_masks[p]);
+        }
+    }
+    const double ref_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / reps / count;
+
+    Batch batch(poses);
+    start = Clock::now();
+    for (int r = 0; r < reps; r++) {
+        batch.run(sk, config, poses);
+    }
+    const double soa_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / reps / count;
+    printf("%7zu poses: per pose reference %6.1f ns/pose, SoA kernel %6.1f ns/pose\n", count, ref_ns, soa_ns);
+}
+
+// Batch mode over a track written to a temporary file.
+static bool timeTrack(const NormalizerSkeleton& sk, size_t count, unsigned int max_threads) {
+    const char* path = "/tmp/skeleton-normalizer-bench.wptk";
+    const Poses poses = makePoses(count, 0.002f, true, 4);
+    {
+        PoseTrackWriter writer;
+        if (!writer.open(path, "j23", NUM_JOINTS, nullptr, 0)) {
+            fprintf(stderr, "cannot write %s\n", path);
+            return false;
+        }
+        std::vector<float> scores(NUM_JOINTS, 0.9f);
+        for (size_t p = 0; p < count; p++) {
+            PoseTrackRecord r = {};
+            r.timestamp_us = (int64_t) (p / 4) * 33333;
+            r.id = (int) (p % 4);
+            r.valid_mask = poses.masks[p];
+            writer.append(r, &poses.joints[p * NUM_JOINTS * 2], scores.data());
+        }
+        writer.close();
+    }
+
+    PoseTrackReader track;
+    if (!track.open(path)) return false;
+    const size_t stride = (count + 3) & ~(size_t) 3;
+    std::vector<float> single(NUM_JOINTS * 2 * stride), features(NUM_JOINTS * 2 * stride);
+    std::vector<uint32_t> single_masks(count), masks(count);
+    NormalizeConfig config;
+    config.face_camera = true;
+
+    // fault the mapping in first, so the runs compare the normalization only
+    {
+        const FeatureMatrix out = { single.data(), single_masks.data(), stride };
+        normalizeTrack(track, sk, config, out, ASPECT, 1);
+    }
+
+    bool ok = true;
+    double single_ms = 0;
+    for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+        std::vector<float>& f = threads == 1 ? single : features;
+        std::vector<uint32_t>& m = threads == 1 ? single_masks : masks;
+        const FeatureMatrix out = { f.data(), m.data(), stride };
+        const auto start = Clock::now();
+        const size_t normalized = normalizeTrack(track, sk, config, out, ASPECT, threads);
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (threads == 1) single_ms = ms;
+        const bool same = threads == 1 || (f == single && m == single_masks);
+        printf("track of %zu records, %u threads: %7.1f ms, %5.1f ns/record, %.2fx, %zu normalized%s\n",
+               count, threads, ms, ms * 1e6 / count, single_ms / ms, normalized, same ? "" : ", DIFFERS");
+        ok = ok && same;
+    }
+    track.close();
+    remove(path);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    const size_t track_poses = argc > 1 ? atol(argv[1]) : 400000;
+    const unsigned int threads = argc > 2 ? atoi(argv[2]) : 8;
+    const NormalizerSkeleton sk = j23Skeleton();
+
+    bool ok = checkModes(sk);
+    ok = checkInvariance(sk) && ok;
+    for (size_t count : { 1, 4, 16, 1024, 65536 }) {
+        timeKernels(sk, count);
+    }
+    ok = timeTrack(sk, track_poses, threads) && ok;
+    return ok ? 0 : 1;
+}
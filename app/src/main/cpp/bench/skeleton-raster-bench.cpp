@@ -0,0 +1,243 @@
+// Host benchmark for the native skeleton overlay rasterizer.
+//
+// Kernel: the vectorized coverage kernel against the scalar reference over random discs
+// and capsules. Reference: a few frames of the scene below drawn into a cleared buffer
+// must hash to the checksums recorded here, which pins the output itself and not only its
+// consistency; a deliberate change to the drawing has to update them from the printed
+// values. The checksums are of the SSE build; a NEON build may differ by the kernel's
+// rounding. Golden: three people (one standing still, one walking, one waving) are drawn
+// frame after frame with dirty tile tracking, some frames with a random region of the
+// buffer trashed and passed as invalid, and every frame must be byte for byte what a fresh
+// rasterizer draws into a cleared buffer. Throughput: time per frame and tiles drawn for
+// redrawing everything and for dirty tracking, at phone and 1080p sizes.
+// Exits non-zero on a coverage difference above 1, a reference or a golden mismatch.
+//
+//   skeleton-raster-bench [frames]
+
+#include "../skeleton-raster.h"
+#include "../skeleton-kernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const unsigned int NUM_JOINTS = 23;
+static const size_t NUM_PEOPLE = 3;
+
+// j23 standing, hips middle at 0, y down, in torso lengths.
+static const float CANONICAL[NUM_JOINTS][2] = {
+    { -0.2f, 1.8f }, { -0.2f, 0.9f }, { -0.2f, 0.0f }, { 0.2f, 0.0f }, { 0.2f, 0.9f }, { 0.2f, 1.8f },
+    { 0.0f, 0.0f }, { 0.0f, -0.6f }, { 0.0f, -1.1f }, { 0.0f, -1.5f },
+    { -0.35f, 0.0f }, { -0.35f, -0.5f }, { -0.3f, -1.0f }, { 0.3f, -1.0f }, { 0.35f, -0.5f }, { 0.35f, 0.0f },
+    { 0.0f, -1.35f }, { -0.05f, -1.4f }, { -0.12f, -1.38f }, { 0.05f, -1.4f }, { 0.12f, -1.38f },
+    { -0.25f, 1.9f }, { 0.25f, 1.9f },
+};
+
+// Normalized joints of the three people at frame f: still, walking right, waving.
+static void scene(int f, float aspect, float* joints, uint32_t* masks) {
+    const float t = f / 30.0f;
+    for (size_t p = 0; p < NUM_PEOPLE; p++) {
+        const float cx = p == 1 ? 0.1f + std::fmod(t * 0.05f, 0.8f) : 0.25f + 0.5f * (p / 2);
+        const float scale = 0.12f;
+        const float wave = p == 2 ? 1.2f * std::sin(t * 5.0f) : 0.0f;
+        for (unsigned int j = 0; j < NUM_JOINTS; j++) {
+            float x = CANONICAL[j][0], y = CANONICAL[j][1];
+            if (j == 10 || j == 11) {
+                const float dx = x - CANONICAL[12][0], dy = y - CANONICAL[12][1];
+                x = CANONICAL[12][0] + std::cos(wave) * dx - std::sin(wave) * dy;
+                y = CANONICAL[12][1] + std::sin(wave) * dx + std::cos(wave) * dy;
+            }
+            joints[(p * NUM_JOINTS + j) * 2] = cx + x * scale / aspect;
+            joints[(p * NUM_JOINTS + j) * 2 + 1] = 0.55f + y * scale;
+        }
+        // the walker loses a wrist now and then
+        masks[p] = (1u << NUM_JOINTS) - 1;
+        if (p == 1 && (f / 7) % 3 == 0) masks[p] &= ~(1u << 15);
+    }
+}
+
+static bool kernelCheck() {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> pos(0.0f, 200.0f), rad(0.5f, 12.0f);
+    uint8_t a[64], b[64];
+    int worst = 0;
+    long differing = 0, total = 0;
+    for (int s = 0; s < 20000; s++) {
+        const float ax = pos(rng), ay = pos(rng);
+        const bool disc = s % 3 == 0;
+        const float bx = disc ? ax : pos(rng), by = disc ? ay : pos(rng);
+        const float len_sq = (bx - ax) * (bx - ax) + (by - ay) * (by - ay);
+        const float inv = len_sq > 0 ? 1.0f / len_sq : 0.0f;
+        const float r = rad(rng);
+        const int x = (int) pos(rng), y = (int) pos(rng), n = 1 + s % 64;
+        rasterCoverageScalar(ax, ay, bx, by, inv, r, x, y, n, a);
+        rasterCoverage(ax, ay, bx, by, inv, r, x, y, n, b);
+        for (int i = 0; i < n; i++) {
+            const int d = std::abs(a[i] - b[i]);
+            worst = std::max(worst, d);
+            if (d) differing++;
+            total++;
+        }
+    }
+    printf("coverage kernel: %ld of %ld pixels differ from scalar, max %d\n", differing, total, worst);
+    return worst <= 1;
+}
+
+// FNV-1a over the visible pixels.
+static uint64_t checksum(const uint8_t* rgba, size_t stride, int width, int height) {
+    uint64_t h = 14695981039346656037ull;
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = rgba + y * stride;
+        for (int x = 0; x < width * 4; x++) {
+            h = (h ^ row[x]) * 1099511628211ull;
+        }
+    }
+    return h;
+}
+
+struct ReferenceFrame {
+    int width, height;
+    int frame;                  // of scene()
+    bool translucent;           // the translucent green bones of golden()'s second half
+    uint64_t checksum;
+};
+
+static const ReferenceFrame REFERENCE_FRAMES[] = {
+    { 640, 360, 0, false, 0x4987415e717c3795ull },
+    { 640, 360, 21, false, 0xe14270a86eecd04full },     // walker without the left wrist
+    { 640, 360, 50, true, 0xcc70a2262e4387b1ull },
+    { 1080, 1920, 13, true, 0xa72255551994bff8ull },
+};
+
+static bool reference() {
+    long mismatches = 0;
+    for (const ReferenceFrame& ref : REFERENCE_FRAMES) {
+        SkeletonRasterizer r;
+        r.configure(ref.width, ref.height, TopologyTraits<J23Topology>::pairs(), TopologyTraits<J23Topology>::NUM_BONES);
+        if (ref.translucent) {
+            RasterStyle style;
+            style.bone_color = 0xc000c000;
+            style.bone_width = 5.0f;
+            r.setStyle(style);
+        }
+        const size_t stride = ref.width * 4 + 64;
+        std::vector<uint8_t> rgba(stride * ref.height, 0);
+        std::vector<float> joints(NUM_PEOPLE * NUM_JOINTS * 2);
+        uint32_t masks[NUM_PEOPLE];
+        const RasterTransform transform = { (float) ref.width, (float) ref.height, 0.0f, 0.0f };
+        scene(ref.frame, (float) ref.width / ref.height, joints.data(), masks);
+        r.beginFrame(joints.data(), masks, NUM_PEOPLE, NUM_JOINTS, transform);
+        r.draw(rgba.data(), stride, nullptr);
+
+        const uint64_t h = checksum(rgba.data(), stride, ref.width, ref.height);
+        if (h != ref.checksum) {
+            printf("reference %dx%d frame %d: checksum 0x%016llxull, expected 0x%016llxull\n", ref.width, ref.height,
+                   ref.frame, (unsigned long long) h, (unsigned long long) ref.checksum);
+            mismatches++;
+        }
+    }
+    printf("reference: %ld of %zu frames differ\n", mismatches, sizeof(REFERENCE_FRAMES) / sizeof(REFERENCE_FRAMES[0]));
+    return mismatches == 0;
+}
+
+static bool golden(int width, int height, int frames) {
+    SkeletonRasterizer tracked, fresh;
+    tracked.configure(width, height, TopologyTraits<J23Topology>::pairs(), TopologyTraits<J23Topology>::NUM_BONES);
+    const size_t stride = width * 4 + 64;
+    std::vector<uint8_t> a(stride * height, 0), b(stride * height);
+    std::vector<float> joints(NUM_PEOPLE * NUM_JOINTS * 2);
+    uint32_t masks[NUM_PEOPLE];
+    const RasterTransform transform = { (float) width, (float) height, 0.0f, 0.0f };
+    std::mt19937 rng(2);
+
+    long mismatches = 0;
+    for (int f = 0; f < frames; f++) {
+        scene(f, (float) width / height, joints.data(), masks);
+        if (f == frames / 2) {
+            RasterStyle style;
+            style.bone_color = 0xc000c000;      // translucent green
+            style.bone_width = 5.0f;
+            tracked.setStyle(style);
+        }
+        tracked.beginFrame(joints.data(), masks, NUM_PEOPLE, NUM_JOINTS, transform);
+
+        // like a window buffer that was not preserved: garbage the caller reports
+        RasterRect invalid = { 0, 0, 0, 0 };
+        if (f % 5 == 4) {
+            invalid.left = rng() % width;
+            invalid.top = rng() % height;
+            invalid.right = invalid.left + 1 + rng() % 300;
+            invalid.bottom = invalid.top + 1 + rng() % 300;
+            for (int y = invalid.top; y < std::min(invalid.bottom, height); y++) {
+                for (int x = invalid.left; x < std::min(invalid.right, width); x++) {
+                    memset(&a[y * stride + x * 4], 0x5a, 4);
+                }
+            }
+        }
+        tracked.draw(a.data(), stride, &invalid);
+
+        fresh.configure(width, height, TopologyTraits<J23Topology>::pairs(), TopologyTraits<J23Topology>::NUM_BONES);
+        if (f >= frames / 2) {
+            RasterStyle style;
+            style.bone_color = 0xc000c000;
+            style.bone_width = 5.0f;
+            fresh.setStyle(style);
+        }
+        std::fill(b.begin(), b.end(), 0xee);
+        fresh.beginFrame(joints.data(), masks, NUM_PEOPLE, NUM_JOINTS, transform);
+        fresh.draw(b.data(), stride, nullptr);
+
+        for (int y = 0; y < height; y++) {
+            if (memcmp(&a[y * stride], &b[y * stride], width * 4)) mismatches++;
+        }
+    }
+    printf("golden %dx%d, %d frames: %ld mismatching rows\n", width, height, frames, mismatches);
+    return mismatches == 0;
+}
+
+static void throughput(int width, int height, int frames) {
+    SkeletonRasterizer r;
+    r.configure(width, height, TopologyTraits<J23Topology>::pairs(), TopologyTraits<J23Topology>::NUM_BONES);
+    const size_t stride = width * 4;
+    std::vector<uint8_t> rgba(stride * height, 0);
+    std::vector<float> joints(NUM_PEOPLE * NUM_JOINTS * 2);
+    uint32_t masks[NUM_PEOPLE];
+    const RasterTransform transform = { (float) width, (float) height, 0.0f, 0.0f };
+    const size_t tiles = ((width + 31) / 32) * ((height + 31) / 32);
+
+    for (int mode = 0; mode < 2; mode++) {
+        size_t drawn = 0;
+        const auto start = Clock::now();
+        for (int f = 0; f < frames; f++) {
+            scene(f, (float) width / height, joints.data(), masks);
+            if (mode == 0) r.invalidate();
+            r.beginFrame(joints.data(), masks, NUM_PEOPLE, NUM_JOINTS, transform);
+            drawn += r.draw(rgba.data(), stride, nullptr);
+        }
+        const double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / frames;
+        printf("  %-14s %7.1f us/frame, %5.1f%% of tiles drawn\n", mode == 0 ? "full redraw" : "dirty tiles",
+               us, 100.0 * drawn / frames / tiles);
+    }
+}
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? atoi(argv[1]) : 300;
+
+    bool ok = kernelCheck();
+    ok = reference() && ok;
+    ok = golden(640, 360, 90) && ok;
+    ok = golden(1080, 1920, 30) && ok;
+    const int sizes[][2] = { { 1080, 1920 }, { 1920, 1080 }, { 720, 1280 } };
+    for (const auto& s : sizes) {
+        printf("%dx%d, %zu people:\n", s[0], s[1], NUM_PEOPLE);
+        throughput(s[0], s[1], frames);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+#include "dtw-matcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "simd4.h"
+
+static const float INF = std::numeric_limits<float>::infinity();
+
+DtwMatcher::DtwMatcher(size_t dim) : dim_(dim), padded_dim_((dim + 3) & ~(size_t) 3) {
+    query_.assign(padded_dim_, 0.0f);
+    start();
+}
+
+void DtwMatcher::setConfig(const DtwMatcherConfig& config) {
+    config_ = config;
+    for (Template& t : templates_) {
+        buildEnvelope(t);
+    }
+    start();
+}
+
+size_t DtwMatcher::addTemplate(const float* features, size_t frames, float fps) {
+    Template t;
+    t.offset = features_.size();
+    t.frames = frames;
+    t.fps = fps;
+
+    features_.resize(t.offset + frames * padded_dim_, 0.0f);
+    upper_.resize(features_.size());
+    lower_.resize(features_.size());
+    for (size_t j = 0; j < frames; j++) {
+        std::copy(features + j * dim_, features + (j + 1) * dim_, &features_[t.offset + j * padded_dim_]);
+    }
+    buildEnvelope(t);
+
+    templates_.push_back(t);
+    scores_.push_back(DtwScore());
+    start();
+    return templates_.size() - 1;
+}
+
+void DtwMatcher::clearTemplates() {
+    templates_.clear();
+    scores_.clear();
+    features_.clear();
+    upper_.clear();
+    lower_.clear();
+    start();
+}
+
+void DtwMatcher::buildEnvelope(Template& t) {
+    const size_t w = config_.band;
+    for (size_t j = 0; j < t.frames; j++) {
+        const size_t lo = j > w ? j - w : 0;
+        const size_t hi = std::min(j + w, t.frames - 1);
+        float* upper = &upper_[t.offset + j * padded_dim_];
+        float* lower = &lower_[t.offset + j * padded_dim_];
+        std::copy_n(&features_[t.offset + lo * padded_dim_], padded_dim_, upper);
+        std::copy_n(&features_[t.offset + lo * padded_dim_], padded_dim_, lower);
+        for (size_t k = lo + 1; k <= hi; k++) {
+            const float* f = &features_[t.offset + k * padded_dim_];
+            for (size_t d = 0; d < padded_dim_; d++) {
+                upper[d] = std::max(upper[d], f[d]);
+                lower[d] = std::min(lower[d], f[d]);
+            }
+        }
+    }
+}
+
+void DtwMatcher::start() {
+    const size_t width = 2 * config_.band + 1;
+    rows_.assign(templates_.size() * 2 * width, INF);
+    for (size_t k = 0; k < templates_.size(); k++) {
+        templates_[k].lb_sum = 0.0f;
+        templates_[k].prev_lo = 0;
+        templates_[k].prev_hi = -1;
+        scores_[k].state = DtwScore::WAITING;
+        scores_[k].cost = INF;
+        scores_[k].progress = 0.0f;
+    }
+    started_ = false;
+    start_us_ = 0;
+    frame_ = 0;
+    row_parity_ = 0;
+    best_total_ = INF;
+    best_ = -1;
+    last_cells_ = 0;
+}
+
+float DtwMatcher::cellCost(const float* a, const float* b) const {
+    f32x4 acc = set4(0.0f);
+    for (size_t d = 0; d < padded_dim_; d += 4) {
+        const f32x4 diff = sub4(load4(a + d), load4(b + d));
+        acc = madd4(acc, diff, diff);
+    }
+    return hsum4(acc);
+}
+
+// LB_Keogh term of one live frame: its distance to the [lower, upper] envelope of the band.
+float DtwMatcher::lowerBound(const float* query, const Template& t, size_t j) const {
+    const float* upper = &upper_[t.offset + j * padded_dim_];
+    const float* lower = &lower_[t.offset + j * padded_dim_];
+    const f32x4 zero = set4(0.0f);
+    f32x4 acc = zero;
+    for (size_t d = 0; d < padded_dim_; d += 4) {
+        const f32x4 q = load4(query + d);
+        const f32x4 e = add4(max4(sub4(q, load4(upper + d)), zero), max4(sub4(load4(lower + d), q), zero));
+        acc = madd4(acc, e, e);
+    }
+    return hsum4(acc);
+}
+
+void DtwMatcher::update(int64_t timestamp_us, const float* features) {
+    if (started_ && timestamp_us < start_us_) {
+        start();
+    }
+    if (!started_) {
+        started_ = true;
+        start_us_ = timestamp_us;
+    }
+    std::copy(features, features + dim_, query_.begin());
+
+    last_cells_ = 0;
+    const double elapsed_s = (timestamp_us - start_us_) * 1e-6;
+    for (size_t k = 0; k < templates_.size(); k++) {
+        const DtwScore::State state = scores_[k].state;
+        if (state == DtwScore::PRUNED || state == DtwScore::FINISHED) continue;
+        updateTemplate(k, (int) std::lround(elapsed_s * templates_[k].fps));
+    }
+
+    best_ = -1;
+    float best_cost = INF;
+    for (size_t k = 0; k < scores_.size(); k++) {
+        const DtwScore& s = scores_[k];
+        if (s.state != DtwScore::PRUNED && s.cost < best_cost) {
+            best_cost = s.cost;
+            best_ = (int) k;
+        }
+    }
+    best_total_ = best_cost * (frame_ + 1);
+
+    frame_++;
+    row_parity_ ^= 1;
+}
+
+void DtwMatcher::updateTemplate(size_t k, int center) {
+    Template& t = templates_[k];
+    DtwScore& score = scores_[k];
+    const int w = (int) config_.band;
+    const int last = (int) t.frames - 1;
+    const int lo = std::max(center - w, 0);
+    const int hi = std::min(center + w, last);
+
+    const size_t width = 2 * config_.band + 1;
+    float* prev = &rows_[k * 2 * width + (row_parity_ ^ 1) * width];
+    float* cur = &rows_[k * 2 * width + row_parity_ * width];
+
+    if (lo > last) {
+        // the band has moved past the end: the full template path is final
+        if (t.prev_hi == last) {
+            score.cost = prev[last - t.prev_lo] / frame_;
+            score.progress = 1.0f;
+        }
+        score.state = DtwScore::FINISHED;
+        return;
+    }
+
+    // best_total_ covers the frames before this one, so compare the bound before adding to it;
+    // with prune_ratio >= 1 the best template can't prune itself
+    const bool hopeless = config_.prune_ratio > 0.0f && t.lb_sum > config_.prune_ratio * best_total_;
+    t.lb_sum += lowerBound(query_.data(), t, (size_t) std::min(center, last));
+    if (hopeless || (config_.max_mean_cost > 0.0f && t.lb_sum > config_.max_mean_cost * (frame_ + 1))) {
+        score.state = DtwScore::PRUNED;
+        return;
+    }
+
+    const float* feat = &features_[t.offset];
+    float total = INF;
+    int arg = lo;
+    for (int j = lo; j <= hi; j++) {
+        float from;
+        if (frame_ == 0) {
+            from = j == 0 ? 0.0f : INF;
+        } else {
+            from = j >= t.prev_lo && j <= t.prev_hi ? prev[j - t.prev_lo] : INF;
+            if (j - 1 >= t.prev_lo && j - 1 <= t.prev_hi) {
+                from = std::min(from, prev[j - 1 - t.prev_lo]);
+            } else if (j == lo && j - 1 > t.prev_hi) {
+                // skipped live frames moved the band past the previous row: join its end
+                from = std::min(from, prev[t.prev_hi - t.prev_lo]);
+            }
+        }
+        if (j > lo) {
+            from = std::min(from, cur[j - 1 - lo]);
+        }
+        const float d = cellCost(query_.data(), feat + j * padded_dim_) + from;
+        cur[j - lo] = d;
+        if (d < total) {
+            total = d;
+            arg = j;
+        }
+    }
+    last_cells_ += hi - lo + 1;
+    t.prev_lo = lo;
+    t.prev_hi = hi;
+
+    score.state = DtwScore::ACTIVE;
+    score.cost = total / (frame_ + 1);
+    score.progress = (float) (arg + 1) / t.frames;
+}
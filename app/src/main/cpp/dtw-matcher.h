@@ -0,0 +1,99 @@
+#ifndef DTW_MATCHER_H
+#define DTW_MATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Streaming dynamic time warping of a live feature stream against reference templates.
+//
+// A session starts with the first update after start(); from then on the live stream is
+// expected to follow each template in time, live frame i at time t lining up with template
+// frame (t - t0) * template fps. A Sakoe-Chiba band of +-band template frames around that
+// frame bounds the warping, so every update adds one row of at most 2 * band + 1 cells per
+// template. Only the previous row is kept, in one arena for all templates.
+//
+// Before its row is computed, each template's LB_Keogh lower bound for the frame (the
+// distance of the live features to the template's band envelope) is added to a running sum.
+// That sum never exceeds the template's DTW cost, so a template whose sum is out of reach of
+// the best one, or above max_mean_cost per frame, is dropped and costs nothing afterwards.
+//
+// Costs are squared Euclidean distances summed along the path, reported per live frame.
+// Scores are kept up to date by update() and read back without any work.
+
+struct DtwMatcherConfig {
+    size_t band = 15;               // Sakoe-Chiba half width in template frames
+    float prune_ratio = 2.0f;       // drop when lower bound > ratio * best cost; 0 disables
+    float max_mean_cost = 0.0f;     // drop when lower bound per frame exceeds this; 0 disables
+};
+
+struct DtwScore {
+    enum State { WAITING, ACTIVE, PRUNED, FINISHED };
+
+    State state;
+    float cost;                     // best open-ended path cost per live frame so far
+    float progress;                 // template position of that path, 0..1
+};
+
+class DtwMatcher {
+public:
+    explicit DtwMatcher(size_t dim);
+
+    // Applies to the templates already added too; restarts the session.
+    void setConfig(const DtwMatcherConfig& config);
+
+    // frames x dim features sampled at fps. Returns the template index.
+    size_t addTemplate(const float* features, size_t frames, float fps);
+    void clearTemplates();
+
+    // Restarts matching: the next update is frame 0 of every template.
+    void start();
+
+    // Feeds one live frame of dim features.
+    void update(int64_t timestamp_us, const float* features);
+
+    size_t numTemplates() const { return templates_.size(); }
+    size_t dim() const { return dim_; }
+    const DtwScore& score(size_t i) const { return scores_[i]; }
+
+    // Lowest cost template that is not pruned, -1 if none.
+    int best() const { return best_; }
+
+    // Cells computed in the last update, for measuring the pruning.
+    size_t lastCells() const { return last_cells_; }
+
+private:
+    struct Template {
+        size_t offset;              // into features_, upper_ and lower_, in floats
+        size_t frames;
+        float fps;
+        float lb_sum;
+        int prev_lo;                // template frames of the previous row
+        int prev_hi;
+    };
+
+    void buildEnvelope(Template& t);
+    float cellCost(const float* a, const float* b) const;
+    float lowerBound(const float* query, const Template& t, size_t j) const;
+    void updateTemplate(size_t k, int center);
+
+    size_t dim_;
+    size_t padded_dim_;             // dim rounded up to 4
+    DtwMatcherConfig config_;
+    std::vector<Template> templates_;
+    std::vector<DtwScore> scores_;
+    std::vector<float> features_;   // padded_dim_ floats per template frame
+    std::vector<float> upper_;      // band envelope of features_
+    std::vector<float> lower_;
+    std::vector<float> rows_;       // per template, previous and current row of 2 * band + 1
+    std::vector<float> query_;
+    bool started_;
+    int64_t start_us_;
+    size_t frame_;
+    size_t row_parity_;
+    float best_total_;              // best unnormalized cost of the previous frame
+    int best_;
+    size_t last_cells_;
+};
+
+#endif // DTW_MATCHER_H
@@ -0,0 +1,155 @@
+#include "frame-kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "mask-kernels.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+void rgbaToBgrScalar(const uint8_t* rgba, size_t count, uint8_t* bgr) {
+    for (size_t i = 0; i < count; i++) {
+        bgr[i * 3] = rgba[i * 4 + 2];
+        bgr[i * 3 + 1] = rgba[i * 4 + 1];
+        bgr[i * 3 + 2] = rgba[i * 4];
+    }
+}
+
+void rgbaToBgr(const uint8_t* rgba, size_t count, uint8_t* bgr) {
+    size_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    // de-interleaving loads and interleaving stores do the whole shuffle
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16x4_t in = vld4q_u8(rgba + i * 4);
+        uint8x16x3_t out;
+        out.val[0] = in.val[2];
+        out.val[1] = in.val[1];
+        out.val[2] = in.val[0];
+        vst3q_u8(bgr + i * 3, out);
+    }
+#endif
+    // SSE2 has no byte shuffle, so x86 takes the scalar loop
+
+    rgbaToBgrScalar(rgba + i * 4, count - i, bgr + i * 3);
+}
+
+static inline uint8_t clampByte(int v) {
+    return (uint8_t) std::min(std::max(v, 0), 255);
+}
+
+static inline void yuvPixel(int y, int ruv, int guv, int buv, uint8_t* bgr) {
+    const int c = (y - 16) * 298 + 128;
+    bgr[0] = clampByte((c + buv) >> 8);
+    bgr[1] = clampByte((c + guv) >> 8);
+    bgr[2] = clampByte((c + ruv) >> 8);
+}
+
+void yuv420ToBgr(const Yuv420Image& src, uint8_t* bgr, size_t bgr_stride) {
+    const int step = src.chroma_step;
+    for (int row = 0; row < src.height; row++) {
+        const uint8_t* y = src.y + (size_t) row * src.y_stride;
+        const uint8_t* u = src.u + (size_t) (row / 2) * src.uv_stride;
+        const uint8_t* v = src.v + (size_t) (row / 2) * src.uv_stride;
+        uint8_t* out = bgr + (size_t) row * bgr_stride;
+        // the chroma terms once per pair of pixels sharing them
+        for (int x = 0; x < src.width; x += 2) {
+            const int d = u[(x / 2) * step] - 128;
+            const int e = v[(x / 2) * step] - 128;
+            const int ruv = 409 * e;
+            const int guv = -100 * d - 208 * e;
+            const int buv = 516 * d;
+            yuvPixel(y[x], ruv, guv, buv, out + x * 3);
+            if (x + 1 < src.width) yuvPixel(y[x + 1], ruv, guv, buv, out + x * 3 + 3);
+        }
+    }
+}
+
+BgrResizer::BgrResizer() : src_width_(0), src_height_(0), dst_width_(0), dst_height_(0) {}
+
+void BgrResizer::configure(int src_width, int src_height, int dst_width, int dst_height) {
+    if (src_width == src_width_ && src_height == src_height_ && dst_width == dst_width_ && dst_height == dst_height_) {
+        return;
+    }
+    src_width_ = src_width;
+    src_height_ = src_height;
+    dst_width_ = dst_width;
+    dst_height_ = dst_height;
+
+    linearSamplePositions(src_width, dst_width, x0_, wx_);
+    linearSamplePositions(src_height, dst_height, y0_, wy_);
+    x1_.resize(dst_width);
+    for (int x = 0; x < dst_width; x++) {
+        x1_[x] = std::min(x0_[x] + 1, src_width - 1) * 3;
+        x0_[x] *= 3;
+    }
+}
+
+void BgrResizer::resize(const uint8_t* src, size_t src_stride, uint8_t* dst, size_t dst_stride) const {
+    const int32_t* __restrict x0 = x0_.data();
+    const int32_t* __restrict x1 = x1_.data();
+    const uint16_t* __restrict wx = wx_.data();
+    for (int y = 0; y < dst_height_; y++) {
+        const int y0 = y0_[y];
+        const int y1 = std::min(y0 + 1, src_height_ - 1);
+        const uint32_t wy = wy_[y];
+        const uint8_t* __restrict top = src + (size_t) y0 * src_stride;
+        const uint8_t* __restrict bottom = src + (size_t) y1 * src_stride;
+        uint8_t* __restrict out = dst + (size_t) y * dst_stride;
+        // only the four source pixels of every output pixel are read, so shrinking a large
+        // frame costs the output size, not the input size
+        for (int x = 0; x < dst_width_; x++) {
+            const uint32_t w1 = wx[x], w0 = 256 - w1;
+            for (int c = 0; c < 3; c++) {
+                const uint32_t t = top[x0[x] + c] * w0 + top[x1[x] + c] * w1;
+                const uint32_t b = bottom[x0[x] + c] * w0 + bottom[x1[x] + c] * w1;
+                out[x * 3 + c] = (uint8_t) ((t * (256 - wy) + b * wy + (1 << 15)) >> 16);
+            }
+        }
+    }
+}
+
+void rotateBgr(const uint8_t* src, int width, int height, size_t src_stride, int quarter_turns,
+               uint8_t* dst, size_t dst_stride) {
+    const int turns = ((quarter_turns % 4) + 4) % 4;
+    if (turns == 0) {
+        for (int y = 0; y < height; y++) {
+            memcpy(dst + (size_t) y * dst_stride, src + (size_t) y * src_stride, (size_t) width * 3);
+        }
+        return;
+    }
+    if (turns == 2) {
+        for (int y = 0; y < height; y++) {
+            const uint8_t* in = src + (size_t) y * src_stride;
+            uint8_t* out = dst + (size_t) (height - 1 - y) * dst_stride + (size_t) (width - 1) * 3;
+            for (int x = 0; x < width; x++, in += 3, out -= 3) {
+                out[0] = in[0];
+                out[1] = in[1];
+                out[2] = in[2];
+            }
+        }
+        return;
+    }
+
+    // a quarter turn reads rows and writes columns; in tiles, both sides stay in cache
+    const int TILE = 16;
+    for (int ty = 0; ty < height; ty += TILE) {
+        const int y_end = std::min(ty + TILE, height);
+        for (int tx = 0; tx < width; tx += TILE) {
+            const int x_end = std::min(tx + TILE, width);
+            for (int y = ty; y < y_end; y++) {
+                const uint8_t* in = src + (size_t) y * src_stride + (size_t) tx * 3;
+                // clockwise (x, y) goes to (height - 1 - y, x), counter-clockwise to (y, width - 1 - x)
+                const size_t col = (size_t) (turns == 1 ? height - 1 - y : y) * 3;
+                for (int x = tx; x < x_end; x++, in += 3) {
+                    uint8_t* out = dst + (size_t) (turns == 1 ? x : width - 1 - x) * dst_stride + col;
+                    out[0] = in[0];
+                    out[1] = in[1];
+                    out[2] = in[2];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef FRAME_KERNELS_H
+#define FRAME_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Kernels turning a video frame into the estimator's input: packed 8-bit BGR, upright, at
+// the small size the estimator is fed (244x128 in the app).
+//
+// Frames come either as RGBA, like the TextureView bitmap the app grabs, or as YUV 4:2:0
+// from a decoder; both convert to BGR. Resizing is bilinear, as the app's filtered bitmap
+// scaling is, and rotation is by quarter turns for sensor or display orientation.
+
+// RGBA as packed in memory to BGR, count pixels; alpha is dropped.
+void rgbaToBgr(const uint8_t* rgba, size_t count, uint8_t* bgr);
+
+// Plain scalar version of rgbaToBgr, the reference for the vectorized one.
+void rgbaToBgrScalar(const uint8_t* rgba, size_t count, uint8_t* bgr);
+
+// A YUV 4:2:0 frame. u and v point at the first sample of their planes; chroma samples are
+// chroma_step bytes apart within a row (1 planar, 2 for NV12 / NV21) and rows uv_stride apart.
+struct Yuv420Image {
+    const uint8_t* y;
+    const uint8_t* u;
+    const uint8_t* v;
+    size_t y_stride;
+    size_t uv_stride;
+    int chroma_step;
+    int width;
+    int height;
+};
+
+// Limited range BT.601 YUV to BGR rows bgr_stride bytes apart, in 8.8 fixed point.
+void yuv420ToBgr(const Yuv420Image& src, uint8_t* bgr, size_t bgr_stride);
+
+// Bilinear resize of BGR images between one pair of sizes, sample positions precomputed.
+class BgrResizer {
+public:
+    BgrResizer();
+
+    void configure(int src_width, int src_height, int dst_width, int dst_height);
+
+    void resize(const uint8_t* src, size_t src_stride, uint8_t* dst, size_t dst_stride) const;
+
+    int dstWidth() const { return dst_width_; }
+    int dstHeight() const { return dst_height_; }
+
+private:
+    int src_width_;
+    int src_height_;
+    int dst_width_;
+    int dst_height_;
+    std::vector<int32_t> x0_;       // byte offsets of the left and right source pixel
+    std::vector<int32_t> x1_;
+    std::vector<uint16_t> wx_;      // weight of the right pixel, 8.8 fixed point
+    std::vector<int32_t> y0_;
+    std::vector<uint16_t> wy_;
+};
+
+// Rotates the width x height BGR image src clockwise by quarter_turns * 90 degrees into dst,
+// which is height x width for an odd number of turns. src and dst must not overlap.
+void rotateBgr(const uint8_t* src, int width, int height, size_t src_stride, int quarter_turns,
+               uint8_t* dst, size_t dst_stride);
+
+#endif // FRAME_KERNELS_H
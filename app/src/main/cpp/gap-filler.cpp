@@ -0,0 +1,91 @@
+#include "gap-filler.h"
+
+#include <algorithm>
+
+// Hermite interpolation at s in [0, 1] between p0 and p1 with tangents m0 and m1 already
+// scaled to the interval.
+static inline float hermite(float p0, float m0, float p1, float m1, float s) {
+    const float s2 = s * s;
+    const float s3 = s2 * s;
+    return (2 * s3 - 3 * s2 + 1) * p0 + (s3 - 2 * s2 + s) * m0 + (-2 * s3 + 3 * s2) * p1 + (s3 - s2) * m1;
+}
+
+void fillGaps(const PoseWindow& window, size_t target, const GapFillConfig& config,
+              float* joints, uint32_t* valid_mask, uint32_t* filled_mask) {
+    const unsigned int num_joints = window.numJoints();
+    const size_t max_frames = GAP_FILL_MAX_FRAMES;
+    const size_t back = std::min(config.look_back_frames, max_frames);
+    const size_t ahead = std::min(config.delay_frames, max_frames);
+    const size_t first = target > back ? target - back : 0;
+    const size_t end = std::min(target + ahead + 1, window.size());
+
+    PoseFrameView frames[2 * GAP_FILL_MAX_FRAMES + 1];
+    for (size_t i = first; i < end; i++) {
+        frames[i - first] = window.at(i);
+    }
+    const PoseFrameView* f = frames - first;    // indexed by window position
+    const PoseFrameView& cur = f[target];
+
+    std::copy(cur.joints, cur.joints + num_joints * 2, joints);
+    *valid_mask = cur.valid_mask;
+    *filled_mask = 0;
+
+    for (unsigned int j = 0; j < num_joints; j++) {
+        const uint32_t bit = 1u << j;
+        if (cur.valid_mask & bit) continue;
+
+        // nearest frames having the joint on either side, and one more beyond each
+        long i0 = -1, i1 = -1, im = -1, in = -1;
+        for (long i = (long) target - 1; i >= (long) first; i--) {
+            if (!(f[i].valid_mask & bit)) continue;
+            if (i0 < 0) i0 = i;
+            else { im = i; break; }
+        }
+        if (i0 < 0) continue;
+        for (size_t i = target + 1; i < end; i++) {
+            if (!(f[i].valid_mask & bit)) continue;
+            if (i1 < 0) i1 = (long) i;
+            else { in = (long) i; break; }
+        }
+        if (i1 < 0) continue;
+
+        const int64_t t0 = f[i0].timestamp_us, t1 = f[i1].timestamp_us;
+        if (t1 - t0 > config.max_gap_us || t1 <= t0) continue;
+
+        const float h = (float) (t1 - t0);
+        const float s = (float) (cur.timestamp_us - t0) / h;
+        for (int c = 0; c < 2; c++) {
+            const float p0 = f[i0].joints[j * 2 + c];
+            const float p1 = f[i1].joints[j * 2 + c];
+            float v;
+            if (config.interpolation == GAP_LINEAR) {
+                v = p0 + (p1 - p0) * s;
+            } else {
+                // tangents per microsecond, then scaled to the gap
+                const float secant = (p1 - p0) / h;
+                const float d0 = im >= 0 ? (p1 - f[im].joints[j * 2 + c]) / (float) (t1 - f[im].timestamp_us) : secant;
+                const float d1 = in >= 0 ? (f[in].joints[j * 2 + c] - p0) / (float) (f[in].timestamp_us - t0) : secant;
+                v = hermite(p0, d0 * h, p1, d1 * h, s);
+            }
+            joints[j * 2 + c] = v;
+        }
+        *valid_mask |= bit;
+        *filled_mask |= bit;
+    }
+}
+
+bool fillDelayedFrame(const PoseHistory& history, int id, const GapFillConfig& config, PoseFrameView* frame,
+                      float* joints, uint32_t* valid_mask, uint32_t* filled_mask) {
+    const size_t max_frames = GAP_FILL_MAX_FRAMES;
+    const size_t back = std::min(config.look_back_frames, max_frames);
+    const size_t ahead = std::min(config.delay_frames, max_frames);
+    const PoseWindow window = history.windowByCount(id, back + ahead + 1);
+    if (window.size() <= ahead) {
+        return false;
+    }
+
+    const size_t target = window.size() - 1 - ahead;
+    *frame = window.at(target);
+    fillGaps(window, target, config, joints, valid_mask, filled_mask);
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef GAP_FILLER_H
+#define GAP_FILLER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pose-history.h"
+
+// Filling of short joint dropouts from the frames around them in a person's pose history.
+//
+// A joint missing from a frame is interpolated between the last frame that has it (at most
+// look_back_frames back) and the next one (at most delay_frames ahead), if those two are no
+// more than max_gap_us apart. Hermite interpolation takes its tangents from one more sample
+// on either side where there is one (Catmull-Rom over non-uniform times), which follows
+// curved motion better than a straight line; without one it falls back to the secant.
+//
+// Live use reads the frame delay_frames behind the newest one, so the output lags the input
+// by that many frames and no more. Nothing is stored besides the history itself.
+
+enum GapInterpolation {
+    GAP_LINEAR,
+    GAP_HERMITE,
+};
+
+struct GapFillConfig {
+    GapInterpolation interpolation = GAP_HERMITE;
+    size_t delay_frames = 2;
+    size_t look_back_frames = 4;
+    int64_t max_gap_us = 300000;
+};
+
+// Frames of look-back and look-ahead used at most, whatever the config asks for.
+static const size_t GAP_FILL_MAX_FRAMES = 32;
+
+// Fills frame target of window. joints (num_joints * 2) gets the frame's joints with the
+// gaps filled, valid_mask its valid joints plus the filled ones and filled_mask only the
+// filled ones.
+void fillGaps(const PoseWindow& window, size_t target, const GapFillConfig& config,
+              float* joints, uint32_t* valid_mask, uint32_t* filled_mask);
+
+// The frame delay_frames before the newest of track id, filled. frame gets its timestamp,
+// scores and box. False while the track has no frame that old.
+bool fillDelayedFrame(const PoseHistory& history, int id, const GapFillConfig& config, PoseFrameView* frame,
+                      float* joints, uint32_t* valid_mask, uint32_t* filled_mask);
+
+#endif // GAP_FILLER_H
@@ -0,0 +1,49 @@
+#include <android/bitmap.h>
+#include <android/log.h>
+#include <android/native_window_jni.h>
+
+#include <cstdarg>
+#include <cstdio>
+
+extern "C" int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+    static const char LEVELS[] = "??VDIWEFS";
+    const char level = prio >= 0 && prio < (int) sizeof(LEVELS) - 1 ? LEVELS[prio] : '?';
+    char message[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+    return fprintf(stderr, "%c/%s: %s\n", level, tag, message);
+}
+
+extern "C" int AndroidBitmap_getInfo(JNIEnv*, jobject, AndroidBitmapInfo*) {
+    return ANDROID_BITMAP_RESULT_BAD_PARAMETER;
+}
+
+extern "C" int AndroidBitmap_lockPixels(JNIEnv*, jobject, void**) {
+    return ANDROID_BITMAP_RESULT_BAD_PARAMETER;
+}
+
+extern "C" int AndroidBitmap_unlockPixels(JNIEnv*, jobject) {
+    return ANDROID_BITMAP_RESULT_BAD_PARAMETER;
+}
+
+extern "C" ANativeWindow* ANativeWindow_fromSurface(JNIEnv*, jobject) {
+    return nullptr;
+}
+
+// Unreachable without a window, defined for the linker.
+extern "C" void ANativeWindow_acquire(ANativeWindow*) {}
+extern "C" void ANativeWindow_release(ANativeWindow*) {}
+
+extern "C" int32_t ANativeWindow_setBuffersGeometry(ANativeWindow*, int32_t, int32_t, int32_t) {
+    return -1;
+}
+
+extern "C" int32_t ANativeWindow_lock(ANativeWindow*, ANativeWindow_Buffer*, ARect*) {
+    return -1;
+}
+
+extern "C" int32_t ANativeWindow_unlockAndPost(ANativeWindow*) {
+    return -1;
+}
@@ -0,0 +1,18 @@
+#ifndef HOST_ANDROID_NATIVE_WINDOW_JNI_H
+#define HOST_ANDROID_NATIVE_WINDOW_JNI_H
+
+#include <android/native_window.h>
+#include <jni.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Host build: always null.
+ANativeWindow* ANativeWindow_fromSurface(JNIEnv* env, jobject surface);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ANDROID_NATIVE_WINDOW_JNI_H
@@ -0,0 +1,13 @@
+#ifndef HOST_ANDROID_RECT_H
+#define HOST_ANDROID_RECT_H
+
+#include <stdint.h>
+
+typedef struct ARect {
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+} ARect;
+
+#endif // HOST_ANDROID_RECT_H
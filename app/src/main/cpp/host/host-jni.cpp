@@ -0,0 +1,263 @@
+#include <jni.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+void fail(const char* what) {
+    fprintf(stderr, "JNI misuse: %s\n", what);
+    abort();
+}
+
+void retain(jobject object) {
+    if (object) object->refs++;
+}
+
+void release(jobject object) {
+    if (object && --object->refs == 0) delete object;
+}
+
+struct HostClass : _jclass {
+    std::string name;
+};
+
+struct HostString : _jstring {
+    std::string utf;
+};
+
+struct HostDirectBuffer : _jobject {
+    void* address;
+    jlong capacity;
+};
+
+// For the length of any array, whatever its element type.
+struct HostArrayBase {
+    virtual ~HostArrayBase() {}
+    virtual size_t size() const = 0;
+};
+
+struct HostObjectArray : _jobjectArray, HostArrayBase {
+    ~HostObjectArray() override {
+        for (jobject e : elements) release(e);
+    }
+    size_t size() const override { return elements.size(); }
+    std::vector<jobject> elements;
+};
+
+template <typename T, typename Base>
+struct HostArray : Base, HostArrayBase {
+    size_t size() const override { return elements.size(); }
+    std::vector<T> elements;
+};
+
+template <typename T, typename Base>
+std::vector<T>& elementsOf(Base* array) {
+    if (!array) fail("null array");
+    return static_cast<HostArray<T, Base>*>(array)->elements;
+}
+
+void checkRange(size_t size, jsize start, jsize len) {
+    if (start < 0 || len < 0 || (size_t) start + len > size) fail("array region out of bounds");
+}
+
+template <typename T, typename Base>
+void getRegion(Base* array, jsize start, jsize len, T* buf) {
+    const std::vector<T>& e = elementsOf<T>(array);
+    checkRange(e.size(), start, len);
+    if (len) memcpy(buf, e.data() + start, sizeof(T) * len);
+}
+
+template <typename T, typename Base>
+void setRegion(Base* array, jsize start, jsize len, const T* buf) {
+    std::vector<T>& e = elementsOf<T>(array);
+    checkRange(e.size(), start, len);
+    if (len) memcpy(e.data() + start, buf, sizeof(T) * len);
+}
+
+template <typename T, typename Base>
+T* getElements(Base* array, jboolean* is_copy) {
+    if (is_copy) *is_copy = JNI_FALSE;
+    return elementsOf<T>(array).data();
+}
+
+template <typename T, typename Base>
+void releaseElements(Base* array, T* elems, jint mode) {
+    if (elems != elementsOf<T>(array).data()) fail("elements released to the wrong array");
+    if (mode != 0 && mode != JNI_COMMIT && mode != JNI_ABORT) fail("bad release mode");
+}
+
+template <typename T, typename Base>
+HostArray<T, Base>* newArray(jsize length) {
+    if (length < 0) fail("negative array size");
+    HostArray<T, Base>* array = new HostArray<T, Base>();
+    array->elements.assign(length, T());
+    return array;
+}
+
+HostString* stringOf(jstring string) {
+    if (!string) fail("null string");
+    return static_cast<HostString*>(string);
+}
+
+HostObjectArray* objectArrayOf(jobjectArray array, jsize index) {
+    if (!array) fail("null array");
+    HostObjectArray* a = static_cast<HostObjectArray*>(array);
+    checkRange(a->elements.size(), index, 1);
+    return a;
+}
+
+} // namespace
+
+// Local reference frames, innermost last; each entry is one reference.
+struct JNIEnv::LocalFrames {
+    std::vector<std::vector<jobject>> frames;
+};
+
+JNIEnv::JNIEnv() : frames_(new LocalFrames) {
+    frames_->frames.emplace_back();
+}
+
+JNIEnv::~JNIEnv() {
+    for (const std::vector<jobject>& frame : frames_->frames) {
+        for (jobject ref : frame) release(ref);
+    }
+    delete frames_;
+}
+
+template <typename T>
+T* JNIEnv::track(T* object) {
+    if (object) {
+        retain(object);
+        frames_->frames.back().push_back(object);
+    }
+    return object;
+}
+
+jclass JNIEnv::FindClass(const char* name) {
+    HostClass* c = new HostClass();
+    c->name = name;
+    return track(c);
+}
+
+jint JNIEnv::PushLocalFrame(jint capacity) {
+    frames_->frames.emplace_back();
+    frames_->frames.back().reserve(std::max(capacity, 0));
+    return JNI_OK;
+}
+
+jobject JNIEnv::PopLocalFrame(jobject result) {
+    if (frames_->frames.size() < 2) fail("PopLocalFrame without PushLocalFrame");
+    std::vector<jobject> popped;
+    popped.swap(frames_->frames.back());
+    frames_->frames.pop_back();
+    // a reference to result in the enclosing frame before the popped ones go
+    track(result);
+    for (jobject ref : popped) release(ref);
+    return result;
+}
+
+void JNIEnv::DeleteLocalRef(jobject ref) {
+    if (!ref) return;
+    for (auto frame = frames_->frames.rbegin(); frame != frames_->frames.rend(); ++frame) {
+        auto it = std::find(frame->begin(), frame->end(), ref);
+        if (it != frame->end()) {
+            frame->erase(it);
+            release(ref);
+            return;
+        }
+    }
+    fail("DeleteLocalRef of an object without a local reference");
+}
+
+jstring JNIEnv::NewStringUTF(const char* bytes) {
+    if (!bytes) return nullptr;
+    HostString* s = new HostString();
+    s->utf = bytes;
+    return track(s);
+}
+
+jsize JNIEnv::GetStringUTFLength(jstring string) {
+    return (jsize) stringOf(string)->utf.size();
+}
+
+const char* JNIEnv::GetStringUTFChars(jstring string, jboolean* is_copy) {
+    if (is_copy) *is_copy = JNI_FALSE;
+    return stringOf(string)->utf.c_str();
+}
+
+void JNIEnv::ReleaseStringUTFChars(jstring string, const char* utf) {
+    if (utf != stringOf(string)->utf.c_str()) fail("string chars released to the wrong string");
+}
+
+jsize JNIEnv::GetArrayLength(jarray array) {
+    HostArrayBase* a = dynamic_cast<HostArrayBase*>(static_cast<jobject>(array));
+    if (!a) fail("not an array");
+    return (jsize) a->size();
+}
+
+jobjectArray JNIEnv::NewObjectArray(jsize length, jclass element_class, jobject initial) {
+    if (length < 0) fail("negative array size");
+    if (!element_class) fail("null element class");
+    HostObjectArray* array = new HostObjectArray();
+    array->elements.assign(length, initial);
+    for (jsize i = 0; i < length; i++) retain(initial);
+    return track(array);
+}
+
+jobject JNIEnv::GetObjectArrayElement(jobjectArray array, jsize index) {
+    return track(objectArrayOf(array, index)->elements[index]);
+}
+
+void JNIEnv::SetObjectArrayElement(jobjectArray array, jsize index, jobject value) {
+    jobject& slot = objectArrayOf(array, index)->elements[index];
+    retain(value);
+    release(slot);
+    slot = value;
+}
+
+jbyteArray JNIEnv::NewByteArray(jsize length) { return track(newArray<jbyte, _jbyteArray>(length)); }
+jintArray JNIEnv::NewIntArray(jsize length) { return track(newArray<jint, _jintArray>(length)); }
+jlongArray JNIEnv::NewLongArray(jsize length) { return track(newArray<jlong, _jlongArray>(length)); }
+jfloatArray JNIEnv::NewFloatArray(jsize length) { return track(newArray<jfloat, _jfloatArray>(length)); }
+
+jbyte* JNIEnv::GetByteArrayElements(jbyteArray array, jboolean* is_copy) { return getElements<jbyte>(array, is_copy); }
+jint* JNIEnv::GetIntArrayElements(jintArray array, jboolean* is_copy) { return getElements<jint>(array, is_copy); }
+jlong* JNIEnv::GetLongArrayElements(jlongArray array, jboolean* is_copy) { return getElements<jlong>(array, is_copy); }
+jfloat* JNIEnv::GetFloatArrayElements(jfloatArray array, jboolean* is_copy) { return getElements<jfloat>(array, is_copy); }
+
+void JNIEnv::ReleaseByteArrayElements(jbyteArray array, jbyte* elems, jint mode) { releaseElements(array, elems, mode); }
+void JNIEnv::ReleaseIntArrayElements(jintArray array, jint* elems, jint mode) { releaseElements(array, elems, mode); }
+void JNIEnv::ReleaseLongArrayElements(jlongArray array, jlong* elems, jint mode) { releaseElements(array, elems, mode); }
+void JNIEnv::ReleaseFloatArrayElements(jfloatArray array, jfloat* elems, jint mode) { releaseElements(array, elems, mode); }
+
+void JNIEnv::GetByteArrayRegion(jbyteArray array, jsize start, jsize len, jbyte* buf) { getRegion(array, start, len, buf); }
+void JNIEnv::GetIntArrayRegion(jintArray array, jsize start, jsize len, jint* buf) { getRegion(array, start, len, buf); }
+void JNIEnv::GetLongArrayRegion(jlongArray array, jsize start, jsize len, jlong* buf) { getRegion(array, start, len, buf); }
+void JNIEnv::GetFloatArrayRegion(jfloatArray array, jsize start, jsize len, jfloat* buf) { getRegion(array, start, len, buf); }
+
+void JNIEnv::SetByteArrayRegion(jbyteArray array, jsize start, jsize len, const jbyte* buf) { setRegion(array, start, len, buf); }
+void JNIEnv::SetIntArrayRegion(jintArray array, jsize start, jsize len, const jint* buf) { setRegion(array, start, len, buf); }
+void JNIEnv::SetLongArrayRegion(jlongArray array, jsize start, jsize len, const jlong* buf) { setRegion(array, start, len, buf); }
+void JNIEnv::SetFloatArrayRegion(jfloatArray array, jsize start, jsize len, const jfloat* buf) { setRegion(array, start, len, buf); }
+
+jobject JNIEnv::NewDirectByteBuffer(void* address, jlong capacity) {
+    HostDirectBuffer* buffer = new HostDirectBuffer();
+    buffer->address = address;
+    buffer->capacity = capacity;
+    return track(buffer);
+}
+
+void* JNIEnv::GetDirectBufferAddress(jobject buf) {
+    HostDirectBuffer* buffer = dynamic_cast<HostDirectBuffer*>(buf);
+    return buffer ? buffer->address : nullptr;
+}
+
+jlong JNIEnv::GetDirectBufferCapacity(jobject buf) {
+    HostDirectBuffer* buffer = dynamic_cast<HostDirectBuffer*>(buf);
+    return buffer ? buffer->capacity : -1;
+}
@@ -0,0 +1,116 @@
+#ifndef HOST_JNI_H
+#define HOST_JNI_H
+
+#include <cstdint>
+
+// Just enough of the JNI for native-lib.cpp to build and run off-device, in the host build
+// only. There is no JVM: a caller owns a JNIEnv and the objects are plain allocations made
+// through it. A local reference lives until DeleteLocalRef or until the PopLocalFrame of the
+// frame it was made in, so a driver brackets every native call with PushLocalFrame and
+// PopLocalFrame the way returning to Java frees the call's references. Misuse a JVM would
+// throw for, like an out of bounds region, aborts. One JNIEnv per thread, as on a device.
+
+#define JNIEXPORT __attribute__((visibility("default")))
+#define JNICALL
+
+#define JNI_FALSE 0
+#define JNI_TRUE 1
+
+#define JNI_OK 0
+#define JNI_ERR (-1)
+
+#define JNI_COMMIT 1
+#define JNI_ABORT 2
+
+typedef uint8_t jboolean;
+typedef int8_t jbyte;
+typedef int32_t jint;
+typedef int64_t jlong;
+typedef float jfloat;
+typedef jint jsize;
+
+// Counts the local references and object array slots holding the object.
+class _jobject {
+public:
+    _jobject() : refs(0) {}
+    virtual ~_jobject() {}
+    int refs;
+};
+class _jclass : public _jobject {};
+class _jstring : public _jobject {};
+class _jarray : public _jobject {};
+class _jobjectArray : public _jarray {};
+class _jbyteArray : public _jarray {};
+class _jintArray : public _jarray {};
+class _jlongArray : public _jarray {};
+class _jfloatArray : public _jarray {};
+
+typedef _jobject* jobject;
+typedef _jclass* jclass;
+typedef _jstring* jstring;
+typedef _jarray* jarray;
+typedef _jobjectArray* jobjectArray;
+typedef _jbyteArray* jbyteArray;
+typedef _jintArray* jintArray;
+typedef _jlongArray* jlongArray;
+typedef _jfloatArray* jfloatArray;
+
+struct JNIEnv {
+    JNIEnv();
+    ~JNIEnv();
+    JNIEnv(const JNIEnv&) = delete;
+    JNIEnv& operator=(const JNIEnv&) = delete;
+
+    jclass FindClass(const char* name);
+
+    jint PushLocalFrame(jint capacity);
+    jobject PopLocalFrame(jobject result);
+    void DeleteLocalRef(jobject ref);
+
+    jstring NewStringUTF(const char* bytes);
+    jsize GetStringUTFLength(jstring string);
+    const char* GetStringUTFChars(jstring string, jboolean* is_copy);
+    void ReleaseStringUTFChars(jstring string, const char* utf);
+
+    jsize GetArrayLength(jarray array);
+
+    jobjectArray NewObjectArray(jsize length, jclass element_class, jobject initial);
+    jobject GetObjectArrayElement(jobjectArray array, jsize index);
+    void SetObjectArrayElement(jobjectArray array, jsize index, jobject value);
+
+    jbyteArray NewByteArray(jsize length);
+    jintArray NewIntArray(jsize length);
+    jlongArray NewLongArray(jsize length);
+    jfloatArray NewFloatArray(jsize length);
+
+    // Never copies: the elements are the array's own storage.
+    jbyte* GetByteArrayElements(jbyteArray array, jboolean* is_copy);
+    jint* GetIntArrayElements(jintArray array, jboolean* is_copy);
+    jlong* GetLongArrayElements(jlongArray array, jboolean* is_copy);
+    jfloat* GetFloatArrayElements(jfloatArray array, jboolean* is_copy);
+    void ReleaseByteArrayElements(jbyteArray array, jbyte* elems, jint mode);
+    void ReleaseIntArrayElements(jintArray array, jint* elems, jint mode);
+    void ReleaseLongArrayElements(jlongArray array, jlong* elems, jint mode);
+    void ReleaseFloatArrayElements(jfloatArray array, jfloat* elems, jint mode);
+
+    void GetByteArrayRegion(jbyteArray array, jsize start, jsize len, jbyte* buf);
+    void GetIntArrayRegion(jintArray array, jsize start, jsize len, jint* buf);
+    void GetLongArrayRegion(jlongArray array, jsize start, jsize len, jlong* buf);
+    void GetFloatArrayRegion(jfloatArray array, jsize start, jsize len, jfloat* buf);
+    void SetByteArrayRegion(jbyteArray array, jsize start, jsize len, const jbyte* buf);
+    void SetIntArrayRegion(jintArray array, jsize start, jsize len, const jint* buf);
+    void SetLongArrayRegion(jlongArray array, jsize start, jsize len, const jlong* buf);
+    void SetFloatArrayRegion(jfloatArray array, jsize start, jsize len, const jfloat* buf);
+
+    jobject NewDirectByteBuffer(void* address, jlong capacity);
+    void* GetDirectBufferAddress(jobject buf);
+    jlong GetDirectBufferCapacity(jobject buf);
+
+private:
+    struct LocalFrames;
+    LocalFrames* frames_;
+
+    template <typename T> T* track(T* object);
+};
+
+#endif // HOST_JNI_H
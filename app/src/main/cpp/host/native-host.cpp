@@ -0,0 +1,127 @@
+// Runs native-lib off-device: the JNI entry points over the host JNI and the stub wrnch
+// library, fed synthetic BGR frames the way PlayerTextureView feeds the real ones.
+//
+// Checks that init reports the j23 bones, that every frame comes back with the main person
+// in the processWrnchJNI layout stamped with the frame's time and that the frame counters
+// add up, then prints the per-stage latencies from getStatsJNI. With -latency the process
+// stage should sit at that many microseconds. -switch-tracking n flips between the native
+// and the estimator's tracker every n frames, which reconfigures the estimator on the frame
+// thread. Exits non-zero on a failed check.
+//
+//   native-host [-frames n] [-size WxH] [-people n] [-latency us] [-jitter us] [-busy]
+//               [-smoothing mode] [-tracking] [-switch-tracking n]
+
+#include "wrnch-natives.h"
+#include "wrnch-stub.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static void printStats(const float* stats) {
+    static const char* const NAMES[WRNCH_NUM_STAGES] = { "ingest", "conversion", "process", "extraction", "marshal" };
+    printf("%-11s %8s %9s %9s %9s %9s %9s %9s\n", "stage", "samples", "mean us", "p50", "p90", "p99", "p99.9", "max");
+    for (int s = 0; s < WRNCH_NUM_STAGES; s++) {
+        const float* h = stats + s * WRNCH_STATS_PER_STAGE;
+        if (h[0] == 0) continue;
+        printf("%-11s %8.0f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", NAMES[s], h[0], h[1], h[2], h[3], h[4], h[5], h[6]);
+    }
+}
+
+int main(int argc, char** argv) {
+    long frames = 300;
+    int width = 244, height = 128;
+    int smoothing = WRNCH_SMOOTHING_LIBRARY;
+    bool tracking = false;
+    long switch_every = 0;
+    WrnchStubConfig stub = wrnchStubDefaults();
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-frames") && i + 1 < argc) {
+            frames = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "-size") && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &width, &height);
+        } else if (!strcmp(argv[i], "-people") && i + 1 < argc) {
+            stub.num_people = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-latency") && i + 1 < argc) {
+            stub.latency_us = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-jitter") && i + 1 < argc) {
+            stub.jitter_us = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-busy")) {
+            stub.busy_wait = true;
+        } else if (!strcmp(argv[i], "-smoothing") && i + 1 < argc) {
+            smoothing = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-tracking")) {
+            tracking = true;
+        } else if (!strcmp(argv[i], "-switch-tracking") && i + 1 < argc) {
+            switch_every = atol(argv[++i]);
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    setWrnchStubConfig(stub);
+
+    JNIEnv env;
+    Java_com_samsungnext_audiovideoplayersample_Wrnch_setNativeTrackingJNI(&env, nullptr, tracking ? JNI_TRUE : JNI_FALSE);
+    Java_com_samsungnext_audiovideoplayersample_Wrnch_setSmoothingJNI(&env, nullptr, smoothing);
+
+    env.PushLocalFrame(4);
+    jintArray bones = Java_com_samsungnext_audiovideoplayersample_Wrnch_initWrnchJNI(&env, nullptr, env.NewStringUTF("/tmp"));
+    const jsize num_bone_ints = env.GetArrayLength(bones);
+    env.PopLocalFrame(nullptr);
+    printf("init: %d bones\n", num_bone_ints / 2);
+    if (num_bone_ints == 0) return 1;
+
+    // a frame the size the app scales to, in a Java array reused for every frame like the app's
+    jbyteArray img = env.NewByteArray(width * height * 3);
+    std::vector<jbyte> bgr(width * height * 3);
+    for (size_t i = 0; i < bgr.size(); i++) bgr[i] = (jbyte) (i * 7);
+    env.SetByteArrayRegion(img, 0, (jsize) bgr.size(), bgr.data());
+
+    // body section plus an empty face section, the stub has no face model
+    const jsize expected = 23 * 3 + 5 + 9;
+    long wrong_size = 0, wrong_time = 0, without_main = 0;
+    const long frame_us = (long) (1e6f / stub.fps);
+    for (long f = 0; f < frames; f++) {
+        if (switch_every > 0 && f > 0 && f % switch_every == 0) {
+            tracking = !tracking;
+            Java_com_samsungnext_audiovideoplayersample_Wrnch_setNativeTrackingJNI(&env, nullptr, tracking ? JNI_TRUE : JNI_FALSE);
+        }
+        env.PushLocalFrame(4);
+        jfloatArray out = Java_com_samsungnext_audiovideoplayersample_Wrnch_processWrnchJNI(&env, nullptr, img, width, height, f * frame_us);
+        const jsize n = env.GetArrayLength(out);
+        if (n == 0) {
+            without_main++;
+        } else if (n != expected) {
+            wrong_size++;
+        } else {
+            jfloat time_bits[2];
+            int64_t pose_us;
+            env.GetFloatArrayRegion(out, 23 * 3 + 3, 2, time_bits);
+            memcpy(&pose_us, time_bits, sizeof(pose_us));
+            wrong_time += pose_us != f * frame_us;
+        }
+        env.PopLocalFrame(nullptr);
+    }
+
+    env.PushLocalFrame(4);
+    float stats[WRNCH_STATS_LENGTH];
+    jfloatArray packed = Java_com_samsungnext_audiovideoplayersample_Wrnch_getStatsJNI(&env, nullptr);
+    const bool stats_ok = env.GetArrayLength(packed) == WRNCH_STATS_LENGTH;
+    if (stats_ok) env.GetFloatArrayRegion(packed, 0, WRNCH_STATS_LENGTH, stats);
+    env.PopLocalFrame(nullptr);
+    if (!stats_ok) return 1;
+
+    printf("%ld frames of %dx%d, %d people, stub latency %u +- %u us%s: %ld without a main person, %ld wrong size, %ld wrong timestamp\n",
+           frames, width, height, stub.num_people, stub.latency_us, stub.jitter_us, stub.busy_wait ? " busy" : "",
+           without_main, wrong_size, wrong_time);
+    printStats(stats);
+    printf("frames processed %.0f, failed %.0f\n", stats[WRNCH_STATS_FRAMES], stats[WRNCH_STATS_FRAMES_FAILED]);
+
+    const bool ok = wrong_size == 0 && wrong_time == 0 && (stub.num_people == 0 || without_main == 0) &&
+                    stats[WRNCH_STATS_FRAMES] == frames && stats[WRNCH_STATS_FRAMES_FAILED] == 0 &&
+                    stats[WRNCH_STAGE_PROCESS * WRNCH_STATS_PER_STAGE] == frames;
+    return ok ? 0 : 1;
+}
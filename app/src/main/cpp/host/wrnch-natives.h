@@ -0,0 +1,46 @@
+#ifndef WRNCH_NATIVES_H
+#define WRNCH_NATIVES_H
+
+#include <jni.h>
+
+// The native methods of Wrnch.java that host drivers call, as native-lib.cpp defines them.
+// They are static in Java, so the jobject is the class and may be null here. The constants
+// mirror Wrnch.java's.
+
+static const int WRNCH_SMOOTHING_LIBRARY = 1;
+static const int WRNCH_SMOOTHING_NATIVE = 2;
+
+static const int WRNCH_STAGE_INGEST = 0;
+static const int WRNCH_STAGE_CONVERSION = 1;
+static const int WRNCH_STAGE_PROCESS = 2;
+static const int WRNCH_STAGE_EXTRACTION = 3;
+static const int WRNCH_STAGE_MARSHAL = 4;
+static const int WRNCH_NUM_STAGES = 5;
+
+static const int WRNCH_STATS_PER_STAGE = 7;
+static const int WRNCH_STATS_FRAMES = WRNCH_NUM_STAGES * WRNCH_STATS_PER_STAGE;
+static const int WRNCH_STATS_FRAMES_FAILED = WRNCH_STATS_FRAMES + 1;
+static const int WRNCH_STATS_LENGTH = WRNCH_STATS_FRAMES + 8;
+
+extern "C" {
+
+jintArray Java_com_samsungnext_audiovideoplayersample_Wrnch_initWrnchJNI(JNIEnv* env, jobject, jstring dirStr);
+jfloatArray Java_com_samsungnext_audiovideoplayersample_Wrnch_processWrnchJNI(JNIEnv* env, jobject, jbyteArray img,
+                                                                             jint cols, jint rows, jlong timestampUs);
+void Java_com_samsungnext_audiovideoplayersample_Wrnch_setSmoothingJNI(JNIEnv* env, jobject, jint mode);
+void Java_com_samsungnext_audiovideoplayersample_Wrnch_setNativeTrackingJNI(JNIEnv* env, jobject, jboolean enabled);
+void Java_com_samsungnext_audiovideoplayersample_Wrnch_setFaceEnabledJNI(JNIEnv* env, jobject, jboolean enabled);
+
+jboolean Java_com_samsungnext_audiovideoplayersample_Wrnch_startRecordingJNI(JNIEnv* env, jobject, jstring pathStr);
+jboolean Java_com_samsungnext_audiovideoplayersample_Wrnch_stopRecordingJNI(JNIEnv* env, jobject);
+jint Java_com_samsungnext_audiovideoplayersample_Wrnch_openReplayJNI(JNIEnv* env, jobject, jstring pathStr);
+jfloatArray Java_com_samsungnext_audiovideoplayersample_Wrnch_replayFrameJNI(JNIEnv* env, jobject, jlong timestampUs);
+void Java_com_samsungnext_audiovideoplayersample_Wrnch_closeReplayJNI(JNIEnv* env, jobject);
+
+void Java_com_samsungnext_audiovideoplayersample_Wrnch_recordStageLatencyJNI(JNIEnv* env, jobject, jint stage, jlong nanos);
+jfloatArray Java_com_samsungnext_audiovideoplayersample_Wrnch_getStatsJNI(JNIEnv* env, jobject);
+void Java_com_samsungnext_audiovideoplayersample_Wrnch_resetStatsJNI(JNIEnv* env, jobject);
+
+} // extern "C"
+
+#endif // WRNCH_NATIVES_H
@@ -0,0 +1,486 @@
+#include "wrnch-stub.h"
+
+#include <wrnch/engine.h>
+#include <wrnch/version.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../skeleton-kernels.h"
+
+// Handle types the headers only declare.
+
+struct wrJointDefinition {
+    const char* name;
+    unsigned int num_joints;
+    const char* const* joint_names;
+    const unsigned int* bone_pairs;
+    unsigned int num_bones;
+    const int* reflected;
+};
+
+struct wrPoseParams {
+    wrSensitivity bone_sensitivity;
+    wrSensitivity joint_sensitivity;
+    int enable_tracking;
+    int net_width;
+    int net_height;
+};
+
+struct wrPoseEstimatorConfigParams_ {
+    std::string models_dir;
+    std::string license;
+    std::string fingerprint;
+    wrJointDefinitionHandleConst format;
+    wrPoseParams pose_params;
+};
+
+struct wrPoseEstimatorOptions {
+    int estimate_mask;
+    int estimate_3d;
+    int use_ik;
+    int joint_smoothing;
+    int pose_face;
+    int rotation;
+};
+
+struct wrBox2d {
+    float min_x;
+    float min_y;
+    float width;
+    float height;
+};
+
+static const unsigned int J23_JOINTS = 23;
+
+struct wrPose2d {
+    int id;
+    int is_main;
+    float score;
+    float joints[J23_JOINTS * 2];
+    float scores[J23_JOINTS];
+    wrBox2d box;
+};
+
+struct wrPoseEstimator {
+    wrJointDefinitionHandleConst format;
+    uint64_t frame;
+    std::vector<wrPose2d> humans;
+};
+
+struct wrIKParams {};
+struct wrPose3d {};
+struct wrPoseFace {};
+struct wrArrow {};
+struct wrActivityModel {};
+struct wrActivityModelBuilder {};
+struct wrIndividualActivityModel {};
+
+struct wrPoseEstimatorRequirements {
+    wrPoseEstimatorOptions options;
+};
+
+// The j23 definition, bone pairs as skeleton-kernels.h has them.
+
+static const char* const J23_NAMES[J23_JOINTS] = {
+    "RANKLE", "RKNEE", "RHIP", "LHIP", "LKNEE", "LANKLE", "PELV", "THRX", "NECK", "HEAD",
+    "RWRIST", "RELBOW", "RSHOULDER", "LSHOULDER", "LELBOW", "LWRIST",
+    "NOSE", "REYE", "REAR", "LEYE", "LEAR", "RTOE", "LTOE",
+};
+
+static const int J23_REFLECTED[J23_JOINTS] = {
+    5, 4, 3, 2, 1, 0, 6, 7, 8, 9,
+    15, 14, 13, 12, 11, 10,
+    16, 19, 20, 17, 18, 22, 21,
+};
+
+static const wrJointDefinition J23 = {
+    "j23", J23_JOINTS, J23_NAMES, TopologyTraits<J23Topology>::pairs(),
+    (unsigned int) TopologyTraits<J23Topology>::NUM_BONES, J23_REFLECTED,
+};
+
+// Standing pose, normalized image coordinates around x = 0 (the person's centre).
+static const float J23_STANDING[J23_JOINTS * 2] = {
+    -0.04f, 0.90f,  -0.04f, 0.75f,  -0.04f, 0.58f,   0.04f, 0.58f,   0.04f, 0.75f,
+     0.04f, 0.90f,   0.00f, 0.58f,   0.00f, 0.40f,   0.00f, 0.33f,   0.00f, 0.24f,
+    -0.10f, 0.55f,  -0.09f, 0.46f,  -0.07f, 0.36f,   0.07f, 0.36f,   0.09f, 0.46f,
+     0.10f, 0.55f,   0.00f, 0.28f,  -0.015f, 0.265f, -0.03f, 0.27f,  0.015f, 0.265f,
+     0.03f, 0.27f,  -0.05f, 0.93f,   0.05f, 0.93f,
+};
+
+// Configuration
+
+static std::mutex config_mutex;
+static bool config_set = false;
+static WrnchStubConfig config;
+
+static long envLong(const char* name, long fallback) {
+    const char* value = getenv(name);
+    return value && *value ? strtol(value, nullptr, 10) : fallback;
+}
+
+WrnchStubConfig wrnchStubDefaults() {
+    WrnchStubConfig c;
+    c.num_people = (int) std::max(envLong("WRNCH_STUB_PEOPLE", 1), 0L);
+    c.latency_us = (unsigned int) std::max(envLong("WRNCH_STUB_LATENCY_US", 30000), 0L);
+    c.jitter_us = (unsigned int) std::max(envLong("WRNCH_STUB_JITTER_US", 0), 0L);
+    c.busy_wait = envLong("WRNCH_STUB_BUSY", 0) != 0;
+    c.fps = 30.0f;
+    const char* dropout = getenv("WRNCH_STUB_DROPOUT");
+    c.dropout = dropout && *dropout ? (float) strtod(dropout, nullptr) : 0.02f;
+    return c;
+}
+
+void setWrnchStubConfig(const WrnchStubConfig& c) {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    config = c;
+    config_set = true;
+}
+
+WrnchStubConfig wrnchStubConfig() {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    if (!config_set) {
+        config = wrnchStubDefaults();
+        config_set = true;
+    }
+    return config;
+}
+
+// Synthetic people
+
+// Uniform in [0, 1) from the frame, person, joint and what it is for; no state, so a frame
+// looks the same whichever estimator or thread makes it.
+static float noise(uint64_t frame, int person, int joint, int purpose) {
+    uint64_t z = frame * 0x9E3779B97F4A7C15ull ^ ((uint64_t) person << 40) ^ ((uint64_t) joint << 16) ^ purpose;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (float) (z >> 40) / (float) (1 << 24);
+}
+
+static bool isKnee(unsigned int j) { return j == 1 || j == 4; }
+static bool isFoot(unsigned int j) { return j == 0 || j == 5 || j == 21 || j == 22; }
+
+// Person p of n squatting, phase shifted per person; ids are p + 1 and stay put.
+static void synthesizePerson(uint64_t frame, int p, int n, const WrnchStubConfig& c, wrPose2d* out) {
+    const float pi = 3.14159265f;
+    const float t = frame / std::max(c.fps, 1.0f);
+    const float squat = 0.5f - 0.5f * std::cos(2.0f * pi * t / 2.0f + p * 0.9f);
+    const float centre = (p + 1.0f) / (n + 1.0f);
+    const float width = std::min(1.0f, 2.0f / (n + 1));
+
+    float min_x = 1.0f, min_y = 1.0f, max_x = 0.0f, max_y = 0.0f, total = 0.0f;
+    for (unsigned int j = 0; j < J23_JOINTS; j++) {
+        float x = J23_STANDING[j * 2];
+        float y = J23_STANDING[j * 2 + 1];
+        if (isKnee(j)) {
+            y += 0.06f * squat;
+            x *= 1.0f + 0.5f * squat;
+        } else if (!isFoot(j)) {
+            y += 0.12f * squat;
+        }
+        // arms reach forward (up in the image) on the way down
+        if (j == 10 || j == 15) y -= 0.15f * squat;
+        if (j == 11 || j == 14) y -= 0.07f * squat;
+
+        x = centre + x * width + (noise(frame, p, j, 0) - 0.5f) * 0.008f;
+        y = y + (noise(frame, p, j, 1) - 0.5f) * 0.008f;
+        float score = 0.7f + 0.3f * noise(frame, p, j, 2);
+        if (noise(frame, p, j, 3) < c.dropout) {
+            x = y = -1.0f;
+            score = 0.05f;
+        } else {
+            min_x = std::min(min_x, x);
+            min_y = std::min(min_y, y);
+            max_x = std::max(max_x, x);
+            max_y = std::max(max_y, y);
+        }
+        out->joints[j * 2] = x;
+        out->joints[j * 2 + 1] = y;
+        out->scores[j] = score;
+        total += score;
+    }
+    out->id = p + 1;
+    out->is_main = p == 0 ? 1 : 0;
+    out->score = total / J23_JOINTS;
+    out->box.min_x = min_x - 0.02f;
+    out->box.min_y = min_y - 0.02f;
+    out->box.width = max_x - min_x + 0.04f;
+    out->box.height = max_y - min_y + 0.04f;
+}
+
+static void waitLatency(uint64_t frame, const WrnchStubConfig& c, std::chrono::steady_clock::time_point start) {
+    const float spread = (2.0f * noise(frame, -1, 0, 4) - 1.0f) * c.jitter_us;
+    const long us = std::max(0L, (long) c.latency_us + (long) spread);
+    const auto deadline = start + std::chrono::microseconds(us);
+    if (c.busy_wait) {
+        while (std::chrono::steady_clock::now() < deadline) {}
+    } else {
+        std::this_thread::sleep_until(deadline);
+    }
+}
+
+extern "C" {
+
+char const* wrnch_version(void) {
+    return WRNCH_ENGINE_API_VERSION "-host-stub";
+}
+
+const char* wrReturnCode_Translate(wrReturnCode code) {
+    switch (code) {
+        case wrReturnCode_OK: return "OK";
+        case wrReturnCode_BAD_ALLOC: return "BAD_ALLOC";
+        case wrReturnCode_OTHER_ERROR: return "OTHER_ERROR";
+        case wrReturnCode_NO_MODELS: return "NO_MODELS (host stub)";
+        case wrReturnCode_3D_NOT_INITIALIZED: return "3D_NOT_INITIALIZED";
+        case wrReturnCode_JOINT_DEFINITION_ERROR: return "JOINT_DEFINITION_ERROR (host stub has j23 only)";
+        case wrReturnCode_UNSUPPORTED_ON_PLATFORM: return "UNSUPPORTED_ON_PLATFORM (host stub)";
+        default: return "error (host stub)";
+    }
+}
+
+// Joint definitions
+
+wrJointDefinitionHandleConst wrJointDefinition_Get(const char* name) {
+    return name && strcmp(name, J23.name) == 0 ? &J23 : nullptr;
+}
+
+unsigned int wrJointDefinition_GetNumJoints(wrJointDefinitionHandleConst def) {
+    return def->num_joints;
+}
+
+void wrJointDefinition_GetJointNames(wrJointDefinitionHandleConst def, char const** names) {
+    std::copy(def->joint_names, def->joint_names + def->num_joints, names);
+}
+
+unsigned int wrJointDefinition_GetNumBones(wrJointDefinitionHandleConst def) {
+    return def->num_bones;
+}
+
+void wrJointDefinition_GetBonePairs(wrJointDefinitionHandleConst def, unsigned int* pairs) {
+    std::copy(def->bone_pairs, def->bone_pairs + def->num_bones * 2, pairs);
+}
+
+int wrJointDefinition_GetJointIndex(wrJointDefinitionHandleConst def, const char* joint_name) {
+    for (unsigned int j = 0; j < def->num_joints; j++) {
+        if (strcmp(def->joint_names[j], joint_name) == 0) return (int) j;
+    }
+    return -1;
+}
+
+int wrJointDefinition_ReflectedIndexOverY(wrJointDefinitionHandleConst def, int joint_index) {
+    return def->reflected[joint_index];
+}
+
+// Parameters and options
+
+wrPoseParamsHandle wrPoseParams_Create(void) {
+    return new wrPoseParams{ wrSensitivity_MEDIUM, wrSensitivity_MEDIUM, 1, 0, 0 };
+}
+
+void wrPoseParams_Destroy(wrPoseParamsHandle params) { delete params; }
+void wrPoseParams_SetBoneSensitivity(wrPoseParamsHandle params, wrSensitivity s) { params->bone_sensitivity = s; }
+void wrPoseParams_SetJointSensitivity(wrPoseParamsHandle params, wrSensitivity s) { params->joint_sensitivity = s; }
+void wrPoseParams_SetEnableTracking(wrPoseParamsHandle params, int yes_no) { params->enable_tracking = yes_no; }
+void wrPoseParams_SetPreferredNetWidth2d(wrPoseParamsHandle params, int width) { params->net_width = width; }
+void wrPoseParams_SetPreferredNetHeight2d(wrPoseParamsHandle params, int height) { params->net_height = height; }
+
+wrPoseEstimatorConfigParams wrPoseEstimatorConfigParams_Create(const char* models_dir) {
+    wrPoseEstimatorConfigParams params = new wrPoseEstimatorConfigParams_();
+    params->models_dir = models_dir ? models_dir : "";
+    params->format = &J23;
+    params->pose_params = wrPoseParams{ wrSensitivity_MEDIUM, wrSensitivity_MEDIUM, 1, 0, 0 };
+    return params;
+}
+
+void wrPoseEstimatorConfigParams_SetLicenseString(wrPoseEstimatorConfigParams params, const char* license) {
+    params->license = license;
+}
+
+void wrPoseEstimatorConfigParams_SetDeviceFingerprint(wrPoseEstimatorConfigParams params, const char* fingerprint) {
+    params->fingerprint = fingerprint;
+}
+
+void wrPoseEstimatorConfigParams_SetPoseParams(wrPoseEstimatorConfigParams params, wrPoseParamsHandleConst pose_params) {
+    params->pose_params = *pose_params;
+}
+
+void wrPoseEstimatorConfigParams_SetOutputFormat(wrPoseEstimatorConfigParams params, wrJointDefinitionHandleConst format) {
+    params->format = format;
+}
+
+wrPoseEstimatorOptionsHandle wrPoseEstimatorOptions_Create(void) {
+    return new wrPoseEstimatorOptions{ 0, 0, 0, 1, 0, 0 };
+}
+
+void wrPoseEstimatorOptions_Destroy(wrPoseEstimatorOptionsHandle options) { delete options; }
+void wrPoseEstimatorOptions_SetEstimateMask(wrPoseEstimatorOptionsHandle options, int yes_no) { options->estimate_mask = yes_no; }
+void wrPoseEstimatorOptions_SetEstimate3d(wrPoseEstimatorOptionsHandle options, int yes_no) { options->estimate_3d = yes_no; }
+void wrPoseEstimatorOptions_SetUseIK(wrPoseEstimatorOptionsHandle options, int yes_no) { options->use_ik = yes_no; }
+void wrPoseEstimatorOptions_SetEnableJointSmoothing(wrPoseEstimatorOptionsHandle options, int yes_no) { options->joint_smoothing = yes_no; }
+void wrPoseEstimatorOptions_SetEstimatePoseFace(wrPoseEstimatorOptionsHandle options, int yes_no) { options->pose_face = yes_no; }
+void wrPoseEstimatorOptions_SetRotationMultipleOf90(wrPoseEstimatorOptionsHandle options, int rotation) { options->rotation = rotation; }
+
+wrIKParamsHandle wrIKParams_Create(void) { return new wrIKParams(); }
+void wrIKParams_Destroy(wrIKParamsHandle params) { delete params; }
+
+// Estimator
+
+wrReturnCode wrPoseEstimator_CreateFromConfig(wrPoseEstimatorHandle* handle, wrPoseEstimatorConfigParamsConst config_params) {
+    if (!handle || !config_params) return wrReturnCode_OTHER_ERROR;
+    if (config_params->format != &J23) return wrReturnCode_JOINT_DEFINITION_ERROR;
+    *handle = new wrPoseEstimator{ &J23, 0, {} };
+    return wrReturnCode_OK;
+}
+
+wrReturnCode wrPoseEstimator_ReinitializeFromConfig(wrPoseEstimatorHandle* handle, wrPoseEstimatorConfigParamsConst config_params) {
+    if (!handle) return wrReturnCode_OTHER_ERROR;
+    wrPoseEstimator_Destroy(*handle);
+    *handle = nullptr;
+    return wrPoseEstimator_CreateFromConfig(handle, config_params);
+}
+
+void wrPoseEstimator_Destroy(wrPoseEstimatorHandle handle) {
+    delete handle;
+}
+
+wrReturnCode wrPoseEstimator_Initialize3D(wrPoseEstimatorHandle, wrIKParamsHandleConst, const char*) {
+    return wrReturnCode_UNSUPPORTED_ON_PLATFORM;
+}
+
+wrJointDefinitionHandleConst wrPoseEstimator_GetHuman2DOutputFormat(wrPoseEstimatorHandleConst handle) {
+    return handle->format;
+}
+
+wrJointDefinitionHandleConst wrPoseEstimator_GetFaceOutputFormat(wrPoseEstimatorHandleConst) {
+    return nullptr;
+}
+
+int wrPoseEstimator_SupportsMaskEstimation(wrPoseEstimatorHandleConst) {
+    return 0;
+}
+
+wrReturnCode wrPoseEstimator_ProcessFrame(wrPoseEstimatorHandle handle, const unsigned char* bgr, int width, int height,
+                                          wrPoseEstimatorOptionsHandleConst options) {
+    const auto start = std::chrono::steady_clock::now();
+    if (!handle || !bgr || width <= 0 || height <= 0 || !options) return wrReturnCode_OTHER_ERROR;
+
+    const WrnchStubConfig c = wrnchStubConfig();
+    const uint64_t frame = handle->frame++;
+    handle->humans.resize(c.num_people);
+    for (int p = 0; p < c.num_people; p++) {
+        synthesizePerson(frame, p, c.num_people, c, &handle->humans[p]);
+    }
+    waitLatency(frame, c, start);
+    return wrReturnCode_OK;
+}
+
+unsigned int wrPoseEstimator_GetNumHumans2D(wrPoseEstimatorHandleConst handle) {
+    return (unsigned int) handle->humans.size();
+}
+
+wrPose2dHandleConst wrPoseEstimator_GetHumans2DBegin(wrPoseEstimatorHandleConst handle) {
+    return handle->humans.empty() ? nullptr : handle->humans.data();
+}
+
+wrPose2dHandleConst wrPoseEstimator_GetPose2DNext(wrPose2dHandleConst pose) {
+    return pose + 1;
+}
+
+void wrPoseEstimator_GetMaskDims(wrPoseEstimatorHandleConst, int* width, int* height, int* depth) {
+    *width = *height = *depth = 0;
+}
+
+const unsigned char* wrPoseEstimator_GetMaskView(wrPoseEstimatorHandleConst) {
+    return nullptr;
+}
+
+wrPoseFaceHandleConst wrPoseEstimator_GetFacePosesBegin(wrPoseEstimatorHandleConst) { return nullptr; }
+wrPoseFaceHandleConst wrPoseEstimator_GetFacePosesNext(wrPoseFaceHandleConst) { return nullptr; }
+wrPoseFaceHandleConst wrPoseEstimator_GetFacePosesEnd(wrPoseEstimatorHandleConst) { return nullptr; }
+
+unsigned int wrPoseEstimator_GetNumHumans3D(wrPoseEstimatorHandleConst) { return 0; }
+wrPose3dHandleConst wrPoseEstimator_GetHumans3DBegin(wrPoseEstimatorHandleConst) { return nullptr; }
+wrPose3dHandleConst wrPoseEstimator_GetPose3DNext(wrPose3dHandleConst) { return nullptr; }
+
+// Poses
+
+int wrPose2d_GetId(wrPose2dHandleConst pose) { return pose->id; }
+int wrPose2d_GetIsMain(wrPose2dHandleConst pose) { return pose->is_main; }
+unsigned int wrPose2d_GetNumJoints(wrPose2dHandleConst) { return J23_JOINTS; }
+const float* wrPose2d_GetJoints(wrPose2dHandleConst pose) { return pose->joints; }
+const float* wrPose2d_GetScores(wrPose2dHandleConst pose) { return pose->scores; }
+float wrPose2d_GetScore(wrPose2dHandleConst pose) { return pose->score; }
+wrBox2dHandleConst wrPose2d_GetBoundingBox(wrPose2dHandleConst pose) { return &pose->box; }
+
+float wrBox2d_GetMinX(wrBox2dHandleConst box) { return box->min_x; }
+float wrBox2d_GetMinY(wrBox2dHandleConst box) { return box->min_y; }
+float wrBox2d_GetWidth(wrBox2dHandleConst box) { return box->width; }
+float wrBox2d_GetHeight(wrBox2dHandleConst box) { return box->height; }
+
+// Never produced by the stub: there are no 3D poses or faces to ask about.
+
+int wrPose3d_GetId(wrPose3dHandleConst) { return -1; }
+unsigned int wrPose3d_GetNumJoints(wrPose3dHandleConst) { return 0; }
+const float* wrPose3d_GetPositions(wrPose3dHandleConst) { return nullptr; }
+const float* wrPose3d_GetRotations(wrPose3dHandleConst) { return nullptr; }
+
+int wrPoseFace_GetId(wrPoseFaceHandleConst) { return -1; }
+unsigned int wrPoseFace_GetNumLandmarks(wrPoseFaceHandleConst) { return 0; }
+const float* wrPoseFace_GetLandmarks(wrPoseFaceHandleConst) { return nullptr; }
+wrArrowHandleConst wrPoseFace_GetFaceArrow(wrPoseFaceHandleConst) { return nullptr; }
+wrBox2dHandleConst wrPoseFace_GetBoundingBox(wrPoseFaceHandleConst) { return nullptr; }
+
+float wrArrow_GetTipX(wrArrowHandleConst) { return 0.0f; }
+float wrArrow_GetTipY(wrArrowHandleConst) { return 0.0f; }
+float wrArrow_GetBaseX(wrArrowHandleConst) { return 0.0f; }
+float wrArrow_GetBaseY(wrArrowHandleConst) { return 0.0f; }
+
+// Activity models: there are none to load.
+
+wrReturnCode wrActivityModelBuilder_Create(char const*, wrActivityModelBuilderHandle* builder) {
+    *builder = nullptr;
+    return wrReturnCode_NO_MODELS;
+}
+
+void wrActivityModelBuilder_Destroy(wrActivityModelBuilderHandle builder) { delete builder; }
+
+wrReturnCode wrActivityModelBuilder_Build(wrActivityModelBuilderHandleConst, wrActivityModelHandle* model) {
+    *model = nullptr;
+    return wrReturnCode_NO_MODELS;
+}
+
+wrReturnCode wrActivityModelBuilder_PoseEstimatorRequirements(wrActivityModelBuilderHandleConst,
+                                                              wrPoseEstimatorRequirementsHandle* requirements) {
+    *requirements = nullptr;
+    return wrReturnCode_NO_MODELS;
+}
+
+void wrPoseEstimatorRequirements_Destroy(wrPoseEstimatorRequirementsHandle requirements) { delete requirements; }
+
+wrPoseEstimatorOptionsHandle wrPoseEstimatorRequirements_CreateCompatibleOptions(wrPoseEstimatorRequirementsHandleConst requirements) {
+    return new wrPoseEstimatorOptions(requirements->options);
+}
+
+int wrPoseEstimatorRequirements_IsEstimatorCompatible(wrPoseEstimatorRequirementsHandleConst, wrPoseEstimatorHandleConst) {
+    return 1;
+}
+
+void wrActivityModel_Destroy(wrActivityModelHandle model) { delete model; }
+void wrActivityModel_ProcessPoses(wrActivityModelHandle, wrPoseEstimatorHandleConst, int, int) {}
+int wrActivityModel_NumClasses(wrActivityModelHandleConst) { return 0; }
+void wrActivityModel_ClassNames(wrActivityModelHandleConst, char const**) {}
+wrIndividualActivityModelHandleConst wrActivityModel_IndividualModel(wrActivityModelHandleConst, int) { return nullptr; }
+int wrActivityModel_NumIndividualModels(wrActivityModelHandleConst) { return 0; }
+void wrActivityModel_PersonIds(wrActivityModelHandleConst, int*) {}
+float const* wrIndividualActivityModel_Probabilities(wrIndividualActivityModelHandleConst) { return nullptr; }
+
+} // extern "C"
@@ -0,0 +1,27 @@
+#ifndef WRNCH_STUB_H
+#define WRNCH_STUB_H
+
+// The host build links this stub instead of libwrAPI: the subset of the wrnch C API the app
+// calls, with no models behind it. wrPoseEstimator_ProcessFrame takes a configurable time
+// and then reports synthetic j23 people doing squats, the same for every run with the same
+// configuration and frame count, whatever the image. Face, mask, 3D and activity estimation
+// report nothing or fail as unsupported, the way a device without those models would.
+
+struct WrnchStubConfig {
+    int num_people;             // people in every frame, the first one is the main person
+    unsigned int latency_us;    // mean ProcessFrame time
+    unsigned int jitter_us;     // spread uniformly around the mean, up to this much either way
+    bool busy_wait;             // spin instead of sleeping, to take a core like CPU inference
+    float fps;                  // frame rate the synthetic motion is paced for
+    float dropout;              // chance of any one joint being missed
+};
+
+// The defaults, overridden by the environment variables WRNCH_STUB_PEOPLE,
+// WRNCH_STUB_LATENCY_US, WRNCH_STUB_JITTER_US, WRNCH_STUB_BUSY and WRNCH_STUB_DROPOUT.
+WrnchStubConfig wrnchStubDefaults();
+
+// Applies from the next frame on, to every estimator; thread safe.
+void setWrnchStubConfig(const WrnchStubConfig& config);
+WrnchStubConfig wrnchStubConfig();
+
+#endif // WRNCH_STUB_H
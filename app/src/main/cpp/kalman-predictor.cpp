@@ -0,0 +1,236 @@
+#include "kalman-predictor.h"
+
+#include <algorithm>
+
+#include "simd4.h"
+
+// Variance of velocity and acceleration a new joint starts with.
+static const float INITIAL_VELOCITY_VAR = 1.0f;
+static const float INITIAL_ACCELERATION_VAR = 25.0f;
+
+KalmanPosePredictor::KalmanPosePredictor(unsigned int num_joints, size_t max_tracks, KalmanModel model)
+        : num_joints_(num_joints), max_tracks_(max_tracks), stride_((num_joints * 2 + 3) & ~(size_t) 3),
+          model_(model), tracks_(max_tracks), state_(NUM_FIELDS * max_tracks * stride_, 0.0f), z_(stride_, 0.0f) {
+    setNoise(model == KalmanModel::CONSTANT_VELOCITY ? 2.0f : 40.0f, 2.5e-5f);
+    clear();
+}
+
+void KalmanPosePredictor::setModel(KalmanModel model) {
+    model_ = model;
+    clear();
+}
+
+void KalmanPosePredictor::setNoise(float process_noise, float measurement_noise) {
+    process_noise_ = process_noise;
+    measurement_noise_ = measurement_noise;
+}
+
+void KalmanPosePredictor::clear() {
+    for (auto& track : tracks_) {
+        track.live = false;
+        track.id = -1;
+        track.last_update_us = 0;
+        track.valid_mask = 0;
+    }
+}
+
+int KalmanPosePredictor::findTrack(int id) const {
+    for (size_t i = 0; i < max_tracks_; i++) {
+        if (tracks_[i].live && tracks_[i].id == id) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+int KalmanPosePredictor::acquireTrack(int id) {
+    size_t victim = 0;
+    for (size_t i = 0; i < max_tracks_; i++) {
+        if (!tracks_[i].live) {
+            victim = i;
+            break;
+        }
+        if (tracks_[i].last_update_us < tracks_[victim].last_update_us) {
+            victim = i;
+        }
+    }
+
+    Track& track = tracks_[victim];
+    track.id = id;
+    track.live = true;
+    track.valid_mask = 0;
+    return (int) victim;
+}
+
+void KalmanPosePredictor::seed(size_t slot, size_t channel, float z) {
+    field(P, slot)[channel] = z;
+    field(V, slot)[channel] = 0.0f;
+    field(A, slot)[channel] = 0.0f;
+    field(C00, slot)[channel] = measurement_noise_;
+    field(C01, slot)[channel] = 0.0f;
+    field(C02, slot)[channel] = 0.0f;
+    field(C11, slot)[channel] = INITIAL_VELOCITY_VAR;
+    field(C12, slot)[channel] = 0.0f;
+    field(C22, slot)[channel] = INITIAL_ACCELERATION_VAR;
+}
+
+// Predict over dt then update with measurement z, constant velocity model.
+static void stepConstantVelocity(float* p, float* v, float* c00, float* c01, float* c11, const float* z,
+                                 size_t n, float dt, float q, float r) {
+    const f32x4 h = set4(dt);
+    const f32x4 h2 = set4(dt * dt);
+    const f32x4 q00 = set4(q * dt * dt * dt / 3.0f);
+    const f32x4 q01 = set4(q * dt * dt / 2.0f);
+    const f32x4 q11 = set4(q * dt);
+    const f32x4 rv = set4(r);
+    const f32x4 one = set4(1.0f);
+
+    for (size_t i = 0; i < n; i += 4) {
+        f32x4 pp = load4(p + i);
+        f32x4 vv = load4(v + i);
+        const f32x4 a00 = load4(c00 + i);
+        const f32x4 a01 = load4(c01 + i);
+        const f32x4 a11 = load4(c11 + i);
+
+        // predict: x = F x, C = F C F' + Q
+        pp = madd4(pp, vv, h);
+        const f32x4 b00 = add4(madd4(madd4(a00, a01, add4(h, h)), a11, h2), q00);
+        const f32x4 b01 = add4(madd4(a01, a11, h), q01);
+        const f32x4 b11 = add4(a11, q11);
+
+        // update with a position measurement
+        const f32x4 s = add4(b00, rv);
+        const f32x4 k0 = div4(b00, s);
+        const f32x4 k1 = div4(b01, s);
+        const f32x4 y = sub4(load4(z + i), pp);
+        const f32x4 k0c = sub4(one, k0);
+
+        store4(p + i, madd4(pp, k0, y));
+        store4(v + i, madd4(vv, k1, y));
+        store4(c00 + i, mul4(k0c, b00));
+        store4(c01 + i, mul4(k0c, b01));
+        store4(c11 + i, sub4(b11, mul4(k1, b01)));
+    }
+}
+
+// Same for the constant acceleration model.
+static void stepConstantAcceleration(float* p, float* v, float* a, float* c00, float* c01, float* c02,
+                                     float* c11, float* c12, float* c22, const float* z,
+                                     size_t n, float dt, float q, float r) {
+    const f32x4 h = set4(dt);
+    const f32x4 hh = set4(dt * dt / 2.0f);
+    const float dt2 = dt * dt, dt3 = dt2 * dt;
+    const f32x4 q00 = set4(q * dt3 * dt2 / 20.0f);
+    const f32x4 q01 = set4(q * dt2 * dt2 / 8.0f);
+    const f32x4 q02 = set4(q * dt3 / 6.0f);
+    const f32x4 q11 = set4(q * dt3 / 3.0f);
+    const f32x4 q12 = set4(q * dt2 / 2.0f);
+    const f32x4 q22 = set4(q * dt);
+    const f32x4 rv = set4(r);
+
+    for (size_t i = 0; i < n; i += 4) {
+        f32x4 pp = load4(p + i);
+        f32x4 vv = load4(v + i);
+        f32x4 aa = load4(a + i);
+        const f32x4 a00 = load4(c00 + i), a01 = load4(c01 + i), a02 = load4(c02 + i);
+        const f32x4 a11 = load4(c11 + i), a12 = load4(c12 + i), a22 = load4(c22 + i);
+
+        // predict: F = [1 h h^2/2; 0 1 h; 0 0 1]
+        pp = madd4(madd4(pp, vv, h), aa, hh);
+        vv = madd4(vv, aa, h);
+        const f32x4 r00 = madd4(madd4(a00, a01, h), a02, hh);   // rows of F C
+        const f32x4 r01 = madd4(madd4(a01, a11, h), a12, hh);
+        const f32x4 r02 = madd4(madd4(a02, a12, h), a22, hh);
+        const f32x4 r11 = madd4(a11, a12, h);
+        const f32x4 r12 = madd4(a12, a22, h);
+        const f32x4 b00 = add4(madd4(madd4(r00, r01, h), r02, hh), q00);
+        const f32x4 b01 = add4(madd4(r01, r02, h), q01);
+        const f32x4 b02 = add4(r02, q02);
+        const f32x4 b11 = add4(madd4(r11, r12, h), q11);
+        const f32x4 b12 = add4(r12, q12);
+        const f32x4 b22 = add4(a22, q22);
+
+        // update
+        const f32x4 s = add4(b00, rv);
+        const f32x4 k0 = div4(b00, s);
+        const f32x4 k1 = div4(b01, s);
+        const f32x4 k2 = div4(b02, s);
+        const f32x4 y = sub4(load4(z + i), pp);
+
+        store4(p + i, madd4(pp, k0, y));
+        store4(v + i, madd4(vv, k1, y));
+        store4(a + i, madd4(aa, k2, y));
+        store4(c00 + i, sub4(b00, mul4(k0, b00)));
+        store4(c01 + i, sub4(b01, mul4(k0, b01)));
+        store4(c02 + i, sub4(b02, mul4(k0, b02)));
+        store4(c11 + i, sub4(b11, mul4(k1, b01)));
+        store4(c12 + i, sub4(b12, mul4(k1, b02)));
+        store4(c22 + i, sub4(b22, mul4(k2, b02)));
+    }
+}
+
+void KalmanPosePredictor::update(int id, int64_t timestamp_us, const float* joints, uint32_t valid_mask) {
+    int slot = findTrack(id);
+    if (slot < 0) {
+        slot = acquireTrack(id);
+    }
+
+    Track& track = tracks_[slot];
+    const int64_t gap_us = timestamp_us - track.last_update_us;
+    if (gap_us <= 0 || gap_us > MAX_GAP_US) {
+        track.valid_mask = 0;
+    }
+    track.last_update_us = timestamp_us;
+
+    const size_t channels = num_joints_ * 2;
+    std::copy(joints, joints + channels, z_.begin());
+
+    const uint32_t tracked = track.valid_mask & valid_mask;
+    if (tracked) {
+        const float dt = gap_us * 1e-6f;
+        if (model_ == KalmanModel::CONSTANT_VELOCITY) {
+            stepConstantVelocity(field(P, slot), field(V, slot), field(C00, slot), field(C01, slot), field(C11, slot),
+                                 z_.data(), stride_, dt, process_noise_, measurement_noise_);
+        } else {
+            stepConstantAcceleration(field(P, slot), field(V, slot), field(A, slot), field(C00, slot), field(C01, slot),
+                                     field(C02, slot), field(C11, slot), field(C12, slot), field(C22, slot),
+                                     z_.data(), stride_, dt, process_noise_, measurement_noise_);
+        }
+    }
+
+    // new, returning and lost joints restart from the measurement
+    for (unsigned int j = 0; j < num_joints_; j++) {
+        if (!(tracked & (1u << j))) {
+            seed(slot, j * 2, joints[j * 2]);
+            seed(slot, j * 2 + 1, joints[j * 2 + 1]);
+        }
+    }
+    track.valid_mask = valid_mask;
+}
+
+bool KalmanPosePredictor::predict(int id, int64_t time_us, float* out, uint32_t* valid_mask) const {
+    const int slot = findTrack(id);
+    if (slot < 0) {
+        return false;
+    }
+
+    const Track& track = tracks_[slot];
+    const int64_t horizon_us = MAX_HORIZON_US;
+    const float t = std::min(std::max(time_us - track.last_update_us, (int64_t) 0), horizon_us) * 1e-6f;
+    const float* p = field(P, slot);
+    const float* v = field(V, slot);
+    const float* a = field(A, slot);
+    const float tt = model_ == KalmanModel::CONSTANT_ACCELERATION ? t * t / 2.0f : 0.0f;
+
+    for (unsigned int j = 0; j < num_joints_; j++) {
+        if (track.valid_mask & (1u << j)) {
+            out[j * 2] = p[j * 2] + v[j * 2] * t + a[j * 2] * tt;
+            out[j * 2 + 1] = p[j * 2 + 1] + v[j * 2 + 1] * t + a[j * 2 + 1] * tt;
+        } else {
+            out[j * 2] = -1.0f;
+            out[j * 2 + 1] = -1.0f;
+        }
+    }
+    *valid_mask = track.valid_mask;
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef KALMAN_PREDICTOR_H
+#define KALMAN_PREDICTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-joint Kalman tracking of every tracked person, used to predict where the joints are
+// at a later time than the frame they were estimated from (latency compensation).
+//
+// Each x and y coordinate is an independent constant velocity (position, velocity) or
+// constant acceleration (plus acceleration) filter driven by white noise in the highest
+// derivative. State and covariance live struct-of-arrays per track slot, padded to a
+// multiple of 4 channels, so one frame is a single vectorized predict + update pass over
+// all joints. The class does no locking of its own.
+
+enum class KalmanModel {
+    CONSTANT_VELOCITY,
+    CONSTANT_ACCELERATION,
+};
+
+class KalmanPosePredictor {
+public:
+    // Gaps longer than this restart the filter; predictions further ahead than
+    // MAX_HORIZON_US are clamped to it.
+    static constexpr int64_t MAX_GAP_US = 500000;
+    static constexpr int64_t MAX_HORIZON_US = 250000;
+
+    KalmanPosePredictor(unsigned int num_joints, size_t max_tracks,
+                        KalmanModel model = KalmanModel::CONSTANT_VELOCITY);
+
+    // Changes the motion model, dropping all tracks.
+    void setModel(KalmanModel model);
+    KalmanModel model() const { return model_; }
+
+    // process_noise is the spectral density of the driving noise (acceleration for the
+    // constant velocity model, jerk for constant acceleration), measurement_noise the joint
+    // position variance, both in normalized image units.
+    void setNoise(float process_noise, float measurement_noise);
+
+    // Feeds a frame of person id (num_joints * 2 joints, x,y interleaved). Joints not in
+    // valid_mask are not predicted until they come back.
+    void update(int id, int64_t timestamp_us, const float* joints, uint32_t valid_mask);
+
+    // Joints of person id extrapolated to time_us, -1 for joints it does not track; false if
+    // the person is unknown.
+    bool predict(int id, int64_t time_us, float* out, uint32_t* valid_mask) const;
+
+    void clear();
+
+    unsigned int numJoints() const { return num_joints_; }
+
+private:
+    struct Track {
+        int id;
+        bool live;
+        int64_t last_update_us;
+        uint32_t valid_mask;
+    };
+
+    // State and covariance arrays, all slot-major with stride_ floats per slot. The
+    // acceleration terms are only used by the constant acceleration model.
+    enum Field { P, V, A, C00, C01, C02, C11, C12, C22, NUM_FIELDS };
+
+    int findTrack(int id) const;
+    int acquireTrack(int id);
+    float* field(Field f, size_t slot) { return &state_[(f * max_tracks_ + slot) * stride_]; }
+    const float* field(Field f, size_t slot) const { return &state_[(f * max_tracks_ + slot) * stride_]; }
+    void seed(size_t slot, size_t channel, float z);
+
+    unsigned int num_joints_;
+    size_t max_tracks_;
+    size_t stride_;
+    KalmanModel model_;
+    float process_noise_;
+    float measurement_noise_;
+    std::vector<Track> tracks_;
+    std::vector<float> state_;
+    std::vector<float> z_;      // padded measurement scratch
+};
+
+#endif // KALMAN_PREDICTOR_H
@@ -0,0 +1,61 @@
+#include "latency-histogram.h"
+
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram() : reset_requests_(0), resets_done_(0) {
+    applyReset(0);
+}
+
+void LatencyHistogram::applyReset(uint32_t requested) {
+    for (size_t b = 0; b < NUM_BUCKETS; b++) {
+        buckets_[b].store(0, std::memory_order_relaxed);
+    }
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+    // readers that see the reset done see the cleared counters
+    resets_done_.store(requested, std::memory_order_release);
+}
+
+uint64_t LatencyHistogram::count() const {
+    if (resetPending()) return 0;
+    uint64_t n = 0;
+    for (size_t b = 0; b < NUM_BUCKETS; b++) {
+        n += buckets_[b].load(std::memory_order_relaxed);
+    }
+    return n;
+}
+
+double LatencyHistogram::mean() const {
+    const uint64_t n = count();
+    return n ? (double) sum_.load(std::memory_order_relaxed) / n : 0.0;
+}
+
+void LatencyHistogram::percentiles(const double* quantiles, size_t n, uint64_t* out) const {
+    // a snapshot first, so every quantile sees the same counts
+    uint32_t counts[NUM_BUCKETS];
+    uint64_t total = 0;
+    const bool pending = resetPending();
+    for (size_t b = 0; b < NUM_BUCKETS; b++) {
+        counts[b] = pending ? 0 : buckets_[b].load(std::memory_order_relaxed);
+        total += counts[b];
+    }
+    // a bucket's middle can lie past the largest sample in it
+    const uint64_t largest = max();
+
+    size_t b = 0;
+    uint64_t below = 0;     // samples in buckets before b
+    for (size_t q = 0; q < n; q++) {
+        if (!total) {
+            out[q] = 0;
+            continue;
+        }
+        // the rank-th smallest sample, 1 based
+        uint64_t rank = (uint64_t) (quantiles[q] * total + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > total) rank = total;
+        while (below + counts[b] < rank) below += counts[b++];
+        const uint64_t start = bucketStart(b);
+        const uint64_t width = b + 1 < NUM_BUCKETS ? bucketStart(b + 1) - start : 1;
+        out[q] = std::min(start + width / 2, largest);
+    }
+}
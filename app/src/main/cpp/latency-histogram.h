@@ -0,0 +1,91 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed memory, lock-free latency histogram in nanoseconds.
+//
+// Buckets are logarithmic like HdrHistogram's: values below SUB_BUCKETS each get their own
+// bucket, above that every power of two is split into SUB_BUCKETS linear buckets, so a
+// percentile is off by less than 1 / SUB_BUCKETS of its value (3%) from 1 ns up to
+// MAX_VALUE, where larger values are clamped.
+//
+// One thread records (the stage's own thread); any other thread may read percentiles or
+// ask for a reset at the same time. With a single writer, recording needs no atomic
+// read-modify-write, only relaxed loads and stores of the counters, a few nanoseconds. A
+// reset is a request the writer carries out on its next record(); until then readers see
+// the histogram as empty. A read racing with records sees some of them and not others.
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 5;
+    static const uint64_t SUB_BUCKETS = 1u << SUB_BITS;
+    static const int MAX_SHIFT = 36 - SUB_BITS;         // up to 2^37 ns, two minutes
+    static const uint64_t MAX_VALUE = ((SUB_BUCKETS * 2) << MAX_SHIFT) - 1;
+    static const size_t NUM_BUCKETS = (MAX_SHIFT + 2) * SUB_BUCKETS;
+
+    LatencyHistogram();
+
+    // Writer side.
+    void record(uint64_t ns) {
+        const uint32_t requested = reset_requests_.load(std::memory_order_acquire);
+        if (requested != resets_done_.load(std::memory_order_relaxed)) applyReset(requested);
+        if (ns > MAX_VALUE) ns = MAX_VALUE;
+        bump(buckets_[bucketOf(ns)], 1u);
+        bump(sum_, ns);
+        if (ns > max_.load(std::memory_order_relaxed)) max_.store(ns, std::memory_order_relaxed);
+    }
+
+    // Writer side: records the time since start and returns now, to time consecutive stages.
+    std::chrono::steady_clock::time_point recordSince(std::chrono::steady_clock::time_point start) {
+        const auto now = std::chrono::steady_clock::now();
+        record((uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count());
+        return now;
+    }
+
+    // Reader side, any thread.
+    uint64_t count() const;
+    double mean() const;
+    uint64_t max() const { return resetPending() ? 0 : max_.load(std::memory_order_relaxed); }
+
+    // Values at the given quantiles (0..1, ascending) into out: the middle of the bucket
+    // holding each, at most max(), 0 while empty. One pass over the buckets for all of them.
+    void percentiles(const double* quantiles, size_t n, uint64_t* out) const;
+
+    // Any thread: empties the histogram, as far as readers can tell right away.
+    void reset() { reset_requests_.fetch_add(1, std::memory_order_acq_rel); }
+
+    // Bucket of value and the lowest value of bucket; exposed for the benchmark.
+    static size_t bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) return (size_t) value;
+        const int shift = 63 - __builtin_clzll(value) - SUB_BITS;
+        return (size_t) (shift + 1) * SUB_BUCKETS + (size_t) ((value >> shift) - SUB_BUCKETS);
+    }
+    static uint64_t bucketStart(size_t bucket) {
+        if (bucket < SUB_BUCKETS) return bucket;
+        const int shift = (int) (bucket / SUB_BUCKETS) - 1;
+        return (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    }
+
+private:
+    // Only the writer modifies a counter, so a plain load and store is an atomic increment.
+    template <typename T>
+    static void bump(std::atomic<T>& counter, T n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    bool resetPending() const {
+        return reset_requests_.load(std::memory_order_acquire) != resets_done_.load(std::memory_order_acquire);
+    }
+    void applyReset(uint32_t requested);
+
+    std::atomic<uint32_t> buckets_[NUM_BUCKETS];
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+    std::atomic<uint32_t> reset_requests_;
+    std::atomic<uint32_t> resets_done_;
+};
+
+#endif // LATENCY_HISTOGRAM_H
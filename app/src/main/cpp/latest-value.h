@@ -0,0 +1,55 @@
+#ifndef LATEST_VALUE_H
+#define LATEST_VALUE_H
+
+#include <atomic>
+
+// Lock-free single producer / single consumer slot holding the most recently published value.
+//
+// A triple buffer: the producer fills back() and publish()es it, the consumer picks up the
+// newest published buffer with latest(). Neither side ever waits for the other; values the
+// consumer did not get to in time are simply overwritten. Buffers are reused, so a T whose
+// members are assigned in place does not allocate in the steady state.
+template <typename T>
+class LatestValue {
+public:
+    LatestValue() : back_(0), front_(1), have_front_(false), middle_(2) {}
+
+    // Producer side.
+    T& back() { return buffers_[back_]; }
+
+    void publish() {
+        const int prev = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel);
+        back_ = prev & INDEX_MASK;
+    }
+
+    // Consumer side: the newest published value, or nullptr if none was published yet. The
+    // pointer stays valid until the next call.
+    const T* latest() {
+        if (middle_.load(std::memory_order_relaxed) & FRESH) {
+            const int prev = middle_.exchange(front_, std::memory_order_acq_rel);
+            front_ = prev & INDEX_MASK;
+            have_front_ = true;
+        }
+        return have_front_ ? &buffers_[front_] : nullptr;
+    }
+
+    // Only while neither side is active.
+    void reset() {
+        back_ = 0;
+        front_ = 1;
+        have_front_ = false;
+        middle_.store(2, std::memory_order_relaxed);
+    }
+
+private:
+    static const int INDEX_MASK = 3;
+    static const int FRESH = 4;
+
+    T buffers_[3];
+    int back_;
+    int front_;
+    bool have_front_;
+    std::atomic<int> middle_;   // index of the buffer between the two sides, plus FRESH
+};
+
+#endif // LATEST_VALUE_H
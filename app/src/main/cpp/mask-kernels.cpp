@@ -0,0 +1,205 @@
+#include "mask-kernels.h"
+
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void linearSamplePositions(int src_size, int dst_size, std::vector<int32_t>& pos, std::vector<uint16_t>& weight) {
+    pos.resize(dst_size);
+    weight.resize(dst_size);
+
+    const float scale = (float) src_size / dst_size;
+    for (int i = 0; i < dst_size; i++) {
+        const float s = std::min(std::max((i + 0.5f) * scale - 0.5f, 0.0f), (float) (src_size - 1));
+        int p = (int) s;
+        int w = (int) ((s - p) * 256.0f + 0.5f);
+        // keep p + 1 in range; the last sample then takes all its weight from p + 1
+        if (p >= src_size - 1) {
+            p = std::max(src_size - 2, 0);
+            w = src_size > 1 ? 256 : 0;
+        }
+        pos[i] = p;
+        weight[i] = (uint16_t) w;
+    }
+}
+
+MaskUpsampler::MaskUpsampler()
+        : src_width_(0), src_height_(0), dst_width_(0), dst_height_(0), widened_y_{ -1, -1 }, pass_src_(nullptr),
+          pass_y_(-1) {}
+
+void MaskUpsampler::configure(int src_width, int src_height, int dst_width, int dst_height) {
+    if (src_width == src_width_ && src_height == src_height_ && dst_width == dst_width_ && dst_height == dst_height_) {
+        return;
+    }
+    src_width_ = src_width;
+    src_height_ = src_height;
+    dst_width_ = dst_width;
+    dst_height_ = dst_height;
+
+    linearSamplePositions(src_width, dst_width, x0_, wx_);
+    linearSamplePositions(src_height, dst_height, y0_, wy_);
+    // a single column mask reads x0 + 1 = 1 with weight 0; point it back at column 0
+    for (int32_t& x : x0_) x = std::min(x, src_width - 1);
+    for (int i = 0; i < 2; i++) {
+        widened_[i].assign(dst_width, 0);
+        widened_y_[i] = -1;
+    }
+    pass_src_ = nullptr;
+    pass_y_ = -1;
+    row_.assign(dst_width, 0);
+}
+
+// Horizontal blend of source row src_y over the display width from precomputed positions.
+void MaskUpsampler::widen(const uint8_t* src, int src_y, uint16_t* __restrict out) const {
+    const uint8_t* __restrict row = src + (size_t) src_y * src_width_;
+    const int32_t* __restrict x0 = x0_.data();
+    const uint16_t* __restrict wx = wx_.data();
+    const int last = src_width_ - 1;
+    for (int x = 0; x < dst_width_; x++) {
+        const uint32_t a = row[x0[x]];
+        const uint32_t b = row[std::min(x0[x] + 1, last)];
+        out[x] = (uint16_t) (a * (256 - wx[x]) + b * wx[x]);
+    }
+}
+
+void MaskUpsampler::upsampleRow(const uint8_t* src, int y, uint8_t* dst_row) {
+    if (src != pass_src_ || y <= pass_y_) {
+        widened_y_[0] = widened_y_[1] = -1;
+        pass_src_ = src;
+    }
+    pass_y_ = y;
+
+    const int y0 = y0_[y];
+    const int y1 = std::min(y0 + 1, src_height_ - 1);
+    // rows only move down, so the old bottom row is usually the new top one
+    if (widened_y_[0] != y0) {
+        if (widened_y_[1] == y0) {
+            widened_[0].swap(widened_[1]);
+            widened_y_[0] = y0;
+            widened_y_[1] = -1;
+        } else {
+            widen(src, y0, widened_[0].data());
+            widened_y_[0] = y0;
+        }
+    }
+    if (widened_y_[1] != y1) {
+        widen(src, y1, widened_[1].data());
+        widened_y_[1] = y1;
+    }
+
+    // vertical blend over the display width: (top * (256 - wy) + bottom * wy) / 2^16, rounded
+    const uint16_t* __restrict top = widened_[0].data();
+    const uint16_t* __restrict bottom = widened_[1].data();
+    const uint16_t wy = wy_[y];
+    const uint16_t wy0 = 256 - wy;
+    int x = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint16x4_t w0 = vdup_n_u16(wy0), w1 = vdup_n_u16(wy);
+    for (; x + 8 <= dst_width_; x += 8) {
+        const uint16x8_t t = vld1q_u16(top + x), b = vld1q_u16(bottom + x);
+        const uint32x4_t lo = vmlal_u16(vmull_u16(vget_low_u16(t), w0), vget_low_u16(b), w1);
+        const uint32x4_t hi = vmlal_u16(vmull_u16(vget_high_u16(t), w0), vget_high_u16(b), w1);
+        const uint16x8_t v = vcombine_u16(vrshrn_n_u32(lo, 16), vrshrn_n_u32(hi, 16));
+        vst1_u8(dst_row + x, vqmovn_u16(v));
+    }
+#elif defined(__SSE2__)
+    const __m128i w0 = _mm_set1_epi16((short) wy0), w1 = _mm_set1_epi16((short) wy);
+    const __m128i round = _mm_set1_epi32(1 << 15);
+    for (; x + 16 <= dst_width_; x += 16) {
+        __m128i halves[2];
+        for (int h = 0; h < 2; h++) {
+            const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + x + h * 8));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + x + h * 8));
+            // 32 bit products from the low and high 16 bits of each
+            const __m128i tl = _mm_mullo_epi16(t, w0), th = _mm_mulhi_epu16(t, w0);
+            const __m128i bl = _mm_mullo_epi16(b, w1), bh = _mm_mulhi_epu16(b, w1);
+            __m128i lo = _mm_add_epi32(_mm_unpacklo_epi16(tl, th), _mm_unpacklo_epi16(bl, bh));
+            __m128i hi = _mm_add_epi32(_mm_unpackhi_epi16(tl, th), _mm_unpackhi_epi16(bl, bh));
+            lo = _mm_srli_epi32(_mm_add_epi32(lo, round), 16);
+            hi = _mm_srli_epi32(_mm_add_epi32(hi, round), 16);
+            halves[h] = _mm_packs_epi32(lo, hi);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_row + x), _mm_packus_epi16(halves[0], halves[1]));
+    }
+#endif
+
+    for (; x < dst_width_; x++) {
+        dst_row[x] = (uint8_t) ((top[x] * wy0 + bottom[x] * wy + (1u << 15)) >> 16);
+    }
+}
+
+void maskUpsampleScalar(const uint8_t* src, int src_width, int src_height, int dst_width, int dst_height,
+                        uint8_t* dst) {
+    std::vector<int32_t> x0, y0;
+    std::vector<uint16_t> wx, wy;
+    linearSamplePositions(src_width, dst_width, x0, wx);
+    linearSamplePositions(src_height, dst_height, y0, wy);
+    for (int y = 0; y < dst_height; y++) {
+        const uint8_t* top = src + (size_t) y0[y] * src_width;
+        const uint8_t* bottom = src + (size_t) std::min(y0[y] + 1, src_height - 1) * src_width;
+        for (int x = 0; x < dst_width; x++) {
+            const int a = std::min(x0[x], src_width - 1), b = std::min(x0[x] + 1, src_width - 1);
+            const uint32_t h0 = top[a] * (256 - wx[x]) + top[b] * wx[x];
+            const uint32_t h1 = bottom[a] * (256 - wx[x]) + bottom[b] * wx[x];
+            dst[(size_t) y * dst_width + x] = (uint8_t) ((h0 * (256 - wy[y]) + h1 * wy[y] + (1u << 15)) >> 16);
+        }
+    }
+}
+
+void maskToAlpha(const uint8_t* mask, size_t count, uint8_t threshold, uint32_t color, uint32_t* rgba) {
+    size_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint8x16_t thr = vdupq_n_u8(threshold);
+    const uint32x4_t col = vdupq_n_u32(color);
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t m = vcgeq_u8(vld1q_u8(mask + i), thr);
+        const uint8x16x2_t m16 = vzipq_u8(m, m);
+        const uint16x8x2_t lo = vzipq_u16(vreinterpretq_u16_u8(m16.val[0]), vreinterpretq_u16_u8(m16.val[0]));
+        const uint16x8x2_t hi = vzipq_u16(vreinterpretq_u16_u8(m16.val[1]), vreinterpretq_u16_u8(m16.val[1]));
+        vst1q_u32(rgba + i, vandq_u32(vreinterpretq_u32_u16(lo.val[0]), col));
+        vst1q_u32(rgba + i + 4, vandq_u32(vreinterpretq_u32_u16(lo.val[1]), col));
+        vst1q_u32(rgba + i + 8, vandq_u32(vreinterpretq_u32_u16(hi.val[0]), col));
+        vst1q_u32(rgba + i + 12, vandq_u32(vreinterpretq_u32_u16(hi.val[1]), col));
+    }
+#elif defined(__SSE2__)
+    const __m128i thr = _mm_set1_epi8((char) threshold);
+    const __m128i col = _mm_set1_epi32((int) color);
+    for (; i + 16 <= count; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + i));
+        // unsigned v >= thr  <=>  max(v, thr) == v
+        const __m128i m = _mm_cmpeq_epi8(_mm_max_epu8(v, thr), v);
+        const __m128i lo = _mm_unpacklo_epi8(m, m);
+        const __m128i hi = _mm_unpackhi_epi8(m, m);
+        __m128i* out = reinterpret_cast<__m128i*>(rgba + i);
+        _mm_storeu_si128(out, _mm_and_si128(_mm_unpacklo_epi16(lo, lo), col));
+        _mm_storeu_si128(out + 1, _mm_and_si128(_mm_unpackhi_epi16(lo, lo), col));
+        _mm_storeu_si128(out + 2, _mm_and_si128(_mm_unpacklo_epi16(hi, hi), col));
+        _mm_storeu_si128(out + 3, _mm_and_si128(_mm_unpackhi_epi16(hi, hi), col));
+    }
+#endif
+
+    for (; i < count; i++) {
+        rgba[i] = mask[i] >= threshold ? color : 0;
+    }
+}
+
+void renderMaskOverlay(MaskUpsampler& upsampler, const uint8_t* mask, int mask_width, int mask_height,
+                       uint8_t* rgba, int width, int height, size_t stride, uint8_t threshold, uint32_t color) {
+    if (mask_width <= 0 || mask_height <= 0 || width <= 0 || height <= 0) {
+        return;
+    }
+
+    upsampler.configure(mask_width, mask_height, width, height);
+
+    uint8_t* row = upsampler.row();
+    for (int y = 0; y < height; y++) {
+        upsampler.upsampleRow(mask, y, row);
+        maskToAlpha(row, width, threshold, color, reinterpret_cast<uint32_t*>(rgba + y * stride));
+    }
+}
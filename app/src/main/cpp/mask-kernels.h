@@ -0,0 +1,73 @@
+#ifndef MASK_KERNELS_H
+#define MASK_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Kernels turning the estimator's low resolution segmentation mask into a display sized
+// RGBA overlay.
+//
+// The overlay is produced a row at a time: a bilinear upsample writes one display row of
+// mask confidences into a small scratch row, which the threshold kernel turns into RGBA
+// pixels, so no display sized intermediate buffer is needed. The upsample is horizontal
+// first: each source row is widened to the display width once per pass and kept, so a
+// display row is a SIMD blend of the two widened rows around it and the gather of the
+// horizontal pass runs src_height times per frame instead of once per display row.
+
+// Sample positions for a linear resize of src_size to dst_size with pixel centers aligned:
+// output i blends input pos[i] and pos[i] + 1 (always in range if src_size > 1), the latter
+// with weight[i] in 8.8 fixed point.
+void linearSamplePositions(int src_size, int dst_size, std::vector<int32_t>& pos, std::vector<uint16_t>& weight);
+
+// Precomputed horizontal and vertical sample positions for one src -> dst size pair, and
+// the two widened source rows of the current pass.
+class MaskUpsampler {
+public:
+    MaskUpsampler();
+
+    void configure(int src_width, int src_height, int dst_width, int dst_height);
+
+    // Upsamples dst row y of the src mask (src_width x src_height, tightly packed). Widened
+    // rows are reused while y increases over the same src; a y not above the last one or
+    // another src starts a new pass, so a new mask in the same buffer must start at row 0.
+    void upsampleRow(const uint8_t* src, int y, uint8_t* dst_row);
+
+    // Scratch row of dstWidth() bytes for callers working a row at a time.
+    uint8_t* row() { return row_.data(); }
+
+    int dstWidth() const { return dst_width_; }
+    int dstHeight() const { return dst_height_; }
+
+private:
+    int src_width_;
+    int src_height_;
+    int dst_width_;
+    int dst_height_;
+    std::vector<int32_t> x0_;       // left source column per dst column
+    std::vector<uint16_t> wx_;      // weight of the right column, 8.8 fixed point
+    std::vector<int32_t> y0_;
+    std::vector<uint16_t> wy_;
+    std::vector<uint16_t> widened_[2];  // source rows at dst width, 8.8 fixed point
+    int widened_y_[2];                  // their source rows, -1 for none
+    const uint8_t* pass_src_;
+    int pass_y_;                        // last row of the pass
+    std::vector<uint8_t> row_;
+
+    void widen(const uint8_t* src, int src_y, uint16_t* out) const;
+};
+
+// Reference for the upsample: every dst pixel blended from its four source pixels at once.
+void maskUpsampleScalar(const uint8_t* src, int src_width, int src_height, int dst_width, int dst_height,
+                        uint8_t* dst);
+
+// Writes color (premultiplied RGBA, as packed in memory) where mask >= threshold and
+// transparent black elsewhere, for count pixels.
+void maskToAlpha(const uint8_t* mask, size_t count, uint8_t threshold, uint32_t color, uint32_t* rgba);
+
+// Full overlay: upsample mask to width x height and threshold it into rgba, whose rows are
+// stride bytes apart.
+void renderMaskOverlay(MaskUpsampler& upsampler, const uint8_t* mask, int mask_width, int mask_height,
+                       uint8_t* rgba, int width, int height, size_t stride, uint8_t threshold, uint32_t color);
+
+#endif // MASK_KERNELS_H
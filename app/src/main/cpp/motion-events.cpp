@@ -0,0 +1,212 @@
+#include "motion-events.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "one-euro-filter.h"
+
+// Torso lengths (aspect corrected image heights) below this are degenerate.
+static const float MIN_TORSO = 1e-3f;
+
+MotionEventDetector::MotionEventDetector(size_t max_tracks)
+        : have_skeleton_(false),
+          max_tracks_(max_tracks),
+          tracks_(max_tracks) {
+    reset();
+}
+
+void MotionEventDetector::setSkeleton(const NormalizerSkeleton& skeleton) {
+    skeleton_ = skeleton;
+    have_skeleton_ = true;
+    position_.assign(max_tracks_ * skeleton.num_joints * 2, 0.0f);
+    velocity_.assign(max_tracks_ * skeleton.num_joints * 2, 0.0f);
+    for (Track& track : tracks_) {
+        track.live = false;
+    }
+}
+
+void MotionEventDetector::configure(const MotionEventConfig& config) {
+    config_ = config;
+}
+
+void MotionEventDetector::reset() {
+    for (Track& track : tracks_) {
+        track.live = false;
+        track.last_update_us = 0;
+    }
+    queue_.reset();
+}
+
+int MotionEventDetector::findTrack(int id) const {
+    for (size_t i = 0; i < max_tracks_; i++) {
+        if (tracks_[i].live && tracks_[i].id == id) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+int MotionEventDetector::acquireTrack(int id) {
+    size_t victim = 0;
+    for (size_t i = 0; i < max_tracks_; i++) {
+        if (!tracks_[i].live) {
+            victim = i;
+            break;
+        }
+        if (tracks_[i].last_update_us < tracks_[victim].last_update_us) {
+            victim = i;
+        }
+    }
+
+    Track& track = tracks_[victim];
+    track.id = id;
+    track.live = true;
+    track.started = false;
+    track.valid_mask = 0;
+    return (int) victim;
+}
+
+void MotionEventDetector::emit(const Track& track, int64_t timestamp_us, MotionEventType type, int joint, float value) {
+    const MotionEvent event = { timestamp_us, track.id, type, joint, value };
+    queue_.push(event);
+}
+
+void MotionEventDetector::update(int id, int64_t timestamp_us, const float* joints, uint32_t valid_mask, float aspect) {
+    if (!have_skeleton_) return;
+
+    int slot = findTrack(id);
+    if (slot < 0) {
+        slot = acquireTrack(id);
+    }
+
+    Track& track = tracks_[slot];
+    const int64_t gap_us = timestamp_us - track.last_update_us;
+    if (gap_us <= 0 || gap_us > MAX_GAP_US) {
+        track.valid_mask = 0;
+        track.started = false;
+    }
+    track.last_update_us = timestamp_us;
+
+    const float dt = gap_us * 1e-6f;
+    const float alpha = track.valid_mask ? oneEuroAlpha(config_.cutoff_hz, dt) : 0.0f;
+    const float inv_dt = track.valid_mask ? 1.0f / dt : 0.0f;
+
+    // joint velocities, in aspect corrected image heights per second; joints without state
+    // start at rest
+    const unsigned int num_joints = skeleton_.num_joints;
+    float* position = &position_[slot * num_joints * 2];
+    float* velocity = &velocity_[slot * num_joints * 2];
+    const uint32_t seeded = track.valid_mask & valid_mask;
+    float max_speed_sq = 0.0f;
+    int fastest = -1;
+    for (unsigned int j = 0; j < num_joints; j++) {
+        if (!(valid_mask & (1u << j))) continue;
+        const float x = joints[j * 2] * aspect;
+        const float y = joints[j * 2 + 1];
+        if (seeded & (1u << j)) {
+            velocity[j * 2] += alpha * ((x - position[j * 2]) * inv_dt - velocity[j * 2]);
+            velocity[j * 2 + 1] += alpha * ((y - position[j * 2 + 1]) * inv_dt - velocity[j * 2 + 1]);
+            const float speed_sq = velocity[j * 2] * velocity[j * 2] + velocity[j * 2 + 1] * velocity[j * 2 + 1];
+            if (speed_sq > max_speed_sq) {
+                max_speed_sq = speed_sq;
+                fastest = (int) j;
+            }
+        } else {
+            velocity[j * 2] = velocity[j * 2 + 1] = 0.0f;
+        }
+        position[j * 2] = x;
+        position[j * 2 + 1] = y;
+    }
+    track.valid_mask = valid_mask;
+
+    // center of mass and torso, which everything else is measured in
+    const uint32_t reference = (1u << skeleton_.left_hip) | (1u << skeleton_.right_hip) |
+                               (1u << skeleton_.left_shoulder) | (1u << skeleton_.right_shoulder);
+    float torso = 0.0f, com_x = 0.0f, com_y = 0.0f;
+    if ((valid_mask & reference) == reference) {
+        const float hx = (position[skeleton_.left_hip * 2] + position[skeleton_.right_hip * 2]) * 0.5f;
+        const float hy = (position[skeleton_.left_hip * 2 + 1] + position[skeleton_.right_hip * 2 + 1]) * 0.5f;
+        const float sx = (position[skeleton_.left_shoulder * 2] + position[skeleton_.right_shoulder * 2]) * 0.5f;
+        const float sy = (position[skeleton_.left_shoulder * 2 + 1] + position[skeleton_.right_shoulder * 2 + 1]) * 0.5f;
+        torso = std::hypot(sx - hx, sy - hy);
+        com_x = (hx + sx) * 0.5f;
+        com_y = (hy + sy) * 0.5f;
+    }
+    const bool have_com = torso >= MIN_TORSO;
+
+    if (!track.started) {
+        if (!have_com) return;
+        track.started = true;
+        track.com_us = timestamp_us;
+        track.torso = torso;
+        track.com_x = com_x;
+        track.com_y = com_y;
+        track.com_vx = track.com_vy = 0.0f;
+        track.reference_y = com_y;
+        track.descent = 0.0f;
+        track.spike_armed = track.impact_armed = track.fall_armed = true;
+        track.spike_us = track.impact_us = timestamp_us - MAX_GAP_US;
+        return;
+    }
+
+    const int64_t refractory_us = (int64_t) (config_.refractory_s * 1e6f);
+    const float inv_torso = 1.0f / track.torso;
+    const float speed = std::sqrt(max_speed_sq) * inv_torso;
+    if (track.spike_armed && speed > config_.spike_speed) {
+        emit(track, timestamp_us, MOTION_VELOCITY_SPIKE, fastest, speed);
+        track.spike_armed = false;
+        track.spike_us = timestamp_us;
+    } else if (!track.spike_armed && speed < config_.spike_speed * config_.spike_release &&
+               timestamp_us - track.spike_us >= refractory_us) {
+        track.spike_armed = true;
+    }
+
+    track.descent *= std::exp(-dt / config_.fall_window_s);
+    if (!have_com) return;
+
+    // velocity and acceleration of the center of mass, y pointing down, over the interval
+    // since the last frame that had one
+    const int64_t com_gap_us = timestamp_us - track.com_us;
+    track.com_us = timestamp_us;
+    if (com_gap_us > MAX_GAP_US) {
+        track.com_x = com_x;
+        track.com_y = com_y;
+        track.com_vx = track.com_vy = 0.0f;
+        return;
+    }
+    const float com_dt = com_gap_us * 1e-6f;
+    const float com_alpha = oneEuroAlpha(config_.cutoff_hz, com_dt);
+    const float vx = track.com_vx + com_alpha * ((com_x - track.com_x) / com_dt - track.com_vx);
+    const float vy = track.com_vy + com_alpha * ((com_y - track.com_y) / com_dt - track.com_vy);
+    const float accel = std::hypot(vx - track.com_vx, vy - track.com_vy) / com_dt * inv_torso;
+    const float com_speed = std::hypot(vx, vy) * inv_torso;
+    track.com_x = com_x;
+    track.com_y = com_y;
+    track.com_vx = vx;
+    track.com_vy = vy;
+    track.descent = std::max(track.descent, vy * inv_torso);
+
+    if (track.impact_armed && accel > config_.impact_accel) {
+        emit(track, timestamp_us, MOTION_IMPACT, -1, accel);
+        track.impact_armed = false;
+        track.impact_us = timestamp_us;
+    } else if (!track.impact_armed && accel < config_.impact_accel * config_.impact_release &&
+               timestamp_us - track.impact_us >= refractory_us) {
+        track.impact_armed = true;
+    }
+
+    const float drop = (com_y - track.reference_y) * inv_torso;
+    if (track.fall_armed && drop > config_.fall_drop && track.descent > config_.fall_speed) {
+        emit(track, timestamp_us, MOTION_FALL, -1, drop);
+        track.fall_armed = false;
+    } else if (!track.fall_armed && drop < config_.fall_release) {
+        track.fall_armed = true;
+    }
+
+    // standing height and torso length only follow a person at rest
+    if (track.fall_armed && com_speed < config_.still_speed) {
+        const float follow = 1.0f - std::exp(-com_dt / config_.reference_s);
+        track.reference_y += follow * (com_y - track.reference_y);
+        track.torso += follow * (torso - track.torso);
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef MOTION_EVENTS_H
+#define MOTION_EVENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "skeleton-normalizer.h"
+#include "spsc-queue.h"
+
+// Fall and sudden movement detection for every tracked person.
+//
+// Per person the detector keeps low-pass filtered joint velocities, the velocity and
+// acceleration of the center of mass (middle of hips and shoulders) and a standing
+// reference height of it. Everything is measured in torso lengths, so the thresholds hold
+// for any distance to the camera. Three kinds of events are detected:
+//  - VELOCITY_SPIKE: a joint moves faster than spike_speed;
+//  - IMPACT: the center of mass accelerates harder than impact_accel;
+//  - FALL: the center of mass drops fall_drop below its standing height while having
+//    descended faster than fall_speed within the last fall_window_s.
+// Each has hysteresis: after firing it stays quiet until its measure falls back below the
+// release level (the person got up again, for a fall), and spikes and impacts also for at
+// least refractory_s, so an arm thrown out and pulled back is one event. The standing
+// height only follows the center of mass while it is nearly still and no fall is in
+// progress, so squats or a slow sit-down are not taken for the reference, and only a fast
+// drop counts as a fall.
+//
+// Events go into a lock-free queue: update() is the producer and runs on the frame
+// thread, drain() the consumer and may run on any one other thread without locking. The
+// rest of the class does no locking of its own.
+
+enum MotionEventType {
+    MOTION_VELOCITY_SPIKE = 0,
+    MOTION_IMPACT = 1,
+    MOTION_FALL = 2,
+};
+
+struct MotionEvent {
+    int64_t timestamp_us;           // frame that crossed the threshold
+    int id;
+    int type;                       // MotionEventType
+    int joint;                      // fastest joint for VELOCITY_SPIKE, else -1
+    float value;                    // torso lengths/s, /s^2, or the drop in torso lengths
+};
+
+struct MotionEventConfig {
+    float cutoff_hz = 5.0f;         // velocity low-pass
+    float spike_speed = 8.0f;       // torso lengths/s
+    float spike_release = 0.5f;     // fraction of spike_speed that re-arms
+    float impact_accel = 60.0f;     // torso lengths/s^2
+    float impact_release = 0.5f;
+    float refractory_s = 0.5f;      // minimum time between spikes, and between impacts
+    float fall_speed = 2.0f;        // downward torso lengths/s
+    float fall_drop = 0.8f;         // torso lengths below the standing height
+    float fall_release = 0.3f;      // drop that re-arms
+    float fall_window_s = 0.8f;     // how long a fast descent counts towards a fall
+    float still_speed = 0.4f;       // center of mass speed below which the reference follows
+    float reference_s = 1.0f;       // time constant of the standing height and torso length
+};
+
+class MotionEventDetector {
+public:
+    static const size_t QUEUE_SIZE = 256;
+    // Gaps longer than this restart a person's state instead of differentiating across them.
+    static constexpr int64_t MAX_GAP_US = 500000;
+
+    explicit MotionEventDetector(size_t max_tracks);
+
+    // Producer side, like configure(); forgets every person. No frames are taken before the
+    // skeleton is set.
+    void setSkeleton(const NormalizerSkeleton& skeleton);
+    void configure(const MotionEventConfig& config);
+    // Forgets every person and pending event; only while drain() is not running.
+    void reset();
+
+    // Producer side: feeds a frame of person id. aspect is the image width / height.
+    void update(int id, int64_t timestamp_us, const float* joints, uint32_t valid_mask, float aspect);
+
+    // Consumer side: moves up to max_events pending events to out, oldest first.
+    size_t drain(MotionEvent* out, size_t max_events) { return queue_.pop(out, max_events); }
+    // Events waiting to be drained.
+    size_t queued() const { return queue_.size(); }
+    // Events lost because nobody drained the queue in time.
+    uint64_t dropped() const { return queue_.dropped(); }
+
+private:
+    struct Track {
+        int id;
+        bool live;
+        bool started;               // has a reference height and torso length
+        int64_t last_update_us;
+        uint32_t valid_mask;        // joints with velocity state
+        float torso;                // aspect corrected image heights
+        int64_t com_us;             // last frame with a center of mass
+        float com_x, com_y;
+        float com_vx, com_vy;
+        float reference_y;          // standing height of the center of mass
+        float descent;              // fastest recent descent, decaying over fall_window_s
+        bool spike_armed, impact_armed, fall_armed;
+        int64_t spike_us, impact_us;   // last event of the kind
+    };
+
+    int findTrack(int id) const;
+    int acquireTrack(int id);
+    void emit(const Track& track, int64_t timestamp_us, MotionEventType type, int joint, float value);
+
+    NormalizerSkeleton skeleton_;
+    bool have_skeleton_;
+    MotionEventConfig config_;
+    size_t max_tracks_;
+    std::vector<Track> tracks_;
+    // slot-major: slot * num_joints * 2 + channel
+    std::vector<float> position_;
+    std::vector<float> velocity_;
+    SpscQueue<MotionEvent, QUEUE_SIZE> queue_;
+};
+
+#endif // MOTION_EVENTS_H
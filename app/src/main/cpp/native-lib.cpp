@@ -1,16 +1,457 @@
 #include <jni.h>
 #include <android/log.h>
+#include <android/bitmap.h>
+#include <android/native_window_jni.h>
 #include <wrnch/engine.hpp>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include "pose-history.h"
+#include "pose-track.h"
+#include "pose3d-stage.h"
+#include "activity-stage.h"
+#include "mask-kernels.h"
+#include "one-euro-filter.h"
+#include "kalman-predictor.h"
+#include "rep-counter.h"
+#include "skeleton-kernels.h"
+#include "dtw-matcher.h"
+#include "pose-index.h"
+#include "pose-tracker.h"
+#include "gap-filler.h"
+#include "pose-resampler.h"
+#include "skeleton-normalizer.h"
+#include "motion-events.h"
+#include "skeleton-raster.h"
+#include "latest-value.h"
+#include "latency-histogram.h"
 
 static wrPoseEstimatorHandle pose_estimator;
 static wrPoseEstimatorOptionsHandle pose_options;
+static wrPoseEstimatorConfigParams config_params;
+static std::string models_dir;
 //std::vector< std::string > joint_names_{};
 //std::vector< std::pair< int, int > > bone_pairs_{};
 const bool DEBUG = false;
 static bool initialzed = false;
 
+// Joints scoring below this are reported as invalid and left out of the output. Set from
+// any thread, read by the frame thread.
+static std::atomic<float> joint_score_threshold(0.3f);
+
+// Poses of every tracked person, guarded by history_mutex since queries may come from
+// other threads than the one feeding frames.
+static const size_t HISTORY_MAX_TRACKS = 32;
+static std::unique_ptr<PoseHistory> history;
+static std::mutex history_mutex;
+
+// Joint smoothing: the estimator's own smoother, the native One-Euro filter bank, both
+// (bit flags) or none. The filter bank is guarded by history_mutex as well.
+static const int SMOOTHING_LIBRARY = 1;
+static const int SMOOTHING_NATIVE = 2;
+static int smoothing_mode = SMOOTHING_LIBRARY;
+static std::unique_ptr<OneEuroFilterBank> joint_filter;
+static std::vector<float> filtered_joints;
+
+// Latency compensation: Kalman tracking of every person so the renderer can ask for the
+// main person's pose at display time. Guarded by history_mutex, like have_main_output,
+// which tells whether pose_output holds a main person.
+static bool prediction_enabled = false;
+static std::unique_ptr<KalmanPosePredictor> pose_predictor;
+static bool have_main_output = false;
+static std::vector<float> predicted_joints;
+static std::vector<float> predicted_output;
+
+// The main person of the last few frames for sampling at display refresh rate. Written with
+// history_mutex held, read by the renderer without any lock.
+static PoseResampler pose_resampler;
+
+// Repetition counting on the main person, guarded by history_mutex. Angles are measured
+// with the aspect ratio of the last processed frame.
+static bool rep_counter_enabled = false;
+static RepCounter rep_counter;
+static float frame_aspect = 1.0f;
+
+// Fall and velocity spike detection on every person, configured and fed with history_mutex
+// held. Its event queue is drained by Java without the lock.
+static bool motion_events_enabled = false;
+static MotionEventDetector motion_detector(HISTORY_MAX_TRACKS);
+
+// Matching of the main person's joint angles against reference templates, guarded by
+// history_mutex. Frames missing a joint of any angle are not fed.
+static std::unique_ptr<DtwMatcher> dtw_matcher;
+static std::vector<JointAngleDef> dtw_angles;
+static std::vector<float> dtw_x, dtw_y, dtw_out, dtw_features;
+
+// Nearest reference poses of the main person from a prebuilt index file, guarded by
+// history_mutex.
+static const size_t POSE_MATCH_K = 5;
+static PoseIndex pose_index;
+static std::vector<float> pose_query;
+static PoseMatch pose_matches[POSE_MATCH_K];
+static size_t pose_match_count = 0;
+
+// Gap filling of the main person's joints from the history, guarded by history_mutex. When
+// on, everything downstream of the history (rep counting, template and index matching and
+// pose_output) sees the main person gap_config.delay_frames behind the newest frame, with
+// short dropouts interpolated. Smoothing and prediction stay on the live frames.
+static bool gap_filling = false;
+static GapFillConfig gap_config;
+static std::vector<float> gap_joints;
+
+// Bone and joint angle features over a window of one track, in the batch layout of
+// skeleton-kernels.h, guarded by history_mutex. j23_topology is set when the library's bone
+// pairs are the ones compiled into J23Topology.
+static bool j23_topology = false;
+static std::vector<float> skeleton_x, skeleton_y, skeleton_dx, skeleton_dy, skeleton_lengths, skeleton_angles;
+static std::vector<uint32_t> skeleton_masks;
+
+// Normalized feature vectors of every person of the last frame, guarded by history_mutex.
+// postProcessPose stages each person's processed joints, extractFrameFeatures normalizes
+// them all at once into feature_matrix, one column per person.
+static bool feature_extraction = false;
+static bool feature_skeleton_ok = false;
+static NormalizerSkeleton feature_skeleton;
+static NormalizeConfig feature_config;
+static std::vector<float> feature_joints, feature_x, feature_y, feature_matrix;
+static std::vector<uint32_t> feature_masks, feature_out_masks;
+static std::vector<int> feature_ids;
+static size_t feature_count = 0, feature_stride = 0;
+
+// Native skeleton overlay. Frame processing stages every person of a frame in the back
+// buffer of overlay_frames and publishes it; the renderer draws the newest frame under
+// raster_mutex and never waits for frame processing. The rasterizer keeps drawing into the
+// same bitmap or window, which is how it knows what is already there.
+struct OverlayFrame {
+    unsigned int num_joints;
+    std::vector<float> joints;
+    std::vector<uint32_t> masks;
+};
+static std::atomic<bool> skeleton_overlay(false);
+static LatestValue<OverlayFrame> overlay_frames;
+static SkeletonRasterizer skeleton_rasterizer;
+static RasterStyle overlay_style;
+static std::mutex raster_mutex;
+static const void* overlay_pixels = nullptr;    // bitmap drawn last, to notice a new one
+static ANativeWindow* overlay_window = nullptr;
+
+// Pose track recording of the raw estimator output, and replay of such a recording through
+// the same post-processing as live frames.
+static std::vector<unsigned int> bone_pairs;
+static PoseTrackWriter track_writer;
+static PoseTrackReader track_reader;
+static std::mutex track_mutex;
+// Replay shows nobody once the last recorded frame is older than this, for tracks whose
+// index lost their empty frames (see pose-track.h).
+static const int64_t REPLAY_MAX_POSE_AGE_US = 200000;
+
+// One detected person as handed to the post-processing stages, either fresh from the
+// estimator or replayed from a recorded track.
+struct PoseSample {
+    int id;
+    bool is_main;
+    float score;
+    unsigned int num_joints;
+    const float* joints;
+    const float* scores;
+    float bbox[4];
+};
+
+// Output layout for processWrnchJNI, N = number of joints, L = number of face landmarks:
+//   [0, 2N)   joint x,y (normalized), -1 for invalid joints
+//   [2N, 3N)  joint scores
+//   [3N]      validity bitmask, bit i set if joint i is valid (raw int bits)
+//   [3N+1]    tracker id of the person (raw int bits)
+//   [3N+2]    bitmask of the valid joints that were gap filled (raw int bits)
+//   [3N+3, 3N+5)  timestamp of the pose in us (raw int64 bits, low word first): the frame's
+//             own, delayed by gap filling, or the time asked for by predictPoseJNI
+//   face section, starting at F = 3N+5, empty while gap filling is on:
+//   [F]                 landmarks present for this person, 0 or L (raw int bits)
+//   [F+1, F+1+2L)       landmark x,y (normalized)
+//   [F+1+2L, F+5+2L)    face arrow tip x,y, base x,y
+//   [F+5+2L, F+9+2L)    face bbox minX, minY, width, height
+// The buffer is sized at init and reused for every frame.
+static std::vector<float> pose_output;
+static unsigned int num_face_landmarks = 0;
+
+// Face landmarks are estimated per session only when asked for. ProcessFrame reads the
+// estimator options without a lock, so setFaceEnabledJNI only requests the change and the
+// frame thread applies it before its next frame (applyEstimatorOptions).
+static bool face_enabled = true;
+static std::atomic<int> requested_face(-1);            // 0 or 1 pending, -1 for none
+
+// Mean wrPoseEstimator_ProcessFrame time with the face stage on and off, to measure what
+// it costs. Guarded by history_mutex.
+struct StageTiming {
+    double total_us;
+    long frames;
+};
+static StageTiming process_timing[2] = {};
+
+// Latency distribution of every stage a frame goes through, read with getStatsJNI. Ingest
+// (grabbing the frame) and conversion (to BGR) happen in Java and are reported through
+// recordStageLatencyJNI; marshalling is getting the frame in and the result out over JNI.
+// A histogram takes one writer, so all of them are recorded from the frame thread.
+enum LatencyStage {
+    STAGE_INGEST = 0,
+    STAGE_CONVERSION = 1,
+    STAGE_PROCESS = 2,          // wrPoseEstimator_ProcessFrame
+    STAGE_EXTRACTION = 3,       // reading the people out and post-processing them
+    STAGE_MARSHAL = 4,
+    NUM_STAGES = 5,
+};
+static LatencyHistogram stage_latency[NUM_STAGES];
+static std::atomic<long> frames_processed(0);
+static std::atomic<long> frames_failed(0);
+
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// Native id association, used instead of the estimator's tracker when enabled. Ids are
+// assigned to the frame's people before any post-processing sees them. Since the estimator's
+// tracking is part of its configuration, a switch after init is only requested here and
+// carried out on the frame thread between frames (applyTrackingMode), so exactly one of the
+// two trackers runs on every frame.
+static bool native_tracking = false;
+static std::atomic<int> requested_tracking(-1);        // 0 or 1 pending, -1 for none
+static std::unique_ptr<PoseTracker> pose_tracker;
+static std::vector<PoseSample> frame_poses;
+static std::vector<TrackerDetection> tracker_detections;
+static std::vector<uint32_t> tracker_masks;
+static std::vector<int> tracker_ids;
+static StageTiming tracker_timing = {};
+
+// Optional 3D stage on its own estimator and thread, fed from the 2D path.
+static Pose3dStage pose3d_stage;
+static std::vector<Pose2dRef> pose2d_refs;
+
+// Optional activity classification stage, also on its own estimator and thread.
+// activity_mutex keeps start and stop, which replace the class names and reset the results
+// slot, away from the Java threads reading them.
+static ActivityStage activity_stage;
+static std::mutex activity_mutex;
+
+// Segmentation mask output. The mask lives in the estimator and is only valid until the next
+// processWrnchJNI call, so it must be read from the thread feeding frames. Like the face
+// stage, turning it on or off is requested and applied by that thread before its next frame.
+static bool mask_enabled = false;
+static std::atomic<int> requested_mask(-1);            // 0 or 1 pending, -1 for none
+static MaskUpsampler mask_upsampler;
+
+static uint32_t computeValidMask(const float* joints, const float* scores, unsigned int num_joints) {
+    uint32_t mask = 0;
+    const float threshold = joint_score_threshold.load(std::memory_order_relaxed);
+    for (unsigned int j = 0; j < num_joints; j++) {
+        const bool valid = scores[j] >= threshold && joints[j * 2] >= 0 && joints[j * 2 + 1] >= 0;
+        mask |= (uint32_t) valid << j;
+    }
+    return mask;
+}
+
+static size_t faceSectionOffset(unsigned int num_joints) {
+    return num_joints * 3 + 5;
+}
+
+static void matchJointAngles(const float* joints, unsigned int num_joints, uint32_t mask, int64_t timestamp_us) {
+    const size_t n = dtw_angles.size();
+    PoseBatch batch = { dtw_x.data(), dtw_y.data(), &mask, 1, 4 };
+    uint32_t valid;
+    angleValidMasks(dtw_angles.data(), n, batch, &valid);
+    if (valid != (uint32_t) ((1ull << n) - 1)) return;
+
+    transposePoses(joints, 1, num_joints, dtw_x.data(), dtw_y.data(), 4);
+    computeJointAngles(dtw_angles.data(), n, batch, dtw_out.data(), 4, frame_aspect);
+    for (size_t i = 0; i < n; i++) {
+        dtw_features[i] = dtw_out[i * 4];
+    }
+    dtw_matcher->update(timestamp_us, dtw_features.data());
+}
+
+// Feeds one person through the post-processing stages and, for the main person, fills the
+// body section of pose_output. Called with history_mutex held.
+static void postProcessPose(const PoseSample& pose, int64_t timestamp_us, bool* have_main) {
+    const unsigned int num_joints = pose.num_joints;
+    const uint32_t mask = computeValidMask(pose.joints, pose.scores, num_joints);
+
+    const float* joints = pose.joints;
+    if (smoothing_mode & SMOOTHING_NATIVE) {
+        joint_filter->filter(pose.id, timestamp_us, pose.joints, mask, filtered_joints.data());
+        joints = filtered_joints.data();
+    }
+
+    history->append(pose.id, timestamp_us, joints, pose.scores, pose.bbox, mask);
+    if (feature_extraction && num_joints == feature_skeleton.num_joints) {
+        feature_joints.insert(feature_joints.end(), joints, joints + num_joints * 2);
+        feature_masks.push_back(mask);
+        feature_ids.push_back(pose.id);
+    }
+    if (prediction_enabled) {
+        pose_predictor->update(pose.id, timestamp_us, joints, mask);
+    }
+    if (motion_events_enabled) {
+        motion_detector.update(pose.id, timestamp_us, joints, mask, frame_aspect);
+    }
+    if (skeleton_overlay) {
+        OverlayFrame& frame = overlay_frames.back();
+        if (num_joints == frame.num_joints) {
+            frame.joints.insert(frame.joints.end(), joints, joints + num_joints * 2);
+            frame.masks.push_back(mask);
+        }
+    }
+    if (!pose.is_main) {
+        return;
+    }
+
+    // the main person from here on, delayed and filled if asked for
+    int64_t main_us = timestamp_us;
+    const float* main_joints = joints;
+    const float* main_scores = pose.scores;
+    uint32_t main_mask = mask;
+    uint32_t filled_mask = 0;
+    if (gap_filling) {
+        PoseFrameView frame;
+        if (!fillDelayedFrame(*history, pose.id, gap_config, &frame, gap_joints.data(), &main_mask, &filled_mask)) {
+            return;
+        }
+        main_us = frame.timestamp_us;
+        main_joints = gap_joints.data();
+        main_scores = frame.scores;
+    }
+
+    if (rep_counter_enabled) {
+        rep_counter.update(pose.id, main_us, main_joints, main_mask, frame_aspect);
+    }
+    if (dtw_matcher) {
+        matchJointAngles(main_joints, num_joints, main_mask, main_us);
+    }
+    if (pose_index.isOpen()) {
+        pose_match_count = 0;
+        if (pose_index.numJoints() == num_joints && normalizePose(main_joints, main_mask, num_joints, frame_aspect, pose_query.data())) {
+            pose_match_count = pose_index.search(pose_query.data(), POSE_MATCH_K, pose_matches, 0, main_mask);
+        }
+    }
+
+    std::vector<float>& out = pose_output;
+    std::fill(out.begin(), out.end(), -1.0f);
+    const int no_face = 0;
+    memcpy(&out[faceSectionOffset(num_joints)], &no_face, sizeof(no_face));
+    *have_main = true;
+
+    for (unsigned int j = 0; j < num_joints; j++) {
+        if (main_mask & (1u << j)) {
+            out[j * 2] = main_joints[j * 2];
+            out[j * 2 + 1] = main_joints[j * 2 + 1];
+        }
+        out[num_joints * 2 + j] = main_scores[j];
+    }
+    memcpy(&out[num_joints * 3], &main_mask, sizeof(main_mask));
+    memcpy(&out[num_joints * 3 + 1], &pose.id, sizeof(pose.id));
+    memcpy(&out[num_joints * 3 + 2], &filled_mask, sizeof(filled_mask));
+    memcpy(&out[num_joints * 3 + 3], &main_us, sizeof(main_us));
+
+    pose_resampler.push(pose.id, main_us, main_joints, main_mask, num_joints);
+}
+
+// Normalizes the people staged by postProcessPose for this frame. Called with history_mutex
+// held.
+static void extractFrameFeatures() {
+    const size_t n = feature_ids.size();
+    feature_count = n;
+    if (!feature_extraction || n == 0) {
+        return;
+    }
+
+    const unsigned int num_joints = feature_skeleton.num_joints;
+    feature_stride = (n + 3) & ~(size_t) 3;
+    feature_x.assign(num_joints * feature_stride, 0.0f);
+    feature_y.assign(num_joints * feature_stride, 0.0f);
+    feature_matrix.resize(num_joints * 2 * feature_stride);
+    feature_out_masks.resize(n);
+    transposePoses(feature_joints.data(), n, num_joints, feature_x.data(), feature_y.data(), feature_stride);
+
+    const PoseBatch batch = { feature_x.data(), feature_y.data(), feature_masks.data(), n, feature_stride };
+    const FeatureMatrix out = { feature_matrix.data(), feature_out_masks.data(), feature_stride };
+    normalizeSkeletons(feature_skeleton, feature_config, batch, out, frame_aspect);
+}
+
+// Starts staging people for the frame about to be post-processed.
+static void beginFrameFeatures() {
+    feature_joints.clear();
+    feature_masks.clear();
+    feature_ids.clear();
+}
+
+static void beginFrameOverlay() {
+    OverlayFrame& frame = overlay_frames.back();
+    frame.joints.clear();
+    frame.masks.clear();
+    frame.num_joints = history ? history->numJoints() : 0;
+}
+
+static void publishFrameOverlay() {
+    if (skeleton_overlay) overlay_frames.publish();
+}
+
+// Copies the face found for person id into the face section of pose_output.
+static void extractFace(int id, unsigned int num_joints) {
+    float* out = &pose_output[faceSectionOffset(num_joints)];
+
+    auto face = wrPoseEstimator_GetFacePosesBegin(pose_estimator);
+    auto end = wrPoseEstimator_GetFacePosesEnd(pose_estimator);
+    for (; face != end; face = wrPoseEstimator_GetFacePosesNext(face)) {
+        if (wrPoseFace_GetId(face) != id) continue;
+
+        const int n = std::min(wrPoseFace_GetNumLandmarks(face), num_face_landmarks);
+        memcpy(out, &n, sizeof(n));
+        memcpy(out + 1, wrPoseFace_GetLandmarks(face), sizeof(float) * n * 2);
+
+        float* tail = out + 1 + num_face_landmarks * 2;
+        auto arrow = wrPoseFace_GetFaceArrow(face);
+        tail[0] = wrArrow_GetTipX(arrow);
+        tail[1] = wrArrow_GetTipY(arrow);
+        tail[2] = wrArrow_GetBaseX(arrow);
+        tail[3] = wrArrow_GetBaseY(arrow);
+
+        auto box = wrPoseFace_GetBoundingBox(face);
+        tail[4] = wrBox2d_GetMinX(box);
+        tail[5] = wrBox2d_GetMinY(box);
+        tail[6] = wrBox2d_GetWidth(box);
+        tail[7] = wrBox2d_GetHeight(box);
+        return;
+    }
+}
+
+// Called with history_mutex held.
+static jfloatArray toFloatArray(JNIEnv* env, bool have_main) {
+    have_main_output = have_main;
+    if (!have_main) {
+        pose_resampler.clear();
+        return env->NewFloatArray(0);
+    }
+    auto result = env->NewFloatArray(pose_output.size());
+    env->SetFloatArrayRegion(result, 0, pose_output.size(), pose_output.data());
+    return result;
+}
+
+// Estimator pose parameters, with its tracker on unless the native one is used.
+static wrPoseParamsHandle createPoseParams() {
+    auto pose_params = wrPoseParams_Create();
+    wrPoseParams_SetBoneSensitivity(pose_params, wrSensitivity::wrSensitivity_HIGH);
+    wrPoseParams_SetJointSensitivity(pose_params, wrSensitivity::wrSensitivity_HIGH);
+    wrPoseParams_SetEnableTracking(pose_params, native_tracking ? 0 : 1);
+//    wrPoseParams_SetPreferredNetWidth2d(pose_params, 324);
+//    wrPoseParams_SetPreferredNetHeight2d(pose_params, 184);
+    return pose_params;
+}
+
 extern "C" JNIEXPORT jintArray JNICALL
 Java_com_samsungnext_audiovideoplayersample_Wrnch_initWrnchJNI(
         JNIEnv* env,
@@ -30,18 +471,20 @@ Java_com_samsungnext_audiovideoplayersample_Wrnch_initWrnchJNI(
         return env->NewIntArray(0);
     }
 
-    auto pose_params = wrPoseParams_Create();
-    wrPoseParams_SetBoneSensitivity(pose_params, wrSensitivity::wrSensitivity_HIGH);
-    wrPoseParams_SetJointSensitivity(pose_params, wrSensitivity::wrSensitivity_HIGH);
-    wrPoseParams_SetEnableTracking(pose_params, 1);
-//    wrPoseParams_SetPreferredNetWidth2d(pose_params, 324);
-//    wrPoseParams_SetPreferredNetHeight2d(pose_params, 184);
+    const int requested = requested_tracking.exchange(-1);
+    if (requested >= 0) native_tracking = requested == 1;
+    const int face = requested_face.exchange(-1);
+    if (face >= 0) face_enabled = face == 1;
+    auto pose_params = createPoseParams();
 
+    models_dir = dir;
     auto params = wrPoseEstimatorConfigParams_Create(dir);
+    config_params = params;
     wrPoseEstimatorConfigParams_SetLicenseString(params, "3A83A2-46FB01-48CB9F-EE06BF-3698DE-E05B71");
     wrPoseEstimatorConfigParams_SetDeviceFingerprint(params, "smartfitness603DK");
     wrPoseEstimatorConfigParams_SetOutputFormat(params, wrJointDefinition_Get("j23"));
     wrPoseEstimatorConfigParams_SetPoseParams(params, pose_params);
+    wrPoseParams_Destroy(pose_params);
 
     auto wrc = wrPoseEstimator_CreateFromConfig(&pose_estimator, params);
     if (wrc != wrReturnCode_OK) {
@@ -56,8 +499,8 @@ Java_com_samsungnext_audiovideoplayersample_Wrnch_initWrnchJNI(
     }
 
     pose_options = wrPoseEstimatorOptions_Create();
-    wrPoseEstimatorOptions_SetEnableJointSmoothing(pose_options, 1);
-    wrPoseEstimatorOptions_SetEstimatePoseFace(pose_options, 1);
+    wrPoseEstimatorOptions_SetEnableJointSmoothing(pose_options, (smoothing_mode & SMOOTHING_LIBRARY) ? 1 : 0);
+    wrPoseEstimatorOptions_SetEstimatePoseFace(pose_options, face_enabled ? 1 : 0);
     wrPoseEstimatorOptions_SetRotationMultipleOf90(pose_options, 0);
 
     wrJointDefinitionHandleConst format = wrPoseEstimator_GetHuman2DOutputFormat(pose_estimator);
@@ -75,15 +518,47 @@ Java_com_samsungnext_audiovideoplayersample_Wrnch_initWrnchJNI(
 //        joint_names_.push_back(std::string(c_joint_names[i]));
 //    }
 
-    uint *c_bone_pairs = new uint[num_bones * 2];
+    bone_pairs.resize(num_bones * 2);
+    unsigned int *c_bone_pairs = bone_pairs.data();
     wrJointDefinition_GetBonePairs(format, c_bone_pairs);
 //    for(int i = 0; i < num_bones; i++) {
 //        bone_pairs_.emplace_back(c_bone_pairs[i*2+0], c_bone_pairs[i*2+1]);
 //    }
 
+    feature_skeleton.num_joints = num_joints;
+    feature_skeleton.left_hip = wrJointDefinition_GetJointIndex(format, "LHIP");
+    feature_skeleton.right_hip = wrJointDefinition_GetJointIndex(format, "RHIP");
+    feature_skeleton.left_shoulder = wrJointDefinition_GetJointIndex(format, "LSHOULDER");
+    feature_skeleton.right_shoulder = wrJointDefinition_GetJointIndex(format, "RSHOULDER");
+    for (unsigned int j = 0; j < num_joints; j++) {
+        feature_skeleton.reflected[j] = wrJointDefinition_ReflectedIndexOverY(format, j);
+    }
+    feature_skeleton_ok = feature_skeleton.left_hip >= 0 && feature_skeleton.right_hip >= 0 &&
+                          feature_skeleton.left_shoulder >= 0 && feature_skeleton.right_shoulder >= 0;
+
+    j23_topology = skeletonTopologyMatches<J23Topology>(c_bone_pairs, num_bones);
+    if (!j23_topology) __android_log_print(ANDROID_LOG_INFO, "WRNCH", "Bone pairs differ from j23, using the generic skeleton kernels");
+
     auto result = env->NewIntArray(num_bones * 2);
     env->SetIntArrayRegion(result, 0, num_bones * 2, (jint*) c_bone_pairs);
 
+    wrJointDefinitionHandleConst face_format = wrPoseEstimator_GetFaceOutputFormat(pose_estimator);
+    num_face_landmarks = face_format ? wrJointDefinition_GetNumJoints(face_format) : 0;
+
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        history.reset(new PoseHistory(num_joints, HISTORY_MAX_TRACKS));
+        joint_filter.reset(new OneEuroFilterBank(num_joints, HISTORY_MAX_TRACKS));
+        filtered_joints.resize(num_joints * 2);
+        pose_predictor.reset(new KalmanPosePredictor(num_joints, HISTORY_MAX_TRACKS));
+        predicted_joints.resize(num_joints * 2);
+        gap_joints.resize(num_joints * 2);
+        pose_output.assign(faceSectionOffset(num_joints) + 9 + num_face_landmarks * 2, -1.0f);
+        pose_tracker.reset(new PoseTracker(num_joints, HISTORY_MAX_TRACKS));
+        motion_events_enabled = false;
+        if (feature_skeleton_ok) motion_detector.setSkeleton(feature_skeleton);
+    }
+
     __android_log_print(ANDROID_LOG_INFO, "WRNCH", "WRNCH Init Done");
 
     initialzed = true;
@@ -91,58 +566,1585 @@ Java_com_samsungnext_audiovideoplayersample_Wrnch_initWrnchJNI(
     return result;
 }
 
+// Replaces the estimator's ids of frame_poses with native tracker ids. Called with
+// history_mutex held.
+static void assignTrackIds(int64_t timestamp_us) {
+    const size_t n = frame_poses.size();
+    tracker_detections.resize(n);
+    tracker_masks.resize(n);
+    tracker_ids.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        const PoseSample& pose = frame_poses[i];
+        tracker_masks[i] = computeValidMask(pose.joints, pose.scores, pose.num_joints);
+        tracker_detections[i].bbox = pose.bbox;
+        tracker_detections[i].joints = pose.joints;
+        tracker_detections[i].valid_mask = tracker_masks[i];
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pose_tracker->update(timestamp_us, tracker_detections.data(), n, tracker_ids.data());
+    tracker_timing.total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    tracker_timing.frames++;
+
+    for (size_t i = 0; i < n; i++) {
+        frame_poses[i].id = tracker_ids[i];
+    }
+}
+
+// Carries out a tracker switch asked for by setNativeTrackingJNI: reconfigures the estimator
+// with its tracker on or off and flips native_tracking with it. Ids of the old tracker mean
+// nothing to the new one, so the state keyed on them starts over. Called on the frame thread
+// before ProcessFrame, the only place the estimator may be replaced.
+static bool applyTrackingMode() {
+    const int requested = requested_tracking.exchange(-1);
+    if (requested < 0 || (requested == 1) == native_tracking) return true;
+
+    std::lock_guard<std::mutex> lock(history_mutex);
+    native_tracking = requested == 1;
+    auto pose_params = createPoseParams();
+    wrPoseEstimatorConfigParams_SetPoseParams(config_params, pose_params);
+    wrPoseParams_Destroy(pose_params);
+    auto wrc = wrPoseEstimator_ReinitializeFromConfig(&pose_estimator, config_params);
+    if (wrc != wrReturnCode_OK) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "wrPoseEstimator_ReinitializeFromConfig: %s", wrReturnCode_Translate(wrc));
+        initialzed = false;
+        return false;
+    }
+
+    pose_tracker->reset();
+    tracker_timing = StageTiming();
+    history->clear();
+    joint_filter->clear();
+    pose_predictor->clear();
+    pose_resampler.clear();
+    return true;
+}
+
+// Applies the estimator options asked for since the last frame. Called on the frame thread
+// before ProcessFrame, which reads pose_options.
+static void applyEstimatorOptions() {
+    const int face = requested_face.exchange(-1);
+    if (face >= 0) {
+        face_enabled = face == 1;
+        wrPoseEstimatorOptions_SetEstimatePoseFace(pose_options, face_enabled ? 1 : 0);
+    }
+    const int mask = requested_mask.exchange(-1);
+    if (mask >= 0) {
+        mask_enabled = mask == 1;
+        wrPoseEstimatorOptions_SetEstimateMask(pose_options, mask_enabled ? 1 : 0);
+    }
+}
+
 extern "C" JNIEXPORT jfloatArray JNICALL
 Java_com_samsungnext_audiovideoplayersample_Wrnch_processWrnchJNI(
         JNIEnv* env,
         jobject /* this */,
         jbyteArray img,
         jint cols,
-        jint rows) {
+        jint rows,
+        jlong timestampUs) {
 
+    const auto marshal_start = std::chrono::steady_clock::now();
     jboolean isCopy;
     jbyte* b = env->GetByteArrayElements(img, &isCopy);
 
-    if (!initialzed) {
+    if (!initialzed || !applyTrackingMode()) {
         __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Not initialized");
+        env->ReleaseByteArrayElements(img, b, JNI_ABORT);
         return env->NewFloatArray(0);
     }
 
+    applyEstimatorOptions();
+
+    auto start = std::chrono::steady_clock::now();
+    const uint64_t marshal_in_ns = elapsedNs(marshal_start, start);
     auto rc = wrPoseEstimator_ProcessFrame(pose_estimator, (unsigned char*) b, cols, rows, pose_options);
+    const auto processed = stage_latency[STAGE_PROCESS].recordSince(start);
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        StageTiming& timing = process_timing[face_enabled ? 1 : 0];
+        timing.total_us += std::chrono::duration<double, std::micro>(processed - start).count();
+        timing.frames++;
+    }
+
     if (rc != wrReturnCode_OK) {
         __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "wrPoseEstimator_ProcessFrame: %s", wrReturnCode_Translate(rc));
+        frames_failed++;
+        env->ReleaseByteArrayElements(img, b, JNI_ABORT);
         return env->NewFloatArray(0);
     }
 
+    bool have_main = false;
+    unsigned int main_num_joints = 0;
+    std::lock_guard<std::mutex> track_lock(track_mutex);
+    std::lock_guard<std::mutex> lock(history_mutex);
+    pose2d_refs.clear();
+    frame_aspect = (float) cols / rows;
+    beginFrameFeatures();
+    beginFrameOverlay();
+
     auto it = wrPoseEstimator_GetHumans2DBegin(pose_estimator);
 
+    frame_poses.clear();
+    int main_estimator_id = -1;
     for (int i = 0; i < wrPoseEstimator_GetNumHumans2D(pose_estimator); i++)
     {
-        auto pose_score = wrPose2d_GetScore(it);
-        auto num_joints = wrPose2d_GetNumJoints(it);
-        auto joints = wrPose2d_GetJoints(it);
-
-        auto is_main = wrPose2d_GetIsMain(it);
-        if (DEBUG) __android_log_print(ANDROID_LOG_INFO, "WRNCH", "POSE SCORE: %.2f %d %d", pose_score, is_main, num_joints);
-
-        if (is_main == 1) {
-            auto result = env->NewFloatArray(num_joints * 2);
-            env->SetFloatArrayRegion(result, 0, num_joints * 2, joints);
-            env->ReleaseByteArrayElements(img, b, 0);
-            return result;
+        PoseSample pose;
+        pose.id = wrPose2d_GetId(it);
+        pose.is_main = wrPose2d_GetIsMain(it) == 1;
+        pose.score = wrPose2d_GetScore(it);
+        pose.num_joints = wrPose2d_GetNumJoints(it);
+        pose.joints = wrPose2d_GetJoints(it);
+        pose.scores = wrPose2d_GetScores(it);
+
+        auto box = wrPose2d_GetBoundingBox(it);
+        pose.bbox[0] = wrBox2d_GetMinX(box);
+        pose.bbox[1] = wrBox2d_GetMinY(box);
+        pose.bbox[2] = wrBox2d_GetWidth(box);
+        pose.bbox[3] = wrBox2d_GetHeight(box);
+
+        if (pose.is_main) main_estimator_id = pose.id;
+        frame_poses.push_back(pose);
+        it = wrPoseEstimator_GetPose2DNext(it);
+    }
+
+    if (native_tracking) {
+        assignTrackIds(timestampUs);
+    }
+
+    // indexed even when nobody is in it, so replay clears people who left
+    track_writer.beginFrame(timestampUs);
+    for (const PoseSample& pose : frame_poses)
+    {
+        if (DEBUG) __android_log_print(ANDROID_LOG_INFO, "WRNCH", "POSE SCORE: %.2f %d %d %d", pose.score, pose.is_main, pose.num_joints, pose.id);
+
+        if (track_writer.isOpen()) {
+            PoseTrackRecord record;
+            record.timestamp_us = timestampUs;
+            record.id = pose.id;
+            record.flags = pose.is_main ? POSE_TRACK_FLAG_MAIN : 0;
+            record.valid_mask = computeValidMask(pose.joints, pose.scores, pose.num_joints);
+            record.score = pose.score;
+            memcpy(record.bbox, pose.bbox, sizeof(record.bbox));
+            track_writer.append(record, pose.joints, pose.scores);
+        }
+
+        postProcessPose(pose, timestampUs, &have_main);
+
+        Pose2dRef ref;
+        ref.id = pose.id;
+        memcpy(ref.bbox, pose.bbox, sizeof(ref.bbox));
+        pose2d_refs.push_back(ref);
+
+        if (pose.is_main) {
+            main_num_joints = pose.num_joints;
         }
 
 //        printf("Pose [%i / %i] : is main: %i.\n", i, wrPoseEstimator_GetNumHumans2D(pose_estimator), is_main);
 //        types::WrenchPose pose(sensor_data->point_cloud, pose_score, num_joints, joints, scores, joint_names);
 //        printf("Pose [%i / %i]: [%f | %s]\n", i, wrPoseEstimator_GetNumHumans2D(pose_estimator), pose_score, (pose.is_tracked() ? "Tracked!" : "Not tracked.."));
 //        poses.push_back(std::make_shared< types::PoseBase >(pose));
+    }
 
-        it = wrPoseEstimator_GetPose2DNext(it);
+    extractFrameFeatures();
+    publishFrameOverlay();
+
+    // face output carries the estimator's ids, and is of the live frame so it would not
+    // match a body delayed by gap filling
+    if (have_main && face_enabled && !gap_filling) {
+        extractFace(main_estimator_id, main_num_joints);
     }
 
-    env->ReleaseByteArrayElements(img, b, 0);
+    if (pose3d_stage.isRunning()) {
+        pose3d_stage.submit(timestampUs, (const unsigned char*) b, cols, rows, pose2d_refs.data(), pose2d_refs.size());
+    }
+    if (activity_stage.isRunning()) {
+        activity_stage.submit(timestampUs, (const unsigned char*) b, cols, rows, pose2d_refs.data(), pose2d_refs.size());
+    }
+    const auto extracted = stage_latency[STAGE_EXTRACTION].recordSince(processed);
 
-    auto result = env->NewFloatArray(0);
     env->ReleaseByteArrayElements(img, b, 0);
 
+    jfloatArray result = toFloatArray(env, have_main);
+    stage_latency[STAGE_MARSHAL].record(marshal_in_ns + elapsedNs(extracted, std::chrono::steady_clock::now()));
+    frames_processed++;
+    return result;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setJointScoreThresholdJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jfloat threshold) {
+    joint_score_threshold.store(threshold, std::memory_order_relaxed);
+}
+
+// mode is a combination of the SMOOTHING_* flags.
+extern "C" JNIEXPORT void JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setSmoothingJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jint mode) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if ((mode & SMOOTHING_NATIVE) && !(smoothing_mode & SMOOTHING_NATIVE) && joint_filter) {
+        joint_filter->clear();
+    }
+    smoothing_mode = mode;
+    if (pose_options) {
+        wrPoseEstimatorOptions_SetEnableJointSmoothing(pose_options, (mode & SMOOTHING_LIBRARY) ? 1 : 0);
+    }
+}
+
+// Per joint One-Euro min cut-off (Hz) and beta, numJoints each, and the derivative cut-off.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setJointFilterParamsJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jfloatArray minCutoff,
+        jfloatArray beta,
+        jfloat dCutoff) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (!joint_filter) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Not initialized");
+        return JNI_FALSE;
+    }
+    const unsigned int num_joints = joint_filter->numJoints();
+    if ((unsigned int) env->GetArrayLength(minCutoff) < num_joints || (unsigned int) env->GetArrayLength(beta) < num_joints) {
+        return JNI_FALSE;
+    }
+
+    std::vector<float> min_cutoffs(num_joints), betas(num_joints);
+    env->GetFloatArrayRegion(minCutoff, 0, num_joints, min_cutoffs.data());
+    env->GetFloatArrayRegion(beta, 0, num_joints, betas.data());
+    joint_filter->setParams(min_cutoffs.data(), betas.data(), dCutoff);
+    return JNI_TRUE;
+}
+
+// interpolation: 0 linear, 1 Hermite. The main person is reported delayFrames behind the
+// newest frame; a joint is filled if it was seen at most lookBackFrames before and
+// delayFrames after, no more than maxGapMs apart.
+extern "C" JNIEXPORT void JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setGapFillingJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jboolean enabled,
+        jint interpolation,
+        jint delayFrames,
+        jint lookBackFrames,
+        jfloat maxGapMs) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    gap_filling = enabled;
+    gap_config.interpolation = interpolation == 0 ? GAP_LINEAR : GAP_HERMITE;
+    gap_config.delay_frames = std::max(delayFrames, 0);
+    gap_config.look_back_frames = std::max(lookBackFrames, 0);
+    gap_config.max_gap_us = (int64_t) (maxGapMs * 1000.0f);
+}
+
+// model: 0 constant velocity, 1 constant acceleration. Noise values <= 0 keep the current
+// ones.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setPredictionJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jboolean enabled,
+        jint model,
+        jfloat processNoise,
+        jfloat measurementNoise) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (!pose_predictor) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Not initialized");
+        return JNI_FALSE;
+    }
+
+    const KalmanModel kalman_model = model == 1 ? KalmanModel::CONSTANT_ACCELERATION : KalmanModel::CONSTANT_VELOCITY;
+    if (kalman_model != pose_predictor->model() || !prediction_enabled) {
+        pose_predictor->setModel(kalman_model);
+    }
+    if (processNoise > 0 && measurementNoise > 0) {
+        pose_predictor->setNoise(processNoise, measurementNoise);
+    }
+    prediction_enabled = enabled == JNI_TRUE;
+    return JNI_TRUE;
+}
+
+// The main person of the last frame extrapolated to timeUs, in the processWrnchJNI layout.
+// Empty if prediction is off or the last frame had no main person.
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_predictPoseJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong timeUs) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (!prediction_enabled || !have_main_output) {
+        return env->NewFloatArray(0);
+    }
+
+    const unsigned int num_joints = pose_predictor->numJoints();
+    uint32_t mask;
+    int id;
+    memcpy(&mask, &pose_output[num_joints * 3], sizeof(mask));
+    memcpy(&id, &pose_output[num_joints * 3 + 1], sizeof(id));
+
+    uint32_t predicted_mask;
+    if (!pose_predictor->predict(id, timeUs, predicted_joints.data(), &predicted_mask)) {
+        return env->NewFloatArray(0);
+    }
+
+    // joints the predictor does not track yet are left as estimated
+    predicted_output.assign(pose_output.begin(), pose_output.end());
+    const int64_t predicted_us = timeUs;
+    memcpy(&predicted_output[num_joints * 3 + 3], &predicted_us, sizeof(predicted_us));
+    for (unsigned int j = 0; j < num_joints; j++) {
+        if (mask & predicted_mask & (1u << j)) {
+            predicted_output[j * 2] = predicted_joints[j * 2];
+            predicted_output[j * 2 + 1] = predicted_joints[j * 2 + 1];
+        }
+    }
+
+    auto result = env->NewFloatArray(predicted_output.size());
+    env->SetFloatArrayRegion(result, 0, predicted_output.size(), predicted_output.data());
     return result;
 }
+
+// The main person at timeUs, interpolated between the last frames or extrapolated past the
+// newest by at most maxExtrapolationUs, for drawing once per vsync. Writes joint x,y
+// (normalized), then the validity bitmask and the person id (raw int bits) into out, which
+// must hold 2N + 2 values. Takes no lock and allocates nothing; false if there is no main
+// person.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_samplePoseJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong timeUs,
+        jlong maxExtrapolationUs,
+        jfloatArray out) {
+    float sampled[PoseResampler::MAX_JOINTS * 2 + 2];
+    uint32_t mask;
+    int id;
+    unsigned int num_joints;
+    if (!pose_resampler.sample(timeUs, maxExtrapolationUs, sampled, &mask, &id, &num_joints)) {
+        return JNI_FALSE;
+    }
+    if ((unsigned int) env->GetArrayLength(out) < num_joints * 2 + 2) {
+        return JNI_FALSE;
+    }
+    memcpy(&sampled[num_joints * 2], &mask, sizeof(mask));
+    memcpy(&sampled[num_joints * 2 + 1], &id, sizeof(id));
+    env->SetFloatArrayRegion(out, 0, num_joints * 2 + 2, sampled);
+    return JNI_TRUE;
+}
+
+// Turns per frame feature extraction on or off, see skeleton-normalizer.h for the options.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setFeatureExtractionJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jboolean enabled,
+        jboolean rotate,
+        jboolean faceCamera,
+        jboolean mirror) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (enabled && !feature_skeleton_ok) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "No hips and shoulders in the joint definition");
+        return JNI_FALSE;
+    }
+    feature_extraction = enabled;
+    feature_config.rotate = rotate;
+    feature_config.face_camera = faceCamera;
+    feature_config.mirror = mirror;
+    feature_count = 0;
+    return JNI_TRUE;
+}
+
+// Feature vectors of the people of the last frame: feature f (x of joint j at 2j, y at
+// 2j + 1) of person i at data[f * count + i], with their ids and joint masks after
+// mirroring (0 if the person could not be normalized). Returns count, or -1 if the arrays
+// are too small.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getFrameFeaturesJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jfloatArray data,
+        jintArray ids,
+        jintArray masks) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    const size_t n = feature_count;
+    const size_t num_features = feature_skeleton.num_joints * 2;
+    if ((size_t) env->GetArrayLength(data) < num_features * n || (size_t) env->GetArrayLength(ids) < n ||
+            (size_t) env->GetArrayLength(masks) < n) {
+        return -1;
+    }
+    // the matrix is not sized for a frame without people
+    if (n == 0) {
+        return 0;
+    }
+    for (size_t f = 0; f < num_features; f++) {
+        env->SetFloatArrayRegion(data, f * n, n, &feature_matrix[f * feature_stride]);
+    }
+    env->SetIntArrayRegion(ids, 0, n, feature_ids.data());
+    env->SetIntArrayRegion(masks, 0, n, (const jint*) feature_out_masks.data());
+    return (jint) n;
+}
+
+// Index of the named joint in the estimator's output format, -1 if there is none.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getJointIndexJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jstring nameStr) {
+    if (!initialzed) {
+        return -1;
+    }
+    const char* name = env->GetStringUTFChars(nameStr, 0);
+    const int index = wrJointDefinition_GetJointIndex(wrPoseEstimator_GetHuman2DOutputFormat(pose_estimator), name);
+    env->ReleaseStringUTFChars(nameStr, name);
+    return index;
+}
+
+// Starts counting repetitions of the main person. angles holds joint index triples a, b, c
+// for the angle at b; an empty array stops counting. combine: 0 mean, 1 min, 2 max.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_configureRepCounterJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jintArray angles,
+        jint combine,
+        jboolean restHigh,
+        jfloat minAmplitudeDeg,
+        jfloat minPeriodS,
+        jfloat maxPeriodS) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    const jsize n = env->GetArrayLength(angles);
+    if (n == 0) {
+        rep_counter_enabled = false;
+        return JNI_TRUE;
+    }
+    if (n % 3 != 0) {
+        return JNI_FALSE;
+    }
+
+    std::vector<jint> joints(n);
+    env->GetIntArrayRegion(angles, 0, n, joints.data());
+    RepCounterConfig config;
+    for (jsize i = 0; i < n; i += 3) {
+        for (int k = 0; k < 3; k++) {
+            if (joints[i + k] < 0 || joints[i + k] >= 32) return JNI_FALSE;
+        }
+        config.angles.push_back({ joints[i], joints[i + 1], joints[i + 2] });
+    }
+    config.combine = combine == 1 ? RepCounterConfig::MIN : combine == 2 ? RepCounterConfig::MAX : RepCounterConfig::MEAN;
+    config.rest_high = restHigh == JNI_TRUE;
+    config.min_amplitude_deg = minAmplitudeDeg;
+    config.min_period_s = minPeriodS;
+    config.max_period_s = maxPeriodS;
+
+    rep_counter.configure(config);
+    rep_counter_enabled = true;
+    return JNI_TRUE;
+}
+
+// Moves pending repetitions into the arrays, which bound how many are returned.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_drainRepEventsJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jlongArray startUs,
+        jlongArray endUs,
+        jfloatArray confidence) {
+    const size_t max_events = RepCounter::MAX_PENDING_EVENTS;
+    RepEvent events[max_events];
+    size_t n;
+    {
+        std::lock_guard<std::mutex> lock(history_mutex);
+        n = rep_counter.drainEvents(events, std::min((size_t) env->GetArrayLength(startUs), max_events));
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        const jlong start = events[i].start_us;
+        const jlong end = events[i].end_us;
+        env->SetLongArrayRegion(startUs, i, 1, &start);
+        env->SetLongArrayRegion(endUs, i, 1, &end);
+        env->SetFloatArrayRegion(confidence, i, 1, &events[i].confidence);
+    }
+    return n;
+}
+
+// Starts or stops fall and velocity spike detection. Speeds are in torso lengths per second,
+// accelerations per second squared, the drop in torso lengths below standing height.
+// release is the fraction of the spike and impact thresholds that re-arms them, fallRelease
+// the drop below which a fallen person counts as up again.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_configureMotionEventsJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jboolean enabled,
+        jfloat spikeSpeed,
+        jfloat impactAccel,
+        jfloat fallSpeed,
+        jfloat fallDrop,
+        jfloat release,
+        jfloat fallRelease,
+        jfloat refractoryS) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (enabled == JNI_TRUE && !feature_skeleton_ok) {
+        return JNI_FALSE;
+    }
+    if (enabled == JNI_TRUE) {
+        MotionEventConfig config;
+        config.spike_speed = spikeSpeed;
+        config.impact_accel = impactAccel;
+        config.fall_speed = fallSpeed;
+        config.fall_drop = fallDrop;
+        config.spike_release = config.impact_release = release;
+        config.fall_release = fallRelease;
+        config.refractory_s = refractoryS;
+        motion_detector.configure(config);
+    }
+    motion_events_enabled = enabled == JNI_TRUE;
+    return JNI_TRUE;
+}
+
+// Moves pending motion events into the arrays, the shortest of which bounds how many are
+// returned. Runs without history_mutex, so polling it never holds up frame processing.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_drainMotionEventsJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jintArray types,
+        jintArray ids,
+        jintArray joints,
+        jlongArray timestampsUs,
+        jfloatArray values) {
+    const size_t max_events = MotionEventDetector::QUEUE_SIZE;
+    MotionEvent events[max_events];
+    // bounded by the shortest array, so no event is drained that cannot be handed out
+    size_t capacity = max_events;
+    for (jarray array : { (jarray) types, (jarray) ids, (jarray) joints, (jarray) timestampsUs, (jarray) values }) {
+        capacity = std::min(capacity, (size_t) env->GetArrayLength(array));
+    }
+    const size_t n = motion_detector.drain(events, capacity);
+
+    for (size_t i = 0; i < n; i++) {
+        const jlong ts = events[i].timestamp_us;
+        env->SetIntArrayRegion(types, i, 1, &events[i].type);
+        env->SetIntArrayRegion(ids, i, 1, &events[i].id);
+        env->SetIntArrayRegion(joints, i, 1, &events[i].joint);
+        env->SetLongArrayRegion(timestampsUs, i, 1, &ts);
+        env->SetFloatArrayRegion(values, i, 1, &events[i].value);
+    }
+    return n;
+}
+
+// Motion events lost because they were not drained before the queue filled up.
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getDroppedMotionEventsJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    return motion_detector.dropped();
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getRepCountJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    return rep_counter.count();
+}
+
+// Maps the pose index at path, or closes it for a null or empty path.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setPoseIndexJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jstring path) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    pose_match_count = 0;
+    if (!path || env->GetStringUTFLength(path) == 0) {
+        pose_index.close();
+        return JNI_TRUE;
+    }
+
+    const char* c_path = env->GetStringUTFChars(path, nullptr);
+    const bool ok = pose_index.open(c_path);
+    env->ReleaseStringUTFChars(path, c_path);
+    if (!ok) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Can't open pose index");
+        return JNI_FALSE;
+    }
+    pose_query.resize(poseIndexDim(pose_index.numJoints()));
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getPoseIndexLabelsJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    const size_t n = pose_index.isOpen() ? pose_index.numLabels() : 0;
+    auto result = env->NewObjectArray(n, env->FindClass("java/lang/String"), nullptr);
+    for (size_t i = 0; i < n; i++) {
+        jstring name = env->NewStringUTF(pose_index.labelName(i).c_str());
+        env->SetObjectArrayElement(result, i, name);
+        env->DeleteLocalRef(name);
+    }
+    return result;
+}
+
+// Nearest reference poses to the last main person, closest first: labels, library positions
+// and normalized distances. The arrays bound the count returned.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getPoseMatchesJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jintArray labels,
+        jintArray ids,
+        jfloatArray distances) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    const size_t n = std::min(pose_match_count, (size_t) std::min(std::min(env->GetArrayLength(labels),
+            env->GetArrayLength(ids)), env->GetArrayLength(distances)));
+    for (size_t i = 0; i < n; i++) {
+        const jint label = pose_matches[i].label;
+        const jint id = pose_matches[i].id;
+        env->SetIntArrayRegion(labels, i, 1, &label);
+        env->SetIntArrayRegion(ids, i, 1, &id);
+        env->SetFloatArrayRegion(distances, i, 1, &pose_matches[i].distance);
+    }
+    return n;
+}
+
+// Sets up template matching on the angles at joint b of each a, b, c triple, dropping any
+// templates; an empty array disables it.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_configureDtwJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jintArray angles,
+        jint band,
+        jfloat pruneRatio) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    const jsize n = env->GetArrayLength(angles);
+    if (n == 0) {
+        dtw_matcher.reset();
+        return JNI_TRUE;
+    }
+    if (!history || n % 3 != 0 || n / 3 > 32 || band < 0) {
+        return JNI_FALSE;
+    }
+
+    const unsigned int num_joints = history->numJoints();
+    std::vector<JointAngleDef> defs(n / 3);
+    env->GetIntArrayRegion(angles, 0, n, (jint*) defs.data());
+    for (const JointAngleDef& d : defs) {
+        if ((unsigned int) d.a >= num_joints || (unsigned int) d.b >= num_joints || (unsigned int) d.c >= num_joints) {
+            return JNI_FALSE;
+        }
+    }
+
+    dtw_angles = defs;
+    dtw_x.assign(num_joints * 4, 0.0f);
+    dtw_y.assign(num_joints * 4, 0.0f);
+    dtw_out.resize(defs.size() * 4);
+    dtw_features.resize(defs.size());
+
+    DtwMatcherConfig config;
+    config.band = band;
+    config.prune_ratio = pruneRatio;
+    dtw_matcher.reset(new DtwMatcher(defs.size()));
+    dtw_matcher->setConfig(config);
+    return JNI_TRUE;
+}
+
+// Adds a template of frames x angle count features at fps; returns its index or -1.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_addDtwTemplateJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jfloatArray features,
+        jint frames,
+        jfloat fps) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (!dtw_matcher || frames <= 0 || fps <= 0.0f) return -1;
+    const size_t count = frames * dtw_matcher->dim();
+    if ((size_t) env->GetArrayLength(features) < count) return -1;
+
+    std::vector<float> values(count);
+    env->GetFloatArrayRegion(features, 0, count, values.data());
+    return (jint) dtw_matcher->addTemplate(values.data(), frames, fps);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_startDtwJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (dtw_matcher) dtw_matcher->start();
+}
+
+// Per template state (raw int bits), cost per frame and progress into out, which bounds the
+// number of templates. Returns the best template, -1 if none.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getDtwScoresJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jfloatArray out) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (!dtw_matcher) return -1;
+
+    const size_t n = std::min(dtw_matcher->numTemplates(), (size_t) env->GetArrayLength(out) / 3);
+    std::vector<float> values(n * 3);
+    for (size_t i = 0; i < n; i++) {
+        const DtwScore& score = dtw_matcher->score(i);
+        const int state = score.state;
+        memcpy(&values[i * 3], &state, sizeof(state));
+        values[i * 3 + 1] = score.cost;
+        values[i * 3 + 2] = score.progress;
+    }
+    env->SetFloatArrayRegion(out, 0, n * 3, values.data());
+    return dtw_matcher->best();
+}
+
+// Bone lengths and joint angles of the last count frames of track id. Lengths are written
+// bone-major (bone b of frame i at b * count + i), angles in radians likewise per a, b, c
+// triple, and the frames' valid masks into masks. Returns the number of frames, oldest first.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_computeSkeletonFeaturesJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jint id,
+        jint count,
+        jintArray angleTriples,
+        jfloatArray boneLengths,
+        jfloatArray angles,
+        jintArray masks) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (!history || count <= 0) return 0;
+
+    const unsigned int num_joints = history->numJoints();
+    const size_t num_bones = bone_pairs.size() / 2;
+    const size_t num_angles = env->GetArrayLength(angleTriples) / 3;
+    if ((size_t) env->GetArrayLength(boneLengths) < num_bones * count ||
+        (size_t) env->GetArrayLength(angles) < num_angles * count ||
+        env->GetArrayLength(masks) < count) {
+        return 0;
+    }
+
+    std::vector<JointAngleDef> defs(num_angles);
+    env->GetIntArrayRegion(angleTriples, 0, num_angles * 3, (jint*) defs.data());
+    for (const JointAngleDef& d : defs) {
+        if ((unsigned int) d.a >= num_joints || (unsigned int) d.b >= num_joints || (unsigned int) d.c >= num_joints) {
+            return 0;
+        }
+    }
+
+    const PoseWindow window = history->windowByCount(id, count);
+    const size_t n = window.size();
+    if (n == 0) return 0;
+
+    const size_t stride = (n + 3) & ~(size_t) 3;
+    skeleton_x.assign(num_joints * stride, 0.0f);
+    skeleton_y.assign(num_joints * stride, 0.0f);
+    skeleton_masks.resize(n);
+    skeleton_dx.resize(num_bones * stride);
+    skeleton_dy.resize(num_bones * stride);
+    skeleton_lengths.resize(num_bones * stride);
+    skeleton_angles.resize(num_angles * stride);
+
+    size_t dst = 0;
+    for (size_t s = 0; s < window.numSegments(); s++) {
+        const PoseWindow::Segment& seg = window.segment(s);
+        transposePoses(seg.joints, seg.count, num_joints, skeleton_x.data() + dst, skeleton_y.data() + dst, stride);
+        memcpy(&skeleton_masks[dst], seg.valid_masks, seg.count * sizeof(uint32_t));
+        dst += seg.count;
+    }
+
+    const PoseBatch batch = { skeleton_x.data(), skeleton_y.data(), skeleton_masks.data(), n, stride };
+    const BoneFeatures bones = { skeleton_dx.data(), skeleton_dy.data(), skeleton_lengths.data(), stride };
+    if (j23_topology) {
+        computeBones<J23Topology>(batch, bones, frame_aspect);
+    } else {
+        computeBones(bone_pairs.data(), num_bones, batch, bones, frame_aspect);
+    }
+    computeJointAngles(defs.data(), num_angles, batch, skeleton_angles.data(), stride, frame_aspect);
+
+    for (size_t b = 0; b < num_bones; b++) {
+        env->SetFloatArrayRegion(boneLengths, b * count, n, &skeleton_lengths[b * stride]);
+    }
+    for (size_t a = 0; a < num_angles; a++) {
+        env->SetFloatArrayRegion(angles, a * count, n, &skeleton_angles[a * stride]);
+    }
+    env->SetIntArrayRegion(masks, 0, n, (const jint*) skeleton_masks.data());
+    return (jint) n;
+}
+
+// Copies a window into the caller's arrays, which bound the number of frames returned.
+static jint copyPoseWindow(JNIEnv* env, const PoseWindow& window, jlongArray timestamps,
+                           jfloatArray joints, jfloatArray scores, jfloatArray boxes, jintArray masks) {
+    const size_t max_frames = env->GetArrayLength(timestamps);
+    const size_t skip = window.size() > max_frames ? window.size() - max_frames : 0;
+    const unsigned int num_joints = window.numJoints();
+
+    size_t dst = 0;
+    size_t seen = 0;
+    for (size_t s = 0; s < window.numSegments(); s++) {
+        const PoseWindow::Segment& seg = window.segment(s);
+        const size_t first = skip > seen ? std::min(skip - seen, seg.count) : 0;
+        const size_t n = seg.count - first;
+        seen += seg.count;
+        if (n == 0) continue;
+
+        env->SetLongArrayRegion(timestamps, dst, n, (const jlong*) seg.timestamps_us + first);
+        env->SetFloatArrayRegion(joints, dst * num_joints * 2, n * num_joints * 2, seg.joints + first * num_joints * 2);
+        env->SetFloatArrayRegion(scores, dst * num_joints, n * num_joints, seg.scores + first * num_joints);
+        env->SetFloatArrayRegion(boxes, dst * 4, n * 4, seg.bbox + first * 4);
+        env->SetIntArrayRegion(masks, dst, n, (const jint*) seg.valid_masks + first);
+        dst += n;
+    }
+    return (jint) dst;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getPoseWindowByTimeJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jint id,
+        jlong fromUs,
+        jlong toUs,
+        jlongArray timestamps,
+        jfloatArray joints,
+        jfloatArray scores,
+        jfloatArray boxes,
+        jintArray masks) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (!history) return 0;
+    return copyPoseWindow(env, history->windowByTime(id, fromUs, toUs), timestamps, joints, scores, boxes, masks);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getPoseWindowByCountJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jint id,
+        jint count,
+        jlongArray timestamps,
+        jfloatArray joints,
+        jfloatArray scores,
+        jfloatArray boxes,
+        jintArray masks) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (!history) return 0;
+    return copyPoseWindow(env, history->windowByCount(id, count), timestamps, joints, scores, boxes, masks);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getTrackIdsJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jintArray ids) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (!history) return 0;
+    std::vector<int> buf(env->GetArrayLength(ids));
+    const size_t n = history->trackIds(buf.data(), buf.size());
+    env->SetIntArrayRegion(ids, 0, n, buf.data());
+    return (jint) n;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_startRecordingJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jstring pathStr) {
+    if (!initialzed) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Not initialized");
+        return JNI_FALSE;
+    }
+
+    const char* path = env->GetStringUTFChars(pathStr, 0);
+    std::lock_guard<std::mutex> lock(track_mutex);
+    const bool ok = track_writer.open(path, "j23", history->numJoints(), bone_pairs.data(), bone_pairs.size() / 2);
+    if (!ok) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Failed to open pose track %s", path);
+    }
+    env->ReleaseStringUTFChars(pathStr, path);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_stopRecordingJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    std::lock_guard<std::mutex> lock(track_mutex);
+    return track_writer.close() ? JNI_TRUE : JNI_FALSE;
+}
+
+// Returns the number of frames in the track, or -1 if it could not be opened.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_openReplayJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jstring pathStr) {
+    if (!initialzed) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Not initialized");
+        return -1;
+    }
+
+    const char* path = env->GetStringUTFChars(pathStr, 0);
+    std::lock_guard<std::mutex> lock(track_mutex);
+    bool ok = track_reader.open(path);
+    if (ok && track_reader.numJoints() != history->numJoints()) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Pose track %s has %u joints", path, track_reader.numJoints());
+        track_reader.close();
+        ok = false;
+    } else if (!ok) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Failed to open pose track %s", path);
+    }
+    env->ReleaseStringUTFChars(pathStr, path);
+    return ok ? (jint) track_reader.numFrames() : -1;
+}
+
+// Replays the recorded frame at or before timestampUs as if the estimator had produced it.
+// The output matches processWrnchJNI.
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_replayFrameJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jlong timestampUs) {
+    bool have_main = false;
+    std::lock_guard<std::mutex> track_lock(track_mutex);
+    std::lock_guard<std::mutex> lock(history_mutex);
+
+    const long index = track_reader.isOpen() ? track_reader.findFrame(timestampUs) : -1;
+    if (index < 0) {
+        return toFloatArray(env, have_main);
+    }
+
+    PoseTrackReader::Frame frame = track_reader.frame(index);
+    if (timestampUs - frame.timestamp_us > REPLAY_MAX_POSE_AGE_US) {
+        frame.count = 0;
+    }
+    const unsigned int num_joints = track_reader.numJoints();
+    beginFrameFeatures();
+    beginFrameOverlay();
+    const char* rec = reinterpret_cast<const char*>(frame.first);
+    for (size_t i = 0; i < frame.count; i++, rec += poseTrackRecordSize(num_joints)) {
+        const PoseTrackRecord* record = reinterpret_cast<const PoseTrackRecord*>(rec);
+
+        PoseSample pose;
+        pose.id = record->id;
+        pose.is_main = (record->flags & POSE_TRACK_FLAG_MAIN) != 0;
+        pose.score = record->score;
+        pose.num_joints = num_joints;
+        pose.joints = poseTrackJoints(record);
+        pose.scores = poseTrackScores(record, num_joints);
+        memcpy(pose.bbox, record->bbox, sizeof(pose.bbox));
+
+        postProcessPose(pose, frame.timestamp_us, &have_main);
+    }
+    extractFrameFeatures();
+    publishFrameOverlay();
+
+    return toFloatArray(env, have_main);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_closeReplayJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    std::lock_guard<std::mutex> lock(track_mutex);
+    track_reader.close();
+}
+
+// Takes effect from the next frame (or at initWrnchJNI if not initialized yet).
+extern "C" JNIEXPORT void JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setFaceEnabledJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jboolean enabled) {
+    requested_face = enabled == JNI_TRUE ? 1 : 0;
+}
+
+// Mean wrPoseEstimator_ProcessFrame time in microseconds and frame count, with the face
+// stage off then on.
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getProcessTimingJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    float timing[4];
+    for (int i = 0; i < 2; i++) {
+        const StageTiming& t = process_timing[i];
+        timing[i * 2] = t.frames > 0 ? (float) (t.total_us / t.frames) : 0.0f;
+        timing[i * 2 + 1] = (float) t.frames;
+    }
+    auto result = env->NewFloatArray(4);
+    env->SetFloatArrayRegion(result, 0, 4, timing);
+    return result;
+}
+
+// Adds a sample of a stage timed in Java, STAGE_INGEST or STAGE_CONVERSION; frame thread only.
+extern "C" JNIEXPORT void JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_recordStageLatencyJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jint stage,
+        jlong nanos) {
+    if (stage < 0 || stage >= NUM_STAGES || nanos < 0) return;
+    stage_latency[stage].record((uint64_t) nanos);
+}
+
+// Frame path statistics in one array. Per stage, in LatencyStage order, STATS_PER_STAGE
+// values in microseconds:
+//   [0] samples  [1] mean  [2] p50  [3] p90  [4] p99  [5] p99.9  [6] max
+// then the counters, from NUM_STAGES * STATS_PER_STAGE on:
+//   [0] frames processed  [1] frames the estimator failed on
+//   [2] motion events queued  [3] motion events dropped
+//   [4] 3D frames submitted  [5] 3D frames dropped
+//   [6] activity frames submitted  [7] activity frames dropped
+// May be polled from any thread while frames are processed; the histograms are read
+// without locking.
+static const int STATS_PER_STAGE = 7;
+static const int STATS_COUNTERS = 8;
+
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getStatsJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    static const double QUANTILES[4] = { 0.5, 0.9, 0.99, 0.999 };
+    float stats[NUM_STAGES * STATS_PER_STAGE + STATS_COUNTERS];
+    for (int s = 0; s < NUM_STAGES; s++) {
+        const LatencyHistogram& h = stage_latency[s];
+        uint64_t p[4];
+        h.percentiles(QUANTILES, 4, p);
+        float* out = stats + s * STATS_PER_STAGE;
+        out[0] = (float) h.count();
+        out[1] = (float) (h.mean() / 1000.0);
+        for (int q = 0; q < 4; q++) out[2 + q] = (float) (p[q] / 1000.0);
+        out[6] = (float) (h.max() / 1000.0);
+    }
+    const Pose3dTiming pose3d = pose3d_stage.timing();
+    const ActivityTiming activity = activity_stage.timing();
+    float* counters = stats + NUM_STAGES * STATS_PER_STAGE;
+    counters[0] = (float) frames_processed.load();
+    counters[1] = (float) frames_failed.load();
+    counters[2] = (float) motion_detector.queued();
+    counters[3] = (float) motion_detector.dropped();
+    counters[4] = (float) (pose3d.processed + pose3d.dropped);
+    counters[5] = (float) pose3d.dropped;
+    counters[6] = (float) (activity.processed + activity.dropped);
+    counters[7] = (float) activity.dropped;
+
+    const jsize n = NUM_STAGES * STATS_PER_STAGE + STATS_COUNTERS;
+    auto result = env->NewFloatArray(n);
+    env->SetFloatArrayRegion(result, 0, n, stats);
+    return result;
+}
+
+// Clears the latency histograms and frame counters; the stages' own drop counters keep
+// counting.
+extern "C" JNIEXPORT void JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_resetStatsJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    for (LatencyHistogram& h : stage_latency) h.reset();
+    frames_processed = 0;
+    frames_failed = 0;
+}
+
+// Chooses the native tracker over the estimator's own, from the next frame on (or at
+// initWrnchJNI if not initialized yet); see applyTrackingMode.
+extern "C" JNIEXPORT void JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setNativeTrackingJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jboolean enabled) {
+    requested_tracking = enabled == JNI_TRUE ? 1 : 0;
+}
+
+// Native tracker mean time per frame in microseconds and frame count, to compare against
+// getProcessTimingJNI with the estimator's tracker on.
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getTrackerTimingJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    const float timing[2] = {
+        tracker_timing.frames > 0 ? (float) (tracker_timing.total_us / tracker_timing.frames) : 0.0f,
+        (float) tracker_timing.frames };
+    auto result = env->NewFloatArray(2);
+    env->SetFloatArrayRegion(result, 0, 2, timing);
+    return result;
+}
+
+// Number of body joints and face landmarks, fixing the processWrnchJNI output layout.
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getOutputLayoutJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    const jint layout[2] = { history ? (jint) history->numJoints() : 0, (jint) num_face_landmarks };
+    auto result = env->NewIntArray(2);
+    env->SetIntArrayRegion(result, 0, 2, layout);
+    return result;
+}
+
+// Starts or stops the 3D stage. It runs on a second estimator so 2D frames never wait for
+// it; stride N hands every Nth 2D frame to the 3D stage.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_set3dEnabledJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jboolean enabled,
+        jboolean useIk,
+        jint stride) {
+    pose3d_stage.stop();
+    if (!enabled) {
+        return JNI_TRUE;
+    }
+    if (!initialzed) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Not initialized");
+        return JNI_FALSE;
+    }
+
+    wrPoseEstimatorHandle estimator;
+    wrReturnCode wrc;
+    {
+        // applyTrackingMode rewrites config_params on the frame thread
+        std::lock_guard<std::mutex> lock(history_mutex);
+        wrc = wrPoseEstimator_CreateFromConfig(&estimator, config_params);
+    }
+    if (wrc != wrReturnCode_OK) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "3D wrPoseEstimator_CreateFromConfig: %s", wrReturnCode_Translate(wrc));
+        return JNI_FALSE;
+    }
+
+    wrIKParamsHandle ik_params = useIk ? wrIKParams_Create() : nullptr;
+    wrc = wrPoseEstimator_Initialize3D(estimator, ik_params, models_dir.c_str());
+    if (ik_params) {
+        wrIKParams_Destroy(ik_params);
+    }
+    if (wrc != wrReturnCode_OK) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "wrPoseEstimator_Initialize3D: %s", wrReturnCode_Translate(wrc));
+        wrPoseEstimator_Destroy(estimator);
+        return JNI_FALSE;
+    }
+
+    pose3d_stage.start(estimator, useIk, stride);
+    return JNI_TRUE;
+}
+
+// Latest 3D poses: [0] number of people P, [1] joints J (raw int bits), then per person the
+// 2D tracker id (raw int bits, -1 if unmatched), J * 3 positions and J * 4 rotation
+// quaternions. The frame timestamp goes to timestampOut[0].
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_get3dPosesJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jlongArray timestampOut) {
+    Pose3dResult result;
+    if (!pose3d_stage.latest(&result)) {
+        return env->NewFloatArray(0);
+    }
+
+    const int num_people = result.numPeople();
+    const int num_joints = result.num_joints;
+    std::vector<float> out(2 + num_people * (1 + num_joints * 7));
+    memcpy(&out[0], &num_people, sizeof(num_people));
+    memcpy(&out[1], &num_joints, sizeof(num_joints));
+
+    float* dst = &out[2];
+    for (int p = 0; p < num_people; p++) {
+        memcpy(dst, &result.ids[p], sizeof(int));
+        memcpy(dst + 1, &result.positions[p * num_joints * 3], sizeof(float) * num_joints * 3);
+        memcpy(dst + 1 + num_joints * 3, &result.rotations[p * num_joints * 4], sizeof(float) * num_joints * 4);
+        dst += 1 + num_joints * 7;
+    }
+
+    const jlong ts = result.timestamp_us;
+    env->SetLongArrayRegion(timestampOut, 0, 1, &ts);
+
+    auto array = env->NewFloatArray(out.size());
+    env->SetFloatArrayRegion(array, 0, out.size(), out.data());
+    return array;
+}
+
+// 3D stage mean time per processed frame in microseconds, frames processed and frames
+// dropped because the stage was still busy.
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_get3dTimingJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    const Pose3dTiming t = pose3d_stage.timing();
+    const float timing[3] = { (float) t.mean_us, (float) t.processed, (float) t.dropped };
+    auto result = env->NewFloatArray(3);
+    env->SetFloatArrayRegion(result, 0, 3, timing);
+    return result;
+}
+
+// Starts (or stops) the activity stage with the activity model at modelPath, running it on
+// every stride-th frame.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setActivityEnabledJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jboolean enabled,
+        jstring modelPathStr,
+        jint stride) {
+    std::lock_guard<std::mutex> lock(activity_mutex);
+    activity_stage.stop();
+    if (!enabled) {
+        return JNI_TRUE;
+    }
+    if (!initialzed) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Not initialized");
+        return JNI_FALSE;
+    }
+
+    const char* model_path = env->GetStringUTFChars(modelPathStr, 0);
+    wrActivityModelBuilderHandle builder;
+    auto wrc = wrActivityModelBuilder_Create(model_path, &builder);
+    env->ReleaseStringUTFChars(modelPathStr, model_path);
+    if (wrc != wrReturnCode_OK) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "wrActivityModelBuilder_Create: %s", wrReturnCode_Translate(wrc));
+        return JNI_FALSE;
+    }
+
+    wrActivityModelHandle model = nullptr;
+    wrPoseEstimatorRequirementsHandle requirements = nullptr;
+    wrPoseEstimatorHandle estimator = nullptr;
+    wrc = wrActivityModelBuilder_Build(builder, &model);
+    if (wrc != wrReturnCode_OK) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "wrActivityModelBuilder_Build: %s", wrReturnCode_Translate(wrc));
+    } else {
+        wrc = wrActivityModelBuilder_PoseEstimatorRequirements(builder, &requirements);
+        if (wrc != wrReturnCode_OK) {
+            __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "wrActivityModelBuilder_PoseEstimatorRequirements: %s", wrReturnCode_Translate(wrc));
+        }
+    }
+    wrActivityModelBuilder_Destroy(builder);
+
+    // same configuration as the 2D estimator, which has to satisfy the model
+    if (wrc == wrReturnCode_OK) {
+        {
+            std::lock_guard<std::mutex> lock(history_mutex);
+            wrc = wrPoseEstimator_CreateFromConfig(&estimator, config_params);
+        }
+        if (wrc != wrReturnCode_OK) {
+            __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Activity wrPoseEstimator_CreateFromConfig: %s", wrReturnCode_Translate(wrc));
+        } else if (!wrPoseEstimatorRequirements_IsEstimatorCompatible(requirements, estimator)) {
+            __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Pose estimator does not meet the activity model requirements");
+            wrc = wrReturnCode_INCOMPATIBLE_POSE_ESTIMATOR_REQUIREMENTS;
+        }
+    }
+
+    if (wrc != wrReturnCode_OK) {
+        if (estimator) wrPoseEstimator_Destroy(estimator);
+        if (requirements) wrPoseEstimatorRequirements_Destroy(requirements);
+        if (model) wrActivityModel_Destroy(model);
+        return JNI_FALSE;
+    }
+
+    auto options = wrPoseEstimatorRequirements_CreateCompatibleOptions(requirements);
+    wrPoseEstimatorOptions_SetEnableJointSmoothing(options, 1);
+    wrPoseEstimatorOptions_SetRotationMultipleOf90(options, 0);
+    wrPoseEstimatorRequirements_Destroy(requirements);
+
+    activity_stage.start(model, estimator, options, stride);
+    return JNI_TRUE;
+}
+
+// Latest activity results: [0] number of people P, [1] classes C (raw int bits), then per
+// person the 2D tracker id (raw int bits, -1 if unmatched) and C class probabilities. The
+// frame timestamp goes to timestampOut[0].
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getActivityJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jlongArray timestampOut) {
+    std::lock_guard<std::mutex> lock(activity_mutex);
+    const ActivityResult* result = activity_stage.latest();
+    if (!result) {
+        return env->NewFloatArray(0);
+    }
+
+    const int num_people = result->numPeople();
+    const int num_classes = result->num_classes;
+    std::vector<float> out(2 + num_people * (1 + num_classes));
+    memcpy(&out[0], &num_people, sizeof(num_people));
+    memcpy(&out[1], &num_classes, sizeof(num_classes));
+
+    float* dst = &out[2];
+    for (int p = 0; p < num_people; p++) {
+        memcpy(dst, &result->ids[p], sizeof(int));
+        memcpy(dst + 1, &result->probabilities[p * num_classes], sizeof(float) * num_classes);
+        dst += 1 + num_classes;
+    }
+
+    const jlong ts = result->timestamp_us;
+    env->SetLongArrayRegion(timestampOut, 0, 1, &ts);
+
+    auto array = env->NewFloatArray(out.size());
+    env->SetFloatArrayRegion(array, 0, out.size(), out.data());
+    return array;
+}
+
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getActivityClassesJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    std::lock_guard<std::mutex> lock(activity_mutex);
+    const std::vector<std::string>& names = activity_stage.classNames();
+    auto result = env->NewObjectArray(names.size(), env->FindClass("java/lang/String"), nullptr);
+    for (size_t i = 0; i < names.size(); i++) {
+        jstring name = env->NewStringUTF(names[i].c_str());
+        env->SetObjectArrayElement(result, i, name);
+        env->DeleteLocalRef(name);
+    }
+    return result;
+}
+
+// Activity stage mean time per processed frame in microseconds, frames processed and frames
+// dropped because the stage was still busy.
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getActivityTimingJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    const ActivityTiming t = activity_stage.timing();
+    const float timing[3] = { (float) t.mean_us, (float) t.processed, (float) t.dropped };
+    auto result = env->NewFloatArray(3);
+    env->SetFloatArrayRegion(result, 0, 3, timing);
+    return result;
+}
+
+// False if the model has no mask; otherwise the change takes effect from the next frame.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setMaskEnabledJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jboolean enabled) {
+    if (!initialzed) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Not initialized");
+        return JNI_FALSE;
+    }
+    if (enabled && !wrPoseEstimator_SupportsMaskEstimation(pose_estimator)) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Mask estimation not supported by the model");
+        return JNI_FALSE;
+    }
+    requested_mask = enabled == JNI_TRUE ? 1 : 0;
+    return JNI_TRUE;
+}
+
+// Mask width, height and depth (number of planes), all 0 while the mask is off.
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getMaskDimsJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    jint dims[3] = { 0, 0, 0 };
+    if (initialzed && mask_enabled) {
+        wrPoseEstimator_GetMaskDims(pose_estimator, &dims[0], &dims[1], &dims[2]);
+    }
+    auto result = env->NewIntArray(3);
+    env->SetIntArrayRegion(result, 0, 3, dims);
+    return result;
+}
+
+// Direct buffer over the estimator's own mask memory (planes of width * height bytes: body,
+// right hand, left hand, both hands), or null while the mask is off. Nothing tracks the
+// buffer: it dangles after the next frame, turning the mask off or reinitializing the
+// estimator, so Java must fetch it per frame (see Wrnch.getMaskView).
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_getMaskViewJNI(
+        JNIEnv* env,
+        jobject /* this */) {
+    if (!initialzed || !mask_enabled) {
+        return nullptr;
+    }
+    int width, height, depth;
+    wrPoseEstimator_GetMaskDims(pose_estimator, &width, &height, &depth);
+    const unsigned char* mask = wrPoseEstimator_GetMaskView(pose_estimator);
+    if (!mask || width <= 0 || height <= 0) {
+        return nullptr;
+    }
+    return env->NewDirectByteBuffer(const_cast<unsigned char*>(mask), (jlong) width * height * depth);
+}
+
+// Android color int premultiplied and packed as R, G, B, A bytes in memory.
+static uint32_t premultipliedRgba(jint color) {
+    const uint32_t a = (uint32_t) color >> 24;
+    const uint32_t r = (((uint32_t) color >> 16) & 0xff) * a / 255;
+    const uint32_t g = (((uint32_t) color >> 8) & 0xff) * a / 255;
+    const uint32_t b = ((uint32_t) color & 0xff) * a / 255;
+    return (a << 24) | (b << 16) | (g << 8) | r;
+}
+
+// Upsamples the body mask to width x height and writes color where it reaches threshold into
+// the direct RGBA buffer (ARGB_8888 bitmap layout), transparent elsewhere. color is an
+// Android color int.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_renderMaskOverlayJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jobject rgbaBuffer,
+        jint width,
+        jint height,
+        jint stride,
+        jint threshold,
+        jint color) {
+    if (!initialzed || !mask_enabled || width <= 0 || height <= 0) {
+        return JNI_FALSE;
+    }
+
+    uint8_t* rgba = static_cast<uint8_t*>(env->GetDirectBufferAddress(rgbaBuffer));
+    if (!rgba || env->GetDirectBufferCapacity(rgbaBuffer) < (jlong) stride * height || stride < width * 4) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Mask overlay buffer too small");
+        return JNI_FALSE;
+    }
+
+    int mask_width, mask_height, mask_depth;
+    wrPoseEstimator_GetMaskDims(pose_estimator, &mask_width, &mask_height, &mask_depth);
+    const unsigned char* mask = wrPoseEstimator_GetMaskView(pose_estimator);
+    if (!mask || mask_width <= 0 || mask_height <= 0) {
+        return JNI_FALSE;
+    }
+
+    renderMaskOverlay(mask_upsampler, mask, mask_width, mask_height, rgba, width, height, stride,
+                      (uint8_t) std::min(std::max(threshold, 0), 255), premultipliedRgba(color));
+    return JNI_TRUE;
+}
+
+// Starts or stops staging every person of each frame for the native skeleton overlay, drawn
+// with the given Android colors, joint radius and bone width in pixels.
+extern "C" JNIEXPORT void JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setSkeletonOverlayJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jboolean enabled,
+        jint jointColor,
+        jint boneColor,
+        jfloat jointRadius,
+        jfloat boneWidth) {
+    std::lock_guard<std::mutex> lock(raster_mutex);
+    overlay_style.joint_color = premultipliedRgba(jointColor);
+    overlay_style.bone_color = premultipliedRgba(boneColor);
+    overlay_style.joint_radius = jointRadius;
+    overlay_style.bone_width = boneWidth;
+    skeleton_rasterizer.setStyle(overlay_style);
+    skeleton_overlay = enabled == JNI_TRUE;
+}
+
+// Sets up the rasterizer for the newest overlay frame in a width x height image, joints at
+// normalized * scale + offset. Called with raster_mutex held.
+static void beginOverlayFrame(int width, int height, float left, float top, float scaleX, float scaleY) {
+    if (skeleton_rasterizer.width() != width || skeleton_rasterizer.height() != height) {
+        skeleton_rasterizer.configure(width, height, bone_pairs.data(), bone_pairs.size() / 2);
+    }
+    const OverlayFrame* frame = overlay_frames.latest();
+    const RasterTransform transform = { scaleX, scaleY, left, top };
+    if (frame) {
+        skeleton_rasterizer.beginFrame(frame->joints.data(), frame->masks.data(), frame->masks.size(),
+                                       frame->num_joints, transform);
+    } else {
+        skeleton_rasterizer.beginFrame(nullptr, nullptr, 0, 0, transform);
+    }
+}
+
+// Draws the people of the newest processed frame into an ARGB_8888 bitmap, normalized joint
+// coordinates mapped to x * scaleX + left, y * scaleY + top. Keep drawing into the same
+// bitmap: only what changed since the last call is redrawn. Returns the number of tiles
+// drawn, -1 on error.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_renderSkeletonOverlayJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jobject bitmap,
+        jfloat left,
+        jfloat top,
+        jfloat scaleX,
+        jfloat scaleY) {
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "Skeleton overlay needs an ARGB_8888 bitmap");
+        return -1;
+    }
+    void* pixels;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        return -1;
+    }
+
+    size_t drawn;
+    {
+        std::lock_guard<std::mutex> lock(raster_mutex);
+        beginOverlayFrame(info.width, info.height, left, top, scaleX, scaleY);
+        if (pixels != overlay_pixels) {
+            skeleton_rasterizer.invalidate();
+            overlay_pixels = pixels;
+        }
+        drawn = skeleton_rasterizer.draw(static_cast<uint8_t*>(pixels), info.stride, nullptr);
+    }
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return drawn;
+}
+
+// Makes surface (null to release it) the window renderSkeletonOverlayToSurfaceJNI draws into,
+// with RGBA buffers of width x height. The overlay goes either to a surface or to a bitmap,
+// switching between them redraws everything.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_setOverlaySurfaceJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jobject surface,
+        jint width,
+        jint height) {
+    std::lock_guard<std::mutex> lock(raster_mutex);
+    if (overlay_window) {
+        ANativeWindow_release(overlay_window);
+        overlay_window = nullptr;
+    }
+    if (!surface) {
+        return JNI_TRUE;
+    }
+    overlay_window = ANativeWindow_fromSurface(env, surface);
+    if (!overlay_window || ANativeWindow_setBuffersGeometry(overlay_window, width, height, WINDOW_FORMAT_RGBA_8888) != 0) {
+        return JNI_FALSE;
+    }
+    skeleton_rasterizer.configure(width, height, bone_pairs.data(), bone_pairs.size() / 2);
+    overlay_pixels = nullptr;
+    return JNI_TRUE;
+}
+
+// Like renderSkeletonOverlayJNI into the overlay surface. Only the changed region is locked
+// and posted; whatever the window could not preserve is redrawn too. Returns the number of
+// tiles drawn, 0 if nothing changed and no buffer was posted, -1 on error.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_samsungnext_audiovideoplayersample_Wrnch_renderSkeletonOverlayToSurfaceJNI(
+        JNIEnv* env,
+        jobject /* this */,
+        jfloat left,
+        jfloat top,
+        jfloat scaleX,
+        jfloat scaleY) {
+    std::lock_guard<std::mutex> lock(raster_mutex);
+    if (!overlay_window) {
+        return -1;
+    }
+
+    ANativeWindow_Buffer buffer;
+    beginOverlayFrame(skeleton_rasterizer.width(), skeleton_rasterizer.height(), left, top, scaleX, scaleY);
+    const RasterRect dirty = skeleton_rasterizer.dirtyBounds();
+    if (dirty.empty()) {
+        return 0;
+    }
+
+    ARect bounds = { dirty.left, dirty.top, dirty.right, dirty.bottom };
+    if (ANativeWindow_lock(overlay_window, &buffer, &bounds) != 0) {
+        return -1;
+    }
+    if (buffer.width != skeleton_rasterizer.width() || buffer.height != skeleton_rasterizer.height()) {
+        // resized underneath us: start over with the next call
+        ANativeWindow_unlockAndPost(overlay_window);
+        skeleton_rasterizer.configure(buffer.width, buffer.height, bone_pairs.data(), bone_pairs.size() / 2);
+        return -1;
+    }
+    const RasterRect invalid = { bounds.left, bounds.top, bounds.right, bounds.bottom };
+    const size_t drawn = skeleton_rasterizer.draw(static_cast<uint8_t*>(buffer.bits), buffer.stride * 4, &invalid);
+    ANativeWindow_unlockAndPost(overlay_window);
+    return drawn;
+}
@@ -0,0 +1,182 @@
+#include "one-euro-filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const float TWO_PI = 6.28318530718f;
+
+float oneEuroAlpha(float cutoff_hz, float dt) {
+    const float r = TWO_PI * cutoff_hz * dt;
+    return r / (r + 1.0f);
+}
+
+void oneEuroStepScalar(const float* x, float* x_hat, float* dx_hat, const float* min_cutoff, const float* beta,
+                       size_t n, float dt, float alpha_d, float* out) {
+    const float inv_dt = 1.0f / dt;
+    for (size_t i = 0; i < n; i++) {
+        const float dx = (x[i] - x_hat[i]) * inv_dt;
+        const float edx = dx_hat[i] + alpha_d * (dx - dx_hat[i]);
+        const float alpha = oneEuroAlpha(min_cutoff[i] + beta[i] * std::fabs(edx), dt);
+        const float xh = x_hat[i] + alpha * (x[i] - x_hat[i]);
+        dx_hat[i] = edx;
+        x_hat[i] = xh;
+        out[i] = xh;
+    }
+}
+
+void oneEuroStep(const float* x, float* x_hat, float* dx_hat, const float* min_cutoff, const float* beta,
+                 size_t n, float dt, float alpha_d, float* out) {
+    size_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t inv_dt = vdupq_n_f32(1.0f / dt);
+    const float32x4_t ad = vdupq_n_f32(alpha_d);
+    const float32x4_t w = vdupq_n_f32(TWO_PI * dt);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t xv = vld1q_f32(x + i);
+        const float32x4_t xh = vld1q_f32(x_hat + i);
+        const float32x4_t dxh = vld1q_f32(dx_hat + i);
+        const float32x4_t diff = vsubq_f32(xv, xh);
+        const float32x4_t edx = vmlaq_f32(dxh, ad, vsubq_f32(vmulq_f32(diff, inv_dt), dxh));
+        const float32x4_t cutoff = vmlaq_f32(vld1q_f32(min_cutoff + i), vld1q_f32(beta + i), vabsq_f32(edx));
+        const float32x4_t r = vmulq_f32(w, cutoff);
+        const float32x4_t den = vaddq_f32(r, one);
+#if defined(__aarch64__)
+        const float32x4_t alpha = vdivq_f32(r, den);
+#else
+        float32x4_t inv = vrecpeq_f32(den);
+        inv = vmulq_f32(inv, vrecpsq_f32(den, inv));
+        inv = vmulq_f32(inv, vrecpsq_f32(den, inv));
+        const float32x4_t alpha = vmulq_f32(r, inv);
+#endif
+        const float32x4_t res = vmlaq_f32(xh, alpha, diff);
+        vst1q_f32(dx_hat + i, edx);
+        vst1q_f32(x_hat + i, res);
+        vst1q_f32(out + i, res);
+    }
+#elif defined(__SSE2__)
+    const __m128 inv_dt = _mm_set1_ps(1.0f / dt);
+    const __m128 ad = _mm_set1_ps(alpha_d);
+    const __m128 w = _mm_set1_ps(TWO_PI * dt);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    for (; i + 4 <= n; i += 4) {
+        const __m128 xv = _mm_loadu_ps(x + i);
+        const __m128 xh = _mm_loadu_ps(x_hat + i);
+        const __m128 dxh = _mm_loadu_ps(dx_hat + i);
+        const __m128 diff = _mm_sub_ps(xv, xh);
+        const __m128 edx = _mm_add_ps(dxh, _mm_mul_ps(ad, _mm_sub_ps(_mm_mul_ps(diff, inv_dt), dxh)));
+        const __m128 cutoff = _mm_add_ps(_mm_loadu_ps(min_cutoff + i), _mm_mul_ps(_mm_loadu_ps(beta + i), _mm_and_ps(edx, abs_mask)));
+        const __m128 r = _mm_mul_ps(w, cutoff);
+        const __m128 alpha = _mm_div_ps(r, _mm_add_ps(r, one));
+        const __m128 res = _mm_add_ps(xh, _mm_mul_ps(alpha, diff));
+        _mm_storeu_ps(dx_hat + i, edx);
+        _mm_storeu_ps(x_hat + i, res);
+        _mm_storeu_ps(out + i, res);
+    }
+#endif
+
+    if (i < n) {
+        oneEuroStepScalar(x + i, x_hat + i, dx_hat + i, min_cutoff + i, beta + i, n - i, dt, alpha_d, out + i);
+    }
+}
+
+OneEuroFilterBank::OneEuroFilterBank(unsigned int num_joints, size_t max_tracks)
+        : num_joints_(num_joints), max_tracks_(max_tracks), d_cutoff_(1.0f),
+          min_cutoff_(num_joints * 2), beta_(num_joints * 2), tracks_(max_tracks),
+          x_hat_(max_tracks * num_joints * 2), dx_hat_(max_tracks * num_joints * 2) {
+    setParams(1.7f, 0.3f, 1.0f);
+    clear();
+}
+
+void OneEuroFilterBank::setParams(float min_cutoff_hz, float beta, float d_cutoff_hz) {
+    std::fill(min_cutoff_.begin(), min_cutoff_.end(), min_cutoff_hz);
+    std::fill(beta_.begin(), beta_.end(), beta);
+    d_cutoff_ = d_cutoff_hz;
+}
+
+void OneEuroFilterBank::setParams(const float* min_cutoff_hz, const float* beta, float d_cutoff_hz) {
+    for (unsigned int j = 0; j < num_joints_; j++) {
+        min_cutoff_[j * 2] = min_cutoff_[j * 2 + 1] = min_cutoff_hz[j];
+        beta_[j * 2] = beta_[j * 2 + 1] = beta[j];
+    }
+    d_cutoff_ = d_cutoff_hz;
+}
+
+void OneEuroFilterBank::clear() {
+    for (auto& track : tracks_) {
+        track.live = false;
+        track.id = -1;
+        track.last_update_us = 0;
+        track.valid_mask = 0;
+    }
+}
+
+int OneEuroFilterBank::findTrack(int id) const {
+    for (size_t i = 0; i < max_tracks_; i++) {
+        if (tracks_[i].live && tracks_[i].id == id) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+int OneEuroFilterBank::acquireTrack(int id) {
+    size_t victim = 0;
+    for (size_t i = 0; i < max_tracks_; i++) {
+        if (!tracks_[i].live) {
+            victim = i;
+            break;
+        }
+        if (tracks_[i].last_update_us < tracks_[victim].last_update_us) {
+            victim = i;
+        }
+    }
+
+    Track& track = tracks_[victim];
+    track.id = id;
+    track.live = true;
+    track.valid_mask = 0;
+    return (int) victim;
+}
+
+void OneEuroFilterBank::filter(int id, int64_t timestamp_us, const float* joints, uint32_t valid_mask, float* out) {
+    int slot = findTrack(id);
+    if (slot < 0) {
+        slot = acquireTrack(id);
+    }
+
+    Track& track = tracks_[slot];
+    const int64_t gap_us = timestamp_us - track.last_update_us;
+    if (gap_us <= 0 || gap_us > MAX_GAP_US) {
+        track.valid_mask = 0;
+    }
+    track.last_update_us = timestamp_us;
+
+    const size_t channels = num_joints_ * 2;
+    float* x_hat = &x_hat_[slot * channels];
+    float* dx_hat = &dx_hat_[slot * channels];
+
+    // joints without state start out at their raw value; that also covers invalid joints,
+    // whose -1 placeholders then pass through unchanged
+    const uint32_t seeded = track.valid_mask & valid_mask;
+    for (unsigned int j = 0; j < num_joints_; j++) {
+        if (!(seeded & (1u << j))) {
+            x_hat[j * 2] = joints[j * 2];
+            x_hat[j * 2 + 1] = joints[j * 2 + 1];
+            dx_hat[j * 2] = 0.0f;
+            dx_hat[j * 2 + 1] = 0.0f;
+        }
+    }
+    track.valid_mask = valid_mask;
+
+    const float dt = gap_us > 0 ? gap_us * 1e-6f : 1.0f;
+    oneEuroStep(joints, x_hat, dx_hat, min_cutoff_.data(), beta_.data(), channels, dt, oneEuroAlpha(d_cutoff_, dt), out);
+}
@@ -0,0 +1,74 @@
+#ifndef ONE_EURO_FILTER_H
+#define ONE_EURO_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One-Euro joint smoothing for every tracked person, as an alternative to (or on top of)
+// the estimator's own smoothing.
+//
+// Each track slot keeps its filter state (last filtered value and filtered derivative per
+// x/y channel) struct-of-arrays in one slot-major allocation, and a frame of a person is
+// filtered as one vectorized pass over its 2 * num_joints channels. Cut-off and beta are
+// set per joint. The frame interval comes from the frame timestamps, so dropped or
+// irregular frames are handled; a new tracker id gets a fresh slot and so a fresh filter.
+// The class does no locking of its own.
+
+// One filter step over n channels: x are the raw values, x_hat and dx_hat the state, updated
+// in place, out the filtered values (may alias x). alpha_d is the derivative smoothing factor
+// for interval dt seconds.
+void oneEuroStep(const float* x, float* x_hat, float* dx_hat, const float* min_cutoff, const float* beta,
+                 size_t n, float dt, float alpha_d, float* out);
+
+// Plain scalar version of oneEuroStep, the reference for the vectorized one.
+void oneEuroStepScalar(const float* x, float* x_hat, float* dx_hat, const float* min_cutoff, const float* beta,
+                       size_t n, float dt, float alpha_d, float* out);
+
+// Smoothing factor of a first order low-pass with the given cut-off for interval dt.
+float oneEuroAlpha(float cutoff_hz, float dt);
+
+class OneEuroFilterBank {
+public:
+    // Gaps longer than this restart the filter instead of smoothing across them.
+    static constexpr int64_t MAX_GAP_US = 500000;
+
+    OneEuroFilterBank(unsigned int num_joints, size_t max_tracks);
+
+    // Same parameters for all joints.
+    void setParams(float min_cutoff_hz, float beta, float d_cutoff_hz);
+    // Per joint min_cutoff_hz and beta, num_joints each.
+    void setParams(const float* min_cutoff_hz, const float* beta, float d_cutoff_hz);
+
+    // Filters the joints (num_joints * 2, x,y interleaved) of person id. Joints not in
+    // valid_mask are copied through unchanged and restart their filter when they come back.
+    // out may alias joints.
+    void filter(int id, int64_t timestamp_us, const float* joints, uint32_t valid_mask, float* out);
+
+    void clear();
+
+    unsigned int numJoints() const { return num_joints_; }
+
+private:
+    struct Track {
+        int id;
+        bool live;
+        int64_t last_update_us;
+        uint32_t valid_mask;    // joints with filter state
+    };
+
+    int findTrack(int id) const;
+    int acquireTrack(int id);
+
+    unsigned int num_joints_;
+    size_t max_tracks_;
+    float d_cutoff_;
+    std::vector<float> min_cutoff_;     // per channel
+    std::vector<float> beta_;           // per channel
+    std::vector<Track> tracks_;
+    // slot-major: slot * num_joints * 2 + channel
+    std::vector<float> x_hat_;
+    std::vector<float> dx_hat_;
+};
+
+#endif // ONE_EURO_FILTER_H
@@ -0,0 +1,251 @@
+#include "pose-codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+enum FrameKind : uint8_t {
+    FRAME_KEY = 1,
+    FRAME_DELTA = 2,
+};
+
+static const float JOINT_SCALE = 65535.0f;
+static const float SCORE_SCALE = 255.0f;
+
+static void putVarint(uint64_t v, std::vector<uint8_t>& out) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t) (v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t) v);
+}
+
+static bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t* v) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        const uint8_t byte = *p++;
+        result |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t zigzag64(int64_t v) {
+    return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static int64_t unzigzag64(uint64_t v) {
+    return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+static void quantize(const float* __restrict joints, const float* __restrict scores, unsigned int num_joints,
+                     uint16_t* __restrict q) {
+    for (unsigned int i = 0; i < num_joints * 2; i++) {
+        const float v = std::min(std::max(joints[i] * JOINT_SCALE + 0.5f, 0.0f), JOINT_SCALE);
+        q[i] = (uint16_t) v;
+    }
+    uint16_t* __restrict qs = q + num_joints * 2;
+    for (unsigned int i = 0; i < num_joints; i++) {
+        const float v = std::min(std::max(scores[i] * SCORE_SCALE + 0.5f, 0.0f), SCORE_SCALE);
+        qs[i] = (uint16_t) v;
+    }
+}
+
+static void dequantize(const uint16_t* __restrict q, unsigned int num_joints, uint32_t valid_mask,
+                       float* __restrict joints, float* __restrict scores) {
+    for (unsigned int i = 0; i < num_joints * 2; i++) {
+        joints[i] = q[i] * (1.0f / JOINT_SCALE);
+    }
+    for (unsigned int i = 0; i < num_joints; i++) {
+        scores[i] = q[num_joints * 2 + i] * (1.0f / SCORE_SCALE);
+    }
+    for (unsigned int j = 0; j < num_joints; j++) {
+        if (!(valid_mask & (1u << j))) {
+            joints[j * 2] = -1.0f;
+            joints[j * 2 + 1] = -1.0f;
+        }
+    }
+}
+
+PoseEncoder::PoseEncoder(unsigned int num_joints, unsigned int keyframe_interval)
+        : num_joints_(num_joints),
+          num_channels_(num_joints * 3),
+          keyframe_interval_(std::max(keyframe_interval, 1u)),
+          frame_(0),
+          since_keyframe_(0),
+          prev_timestamp_us_(0),
+          prev_mask_(0),
+          prev_(num_channels_, 0),
+          cur_(num_channels_, 0),
+          zigzag_(num_channels_, 0) {
+    reset();
+}
+
+void PoseEncoder::reset() {
+    since_keyframe_ = keyframe_interval_;
+}
+
+void PoseEncoder::encode(int64_t timestamp_us, const float* joints, const float* scores, uint32_t valid_mask,
+                         std::vector<uint8_t>& out) {
+    uint16_t* __restrict cur = cur_.data();
+    const uint16_t* __restrict prev = prev_.data();
+    quantize(joints, scores, num_joints_, cur);
+
+    const bool key = since_keyframe_ >= keyframe_interval_;
+
+    // invalid joints repeat the previous value so they cost one byte in delta frames
+    if (!key) {
+        for (unsigned int j = 0; j < num_joints_; j++) {
+            if (!(valid_mask & (1u << j))) {
+                cur[j * 2] = prev[j * 2];
+                cur[j * 2 + 1] = prev[j * 2 + 1];
+            }
+        }
+    }
+
+    if (key) {
+        PoseKeyframe keyframe = { timestamp_us, frame_, out.size() };
+        keyframes_.push_back(keyframe);
+
+        out.push_back(FRAME_KEY);
+        putVarint(zigzag64(timestamp_us), out);
+        putVarint(valid_mask, out);
+
+        const size_t pos = out.size();
+        out.resize(pos + num_channels_ * 2);
+        uint8_t* dst = &out[pos];
+        for (unsigned int c = 0; c < num_channels_; c++) {
+            dst[c * 2] = (uint8_t) cur[c];
+            dst[c * 2 + 1] = (uint8_t) (cur[c] >> 8);
+        }
+        since_keyframe_ = 0;
+    } else {
+        out.push_back(FRAME_DELTA);
+        putVarint(zigzag64(timestamp_us - prev_timestamp_us_), out);
+        putVarint(valid_mask ^ prev_mask_, out);
+
+        uint16_t* __restrict zz = zigzag_.data();
+        for (unsigned int c = 0; c < num_channels_; c++) {
+            const int16_t d = (int16_t) (uint16_t) (cur[c] - prev[c]);
+            zz[c] = (uint16_t) (((uint16_t) d << 1) ^ (uint16_t) (d >> 15));
+        }
+
+        const unsigned int bitmap_bytes = (num_channels_ + 7) / 8;
+        size_t pos = out.size();
+        out.resize(pos + bitmap_bytes + num_channels_);
+        uint8_t* bitmap = &out[pos];
+        uint8_t* low = bitmap + bitmap_bytes;
+        memset(bitmap, 0, bitmap_bytes);
+
+        unsigned int num_wide = 0;
+        for (unsigned int c = 0; c < num_channels_; c++) {
+            const unsigned int wide = zz[c] > 0xff;
+            bitmap[c >> 3] |= (uint8_t) (wide << (c & 7));
+            low[c] = (uint8_t) zz[c];
+            num_wide += wide;
+        }
+
+        pos = out.size();
+        out.resize(pos + num_wide);
+        uint8_t* high = &out[pos];
+        for (unsigned int c = 0; c < num_channels_; c++) {
+            if (zz[c] > 0xff) {
+                *high++ = (uint8_t) (zz[c] >> 8);
+            }
+        }
+        since_keyframe_++;
+    }
+
+    prev_.swap(cur_);
+    prev_timestamp_us_ = timestamp_us;
+    prev_mask_ = valid_mask;
+    frame_++;
+}
+
+PoseDecoder::PoseDecoder(unsigned int num_joints)
+        : num_joints_(num_joints),
+          num_channels_(num_joints * 3),
+          have_keyframe_(false),
+          prev_timestamp_us_(0),
+          prev_mask_(0),
+          prev_(num_channels_, 0),
+          zigzag_(num_channels_, 0) {}
+
+void PoseDecoder::reset() {
+    have_keyframe_ = false;
+}
+
+size_t PoseDecoder::decode(const uint8_t* data, size_t size, int64_t* timestamp_us, float* joints, float* scores,
+                           uint32_t* valid_mask) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    if (p >= end) {
+        return 0;
+    }
+
+    const uint8_t kind = *p++;
+    uint64_t ts, mask;
+    if (!getVarint(p, end, &ts) || !getVarint(p, end, &mask)) {
+        return 0;
+    }
+
+    uint16_t* __restrict q = prev_.data();
+
+    if (kind == FRAME_KEY) {
+        if ((size_t) (end - p) < num_channels_ * 2) {
+            return 0;
+        }
+        for (unsigned int c = 0; c < num_channels_; c++) {
+            q[c] = (uint16_t) (p[c * 2] | (p[c * 2 + 1] << 8));
+        }
+        p += num_channels_ * 2;
+
+        prev_timestamp_us_ = unzigzag64(ts);
+        prev_mask_ = (uint32_t) mask;
+        have_keyframe_ = true;
+    } else if (kind == FRAME_DELTA && have_keyframe_) {
+        const unsigned int bitmap_bytes = (num_channels_ + 7) / 8;
+        if ((size_t) (end - p) < bitmap_bytes + num_channels_) {
+            return 0;
+        }
+        const uint8_t* bitmap = p;
+        const uint8_t* low = p + bitmap_bytes;
+        const uint8_t* high = low + num_channels_;
+
+        uint16_t* __restrict zz = zigzag_.data();
+        for (unsigned int c = 0; c < num_channels_; c++) {
+            zz[c] = low[c];
+        }
+        for (unsigned int c = 0; c < num_channels_; c++) {
+            if (bitmap[c >> 3] & (1u << (c & 7))) {
+                if (high >= end) {
+                    return 0;
+                }
+                zz[c] |= (uint16_t) (*high++ << 8);
+            }
+        }
+        for (unsigned int c = 0; c < num_channels_; c++) {
+            const uint16_t d = (uint16_t) ((zz[c] >> 1) ^ (uint16_t) -(int16_t) (zz[c] & 1));
+            q[c] = (uint16_t) (q[c] + d);
+        }
+        p = high;
+
+        prev_timestamp_us_ += unzigzag64(ts);
+        prev_mask_ ^= (uint32_t) mask;
+    } else {
+        return 0;
+    }
+
+    *timestamp_us = prev_timestamp_us_;
+    *valid_mask = prev_mask_;
+    dequantize(q, num_joints_, prev_mask_, joints, scores);
+    return p - data;
+}
+
+const PoseKeyframe* poseCodecSeek(const std::vector<PoseKeyframe>& keyframes, int64_t timestamp_us) {
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), timestamp_us,
+            [](int64_t ts, const PoseKeyframe& k) { return ts < k.timestamp_us; });
+    return it == keyframes.begin() ? nullptr : &*(it - 1);
+}
@@ -0,0 +1,85 @@
+#ifndef POSE_CODEC_H
+#define POSE_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compact encoding of one person's pose stream.
+//
+// Joints (normalized to the frame) are quantized to 16-bit fixed point, scores to 8 bits.
+// Every keyframe_interval frames a keyframe stores the quantized channels verbatim;
+// frames in between store the wrapping 16-bit difference to the previous frame, zigzagged
+// and packed one or two bytes per channel with a bitmap of the two-byte channels up front.
+// Decoding can start at any keyframe, so seeks only replay up to keyframe_interval frames.
+//
+// The per-channel loops work on fixed-width integer arrays without branches so the
+// compiler vectorizes them; only the final byte packing is scalar.
+//
+// Frame layout:
+//   uint8   kind (keyframe / delta)
+//   varint  timestamp: absolute on keyframes, delta to the previous frame otherwise
+//   varint  valid mask: absolute on keyframes, xor with the previous mask otherwise
+//   keyframe: uint16 LE per channel
+//   delta:    ceil(C / 8) bytes of wide-channel bits, low bytes of all channels, then the
+//             high bytes of the wide channels
+// with C = num_joints * 3 channels (x, y per joint, then one per score).
+
+struct PoseKeyframe {
+    int64_t timestamp_us;
+    size_t frame;
+    size_t offset;      // byte offset of the keyframe in the encoded stream
+};
+
+class PoseEncoder {
+public:
+    PoseEncoder(unsigned int num_joints, unsigned int keyframe_interval = 30);
+
+    // Appends one frame to out. Joints of invalid joints (mask bit clear) are not kept.
+    void encode(int64_t timestamp_us, const float* joints, const float* scores, uint32_t valid_mask,
+                std::vector<uint8_t>& out);
+    // Forces the next frame to be a keyframe.
+    void reset();
+
+    const std::vector<PoseKeyframe>& keyframes() const { return keyframes_; }
+    size_t numFrames() const { return frame_; }
+
+private:
+    unsigned int num_joints_;
+    unsigned int num_channels_;
+    unsigned int keyframe_interval_;
+    size_t frame_;
+    unsigned int since_keyframe_;
+    int64_t prev_timestamp_us_;
+    uint32_t prev_mask_;
+    std::vector<uint16_t> prev_;
+    std::vector<uint16_t> cur_;
+    std::vector<uint16_t> zigzag_;
+    std::vector<PoseKeyframe> keyframes_;
+};
+
+class PoseDecoder {
+public:
+    explicit PoseDecoder(unsigned int num_joints);
+
+    // Decodes the frame at data, returning the number of bytes consumed or 0 if the data is
+    // truncated or a delta frame comes before any keyframe. Invalid joints come out as -1.
+    size_t decode(const uint8_t* data, size_t size, int64_t* timestamp_us, float* joints, float* scores,
+                  uint32_t* valid_mask);
+    void reset();
+
+private:
+    unsigned int num_joints_;
+    unsigned int num_channels_;
+    bool have_keyframe_;
+    int64_t prev_timestamp_us_;
+    uint32_t prev_mask_;
+    std::vector<uint16_t> prev_;
+    std::vector<uint16_t> zigzag_;
+};
+
+// Seeks through an encoded stream: returns the keyframe to start decoding from to reach
+// the frame at or before timestamp_us, or nullptr if the stream starts later.
+const PoseKeyframe* poseCodecSeek(const std::vector<PoseKeyframe>& keyframes, int64_t timestamp_us);
+
+#endif // POSE_CODEC_H
@@ -0,0 +1,186 @@
+#include "pose-history.h"
+
+#include <algorithm>
+#include <cstring>
+
+PoseFrameView PoseWindow::at(size_t i) const {
+    const Segment& seg = i < segments_[0].count ? segments_[0] : segments_[1];
+    if (i >= segments_[0].count) {
+        i -= segments_[0].count;
+    }
+
+    PoseFrameView view;
+    view.timestamp_us = seg.timestamps_us[i];
+    view.joints = seg.joints + i * num_joints_ * 2;
+    view.scores = seg.scores + i * num_joints_;
+    view.bbox = seg.bbox + i * 4;
+    view.valid_mask = seg.valid_masks[i];
+    return view;
+}
+
+PoseHistory::PoseHistory(unsigned int num_joints, size_t max_tracks, size_t memory_budget)
+        : num_joints_(num_joints),
+          max_tracks_(std::max<size_t>(max_tracks, 1)) {
+    capacity_ = std::max<size_t>(memory_budget / (max_tracks_ * bytesPerFrame()), 2);
+
+    Track empty = { -1, false, 0, 0, 0 };
+    tracks_.assign(max_tracks_, empty);
+    timestamps_.resize(max_tracks_ * capacity_);
+    joints_.resize(max_tracks_ * capacity_ * num_joints_ * 2);
+    scores_.resize(max_tracks_ * capacity_ * num_joints_);
+    bboxes_.resize(max_tracks_ * capacity_ * 4);
+    valid_masks_.resize(max_tracks_ * capacity_);
+}
+
+size_t PoseHistory::bytesPerFrame() const {
+    return sizeof(int64_t) + sizeof(uint32_t) + sizeof(float) * (num_joints_ * 3 + 4);
+}
+
+int PoseHistory::findTrack(int id) const {
+    for (size_t i = 0; i < max_tracks_; i++) {
+        if (tracks_[i].live && tracks_[i].id == id) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+int PoseHistory::acquireTrack(int id) {
+    size_t victim = 0;
+    for (size_t i = 0; i < max_tracks_; i++) {
+        if (!tracks_[i].live) {
+            victim = i;
+            break;
+        }
+        if (tracks_[i].last_update_us < tracks_[victim].last_update_us) {
+            victim = i;
+        }
+    }
+
+    Track& track = tracks_[victim];
+    track.id = id;
+    track.live = true;
+    track.head = 0;
+    track.count = 0;
+    return (int) victim;
+}
+
+void PoseHistory::append(int id, int64_t timestamp_us, const float* joints, const float* scores,
+                         const float* bbox, uint32_t valid_mask) {
+    int slot = findTrack(id);
+    if (slot < 0) {
+        slot = acquireTrack(id);
+    }
+
+    Track& track = tracks_[slot];
+    if (track.count > 0 && timestamp_us < track.last_update_us) {
+        track.head = 0;
+        track.count = 0;
+    }
+
+    const size_t frame = slot * capacity_ + track.head;
+    timestamps_[frame] = timestamp_us;
+    memcpy(&joints_[frame * num_joints_ * 2], joints, sizeof(float) * num_joints_ * 2);
+    memcpy(&scores_[frame * num_joints_], scores, sizeof(float) * num_joints_);
+    if (bbox) {
+        memcpy(&bboxes_[frame * 4], bbox, sizeof(float) * 4);
+    } else {
+        std::fill_n(&bboxes_[frame * 4], 4, 0.0f);
+    }
+    valid_masks_[frame] = valid_mask;
+
+    track.head = track.head + 1 == capacity_ ? 0 : track.head + 1;
+    track.count = std::min(track.count + 1, capacity_);
+    track.last_update_us = timestamp_us;
+}
+
+void PoseHistory::clear() {
+    for (auto& track : tracks_) {
+        track.live = false;
+    }
+}
+
+PoseWindow PoseHistory::makeWindow(size_t slot, size_t first, size_t count) const {
+    // first is the ring index of the oldest frame of the window
+    PoseWindow window;
+    window.num_joints_ = num_joints_;
+
+    size_t remaining = count;
+    size_t pos = first;
+    while (remaining > 0) {
+        const size_t n = std::min(remaining, capacity_ - pos);
+        const size_t frame = slot * capacity_ + pos;
+
+        PoseWindow::Segment& seg = window.segments_[window.num_segments_++];
+        seg.timestamps_us = &timestamps_[frame];
+        seg.joints = &joints_[frame * num_joints_ * 2];
+        seg.scores = &scores_[frame * num_joints_];
+        seg.bbox = &bboxes_[frame * 4];
+        seg.valid_masks = &valid_masks_[frame];
+        seg.count = n;
+
+        remaining -= n;
+        pos = 0;
+    }
+    return window;
+}
+
+bool PoseHistory::latest(int id, PoseFrameView* out) const {
+    PoseWindow window = windowByCount(id, 1);
+    if (window.empty()) {
+        return false;
+    }
+    *out = window.at(0);
+    return true;
+}
+
+PoseWindow PoseHistory::windowByCount(int id, size_t count) const {
+    const int slot = findTrack(id);
+    if (slot < 0) {
+        return PoseWindow();
+    }
+
+    const Track& track = tracks_[slot];
+    count = std::min(count, track.count);
+    const size_t first = (track.head + capacity_ - count) % capacity_;
+    return makeWindow(slot, first, count);
+}
+
+PoseWindow PoseHistory::windowByTime(int id, int64_t from_us, int64_t to_us) const {
+    const int slot = findTrack(id);
+    if (slot < 0 || from_us > to_us) {
+        return PoseWindow();
+    }
+
+    const Track& track = tracks_[slot];
+    const size_t oldest = (track.head + capacity_ - track.count) % capacity_;
+    const int64_t* ts = &timestamps_[slot * capacity_];
+    auto ring_ts = [&](size_t i) { return ts[(oldest + i) % capacity_]; };
+
+    // binary searches over the logical (oldest-first) order of the ring
+    size_t lo = 0, hi = track.count;
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        if (ring_ts(mid) < from_us) lo = mid + 1; else hi = mid;
+    }
+    const size_t begin = lo;
+
+    hi = track.count;
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        if (ring_ts(mid) <= to_us) lo = mid + 1; else hi = mid;
+    }
+    const size_t end = lo;
+
+    return makeWindow(slot, (oldest + begin) % capacity_, end - begin);
+}
+
+size_t PoseHistory::trackIds(int* ids, size_t max_ids) const {
+    size_t n = 0;
+    for (const auto& track : tracks_) {
+        if (track.live && n < max_ids) {
+            ids[n++] = track.id;
+        }
+    }
+    return n;
+}
@@ -0,0 +1,115 @@
+#ifndef POSE_HISTORY_H
+#define POSE_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-person pose history keyed by tracker id.
+//
+// Every track slot owns a fixed ring of frames stored struct-of-arrays (timestamps,
+// joints, scores, bounding boxes and validity masks each in their own contiguous array),
+// so appending is O(1) and never allocates. All slots are carved out of one allocation
+// sized from a memory budget at construction; when every slot is taken the least recently
+// updated track is evicted.
+//
+// Windows returned by the queries point straight into the ring and are invalidated by
+// the next append to the same track. The class does no locking of its own.
+
+struct PoseFrameView {
+    int64_t timestamp_us;
+    const float* joints;    // num_joints * 2, normalized x,y
+    const float* scores;    // num_joints
+    const float* bbox;      // minX, minY, width, height
+    uint32_t valid_mask;
+};
+
+// A run of consecutive frames of one track. Because the ring wraps, the frames are
+// split into at most two contiguous segments; index through at() or walk the segments.
+class PoseWindow {
+public:
+    struct Segment {
+        const int64_t* timestamps_us;
+        const float* joints;
+        const float* scores;
+        const float* bbox;
+        const uint32_t* valid_masks;
+        size_t count;
+    };
+
+    PoseWindow() : num_joints_(0), segments_{}, num_segments_(0) {}
+
+    size_t size() const { return segments_[0].count + segments_[1].count; }
+    bool empty() const { return size() == 0; }
+    unsigned int numJoints() const { return num_joints_; }
+
+    size_t numSegments() const { return num_segments_; }
+    const Segment& segment(size_t i) const { return segments_[i]; }
+
+    // Frame i, oldest first.
+    PoseFrameView at(size_t i) const;
+
+private:
+    friend class PoseHistory;
+
+    unsigned int num_joints_;
+    Segment segments_[2];
+    size_t num_segments_;
+};
+
+class PoseHistory {
+public:
+    static const size_t kDefaultMemoryBudget = 4 * 1024 * 1024;
+
+    // Capacity per track is derived from memory_budget / max_tracks.
+    PoseHistory(unsigned int num_joints, size_t max_tracks, size_t memory_budget = kDefaultMemoryBudget);
+
+    // Appends a frame to the track with the given id, creating it (and evicting the
+    // least recently updated track if needed) on first sight. Timestamps of one track
+    // must be non-decreasing; an older frame restarts the track.
+    void append(int id, int64_t timestamp_us, const float* joints, const float* scores,
+                const float* bbox, uint32_t valid_mask);
+
+    void clear();
+
+    bool latest(int id, PoseFrameView* out) const;
+    // Frames with from_us <= timestamp <= to_us.
+    PoseWindow windowByTime(int id, int64_t from_us, int64_t to_us) const;
+    // Last count frames (or fewer if the track is shorter).
+    PoseWindow windowByCount(int id, size_t count) const;
+
+    // Ids of the live tracks, in slot order.
+    size_t trackIds(int* ids, size_t max_ids) const;
+
+    unsigned int numJoints() const { return num_joints_; }
+    size_t capacity() const { return capacity_; }
+    size_t maxTracks() const { return max_tracks_; }
+    size_t bytesPerFrame() const;
+
+private:
+    struct Track {
+        int id;
+        bool live;
+        size_t head;    // next write position
+        size_t count;
+        int64_t last_update_us;
+    };
+
+    int findTrack(int id) const;
+    int acquireTrack(int id);
+    PoseWindow makeWindow(size_t slot, size_t first, size_t count) const;
+
+    unsigned int num_joints_;
+    size_t max_tracks_;
+    size_t capacity_;
+
+    std::vector<Track> tracks_;
+    // slot-major: slot * capacity_ + frame
+    std::vector<int64_t> timestamps_;
+    std::vector<float> joints_;
+    std::vector<float> scores_;
+    std::vector<float> bboxes_;
+    std::vector<uint32_t> valid_masks_;
+};
+
+#endif // POSE_HISTORY_H
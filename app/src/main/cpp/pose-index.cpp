@@ -0,0 +1,487 @@
+#include "pose-index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <random>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "simd4.h"
+
+static size_t alignTo16(size_t n) {
+    return (n + 15) & ~(size_t) 15;
+}
+
+static float distanceSq(const float* a, const float* b, size_t dim) {
+    f32x4 acc0 = set4(0.0f);
+    f32x4 acc1 = set4(0.0f);
+    size_t d = 0;
+    for (; d + 8 <= dim; d += 8) {
+        const f32x4 d0 = sub4(load4(a + d), load4(b + d));
+        const f32x4 d1 = sub4(load4(a + d + 4), load4(b + d + 4));
+        acc0 = madd4(acc0, d0, d0);
+        acc1 = madd4(acc1, d1, d1);
+    }
+    if (d < dim) {
+        const f32x4 d0 = sub4(load4(a + d), load4(b + d));
+        acc0 = madd4(acc0, d0, d0);
+    }
+    return hsum4(add4(acc0, acc1));
+}
+
+static const size_t MAX_DIM = (32 * 2 + 3) & ~(size_t) 3;
+
+// Partial queries are completed from the mean pose, then once more from the best match of
+// the first round; further rounds barely move recall.
+static const int PARTIAL_ROUNDS = 2;
+
+// A query normalized over the joints of mask, to compare with points renormalized over the
+// same m joints. With P a point's joints in the mask, mu their mean and sigma their RMS
+// radius, the distance is
+//   |Q - (P - mu) / sigma|^2 = |Q|^2 - 2 (Q.P - mu.sum(Q)) / sigma + m
+// so a point takes one pass for sum(P), |P|^2 and Q.P over the mask.
+struct MaskedQuery {
+    float query[MAX_DIM];       // zero outside the mask
+    float weight[MAX_DIM];      // 1 on the mask's coordinates
+    uint32_t mask;
+    float m;
+    float qq;                   // |Q|^2
+    float qx, qy;               // sum(Q)
+};
+
+static bool maskQuery(const float* query, uint32_t mask, unsigned int num_joints, size_t dim, MaskedQuery* q) {
+    std::fill(q->query, q->query + dim, 0.0f);
+    std::fill(q->weight, q->weight + dim, 0.0f);
+    q->mask = mask;
+    q->m = q->qq = q->qx = q->qy = 0.0f;
+    for (unsigned int j = 0; j < num_joints; j++) {
+        if (!(mask & (1u << j))) continue;
+        const float x = query[j * 2], y = query[j * 2 + 1];
+        q->query[j * 2] = x;
+        q->query[j * 2 + 1] = y;
+        q->weight[j * 2] = q->weight[j * 2 + 1] = 1.0f;
+        q->m += 1.0f;
+        q->qq += x * x + y * y;
+        q->qx += x;
+        q->qy += y;
+    }
+    return q->m >= 2.0f;
+}
+
+static float maskedDistanceSq(const MaskedQuery& q, const float* p, size_t dim) {
+    f32x4 sum = set4(0.0f), sum_sq = set4(0.0f), dot = set4(0.0f);
+    for (size_t d = 0; d < dim; d += 4) {
+        const f32x4 v = load4(p + d);
+        const f32x4 wv = mul4(load4(q.weight + d), v);
+        sum = add4(sum, wv);
+        sum_sq = madd4(sum_sq, wv, v);
+        dot = madd4(dot, load4(q.query + d), v);
+    }
+    float s[4];
+    store4(s, sum);     // x in the even lanes, y in the odd ones
+    const float mx = (s[0] + s[2]) / q.m, my = (s[1] + s[3]) / q.m;
+    const float var = hsum4(sum_sq) / q.m - mx * mx - my * my;
+    if (var < 1e-12f) return std::numeric_limits<float>::infinity();
+    const float cross = (hsum4(dot) - mx * q.qx - my * q.qy) / std::sqrt(var);
+    return std::max(q.qq - 2.0f * cross + q.m, 0.0f);
+}
+
+// Completes the query with the joints it lacks from ref, scaled and moved to fit the
+// query's joints best, and normalizes the full pose into out.
+static bool completeQuery(const MaskedQuery& q, const float* ref, unsigned int num_joints, float* out) {
+    float rx = 0.0f, ry = 0.0f;
+    for (unsigned int j = 0; j < num_joints; j++) {
+        if (!(q.mask & (1u << j))) continue;
+        rx += ref[j * 2];
+        ry += ref[j * 2 + 1];
+    }
+    rx /= q.m;
+    ry /= q.m;
+    // least squares scale of ref about its mean onto the query, whose mean is 0
+    float num = 0.0f, den = 0.0f;
+    for (unsigned int j = 0; j < num_joints; j++) {
+        if (!(q.mask & (1u << j))) continue;
+        const float dx = ref[j * 2] - rx, dy = ref[j * 2 + 1] - ry;
+        num += q.query[j * 2] * dx + q.query[j * 2 + 1] * dy;
+        den += dx * dx + dy * dy;
+    }
+    if (den < 1e-12f) return false;
+    const float scale = num / den;
+
+    float full[MAX_DIM];
+    for (unsigned int j = 0; j < num_joints; j++) {
+        const bool have = (q.mask & (1u << j)) != 0;
+        full[j * 2] = have ? q.query[j * 2] : (ref[j * 2] - rx) * scale;
+        full[j * 2 + 1] = have ? q.query[j * 2 + 1] : (ref[j * 2 + 1] - ry) * scale;
+    }
+    const uint32_t all = num_joints >= 32 ? 0xffffffff : (1u << num_joints) - 1;
+    return normalizePose(full, all, num_joints, 1.0f, out);
+}
+
+bool normalizePose(const float* joints, uint32_t valid_mask, unsigned int num_joints, float aspect, float* out) {
+    float cx = 0.0f, cy = 0.0f;
+    unsigned int n = 0;
+    for (unsigned int j = 0; j < num_joints; j++) {
+        if (!(valid_mask & (1u << j))) continue;
+        cx += joints[j * 2] * aspect;
+        cy += joints[j * 2 + 1];
+        n++;
+    }
+    if (n < 2) return false;
+    cx /= n;
+    cy /= n;
+
+    float sum = 0.0f;
+    for (unsigned int j = 0; j < num_joints; j++) {
+        if (!(valid_mask & (1u << j))) continue;
+        const float dx = joints[j * 2] * aspect - cx;
+        const float dy = joints[j * 2 + 1] - cy;
+        sum += dx * dx + dy * dy;
+    }
+    const float rms = std::sqrt(sum / n);
+    if (rms < 1e-6f) return false;
+
+    const float scale = 1.0f / rms;
+    std::fill(out, out + poseIndexDim(num_joints), 0.0f);
+    for (unsigned int j = 0; j < num_joints; j++) {
+        if (!(valid_mask & (1u << j))) continue;
+        out[j * 2] = (joints[j * 2] * aspect - cx) * scale;
+        out[j * 2 + 1] = (joints[j * 2 + 1] - cy) * scale;
+    }
+    return true;
+}
+
+namespace {
+
+class TreeBuilder {
+public:
+    TreeBuilder(const float* poses, size_t num_poses, size_t dim, size_t leaf_size)
+            : poses_(poses), dim_(dim), leaf_size_(leaf_size), order_(num_poses), rng_(1) {
+        for (size_t i = 0; i < num_poses; i++) order_[i] = (uint32_t) i;
+        if (num_poses > 0) build(0, num_poses);
+    }
+
+    const std::vector<uint32_t>& order() const { return order_; }
+    const std::vector<PoseIndexNode>& nodes() const { return nodes_; }
+
+private:
+    const float* point(uint32_t i) const { return poses_ + (size_t) i * dim_; }
+
+    int32_t build(size_t first, size_t count) {
+        const int32_t index = (int32_t) nodes_.size();
+        PoseIndexNode node = { (uint32_t) first, (uint32_t) count, 0.0f, -1, -1, 0 };
+        nodes_.push_back(node);
+        if (count <= leaf_size_) return index;
+
+        // vantage point: the farthest from a random one, which tends to sit on the hull
+        const float* r = point(order_[first + rng_() % count]);
+        size_t far = first;
+        float far_d = -1.0f;
+        for (size_t i = first; i < first + count; i++) {
+            const float d = distanceSq(r, point(order_[i]), dim_);
+            if (d > far_d) {
+                far_d = d;
+                far = i;
+            }
+        }
+        std::swap(order_[first], order_[far]);
+
+        const float* v = point(order_[first]);
+        scratch_.resize(count - 1);
+        for (size_t i = 0; i < count - 1; i++) {
+            const uint32_t p = order_[first + 1 + i];
+            scratch_[i] = std::make_pair(std::sqrt(distanceSq(v, point(p), dim_)), p);
+        }
+        const size_t inside = (count - 1) / 2;
+        std::nth_element(scratch_.begin(), scratch_.begin() + inside, scratch_.end());
+        for (size_t i = 0; i < count - 1; i++) {
+            order_[first + 1 + i] = scratch_[i].second;
+        }
+        const float radius = scratch_[inside].first;
+
+        const int32_t in = build(first + 1, inside);
+        const int32_t out = build(first + 1 + inside, count - 1 - inside);
+        nodes_[index].radius = radius;
+        nodes_[index].inside = in;
+        nodes_[index].outside = out;
+        return index;
+    }
+
+    const float* poses_;
+    size_t dim_;
+    size_t leaf_size_;
+    std::vector<uint32_t> order_;
+    std::vector<PoseIndexNode> nodes_;
+    std::vector<std::pair<float, uint32_t>> scratch_;
+    std::minstd_rand rng_;
+};
+
+} // namespace
+
+static bool writePadded(FILE* file, const void* data, size_t size, size_t* offset) {
+    static const char zeros[16] = {};
+    const size_t pad = alignTo16(*offset) - *offset;
+    if (pad && fwrite(zeros, pad, 1, file) != 1) return false;
+    if (size && fwrite(data, size, 1, file) != 1) return false;
+    *offset += pad + size;
+    return true;
+}
+
+bool buildPoseIndex(const char* path, const float* poses, const uint32_t* labels, size_t num_poses,
+                    unsigned int num_joints, const std::vector<std::string>& label_names, size_t leaf_size) {
+    const size_t dim = poseIndexDim(num_joints);
+    TreeBuilder tree(poses, num_poses, dim, std::max(leaf_size, (size_t) 2));
+    const std::vector<uint32_t>& order = tree.order();
+
+    std::vector<char> names(label_names.size() * POSE_INDEX_LABEL_SIZE, 0);
+    for (size_t i = 0; i < label_names.size(); i++) {
+        strncpy(&names[i * POSE_INDEX_LABEL_SIZE], label_names[i].c_str(), POSE_INDEX_LABEL_SIZE - 1);
+    }
+    std::vector<uint32_t> sorted_labels(num_poses);
+    std::vector<float> points(num_poses * dim);
+    std::vector<double> sum(dim, 0.0);
+    for (size_t i = 0; i < num_poses; i++) {
+        sorted_labels[i] = labels[order[i]];
+        std::copy_n(poses + (size_t) order[i] * dim, dim, &points[i * dim]);
+        for (size_t d = 0; d < dim; d++) sum[d] += points[i * dim + d];
+    }
+    std::vector<float> mean(dim, 0.0f);
+    for (size_t d = 0; d < dim && num_poses > 0; d++) mean[d] = (float) (sum[d] / num_poses);
+
+    PoseIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, POSE_INDEX_MAGIC, sizeof(header.magic));
+    header.version = POSE_INDEX_VERSION;
+    header.num_joints = num_joints;
+    header.dim = dim;
+    header.num_poses = num_poses;
+    header.num_nodes = tree.nodes().size();
+    header.num_labels = label_names.size();
+    header.leaf_size = leaf_size;
+    header.names_offset = alignTo16(sizeof(header));
+    header.labels_offset = alignTo16(header.names_offset + names.size());
+    header.ids_offset = alignTo16(header.labels_offset + num_poses * sizeof(uint32_t));
+    header.nodes_offset = alignTo16(header.ids_offset + num_poses * sizeof(uint32_t));
+    header.points_offset = alignTo16(header.nodes_offset + header.num_nodes * sizeof(PoseIndexNode));
+    header.mean_offset = alignTo16(header.points_offset + points.size() * sizeof(float));
+
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    size_t offset = 0;
+    const bool ok = writePadded(file, &header, sizeof(header), &offset) &&
+                    writePadded(file, names.data(), names.size(), &offset) &&
+                    writePadded(file, sorted_labels.data(), num_poses * sizeof(uint32_t), &offset) &&
+                    writePadded(file, order.data(), num_poses * sizeof(uint32_t), &offset) &&
+                    writePadded(file, tree.nodes().data(), header.num_nodes * sizeof(PoseIndexNode), &offset) &&
+                    writePadded(file, points.data(), points.size() * sizeof(float), &offset) &&
+                    writePadded(file, mean.data(), dim * sizeof(float), &offset);
+    return fclose(file) == 0 && ok;
+}
+
+PoseIndex::PoseIndex()
+        : data_(nullptr), size_(0), header_(nullptr), labels_(nullptr), ids_(nullptr), nodes_(nullptr), points_(nullptr),
+          mean_(nullptr) {}
+
+PoseIndex::~PoseIndex() {
+    close();
+}
+
+bool PoseIndex::open(const char* path) {
+    close();
+
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(PoseIndexHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    data_ = static_cast<const char*>(map);
+    size_ = st.st_size;
+    header_ = reinterpret_cast<const PoseIndexHeader*>(data_);
+
+    const PoseIndexHeader& h = *header_;
+    if (memcmp(h.magic, POSE_INDEX_MAGIC, sizeof(h.magic)) != 0 || h.version != POSE_INDEX_VERSION ||
+        h.dim != poseIndexDim(h.num_joints) || h.num_joints > 32 ||
+        h.names_offset + h.num_labels * POSE_INDEX_LABEL_SIZE > size_ ||
+        h.labels_offset + h.num_poses * sizeof(uint32_t) > size_ ||
+        h.ids_offset + h.num_poses * sizeof(uint32_t) > size_ ||
+        h.nodes_offset + h.num_nodes * sizeof(PoseIndexNode) > size_ ||
+        h.points_offset + h.num_poses * h.dim * sizeof(float) > size_ ||
+        h.mean_offset + h.dim * sizeof(float) > size_ ||
+        (h.num_poses > 0 && h.num_nodes == 0)) {
+        close();
+        return false;
+    }
+
+    labels_ = reinterpret_cast<const uint32_t*>(data_ + h.labels_offset);
+    ids_ = reinterpret_cast<const uint32_t*>(data_ + h.ids_offset);
+    nodes_ = reinterpret_cast<const PoseIndexNode*>(data_ + h.nodes_offset);
+    points_ = reinterpret_cast<const float*>(data_ + h.points_offset);
+    mean_ = reinterpret_cast<const float*>(data_ + h.mean_offset);
+    return true;
+}
+
+void PoseIndex::close() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    labels_ = nullptr;
+    ids_ = nullptr;
+    nodes_ = nullptr;
+    points_ = nullptr;
+    mean_ = nullptr;
+}
+
+std::string PoseIndex::labelName(size_t label) const {
+    if (label >= header_->num_labels) return std::string();
+    const char* name = data_ + header_->names_offset + label * POSE_INDEX_LABEL_SIZE;
+    return std::string(name, strnlen(name, POSE_INDEX_LABEL_SIZE));
+}
+
+// The k best so far, sorted by squared distance, with positions in tree order as ids.
+struct PoseIndex::Search {
+    const float* query;
+    size_t k;
+    PoseMatch* out;
+    size_t found;
+    size_t leaves_left;
+    bool limited;
+
+    bool contains(uint32_t point) const {
+        for (size_t i = 0; i < found; i++) {
+            if (out[i].id == point) return true;
+        }
+        return false;
+    }
+
+    float worst() const {
+        return found < k ? std::numeric_limits<float>::infinity() : out[found - 1].distance;
+    }
+
+    void consider(uint32_t point, float distance_sq) {
+        if (distance_sq >= worst()) return;
+        size_t i = found < k ? found++ : k - 1;
+        for (; i > 0 && out[i - 1].distance > distance_sq; i--) {
+            out[i] = out[i - 1];
+        }
+        out[i].id = point;
+        out[i].distance = distance_sq;
+    }
+};
+
+void PoseIndex::searchNode(Search& s, int32_t index) const {
+    if (s.limited && s.leaves_left == 0) return;
+
+    const PoseIndexNode& node = nodes_[index];
+    const size_t dim = header_->dim;
+    if (node.inside < 0) {
+        for (uint32_t p = node.first; p < node.first + node.count; p++) {
+            s.consider(p, distanceSq(s.query, points_ + (size_t) p * dim, dim));
+        }
+        s.leaves_left--;
+        return;
+    }
+
+    const float d_sq = distanceSq(s.query, points_ + (size_t) node.first * dim, dim);
+    s.consider(node.first, d_sq);
+    const float d = std::sqrt(d_sq);
+
+    // visit the side the query falls in first; the other can only hold closer points if the
+    // k-th distance reaches across the boundary
+    if (d < node.radius) {
+        searchNode(s, node.inside);
+        if (d + std::sqrt(s.worst()) >= node.radius) searchNode(s, node.outside);
+    } else {
+        searchNode(s, node.outside);
+        if (d - std::sqrt(s.worst()) <= node.radius) searchNode(s, node.inside);
+    }
+}
+
+static void finishMatches(PoseMatch* out, size_t n, const uint32_t* ids, const uint32_t* labels) {
+    for (size_t i = 0; i < n; i++) {
+        const uint32_t p = out[i].id;
+        out[i].id = ids[p];
+        out[i].label = labels[p];
+        out[i].distance = std::sqrt(out[i].distance);
+    }
+}
+
+size_t PoseIndex::search(const float* query, size_t k, PoseMatch* out, size_t max_leaves, uint32_t valid_mask) const {
+    const uint32_t all = header_->num_joints >= 32 ? 0xffffffff : (1u << header_->num_joints) - 1;
+    if (k == 0 || header_->num_poses == 0) return 0;
+    if ((valid_mask & all) != all) {
+        return searchPartial(query, k, out, max_leaves, valid_mask & all);
+    }
+
+    Search s = { query, k, out, 0, max_leaves, max_leaves > 0 };
+    searchNode(s, 0);
+    finishMatches(out, s.found, ids_, labels_);
+    return s.found;
+}
+
+size_t PoseIndex::searchPartial(const float* query, size_t k, PoseMatch* out, size_t max_leaves,
+                                uint32_t valid_mask) const {
+    const unsigned int num_joints = header_->num_joints;
+    const size_t dim = header_->dim;
+    MaskedQuery q;
+    if (!maskQuery(query, valid_mask, num_joints, dim, &q)) return 0;
+
+    const size_t num_candidates = PARTIAL_CANDIDATES;
+    Search best = { query, std::min(k, num_candidates), out, 0, 0, false };
+    PoseMatch candidates[PARTIAL_CANDIDATES];
+    float full[MAX_DIM];
+    const float* ref = mean_;
+    for (int round = 0; round < PARTIAL_ROUNDS; round++) {
+        if (!completeQuery(q, ref, num_joints, full)) break;
+        Search s = { full, num_candidates, candidates, 0, max_leaves, max_leaves > 0 };
+        searchNode(s, 0);
+        for (size_t i = 0; i < s.found; i++) {
+            const uint32_t p = candidates[i].id;
+            if (!best.contains(p)) best.consider(p, maskedDistanceSq(q, points_ + (size_t) p * dim, dim));
+        }
+        if (best.found == 0) break;
+        ref = points_ + (size_t) out[0].id * dim;
+    }
+    finishMatches(out, best.found, ids_, labels_);
+    return best.found;
+}
+
+size_t PoseIndex::searchFlat(const float* query, size_t k, PoseMatch* out, uint32_t valid_mask) const {
+    if (k == 0) return 0;
+    const size_t dim = header_->dim;
+    Search s = { query, k, out, 0, 0, false };
+
+    const uint32_t all = header_->num_joints >= 32 ? 0xffffffff : (1u << header_->num_joints) - 1;
+    if ((valid_mask & all) == all) {
+        for (size_t p = 0; p < header_->num_poses; p++) {
+            s.consider((uint32_t) p, distanceSq(query, points_ + p * dim, dim));
+        }
+    } else {
+        MaskedQuery q;
+        if (!maskQuery(query, valid_mask & all, header_->num_joints, dim, &q)) return 0;
+        for (size_t p = 0; p < header_->num_poses; p++) {
+            s.consider((uint32_t) p, maskedDistanceSq(q, points_ + p * dim, dim));
+        }
+    }
+    finishMatches(out, s.found, ids_, labels_);
+    return s.found;
+}
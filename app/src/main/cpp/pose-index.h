@@ -0,0 +1,130 @@
+#ifndef POSE_INDEX_H
+#define POSE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Nearest neighbour index over a library of labelled reference poses.
+//
+// Poses are compared after normalizePose(): centered on the mean of their joints and scaled
+// to unit RMS radius, so neither position nor size in the frame matters. The library is a
+// vantage point tree built offline by buildPoseIndex() into one file that PoseIndex maps
+// read-only, so opening it costs nothing and pages are shared with the page cache.
+//
+//   PoseIndexHeader
+//   label names       char[POSE_INDEX_LABEL_SIZE] per label
+//   labels            uint32 per pose, in tree order
+//   ids               uint32 per pose: position in the library passed to the builder
+//   nodes             PoseIndexNode per node, root first
+//   points            float[dim] per pose, in tree order
+//   mean              float[dim], the mean of the points
+//
+// Each section starts 16-byte aligned. A node covers a contiguous range of points. An inner
+// node's first point is its vantage point; the rest are split at the median distance from
+// it, the closer half under inside and the farther under outside. Leaves hold up to
+// leaf_size points and are scanned with a SIMD distance kernel.
+//
+// A query missing joints is normalized over the joints it has, and compared with every
+// point renormalized over the same joints; zeroing the missing coordinates alone would
+// compare poses centered and scaled over different joints. That distance does not fit the
+// tree, so the tree is searched with the query completed to a full pose instead: the missing
+// joints taken from the mean pose fitted to the present ones, then again from the best match
+// of that search. Candidates of both searches are ranked by the partial distance.
+
+static const char POSE_INDEX_MAGIC[4] = { 'W', 'P', 'I', 'X' };
+static const uint32_t POSE_INDEX_VERSION = 2;
+static const size_t POSE_INDEX_LABEL_SIZE = 32;
+
+struct PoseIndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t num_joints;
+    uint32_t dim;               // floats per point, num_joints * 2 rounded up to 4
+    uint64_t num_poses;
+    uint32_t num_nodes;
+    uint32_t num_labels;
+    uint32_t leaf_size;
+    uint32_t reserved;
+    uint64_t names_offset;
+    uint64_t labels_offset;
+    uint64_t ids_offset;
+    uint64_t nodes_offset;
+    uint64_t points_offset;
+    uint64_t mean_offset;
+};
+
+struct PoseIndexNode {
+    uint32_t first;
+    uint32_t count;
+    float radius;               // median distance from the vantage point
+    int32_t inside;             // child nodes, -1 in leaves
+    int32_t outside;
+    uint32_t reserved;
+};
+
+struct PoseMatch {
+    uint32_t id;                // position in the library
+    uint32_t label;
+    float distance;             // Euclidean, between poses normalized over the query's joints
+};
+
+// Writes the normalized pose (dim floats, padding zeroed) for joints scaled by aspect (image
+// width / height) in x. Joints outside valid_mask are zeroed and don't count. Returns false
+// with fewer than two valid joints or all of them at one point.
+bool normalizePose(const float* joints, uint32_t valid_mask, unsigned int num_joints, float aspect, float* out);
+
+inline size_t poseIndexDim(unsigned int num_joints) {
+    return (num_joints * 2 + 3) & ~(size_t) 3;
+}
+
+// Builds the index of num_poses normalized poses (poseIndexDim floats each) with labels
+// indexing label_names, and writes it to path.
+bool buildPoseIndex(const char* path, const float* poses, const uint32_t* labels, size_t num_poses,
+                    unsigned int num_joints, const std::vector<std::string>& label_names, size_t leaf_size = 16);
+
+class PoseIndex {
+public:
+    PoseIndex();
+    ~PoseIndex();
+
+    bool open(const char* path);
+    void close();
+    bool isOpen() const { return data_ != nullptr; }
+
+    size_t size() const { return header_->num_poses; }
+    unsigned int numJoints() const { return header_->num_joints; }
+    size_t numLabels() const { return header_->num_labels; }
+    std::string labelName(size_t label) const;
+
+    // Up to k nearest poses to the query, closest first. The query is normalized over the
+    // joints of valid_mask (normalizePose with the same mask). With max_leaves > 0 every tree
+    // search stops after scanning that many leaves, trading recall for time. With joints
+    // missing the search is approximate even without a leaf budget, and returns at most
+    // PARTIAL_CANDIDATES matches.
+    size_t search(const float* query, size_t k, PoseMatch* out, size_t max_leaves = 0,
+                  uint32_t valid_mask = 0xffffffff) const;
+
+    // Exact search by scanning every point.
+    size_t searchFlat(const float* query, size_t k, PoseMatch* out, uint32_t valid_mask = 0xffffffff) const;
+
+    static const size_t PARTIAL_CANDIDATES = 32;
+
+private:
+    struct Search;
+
+    void searchNode(Search& s, int32_t node) const;
+    size_t searchPartial(const float* query, size_t k, PoseMatch* out, size_t max_leaves, uint32_t valid_mask) const;
+
+    const char* data_;
+    size_t size_;
+    const PoseIndexHeader* header_;
+    const uint32_t* labels_;
+    const uint32_t* ids_;
+    const PoseIndexNode* nodes_;
+    const float* points_;
+    const float* mean_;
+};
+
+#endif // POSE_INDEX_H
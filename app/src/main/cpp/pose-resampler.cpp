@@ -0,0 +1,150 @@
+#include "pose-resampler.h"
+
+#include <algorithm>
+
+// Consistent copy of the frames, oldest first.
+struct ResamplerSnapshot {
+    size_t count;
+    int id;
+    unsigned int num_joints;
+    int64_t timestamp_us[PoseResampler::DEPTH];
+    uint32_t valid_mask[PoseResampler::DEPTH];
+    float joints[PoseResampler::DEPTH][PoseResampler::MAX_JOINTS * 2];
+};
+
+static inline float hermite(float p0, float m0, float p1, float m1, float s) {
+    const float s2 = s * s;
+    const float s3 = s2 * s;
+    return (2 * s3 - 3 * s2 + 1) * p0 + (s3 - 2 * s2 + s) * m0 + (-2 * s3 + 3 * s2) * p1 + (s3 - s2) * m1;
+}
+
+PoseResampler::PoseResampler() : seq_(0), id_(-1), num_joints_(0), count_(0), head_(0), retries_(0) {
+}
+
+void PoseResampler::beginWrite() {
+    seq_.store(seq_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void PoseResampler::endWrite() {
+    seq_.store(seq_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void PoseResampler::push(int id, int64_t timestamp_us, const float* joints, uint32_t valid_mask, unsigned int num_joints) {
+    num_joints = std::min(num_joints, MAX_JOINTS);
+    size_t count = count_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (count > 0) {
+        const int64_t newest = frames_[(head + DEPTH - 1) % DEPTH].timestamp_us.load(std::memory_order_relaxed);
+        if (id != id_.load(std::memory_order_relaxed) || timestamp_us <= newest ||
+                num_joints != num_joints_.load(std::memory_order_relaxed)) {
+            count = 0;
+        }
+    }
+
+    beginWrite();
+    Frame& f = frames_[head];
+    f.timestamp_us.store(timestamp_us, std::memory_order_relaxed);
+    f.valid_mask.store(valid_mask, std::memory_order_relaxed);
+    for (unsigned int i = 0; i < num_joints * 2; i++) {
+        f.joints[i].store(joints[i], std::memory_order_relaxed);
+    }
+    id_.store(id, std::memory_order_relaxed);
+    num_joints_.store(num_joints, std::memory_order_relaxed);
+    head_.store((head + 1) % DEPTH, std::memory_order_relaxed);
+    count_.store(std::min(count + 1, DEPTH), std::memory_order_relaxed);
+    endWrite();
+}
+
+void PoseResampler::clear() {
+    if (count_.load(std::memory_order_relaxed) == 0) return;
+    beginWrite();
+    count_.store(0, std::memory_order_relaxed);
+    endWrite();
+}
+
+bool PoseResampler::sample(int64_t time_us, int64_t max_extrapolation_us, float* joints, uint32_t* valid_mask,
+                           int* id, unsigned int* num_joints) const {
+    ResamplerSnapshot s;
+    for (;;) {
+        const uint32_t seq = seq_.load(std::memory_order_acquire);
+        if (!(seq & 1)) {
+            s.count = count_.load(std::memory_order_relaxed);
+            s.id = id_.load(std::memory_order_relaxed);
+            s.num_joints = num_joints_.load(std::memory_order_relaxed);
+            const size_t head = head_.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < s.count && i < DEPTH; i++) {
+                const Frame& f = frames_[(head + DEPTH - s.count + i) % DEPTH];
+                s.timestamp_us[i] = f.timestamp_us.load(std::memory_order_relaxed);
+                s.valid_mask[i] = f.valid_mask.load(std::memory_order_relaxed);
+                for (unsigned int k = 0; k < s.num_joints * 2 && k < MAX_JOINTS * 2; k++) {
+                    s.joints[i][k] = f.joints[k].load(std::memory_order_relaxed);
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == seq) break;
+        }
+        retries_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (s.count == 0) {
+        return false;
+    }
+
+    const size_t n = s.count;
+    const unsigned int nj = s.num_joints;
+    *id = s.id;
+    *num_joints = nj;
+    *valid_mask = 0;
+
+    // at or past the newest frame
+    if (time_us >= s.timestamp_us[n - 1] || n == 1) {
+        const float* p1 = s.joints[n - 1];
+        const uint32_t mask1 = s.valid_mask[n - 1];
+        std::copy(p1, p1 + nj * 2, joints);
+        *valid_mask = mask1;
+        if (n == 1) return true;
+
+        const float* p0 = s.joints[n - 2];
+        const uint32_t moving = mask1 & s.valid_mask[n - 2];
+        const int64_t ahead = std::min(std::max(time_us - s.timestamp_us[n - 1], (int64_t) 0), max_extrapolation_us);
+        const float scale = (float) ahead / (float) (s.timestamp_us[n - 1] - s.timestamp_us[n - 2]);
+        for (unsigned int j = 0; j < nj; j++) {
+            if (!(moving & (1u << j))) continue;
+            joints[j * 2] = p1[j * 2] + (p1[j * 2] - p0[j * 2]) * scale;
+            joints[j * 2 + 1] = p1[j * 2 + 1] + (p1[j * 2 + 1] - p0[j * 2 + 1]) * scale;
+        }
+        return true;
+    }
+
+    // before the oldest frame
+    if (time_us <= s.timestamp_us[0]) {
+        std::copy(s.joints[0], s.joints[0] + nj * 2, joints);
+        *valid_mask = s.valid_mask[0];
+        return true;
+    }
+
+    size_t i = 0;
+    while (s.timestamp_us[i + 1] < time_us) i++;
+    const int64_t t0 = s.timestamp_us[i], t1 = s.timestamp_us[i + 1];
+    const float h = (float) (t1 - t0);
+    const float u = (float) (time_us - t0) / h;
+    const uint32_t both = s.valid_mask[i] & s.valid_mask[i + 1];
+    const uint32_t before = i > 0 ? s.valid_mask[i - 1] : 0;
+    const uint32_t after = i + 2 < n ? s.valid_mask[i + 2] : 0;
+    const float* p0 = s.joints[i];
+    const float* p1 = s.joints[i + 1];
+    std::fill(joints, joints + nj * 2, -1.0f);
+    for (unsigned int j = 0; j < nj; j++) {
+        const uint32_t bit = 1u << j;
+        if (!(both & bit)) continue;
+        for (unsigned int k = j * 2; k < j * 2 + 2; k++) {
+            // tangents per microsecond over the neighbouring frames, scaled to the interval
+            const float secant = (p1[k] - p0[k]) / h;
+            const float d0 = (before & bit) ? (p1[k] - s.joints[i - 1][k]) / (float) (t1 - s.timestamp_us[i - 1]) : secant;
+            const float d1 = (after & bit) ? (s.joints[i + 2][k] - p0[k]) / (float) (s.timestamp_us[i + 2] - t0) : secant;
+            joints[k] = hermite(p0[k], d0 * h, p1[k], d1 * h, u);
+        }
+        *valid_mask |= bit;
+    }
+    return true;
+}
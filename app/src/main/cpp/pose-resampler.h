@@ -0,0 +1,58 @@
+#ifndef POSE_RESAMPLER_H
+#define POSE_RESAMPLER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// The main person's pose at arbitrary times between and after the estimated frames, for
+// drawing at display refresh rate while inference runs at a fraction of it.
+//
+// The thread feeding frames push()es each one; the renderer calls sample() once per vsync
+// from any thread. The last DEPTH frames are kept in a sequence lock: the writer never
+// waits, and a reader that raced with a write simply copies again. Nothing allocates.
+//
+// Between two frames each joint follows a Catmull-Rom spline through its neighbouring
+// frames (or a straight line where a neighbour lacks the joint). Past the newest frame it
+// continues at the velocity of the last two frames for at most max_extrapolation_us, then
+// holds. A joint is valid where the frames around it have it.
+
+class PoseResampler {
+public:
+    static const unsigned int MAX_JOINTS = 32;
+    static const size_t DEPTH = 4;
+
+    PoseResampler();
+
+    // Writer side, one thread at a time. A new id or an older timestamp starts over.
+    void push(int id, int64_t timestamp_us, const float* joints, uint32_t valid_mask, unsigned int num_joints);
+    void clear();
+
+    // Reader side. joints gets num_joints * 2 values. False if no frame was pushed since
+    // the last clear.
+    bool sample(int64_t time_us, int64_t max_extrapolation_us, float* joints, uint32_t* valid_mask,
+                int* id, unsigned int* num_joints) const;
+
+    // Reads that had to be repeated because a push came in between.
+    uint64_t retries() const { return retries_.load(std::memory_order_relaxed); }
+
+private:
+    struct Frame {
+        std::atomic<int64_t> timestamp_us;
+        std::atomic<uint32_t> valid_mask;
+        std::atomic<float> joints[MAX_JOINTS * 2];
+    };
+
+    void beginWrite();
+    void endWrite();
+
+    std::atomic<uint32_t> seq_;             // odd while a write is in progress
+    std::atomic<int> id_;
+    std::atomic<unsigned int> num_joints_;
+    std::atomic<size_t> count_;
+    std::atomic<size_t> head_;              // next slot written
+    Frame frames_[DEPTH];
+    mutable std::atomic<uint64_t> retries_;
+};
+
+#endif // POSE_RESAMPLER_H
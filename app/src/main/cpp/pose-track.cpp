@@ -0,0 +1,234 @@
+#include "pose-track.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const size_t WRITE_BUFFER_SIZE = 256 * 1024;
+
+static size_t alignTo8(size_t n) {
+    return (n + 7) & ~(size_t) 7;
+}
+
+PoseTrackWriter::PoseTrackWriter() : file_(nullptr), num_joints_(0), num_records_(0) {}
+
+PoseTrackWriter::~PoseTrackWriter() {
+    close();
+}
+
+bool PoseTrackWriter::open(const char* path, const char* joint_definition, unsigned int num_joints,
+                           const unsigned int* bone_pairs, unsigned int num_bones) {
+    close();
+
+    file_ = fopen(path, "wb");
+    if (!file_) {
+        return false;
+    }
+    buffer_.resize(WRITE_BUFFER_SIZE);
+    setvbuf(file_, buffer_.data(), _IOFBF, buffer_.size());
+
+    num_joints_ = num_joints;
+    num_records_ = 0;
+    index_.clear();
+
+    const size_t bones_size = sizeof(uint32_t) * num_bones * 2;
+    PoseTrackHeader& header = header_;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, POSE_TRACK_MAGIC, sizeof(header.magic));
+    header.version = POSE_TRACK_VERSION;
+    header.header_size = alignTo8(sizeof(header) + bones_size);
+    header.record_size = poseTrackRecordSize(num_joints);
+    header.num_joints = num_joints;
+    header.num_bones = num_bones;
+    strncpy(header.joint_definition, joint_definition, sizeof(header.joint_definition) - 1);
+
+    std::vector<char> head(header.header_size, 0);
+    memcpy(head.data(), &header, sizeof(header));
+    for (unsigned int i = 0; i < num_bones * 2; i++) {
+        const uint32_t v = bone_pairs[i];
+        memcpy(head.data() + sizeof(header) + i * sizeof(uint32_t), &v, sizeof(v));
+    }
+
+    if (fwrite(head.data(), head.size(), 1, file_) != 1) {
+        fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void PoseTrackWriter::beginFrame(int64_t timestamp_us) {
+    if (file_ && (index_.empty() || index_.back().timestamp_us != timestamp_us)) {
+        PoseTrackIndexEntry entry = { timestamp_us, num_records_ };
+        index_.push_back(entry);
+    }
+}
+
+bool PoseTrackWriter::append(const PoseTrackRecord& record, const float* joints, const float* scores) {
+    if (!file_) {
+        return false;
+    }
+
+    beginFrame(record.timestamp_us);
+
+    static const char padding[8] = {};
+    const size_t data_size = sizeof(record) + sizeof(float) * num_joints_ * 3;
+    bool ok = fwrite(&record, sizeof(record), 1, file_) == 1;
+    ok = ok && fwrite(joints, sizeof(float) * num_joints_ * 2, 1, file_) == 1;
+    ok = ok && fwrite(scores, sizeof(float) * num_joints_, 1, file_) == 1;
+    if (header_.record_size > data_size) {
+        ok = ok && fwrite(padding, header_.record_size - data_size, 1, file_) == 1;
+    }
+    num_records_++;
+    return ok;
+}
+
+bool PoseTrackWriter::close() {
+    if (!file_) {
+        return false;
+    }
+
+    bool ok = true;
+    const long index_offset = ftell(file_);
+    if (!index_.empty()) {
+        ok = fwrite(index_.data(), sizeof(PoseTrackIndexEntry) * index_.size(), 1, file_) == 1;
+    }
+
+    if (ok) {
+        header_.num_records = num_records_;
+        header_.index_offset = index_offset;
+        header_.num_frames = index_.size();
+        ok = fseek(file_, 0, SEEK_SET) == 0 && fwrite(&header_, sizeof(header_), 1, file_) == 1;
+    }
+
+    ok = fclose(file_) == 0 && ok;
+    file_ = nullptr;
+    index_.clear();
+    return ok;
+}
+
+PoseTrackReader::PoseTrackReader()
+        : data_(nullptr), size_(0), header_(nullptr), num_records_(0), num_frames_(0), index_(nullptr) {}
+
+PoseTrackReader::~PoseTrackReader() {
+    close();
+}
+
+bool PoseTrackReader::open(const char* path) {
+    close();
+
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(PoseTrackHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    data_ = static_cast<const char*>(map);
+    size_ = st.st_size;
+    header_ = reinterpret_cast<const PoseTrackHeader*>(data_);
+
+    const PoseTrackHeader& h = *header_;
+    if (memcmp(h.magic, POSE_TRACK_MAGIC, sizeof(h.magic)) != 0 ||
+        h.version != POSE_TRACK_VERSION ||
+        h.num_joints == 0 || h.num_joints > POSE_TRACK_MAX_JOINTS ||
+        h.record_size != poseTrackRecordSize(h.num_joints) ||
+        h.num_bones > size_ / (sizeof(uint32_t) * 2) ||
+        h.header_size < sizeof(PoseTrackHeader) + (size_t) h.num_bones * sizeof(uint32_t) * 2 ||
+        h.header_size % alignof(PoseTrackRecord) != 0 ||
+        h.header_size > size_) {
+        close();
+        return false;
+    }
+
+    const size_t max_records = (size_ - h.header_size) / h.record_size;
+    if (h.index_offset != 0 && h.index_offset <= size_ &&
+        h.num_frames <= (size_ - h.index_offset) / sizeof(PoseTrackIndexEntry)) {
+        if (h.num_records > max_records ||
+            h.index_offset < h.header_size + h.num_records * h.record_size ||
+            h.index_offset % alignof(PoseTrackIndexEntry) != 0) {
+            close();
+            return false;
+        }
+        // frame() takes the difference of neighbouring entries and findFrame bisects them
+        const PoseTrackIndexEntry* index = reinterpret_cast<const PoseTrackIndexEntry*>(data_ + h.index_offset);
+        for (size_t i = 0; i < h.num_frames; i++) {
+            if (index[i].first_record > h.num_records ||
+                (i > 0 && (index[i].first_record < index[i - 1].first_record ||
+                           index[i].timestamp_us < index[i - 1].timestamp_us))) {
+                close();
+                return false;
+            }
+        }
+        num_records_ = h.num_records;
+        num_frames_ = h.num_frames;
+        index_ = index;
+    } else {
+        // unfinished recording: take every complete record and index them here
+        num_records_ = max_records;
+        for (size_t i = 0; i < num_records_; i++) {
+            const int64_t ts = record(i)->timestamp_us;
+            if (rebuilt_index_.empty() || rebuilt_index_.back().timestamp_us != ts) {
+                PoseTrackIndexEntry entry = { ts, i };
+                rebuilt_index_.push_back(entry);
+            }
+        }
+        num_frames_ = rebuilt_index_.size();
+        index_ = rebuilt_index_.data();
+    }
+
+    madvise(const_cast<char*>(data_), size_, MADV_RANDOM);
+    return true;
+}
+
+void PoseTrackReader::close() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    num_records_ = 0;
+    num_frames_ = 0;
+    index_ = nullptr;
+    rebuilt_index_.clear();
+}
+
+const unsigned int* PoseTrackReader::bonePairs() const {
+    return reinterpret_cast<const unsigned int*>(data_ + sizeof(PoseTrackHeader));
+}
+
+const PoseTrackRecord* PoseTrackReader::record(size_t i) const {
+    return reinterpret_cast<const PoseTrackRecord*>(data_ + header_->header_size + i * header_->record_size);
+}
+
+PoseTrackReader::Frame PoseTrackReader::frame(size_t i) const {
+    const size_t first = index_[i].first_record;
+    const size_t end = i + 1 < num_frames_ ? index_[i + 1].first_record : num_records_;
+
+    Frame f;
+    f.timestamp_us = index_[i].timestamp_us;
+    f.first = record(first);
+    f.count = end - first;
+    return f;
+}
+
+long PoseTrackReader::findFrame(int64_t timestamp_us) const {
+    const PoseTrackIndexEntry* end = index_ + num_frames_;
+    const PoseTrackIndexEntry* it = std::upper_bound(index_, end, timestamp_us,
+            [](int64_t ts, const PoseTrackIndexEntry& e) { return ts < e.timestamp_us; });
+    return (long) (it - index_) - 1;
+}
@@ -0,0 +1,135 @@
+#ifndef POSE_TRACK_H
+#define POSE_TRACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Append-only binary pose track.
+//
+//   PoseTrackHeader
+//   bone pairs        uint32 [num_bones * 2], padded to 8 bytes
+//   records           record_size bytes each, timestamps non-decreasing
+//   index             PoseTrackIndexEntry [num_frames], written on close
+//
+// A record is one person in one frame: PoseTrackRecord followed by joints (num_joints * 2
+// floats) and scores (num_joints floats), zero padded to keep the next record's timestamp
+// aligned. All people of a frame share its timestamp and sit next to each other. Frames
+// without people have an index entry and no records. A file whose writer died before close
+// has index_offset 0; the reader then rebuilds the index by scanning the records, which
+// loses the empty frames.
+
+static const char POSE_TRACK_MAGIC[4] = { 'W', 'P', 'T', 'K' };
+static const uint32_t POSE_TRACK_VERSION = 2;
+static const unsigned int POSE_TRACK_MAX_JOINTS = 32;    // valid_mask bits
+
+struct PoseTrackHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t header_size;       // offset of the first record
+    uint32_t record_size;
+    uint32_t num_joints;
+    uint32_t num_bones;
+    uint64_t num_records;       // 0 until close
+    uint64_t index_offset;      // 0 until close
+    uint64_t num_frames;        // 0 until close
+    char joint_definition[16];  // e.g. "j23"
+};
+
+struct PoseTrackRecord {
+    int64_t timestamp_us;
+    int32_t id;
+    uint32_t flags;
+    uint32_t valid_mask;
+    float score;
+    float bbox[4];              // minX, minY, width, height
+};
+
+static const uint32_t POSE_TRACK_FLAG_MAIN = 1;
+
+struct PoseTrackIndexEntry {
+    int64_t timestamp_us;
+    uint64_t first_record;
+};
+
+inline size_t poseTrackRecordSize(unsigned int num_joints) {
+    const size_t align = alignof(PoseTrackRecord);
+    return (sizeof(PoseTrackRecord) + sizeof(float) * num_joints * 3 + align - 1) & ~(align - 1);
+}
+
+inline const float* poseTrackJoints(const PoseTrackRecord* record) {
+    return reinterpret_cast<const float*>(record + 1);
+}
+
+inline const float* poseTrackScores(const PoseTrackRecord* record, unsigned int num_joints) {
+    return poseTrackJoints(record) + num_joints * 2;
+}
+
+class PoseTrackWriter {
+public:
+    PoseTrackWriter();
+    ~PoseTrackWriter();
+
+    bool open(const char* path, const char* joint_definition, unsigned int num_joints,
+              const unsigned int* bone_pairs, unsigned int num_bones);
+    bool isOpen() const { return file_ != nullptr; }
+
+    // Starts a frame, so that it is indexed even if nobody is appended to it.
+    void beginFrame(int64_t timestamp_us);
+
+    // Records of one frame must be appended together, frames in timestamp order.
+    bool append(const PoseTrackRecord& record, const float* joints, const float* scores);
+
+    // Writes the index and patches the header.
+    bool close();
+
+private:
+    FILE* file_;
+    PoseTrackHeader header_;
+    unsigned int num_joints_;
+    uint64_t num_records_;
+    std::vector<PoseTrackIndexEntry> index_;
+    std::vector<char> buffer_;
+};
+
+class PoseTrackReader {
+public:
+    struct Frame {
+        int64_t timestamp_us;
+        const PoseTrackRecord* first;
+        size_t count;
+    };
+
+    PoseTrackReader();
+    ~PoseTrackReader();
+
+    bool open(const char* path);
+    void close();
+    bool isOpen() const { return data_ != nullptr; }
+
+    unsigned int numJoints() const { return header_->num_joints; }
+    unsigned int numBones() const { return header_->num_bones; }
+    const unsigned int* bonePairs() const;
+    const char* jointDefinition() const { return header_->joint_definition; }
+
+    size_t numRecords() const { return num_records_; }
+    size_t numFrames() const { return num_frames_; }
+    Frame frame(size_t i) const;
+
+    // Index of the last frame at or before timestamp_us, or -1 if it precedes the track.
+    long findFrame(int64_t timestamp_us) const;
+
+    const PoseTrackRecord* record(size_t i) const;
+
+private:
+    const char* data_;
+    size_t size_;
+    const PoseTrackHeader* header_;
+    size_t num_records_;
+    size_t num_frames_;
+    const PoseTrackIndexEntry* index_;
+    std::vector<PoseTrackIndexEntry> rebuilt_index_;
+};
+
+#endif // POSE_TRACK_H
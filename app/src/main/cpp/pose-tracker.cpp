@@ -0,0 +1,211 @@
+#include "pose-tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "pose2d-ref.h"
+
+// Cost of pairs that must not be matched; finite so the solver's potentials stay finite.
+static const float NO_MATCH = 1e4f;
+
+// Joints further apart than this (in track box heights) without any box overlap can't be the
+// same person.
+static const float MAX_JOINT_DISTANCE = 0.5f;
+
+PoseTracker::PoseTracker(unsigned int num_joints, size_t max_tracks)
+        : num_joints_(num_joints), max_tracks_(max_tracks), joints_(max_tracks * num_joints * 2) {
+    tracks_.reserve(max_tracks);
+    reset();
+}
+
+void PoseTracker::reset() {
+    tracks_.clear();
+    free_slots_.clear();
+    for (size_t i = max_tracks_; i > 0; i--) {
+        free_slots_.push_back((i - 1) * num_joints_ * 2);
+    }
+    next_id_ = 0;
+    last_us_ = std::numeric_limits<int64_t>::min();
+}
+
+float PoseTracker::pairCost(const Track& track, const float* predicted_bbox, const TrackerDetection& det) const {
+    const float iou = boxIoU(predicted_bbox, det.bbox);
+
+    // joints of the track moved along with its box
+    const float shift_x = predicted_bbox[0] + predicted_bbox[2] * 0.5f - (track.bbox[0] + track.bbox[2] * 0.5f);
+    const float shift_y = predicted_bbox[1] + predicted_bbox[3] * 0.5f - (track.bbox[1] + track.bbox[3] * 0.5f);
+    const float* tj = &joints_[track.joints];
+    const uint32_t common = track.valid_mask & det.valid_mask;
+    float sum = 0.0f;
+    int n = 0;
+    for (unsigned int j = 0; j < num_joints_; j++) {
+        if (!(common & (1u << j))) continue;
+        const float dx = det.joints[j * 2] - (tj[j * 2] + shift_x);
+        const float dy = det.joints[j * 2 + 1] - (tj[j * 2 + 1] + shift_y);
+        sum += std::sqrt(dx * dx + dy * dy);
+        n++;
+    }
+    const float joint_distance = n > 0 ? std::min(sum / n / std::max(track.bbox[3], 1e-3f), 2.0f) : 1.0f;
+
+    if (iou <= 0.0f && joint_distance > MAX_JOINT_DISTANCE) {
+        return NO_MATCH;
+    }
+    return config_.iou_weight * (1.0f - iou) + config_.joint_weight * joint_distance;
+}
+
+// Minimum cost assignment of every row of cost_ (rows x cols, rows <= cols) to a distinct
+// column, by shortest augmenting paths with potentials. O(rows^2 * cols).
+void PoseTracker::solve(size_t rows, size_t cols) {
+    const float inf = std::numeric_limits<float>::infinity();
+    u_.assign(rows + 1, 0.0f);
+    v_.assign(cols + 1, 0.0f);
+    col_row_.assign(cols + 1, 0);       // 1-based row matched to each column, 0 if none
+    way_.assign(cols + 1, 0);
+
+    for (size_t i = 1; i <= rows; i++) {
+        col_row_[0] = (int) i;
+        size_t j0 = 0;
+        min_v_.assign(cols + 1, inf);
+        used_.assign(cols + 1, 0);
+        do {
+            used_[j0] = 1;
+            const size_t i0 = col_row_[j0];
+            const float* row = &cost_[(i0 - 1) * cols];
+            float delta = inf;
+            size_t j1 = 0;
+            for (size_t j = 1; j <= cols; j++) {
+                if (used_[j]) continue;
+                const float cur = row[j - 1] - u_[i0] - v_[j];
+                if (cur < min_v_[j]) {
+                    min_v_[j] = cur;
+                    way_[j] = (int) j0;
+                }
+                if (min_v_[j] < delta) {
+                    delta = min_v_[j];
+                    j1 = j;
+                }
+            }
+            for (size_t j = 0; j <= cols; j++) {
+                if (used_[j]) {
+                    u_[col_row_[j]] += delta;
+                    v_[j] -= delta;
+                } else {
+                    min_v_[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (col_row_[j0] != 0);
+        do {
+            const size_t j1 = way_[j0];
+            col_row_[j0] = col_row_[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    row_match_.assign(rows, -1);
+    for (size_t j = 1; j <= cols; j++) {
+        if (col_row_[j] != 0) row_match_[col_row_[j] - 1] = (int) (j - 1);
+    }
+}
+
+void PoseTracker::updateTrack(Track& track, int64_t timestamp_us, const TrackerDetection& det) {
+    const float dt = (timestamp_us - track.last_us) * 1e-6f;
+    if (dt > 0.0f) {
+        for (int k = 0; k < 4; k++) {
+            const float v = (det.bbox[k] - track.bbox[k]) / dt;
+            track.velocity[k] = track.hits == 1 ? v : 0.5f * (track.velocity[k] + v);
+        }
+    }
+    std::copy(det.bbox, det.bbox + 4, track.bbox);
+    std::copy(det.joints, det.joints + num_joints_ * 2, &joints_[track.joints]);
+    track.valid_mask = det.valid_mask;
+    track.last_us = timestamp_us;
+    track.hits++;
+}
+
+void PoseTracker::update(int64_t timestamp_us, const TrackerDetection* detections, size_t count, int* ids) {
+    if (timestamp_us < last_us_) {
+        reset();
+    }
+    last_us_ = timestamp_us;
+
+    const size_t n = tracks_.size();
+    predicted_.resize(n * 4);
+    for (size_t t = 0; t < n; t++) {
+        const Track& track = tracks_[t];
+        const float dt = (timestamp_us - track.last_us) * 1e-6f;
+        for (int k = 0; k < 4; k++) {
+            predicted_[t * 4 + k] = track.bbox[k] + track.velocity[k] * dt;
+        }
+    }
+
+    // tracks x detections, or transposed so rows never outnumber columns
+    det_track_.assign(count, -1);
+    if (n > 0 && count > 0) {
+        const bool by_track = n <= count;
+        const size_t rows = by_track ? n : count, cols = by_track ? count : n;
+        cost_.resize(rows * cols);
+        for (size_t t = 0; t < n; t++) {
+            for (size_t d = 0; d < count; d++) {
+                const float c = pairCost(tracks_[t], &predicted_[t * 4], detections[d]);
+                cost_[by_track ? t * cols + d : d * cols + t] = c;
+            }
+        }
+        solve(rows, cols);
+        for (size_t r = 0; r < rows; r++) {
+            const int c = row_match_[r];
+            if (c < 0 || cost_[r * cols + c] > config_.max_cost) continue;
+            if (by_track) det_track_[c] = (int) r;
+            else det_track_[r] = c;
+        }
+    }
+
+    matched_.assign(n, 0);
+    for (size_t d = 0; d < count; d++) {
+        const int t = det_track_[d];
+        if (t < 0) continue;
+        updateTrack(tracks_[t], timestamp_us, detections[d]);
+        matched_[t] = 1;
+        ids[d] = tracks_[t].id;
+    }
+
+    // deaths: tentative tracks on their first miss, confirmed ones after max_age_us
+    size_t live = 0;
+    for (size_t t = 0; t < n; t++) {
+        const Track& track = tracks_[t];
+        const bool dead = !matched_[t] &&
+                (track.hits < config_.confirm_hits || timestamp_us - track.last_us > config_.max_age_us);
+        if (dead) {
+            free_slots_.push_back(track.joints);
+        } else {
+            tracks_[live++] = track;
+        }
+    }
+    tracks_.resize(live);
+
+    // births, evicting the longest unseen track when full
+    for (size_t d = 0; d < count; d++) {
+        if (det_track_[d] >= 0) continue;
+        if (free_slots_.empty()) {
+            size_t oldest = 0;
+            for (size_t t = 1; t < tracks_.size(); t++) {
+                if (tracks_[t].last_us < tracks_[oldest].last_us) oldest = t;
+            }
+            free_slots_.push_back(tracks_[oldest].joints);
+            tracks_[oldest] = tracks_.back();
+            tracks_.pop_back();
+        }
+
+        Track track;
+        track.id = next_id_++;
+        track.hits = 0;
+        track.last_us = timestamp_us;
+        std::fill(track.velocity, track.velocity + 4, 0.0f);
+        track.joints = free_slots_.back();
+        free_slots_.pop_back();
+        updateTrack(track, timestamp_us, detections[d]);
+        tracks_.push_back(track);
+        ids[d] = track.id;
+    }
+}
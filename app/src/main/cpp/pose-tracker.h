@@ -0,0 +1,83 @@
+#ifndef POSE_TRACKER_H
+#define POSE_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Multi-person id association across frames, for running the estimator with its own tracker
+// disabled.
+//
+// Every frame each live track is moved forward by its bounding box velocity, then the cost
+// of pairing it with each detection is computed from bounding box overlap and the mean
+// distance of the joints both have, relative to the track's box height. The pairing of
+// least total cost is solved exactly (Hungarian algorithm); pairs above max_cost are left
+// unmatched. Unmatched detections start new tracks with fresh ids. A new track is tentative
+// and dies on its first miss until it has been seen confirm_hits times; after that it
+// survives misses for up to max_age_us. All buffers are kept between frames, so a frame
+// allocates nothing once the number of people has been seen.
+
+struct PoseTrackerConfig {
+    float iou_weight = 1.0f;
+    float joint_weight = 1.0f;
+    float max_cost = 1.2f;
+    int confirm_hits = 3;
+    int64_t max_age_us = 500000;
+};
+
+struct TrackerDetection {
+    const float* bbox;              // minX, minY, width, height
+    const float* joints;            // num_joints * 2
+    uint32_t valid_mask;
+};
+
+class PoseTracker {
+public:
+    PoseTracker(unsigned int num_joints, size_t max_tracks);
+
+    void setConfig(const PoseTrackerConfig& config) { config_ = config; }
+    void reset();
+
+    // Writes a track id per detection to ids. Timestamps must be non-decreasing; an older
+    // frame resets the tracker.
+    void update(int64_t timestamp_us, const TrackerDetection* detections, size_t count, int* ids);
+
+    size_t numTracks() const { return tracks_.size(); }
+    unsigned int numJoints() const { return num_joints_; }
+
+private:
+    struct Track {
+        int id;
+        int hits;
+        int64_t last_us;
+        float bbox[4];
+        float velocity[4];          // of bbox, per second
+        uint32_t valid_mask;
+        size_t joints;              // offset into joints_
+    };
+
+    float pairCost(const Track& track, const float* predicted_bbox, const TrackerDetection& det) const;
+    void solve(size_t rows, size_t cols);
+    void updateTrack(Track& track, int64_t timestamp_us, const TrackerDetection& det);
+
+    unsigned int num_joints_;
+    size_t max_tracks_;
+    PoseTrackerConfig config_;
+    std::vector<Track> tracks_;
+    std::vector<float> joints_;             // num_joints * 2 per track slot
+    std::vector<size_t> free_slots_;
+    int next_id_;
+    int64_t last_us_;
+
+    // per frame scratch
+    std::vector<float> predicted_;          // bbox per track
+    std::vector<float> cost_;               // rows x cols
+    std::vector<int> row_match_;            // column per row, -1 if none
+    std::vector<int> det_track_;            // track per detection, -1 if none
+    std::vector<float> u_, v_, min_v_;
+    std::vector<int> col_row_, way_;
+    std::vector<char> used_;
+    std::vector<char> matched_;             // per track
+};
+
+#endif // POSE_TRACKER_H
@@ -0,0 +1,38 @@
+#ifndef POSE2D_REF_H
+#define POSE2D_REF_H
+
+#include <algorithm>
+#include <vector>
+
+// A 2D person as seen by the 2D path, used to carry its tracker id over to stages that run
+// their own estimator (and so their own tracker).
+struct Pose2dRef {
+    int id;
+    float bbox[4];      // minX, minY, width, height
+};
+
+inline float boxIoU(const float* a, const float* b) {
+    const float x0 = std::max(a[0], b[0]);
+    const float y0 = std::max(a[1], b[1]);
+    const float x1 = std::min(a[0] + a[2], b[0] + b[2]);
+    const float y1 = std::min(a[1] + a[3], b[1] + b[3]);
+    const float inter = std::max(x1 - x0, 0.0f) * std::max(y1 - y0, 0.0f);
+    const float uni = a[2] * a[3] + b[2] * b[3] - inter;
+    return uni > 0 ? inter / uni : 0.0f;
+}
+
+// Id of the 2D person overlapping bbox most, or -1 if none overlaps by more than min_iou.
+inline int matchPose2dRef(const float* bbox, const std::vector<Pose2dRef>& poses, float min_iou = 0.3f) {
+    int best_id = -1;
+    float best = min_iou;
+    for (const auto& pose : poses) {
+        const float overlap = boxIoU(bbox, pose.bbox);
+        if (overlap > best) {
+            best = overlap;
+            best_id = pose.id;
+        }
+    }
+    return best_id;
+}
+
+#endif // POSE2D_REF_H
@@ -0,0 +1,144 @@
+#include "pose3d-stage.h"
+
+#include <android/log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+Pose3dStage::Pose3dStage()
+        : estimator_(nullptr), options_(nullptr), stride_(1), frame_counter_(0),
+          have_result_(false), total_us_(0), processed_(0) {}
+
+Pose3dStage::~Pose3dStage() {
+    stop();
+}
+
+void Pose3dStage::start(wrPoseEstimatorHandle estimator, bool use_ik, unsigned int stride) {
+    stop();
+
+    estimator_ = estimator;
+    options_ = wrPoseEstimatorOptions_Create();
+    wrPoseEstimatorOptions_SetEstimate3d(options_, 1);
+    wrPoseEstimatorOptions_SetUseIK(options_, use_ik ? 1 : 0);
+    wrPoseEstimatorOptions_SetEnableJointSmoothing(options_, 1);
+    wrPoseEstimatorOptions_SetRotationMultipleOf90(options_, 0);
+
+    stride_ = std::max(stride, 1u);
+    frame_counter_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        have_result_ = false;
+        total_us_ = 0;
+        processed_ = 0;
+    }
+
+    worker_.start([this](Job& job) { process(job); });
+}
+
+void Pose3dStage::stop() {
+    worker_.stop();
+    if (options_) {
+        wrPoseEstimatorOptions_Destroy(options_);
+        options_ = nullptr;
+    }
+    if (estimator_) {
+        wrPoseEstimator_Destroy(estimator_);
+        estimator_ = nullptr;
+    }
+}
+
+void Pose3dStage::submit(int64_t timestamp_us, const unsigned char* bgr, int cols, int rows,
+                         const Pose2dRef* poses, size_t num_poses) {
+    if (frame_counter_++ % stride_ != 0) {
+        return;
+    }
+
+    worker_.submit([&](Job& job) {
+        job.timestamp_us = timestamp_us;
+        job.cols = cols;
+        job.rows = rows;
+        job.bgr.assign(bgr, bgr + (size_t) cols * rows * 3);
+        job.poses.assign(poses, poses + num_poses);
+    });
+}
+
+int Pose3dStage::matchId(const Job& job, int own_id) const {
+    // find this estimator's 2D pose for the 3D one, then the 2D path's pose overlapping it most
+    auto it = wrPoseEstimator_GetHumans2DBegin(estimator_);
+    for (unsigned int i = 0; i < wrPoseEstimator_GetNumHumans2D(estimator_); i++) {
+        if (wrPose2d_GetId(it) == own_id) {
+            auto box = wrPose2d_GetBoundingBox(it);
+            const float own[4] = { wrBox2d_GetMinX(box), wrBox2d_GetMinY(box), wrBox2d_GetWidth(box), wrBox2d_GetHeight(box) };
+            return matchPose2dRef(own, job.poses);
+        }
+        it = wrPoseEstimator_GetPose2DNext(it);
+    }
+    return -1;
+}
+
+void Pose3dStage::process(Job& job) {
+    auto start = std::chrono::steady_clock::now();
+
+    auto rc = wrPoseEstimator_ProcessFrame(estimator_, job.bgr.data(), job.cols, job.rows, options_);
+    if (rc != wrReturnCode_OK) {
+        __android_log_print(ANDROID_LOG_ERROR, "WRNCH", "3D wrPoseEstimator_ProcessFrame: %s", wrReturnCode_Translate(rc));
+        return;
+    }
+
+    Pose3dResult& out = scratch_;
+    out.timestamp_us = job.timestamp_us;
+    out.num_joints = 0;
+    out.ids.clear();
+    out.positions.clear();
+    out.rotations.clear();
+
+    auto it = wrPoseEstimator_GetHumans3DBegin(estimator_);
+    for (unsigned int i = 0; i < wrPoseEstimator_GetNumHumans3D(estimator_); i++) {
+        const unsigned int n = wrPose3d_GetNumJoints(it);
+        out.num_joints = n;
+        out.ids.push_back(matchId(job, wrPose3d_GetId(it)));
+
+        const float* positions = wrPose3d_GetPositions(it);
+        out.positions.insert(out.positions.end(), positions, positions + n * 3);
+
+        const float* rotations = wrPose3d_GetRotations(it);
+        if (rotations) {
+            out.rotations.insert(out.rotations.end(), rotations, rotations + n * 4);
+        } else {
+            out.rotations.resize(out.rotations.size() + n * 4, 0.0f);
+        }
+
+        it = wrPoseEstimator_GetPose3DNext(it);
+    }
+
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    std::swap(result_, scratch_);
+    have_result_ = true;
+    total_us_ += us;
+    processed_++;
+}
+
+bool Pose3dStage::latest(Pose3dResult* out) const {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    if (!have_result_) {
+        return false;
+    }
+    out->timestamp_us = result_.timestamp_us;
+    out->num_joints = result_.num_joints;
+    out->ids = result_.ids;
+    out->positions = result_.positions;
+    out->rotations = result_.rotations;
+    return true;
+}
+
+Pose3dTiming Pose3dStage::timing() const {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    Pose3dTiming t;
+    t.mean_us = processed_ > 0 ? total_us_ / processed_ : 0.0;
+    t.processed = processed_;
+    t.dropped = worker_.dropped();
+    return t;
+}
@@ -0,0 +1,79 @@
+#ifndef POSE3D_STAGE_H
+#define POSE3D_STAGE_H
+
+#include <wrnch/engine.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "pose2d-ref.h"
+#include "stage-worker.h"
+
+// 3D pose (and IK) estimation decoupled from the 2D path.
+//
+// The stage owns a second pose estimator with 3D initialized and runs it on its own
+// thread. The 2D path hands over every stride-th frame together with its 2D results;
+// if the worker is still busy the older pending frame is dropped, so the 2D path never
+// waits on 3D. 3D poses are labelled with the 2D tracker ids by matching bounding boxes.
+
+struct Pose3dResult {
+    int64_t timestamp_us;
+    unsigned int num_joints;
+    std::vector<int> ids;           // 2D tracker id per person, -1 if unmatched
+    std::vector<float> positions;   // num_joints * 3 per person
+    std::vector<float> rotations;   // num_joints * 4 (quaternions) per person
+
+    size_t numPeople() const { return ids.size(); }
+};
+
+struct Pose3dTiming {
+    double mean_us;
+    long processed;
+    long dropped;
+};
+
+class Pose3dStage {
+public:
+    Pose3dStage();
+    ~Pose3dStage();
+
+    // Takes ownership of estimator, which must have 3D initialized.
+    void start(wrPoseEstimatorHandle estimator, bool use_ik, unsigned int stride);
+    void stop();
+    bool isRunning() const { return worker_.isRunning(); }
+
+    void submit(int64_t timestamp_us, const unsigned char* bgr, int cols, int rows,
+                const Pose2dRef* poses, size_t num_poses);
+
+    // Copies the most recent results; false until the first frame has been processed.
+    bool latest(Pose3dResult* out) const;
+    Pose3dTiming timing() const;
+
+private:
+    struct Job {
+        int64_t timestamp_us;
+        int cols;
+        int rows;
+        std::vector<unsigned char> bgr;
+        std::vector<Pose2dRef> poses;
+    };
+
+    void process(Job& job);
+    int matchId(const Job& job, int own_id) const;
+
+    StageWorker<Job> worker_;
+    wrPoseEstimatorHandle estimator_;
+    wrPoseEstimatorOptionsHandle options_;
+    unsigned int stride_;
+    unsigned int frame_counter_;
+
+    Pose3dResult scratch_;
+    mutable std::mutex result_mutex_;
+    Pose3dResult result_;
+    bool have_result_;
+    double total_us_;
+    long processed_;
+};
+
+#endif // POSE3D_STAGE_H
@@ -0,0 +1,187 @@
+#include "rep-counter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Hysteresis levels as fractions of the envelope range above its minimum.
+static const float LEAVE_REST = 0.65f;
+static const float RETURN_TO_REST = 0.35f;
+
+static const float RAD_TO_DEG = 57.2957795f;
+
+RepCounter::RepCounter() : events_(MAX_PENDING_EVENTS) {
+    reset();
+}
+
+void RepCounter::configure(const RepCounterConfig& config) {
+    config_ = config;
+    last_angles_.resize(config.angles.size());
+    reset();
+}
+
+void RepCounter::reset() {
+    id_ = -1;
+    last_us_ = 0;
+    signal_ = std::numeric_limits<float>::quiet_NaN();
+    std::fill(last_angles_.begin(), last_angles_.end(), std::numeric_limits<float>::quiet_NaN());
+    env_min_ = env_max_ = 0.0f;
+    phase_ = AT_REST;
+    cycle_start_us_ = 0;
+    cycle_extreme_ = 0.0f;
+    rest_level_ = 0.0f;
+    cycle_frames_ = 0;
+    cycle_valid_frames_ = 0;
+    last_period_s_ = 0.0f;
+    count_ = 0;
+    event_head_ = 0;
+    event_count_ = 0;
+}
+
+// An angle whose joints are missing holds its last value, so a dropped joint does not make
+// the combined signal jump to another angle.
+bool RepCounter::combinedAngle(const float* joints, uint32_t valid_mask, float aspect, float* out, bool* all_seen) {
+    *all_seen = true;
+    float sum = 0.0f;
+    float lo = std::numeric_limits<float>::max();
+    float hi = -lo;
+    int n = 0;
+    for (size_t i = 0; i < config_.angles.size(); i++) {
+        const RepAngle& angle = config_.angles[i];
+        const uint32_t needed = (1u << angle.a) | (1u << angle.b) | (1u << angle.c);
+        if ((valid_mask & needed) == needed) {
+            const float ax = (joints[angle.a * 2] - joints[angle.b * 2]) * aspect;
+            const float ay = joints[angle.a * 2 + 1] - joints[angle.b * 2 + 1];
+            const float cx = (joints[angle.c * 2] - joints[angle.b * 2]) * aspect;
+            const float cy = joints[angle.c * 2 + 1] - joints[angle.b * 2 + 1];
+            last_angles_[i] = std::atan2(std::fabs(ax * cy - ay * cx), ax * cx + ay * cy) * RAD_TO_DEG;
+        } else {
+            *all_seen = false;
+        }
+
+        const float deg = last_angles_[i];
+        if (std::isnan(deg)) continue;
+        sum += deg;
+        lo = std::min(lo, deg);
+        hi = std::max(hi, deg);
+        n++;
+    }
+    if (n == 0) {
+        return false;
+    }
+
+    switch (config_.combine) {
+        case RepCounterConfig::MIN: *out = lo; break;
+        case RepCounterConfig::MAX: *out = hi; break;
+        default: *out = sum / n; break;
+    }
+    return true;
+}
+
+void RepCounter::update(int id, int64_t timestamp_us, const float* joints, uint32_t valid_mask, float aspect) {
+    if (id != id_ || timestamp_us < last_us_) {
+        const int new_id = id;
+        reset();
+        id_ = new_id;
+    }
+
+    cycle_frames_++;
+    float angle;
+    bool all_seen;
+    if (!combinedAngle(joints, valid_mask, aspect, &angle, &all_seen)) {
+        return;
+    }
+    if (all_seen) cycle_valid_frames_++;
+
+    // work on a signal that rises away from rest
+    const float u = config_.rest_high ? -angle : angle;
+    if (std::isnan(signal_)) {
+        signal_ = angle;
+        env_min_ = env_max_ = rest_level_ = u;
+        cycle_start_us_ = last_us_ = timestamp_us;
+        cycle_frames_ = cycle_valid_frames_ = 1;
+        return;
+    }
+
+    const float dt = (timestamp_us - last_us_) * 1e-6f;
+    last_us_ = timestamp_us;
+    const float r = 6.2831853f * config_.cutoff_hz * dt;
+    const float prev = config_.rest_high ? -signal_ : signal_;
+    const float s = prev + r / (r + 1.0f) * (u - prev);
+    signal_ = config_.rest_high ? -s : s;
+
+    // range envelope: extremes are taken at once and forgotten over envelope_decay_s
+    const float forget = (env_max_ - env_min_) * std::min(dt / config_.envelope_decay_s, 1.0f);
+    env_max_ = std::max(s, env_max_ - forget);
+    env_min_ = std::min(s, env_min_ + forget);
+    const float range = env_max_ - env_min_;
+
+    if (phase_ == AT_REST) {
+        // the cycle starts at the deepest point of the rest phase
+        if (s <= rest_level_) {
+            rest_level_ = s;
+            cycle_start_us_ = timestamp_us;
+            cycle_frames_ = cycle_valid_frames_ = 1;
+        }
+        if (range >= config_.min_amplitude_deg && s > env_min_ + LEAVE_REST * range) {
+            phase_ = AWAY;
+            cycle_extreme_ = s;
+        }
+        return;
+    }
+
+    cycle_extreme_ = std::max(cycle_extreme_, s);
+    const float period_s = (timestamp_us - cycle_start_us_) * 1e-6f;
+    if (period_s > config_.max_period_s) {
+        // stalled away from rest; start over from here
+        phase_ = AT_REST;
+        rest_level_ = s;
+        cycle_start_us_ = timestamp_us;
+        cycle_frames_ = cycle_valid_frames_ = 1;
+        return;
+    }
+
+    if (s < env_min_ + RETURN_TO_REST * range) {
+        if (period_s >= config_.min_period_s && cycle_extreme_ - rest_level_ >= config_.min_amplitude_deg) {
+            emit(timestamp_us);
+        }
+        phase_ = AT_REST;
+        rest_level_ = s;
+        cycle_start_us_ = timestamp_us;
+        cycle_frames_ = cycle_valid_frames_ = 1;
+    }
+}
+
+void RepCounter::emit(int64_t end_us) {
+    const float period_s = (end_us - cycle_start_us_) * 1e-6f;
+    const float amplitude = cycle_extreme_ - rest_level_;
+
+    // full confidence for clear amplitude, all joints seen and a steady tempo
+    const float amplitude_term = std::min(amplitude / (1.5f * config_.min_amplitude_deg), 1.0f);
+    const float valid_term = (float) cycle_valid_frames_ / std::max(cycle_frames_, 1);
+    const float regularity = last_period_s_ > 0
+            ? std::min(period_s, last_period_s_) / std::max(period_s, last_period_s_) : 1.0f;
+    last_period_s_ = period_s;
+
+    RepEvent& event = events_[(event_head_ + event_count_) % MAX_PENDING_EVENTS];
+    if (event_count_ == MAX_PENDING_EVENTS) {
+        event_head_ = (event_head_ + 1) % MAX_PENDING_EVENTS;
+    } else {
+        event_count_++;
+    }
+    event.start_us = cycle_start_us_;
+    event.end_us = end_us;
+    event.amplitude_deg = amplitude;
+    event.confidence = amplitude_term * valid_term * (0.5f + 0.5f * regularity);
+    count_++;
+}
+
+size_t RepCounter::drainEvents(RepEvent* out, size_t max_events) {
+    const size_t n = std::min(max_events, event_count_);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = events_[event_head_];
+        event_head_ = (event_head_ + 1) % MAX_PENDING_EVENTS;
+    }
+    event_count_ -= n;
+    return n;
+}
@@ -0,0 +1,91 @@
+#ifndef REP_COUNTER_H
+#define REP_COUNTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Streaming repetition counter for one person.
+//
+// Every frame the configured joint angles are computed from the skeleton and combined into
+// one signal, which is low-pass filtered and run through a peak/valley state machine with
+// hysteresis. The hysteresis levels follow an envelope of the recent signal range, so the
+// same counter works for any amplitude above min_amplitude_deg. A repetition is a full
+// cycle from the rest side to the other side and back; it is reported with its start and
+// end timestamps and a confidence. All work per frame is O(number of angles).
+
+// Angle at joint b between the bones to joints a and c.
+struct RepAngle {
+    int a;
+    int b;
+    int c;
+};
+
+struct RepCounterConfig {
+    enum Combine { MEAN, MIN, MAX };
+
+    std::vector<RepAngle> angles;
+    Combine combine = MEAN;
+    bool rest_high = false;         // true if the signal rests at its high end (e.g. straight knees)
+    float min_amplitude_deg = 30.0f;
+    float min_period_s = 0.4f;
+    float max_period_s = 6.0f;
+    float cutoff_hz = 3.0f;         // signal low-pass
+    float envelope_decay_s = 4.0f;  // time for the range envelope to forget an old extreme
+};
+
+struct RepEvent {
+    int64_t start_us;
+    int64_t end_us;
+    float amplitude_deg;
+    float confidence;               // 0..1
+};
+
+class RepCounter {
+public:
+    // Events not drained yet beyond this are dropped, oldest first.
+    static const size_t MAX_PENDING_EVENTS = 64;
+
+    RepCounter();
+
+    void configure(const RepCounterConfig& config);
+    void reset();
+
+    // Feeds a frame of person id; a different id than the last restarts the count. aspect is
+    // the image width / height, to measure angles in square pixels.
+    void update(int id, int64_t timestamp_us, const float* joints, uint32_t valid_mask, float aspect);
+
+    // Moves up to max_events pending events to out, oldest first.
+    size_t drainEvents(RepEvent* out, size_t max_events);
+
+    int count() const { return count_; }
+    // Latest filtered signal in degrees, NaN before the first valid frame.
+    float signal() const { return signal_; }
+
+private:
+    enum Phase { AT_REST, AWAY };
+
+    bool combinedAngle(const float* joints, uint32_t valid_mask, float aspect, float* out, bool* all_seen);
+    void emit(int64_t end_us);
+
+    RepCounterConfig config_;
+    std::vector<float> last_angles_;    // per configured angle, NaN until seen
+    int id_;
+    int64_t last_us_;
+    float signal_;
+    float env_min_;
+    float env_max_;
+    Phase phase_;
+    int64_t cycle_start_us_;
+    float cycle_extreme_;           // furthest point from rest in this cycle
+    float rest_level_;              // signal at the start of this cycle
+    int cycle_frames_;
+    int cycle_valid_frames_;
+    float last_period_s_;
+    int count_;
+    std::vector<RepEvent> events_;  // ring of MAX_PENDING_EVENTS
+    size_t event_head_;
+    size_t event_count_;
+};
+
+#endif // REP_COUNTER_H
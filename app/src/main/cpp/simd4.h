@@ -0,0 +1,111 @@
+#ifndef SIMD4_H
+#define SIMD4_H
+
+// Minimal 4 x float vector helpers over NEON, SSE2 or plain scalar code, for kernels with
+// too many operations to spell out per instruction set. Loads and stores are unaligned.
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+typedef float32x4_t f32x4;
+typedef uint32x4_t m32x4;
+
+static inline f32x4 load4(const float* p) { return vld1q_f32(p); }
+static inline void store4(float* p, f32x4 v) { vst1q_f32(p, v); }
+static inline f32x4 set4(float v) { return vdupq_n_f32(v); }
+static inline f32x4 add4(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+static inline f32x4 sub4(f32x4 a, f32x4 b) { return vsubq_f32(a, b); }
+static inline f32x4 mul4(f32x4 a, f32x4 b) { return vmulq_f32(a, b); }
+static inline f32x4 madd4(f32x4 a, f32x4 b, f32x4 c) { return vmlaq_f32(a, b, c); }   // a + b * c
+static inline f32x4 min4(f32x4 a, f32x4 b) { return vminq_f32(a, b); }
+static inline f32x4 max4(f32x4 a, f32x4 b) { return vmaxq_f32(a, b); }
+static inline f32x4 abs4(f32x4 a) { return vabsq_f32(a); }
+static inline m32x4 gt4(f32x4 a, f32x4 b) { return vcgtq_f32(a, b); }
+static inline m32x4 lt4(f32x4 a, f32x4 b) { return vcltq_f32(a, b); }
+static inline f32x4 select4(m32x4 m, f32x4 a, f32x4 b) { return vbslq_f32(m, a, b); }   // m ? a : b
+static inline f32x4 div4(f32x4 a, f32x4 b) {
+#if defined(__aarch64__)
+    return vdivq_f32(a, b);
+#else
+    f32x4 inv = vrecpeq_f32(b);
+    inv = vmulq_f32(inv, vrecpsq_f32(b, inv));
+    inv = vmulq_f32(inv, vrecpsq_f32(b, inv));
+    return vmulq_f32(a, inv);
+#endif
+}
+static inline f32x4 sqrt4(f32x4 a) {
+#if defined(__aarch64__)
+    return vsqrtq_f32(a);
+#else
+    // a * rsqrt(a) with two refinement steps; 0 stays 0
+    f32x4 r = vrsqrteq_f32(a);
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+    return vbslq_f32(vceqq_f32(a, vdupq_n_f32(0.0f)), a, vmulq_f32(a, r));
+#endif
+}
+static inline float hsum4(f32x4 a) {
+#if defined(__aarch64__)
+    return vaddvq_f32(a);
+#else
+    const float32x2_t s = vadd_f32(vget_low_f32(a), vget_high_f32(a));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+#endif
+}
+
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+
+typedef __m128 f32x4;
+typedef __m128 m32x4;
+
+static inline f32x4 load4(const float* p) { return _mm_loadu_ps(p); }
+static inline void store4(float* p, f32x4 v) { _mm_storeu_ps(p, v); }
+static inline f32x4 set4(float v) { return _mm_set1_ps(v); }
+static inline f32x4 add4(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+static inline f32x4 sub4(f32x4 a, f32x4 b) { return _mm_sub_ps(a, b); }
+static inline f32x4 mul4(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+static inline f32x4 madd4(f32x4 a, f32x4 b, f32x4 c) { return _mm_add_ps(a, _mm_mul_ps(b, c)); }
+static inline f32x4 min4(f32x4 a, f32x4 b) { return _mm_min_ps(a, b); }
+static inline f32x4 max4(f32x4 a, f32x4 b) { return _mm_max_ps(a, b); }
+static inline f32x4 abs4(f32x4 a) { return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))); }
+static inline m32x4 gt4(f32x4 a, f32x4 b) { return _mm_cmpgt_ps(a, b); }
+static inline m32x4 lt4(f32x4 a, f32x4 b) { return _mm_cmplt_ps(a, b); }
+static inline f32x4 select4(m32x4 m, f32x4 a, f32x4 b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+static inline f32x4 div4(f32x4 a, f32x4 b) { return _mm_div_ps(a, b); }
+static inline f32x4 sqrt4(f32x4 a) { return _mm_sqrt_ps(a); }
+static inline float hsum4(f32x4 a) {
+    const __m128 s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+    return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+
+#else
+#include <cmath>
+
+struct f32x4 { float v[4]; };
+struct m32x4 { bool v[4]; };
+
+#define SIMD4_MAP(expr) f32x4 r; for (int i = 0; i < 4; i++) r.v[i] = (expr); return r
+
+static inline f32x4 load4(const float* p) { SIMD4_MAP(p[i]); }
+static inline void store4(float* p, f32x4 a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+static inline f32x4 set4(float v) { SIMD4_MAP(v); }
+static inline f32x4 add4(f32x4 a, f32x4 b) { SIMD4_MAP(a.v[i] + b.v[i]); }
+static inline f32x4 sub4(f32x4 a, f32x4 b) { SIMD4_MAP(a.v[i] - b.v[i]); }
+static inline f32x4 mul4(f32x4 a, f32x4 b) { SIMD4_MAP(a.v[i] * b.v[i]); }
+static inline f32x4 madd4(f32x4 a, f32x4 b, f32x4 c) { SIMD4_MAP(a.v[i] + b.v[i] * c.v[i]); }
+static inline f32x4 min4(f32x4 a, f32x4 b) { SIMD4_MAP(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+static inline f32x4 max4(f32x4 a, f32x4 b) { SIMD4_MAP(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+static inline f32x4 abs4(f32x4 a) { SIMD4_MAP(std::fabs(a.v[i])); }
+static inline m32x4 gt4(f32x4 a, f32x4 b) { m32x4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] > b.v[i]; return r; }
+static inline m32x4 lt4(f32x4 a, f32x4 b) { m32x4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] < b.v[i]; return r; }
+static inline f32x4 select4(m32x4 m, f32x4 a, f32x4 b) { SIMD4_MAP(m.v[i] ? a.v[i] : b.v[i]); }
+static inline f32x4 div4(f32x4 a, f32x4 b) { SIMD4_MAP(a.v[i] / b.v[i]); }
+static inline f32x4 sqrt4(f32x4 a) { SIMD4_MAP(std::sqrt(a.v[i])); }
+static inline float hsum4(f32x4 a) { return (a.v[0] + a.v[2]) + (a.v[1] + a.v[3]); }
+
+#undef SIMD4_MAP
+
+#endif
+
+#endif // SIMD4_H
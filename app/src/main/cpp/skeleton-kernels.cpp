@@ -0,0 +1,96 @@
+#include "skeleton-kernels.h"
+
+void computeBones(const unsigned int* pairs, size_t num_bones, const PoseBatch& poses,
+                  const BoneFeatures& out, float aspect) {
+    const size_t n = (poses.num_poses + 3) & ~(size_t) 3;
+    for (size_t b = 0; b < num_bones; b++) {
+        const size_t ja = pairs[b * 2] * poses.stride;
+        const size_t jb = pairs[b * 2 + 1] * poses.stride;
+        const size_t o = b * out.stride;
+        boneKernel(poses.x + ja, poses.y + ja, poses.x + jb, poses.y + jb, n, aspect,
+                   out.dx + o, out.dy + o, out.length + o);
+    }
+}
+
+// atan2(y, x) for y >= 0, so the result is in [0, pi]. Octant reduction and a minimax
+// polynomial for atan on [0, 1], good to about 1e-5 rad.
+static inline f32x4 atan2Positive4(f32x4 y, f32x4 x) {
+    const f32x4 ax = abs4(x);
+    const f32x4 hi = max4(ax, y);
+    const f32x4 lo = min4(ax, y);
+    // 0 / 0 for coincident joints gives 0 instead of NaN
+    const f32x4 a = div4(lo, max4(hi, set4(1e-30f)));
+    const f32x4 a2 = mul4(a, a);
+
+    f32x4 r = set4(-0.01172120f);
+    r = madd4(set4(0.05265332f), r, a2);
+    r = madd4(set4(-0.11643287f), r, a2);
+    r = madd4(set4(0.19354346f), r, a2);
+    r = madd4(set4(-0.33262347f), r, a2);
+    r = madd4(set4(0.99997726f), r, a2);
+    r = mul4(r, a);
+
+    r = select4(gt4(y, ax), sub4(set4(1.57079633f), r), r);
+    return select4(lt4(x, set4(0.0f)), sub4(set4(3.14159265f), r), r);
+}
+
+void computeJointAngles(const JointAngleDef* angles, size_t num_angles, const PoseBatch& poses,
+                        float* out, size_t out_stride, float aspect) {
+    const size_t n = (poses.num_poses + 3) & ~(size_t) 3;
+    const f32x4 asp = set4(aspect);
+    for (size_t i = 0; i < num_angles; i++) {
+        const float* xa = poses.x + angles[i].a * poses.stride;
+        const float* ya = poses.y + angles[i].a * poses.stride;
+        const float* xb = poses.x + angles[i].b * poses.stride;
+        const float* yb = poses.y + angles[i].b * poses.stride;
+        const float* xc = poses.x + angles[i].c * poses.stride;
+        const float* yc = poses.y + angles[i].c * poses.stride;
+        float* dst = out + i * out_stride;
+
+        for (size_t p = 0; p < n; p += 4) {
+            const f32x4 bx = load4(xb + p);
+            const f32x4 by = load4(yb + p);
+            const f32x4 ux = mul4(sub4(load4(xa + p), bx), asp);
+            const f32x4 uy = sub4(load4(ya + p), by);
+            const f32x4 vx = mul4(sub4(load4(xc + p), bx), asp);
+            const f32x4 vy = sub4(load4(yc + p), by);
+            const f32x4 cross = abs4(sub4(mul4(ux, vy), mul4(uy, vx)));
+            const f32x4 dot = madd4(mul4(ux, vx), uy, vy);
+            store4(dst + p, atan2Positive4(cross, dot));
+        }
+    }
+}
+
+void boneValidMasks(const unsigned int* pairs, size_t num_bones, const PoseBatch& poses, uint32_t* out) {
+    for (size_t p = 0; p < poses.num_poses; p++) {
+        const uint32_t joints = poses.valid_masks[p];
+        uint32_t mask = 0;
+        for (size_t b = 0; b < num_bones; b++) {
+            const uint32_t needed = (1u << pairs[b * 2]) | (1u << pairs[b * 2 + 1]);
+            mask |= (uint32_t) ((joints & needed) == needed) << b;
+        }
+        out[p] = mask;
+    }
+}
+
+void angleValidMasks(const JointAngleDef* angles, size_t num_angles, const PoseBatch& poses, uint32_t* out) {
+    for (size_t p = 0; p < poses.num_poses; p++) {
+        const uint32_t joints = poses.valid_masks[p];
+        uint32_t mask = 0;
+        for (size_t i = 0; i < num_angles; i++) {
+            const uint32_t needed = (1u << angles[i].a) | (1u << angles[i].b) | (1u << angles[i].c);
+            mask |= (uint32_t) ((joints & needed) == needed) << i;
+        }
+        out[p] = mask;
+    }
+}
+
+void transposePoses(const float* joints, size_t count, unsigned int num_joints, float* x, float* y, size_t stride) {
+    for (size_t p = 0; p < count; p++) {
+        const float* src = joints + p * num_joints * 2;
+        for (unsigned int j = 0; j < num_joints; j++) {
+            x[j * stride + p] = src[j * 2];
+            y[j * stride + p] = src[j * 2 + 1];
+        }
+    }
+}
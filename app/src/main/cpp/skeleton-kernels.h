@@ -0,0 +1,122 @@
+#ifndef SKELETON_KERNELS_H
+#define SKELETON_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simd4.h"
+
+// Bone vectors, bone lengths and joint angles for many poses at once.
+//
+// Poses are laid out struct-of-arrays across poses: the x of joint j of pose p is at
+// x[j * stride + p], so every bone or angle is one vectorized pass over all poses. Results
+// are laid out the same way, bone-major or angle-major. stride must be a multiple of 4 and
+// the kernels process num_poses rounded up to a multiple of 4, so padding poses are written
+// too. x is multiplied by aspect (image width / height) so lengths and angles are in square
+// units.
+//
+// The topology is either a SkeletonTopology type, which bakes the bone pairs into the code,
+// or a runtime list of pairs for any joint definition.
+
+struct PoseBatch {
+    const float* x;
+    const float* y;
+    const uint32_t* valid_masks;    // per pose
+    size_t num_poses;
+    size_t stride;
+};
+
+struct BoneFeatures {
+    float* dx;                      // joint b - joint a
+    float* dy;
+    float* length;
+    size_t stride;
+};
+
+// Angle at joint b between the bones to joints a and c, in radians from 0 to pi.
+struct JointAngleDef {
+    int a;
+    int b;
+    int c;
+};
+
+// Bone pairs as template arguments: a0, b0, a1, b1, ...
+template <unsigned NumJoints, unsigned... Joints>
+struct SkeletonTopology {
+    static constexpr unsigned NUM_JOINTS = NumJoints;
+    static constexpr unsigned NUM_BONES = sizeof...(Joints) / 2;
+};
+
+// The j23 skeleton as wrJointDefinition "j23" describes it. Callers compare it against the
+// library's bone pairs (skeletonTopologyMatches) before relying on it.
+using J23Topology = SkeletonTopology<23,
+        0, 1,   1, 2,   3, 4,   4, 5,   2, 6,   3, 6,   6, 7,   7, 8,   8, 9,
+        10, 11, 11, 12, 12, 7,  13, 7,  13, 14, 14, 15,
+        16, 9,  17, 16, 18, 17, 19, 16, 20, 19, 21, 0,  22, 5>;
+
+static inline void boneKernel(const float* xa, const float* ya, const float* xb, const float* yb,
+                              size_t n, float aspect, float* dx, float* dy, float* length) {
+    const f32x4 asp = set4(aspect);
+    for (size_t p = 0; p < n; p += 4) {
+        const f32x4 vx = mul4(sub4(load4(xb + p), load4(xa + p)), asp);
+        const f32x4 vy = sub4(load4(yb + p), load4(ya + p));
+        store4(dx + p, vx);
+        store4(dy + p, vy);
+        store4(length + p, sqrt4(madd4(mul4(vx, vx), vy, vy)));
+    }
+}
+
+template <typename Topology>
+struct TopologyTraits;
+
+template <unsigned NumJoints, unsigned... Joints>
+struct TopologyTraits<SkeletonTopology<NumJoints, Joints...>> {
+    static constexpr size_t NUM_BONES = sizeof...(Joints) / 2;
+    static const unsigned* pairs() {
+        static constexpr unsigned p[] = { Joints... };
+        return p;
+    }
+};
+
+// Bones of a compile time topology; the bone loop has constant bounds and joint offsets.
+template <typename Topology>
+void computeBones(const PoseBatch& poses, const BoneFeatures& out, float aspect) {
+    const unsigned* pairs = TopologyTraits<Topology>::pairs();
+    const size_t n = (poses.num_poses + 3) & ~(size_t) 3;
+    for (size_t b = 0; b < TopologyTraits<Topology>::NUM_BONES; b++) {
+        const size_t ja = pairs[b * 2] * poses.stride;
+        const size_t jb = pairs[b * 2 + 1] * poses.stride;
+        const size_t o = b * out.stride;
+        boneKernel(poses.x + ja, poses.y + ja, poses.x + jb, poses.y + jb, n, aspect,
+                   out.dx + o, out.dy + o, out.length + o);
+    }
+}
+
+// True if pairs (num_bones pairs) are exactly the bones of Topology.
+template <typename Topology>
+bool skeletonTopologyMatches(const unsigned int* pairs, size_t num_bones) {
+    if (num_bones != TopologyTraits<Topology>::NUM_BONES) return false;
+    const unsigned* expected = TopologyTraits<Topology>::pairs();
+    for (size_t i = 0; i < num_bones * 2; i++) {
+        if (pairs[i] != expected[i]) return false;
+    }
+    return true;
+}
+
+// Bones of a runtime topology, pairs holds num_bones joint index pairs.
+void computeBones(const unsigned int* pairs, size_t num_bones, const PoseBatch& poses,
+                  const BoneFeatures& out, float aspect);
+
+// Joint angles, angle-major into out with out_stride.
+void computeJointAngles(const JointAngleDef* angles, size_t num_angles, const PoseBatch& poses,
+                        float* out, size_t out_stride, float aspect);
+
+// Validity of every bone (bit b) or angle (bit i) per pose, from the poses' joint masks.
+void boneValidMasks(const unsigned int* pairs, size_t num_bones, const PoseBatch& poses, uint32_t* out);
+void angleValidMasks(const JointAngleDef* angles, size_t num_angles, const PoseBatch& poses, uint32_t* out);
+
+// Transposes count poses of num_joints * 2 interleaved x,y floats (frame after frame) into
+// the SoA x and y arrays with the given stride.
+void transposePoses(const float* joints, size_t count, unsigned int num_joints, float* x, float* y, size_t stride);
+
+#endif // SKELETON_KERNELS_H
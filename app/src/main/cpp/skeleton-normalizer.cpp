@@ -0,0 +1,174 @@
+#include "skeleton-normalizer.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Torso lengths (squared, in aspect corrected image heights) below this are degenerate.
+static const float MIN_TORSO_SQ = 1e-8f;
+
+// Poses transformed per step of normalizeSkeletons, a multiple of 4.
+static const size_t NORMALIZE_CHUNK = 64;
+
+// Records transposed per step of normalizeTrack.
+static const size_t TRACK_BLOCK = 256;
+
+size_t normalizeSkeletons(const NormalizerSkeleton& skeleton, const NormalizeConfig& config,
+                          const PoseBatch& poses, const FeatureMatrix& out, float aspect) {
+    const size_t n = (poses.num_poses + 3) & ~(size_t) 3;
+    const size_t s = poses.stride;
+    const unsigned int num_joints = skeleton.num_joints;
+    const float* x = poses.x;
+    const float* y = poses.y;
+    const f32x4 asp = set4(aspect);
+    const f32x4 half = set4(0.5f);
+    const f32x4 zero = set4(0.0f);
+    const f32x4 one = set4(1.0f);
+    const f32x4 min_torso = set4(MIN_TORSO_SQ);
+    const f32x4 mirror_sign = set4(config.mirror ? -1.0f : 1.0f);
+    const uint32_t reference = (1u << skeleton.left_hip) | (1u << skeleton.right_hip) |
+                               (1u << skeleton.left_shoulder) | (1u << skeleton.right_shoulder);
+
+    // Per chunk, the transform of every pose first, then joint by joint so each row of the
+    // output is written in one contiguous run even when the stride is large.
+    float hx[NORMALIZE_CHUNK], hy[NORMALIZE_CHUNK], ca[NORMALIZE_CHUNK], cb[NORMALIZE_CHUNK], sign[NORMALIZE_CHUNK];
+    uint32_t masks[NORMALIZE_CHUNK];
+    size_t normalized = 0;
+    for (size_t c = 0; c < n; c += NORMALIZE_CHUNK) {
+        const size_t m = std::min(NORMALIZE_CHUNK, n - c);
+
+        for (size_t i = 0; i < m; i += 4) {
+            const size_t p = c + i;
+            const f32x4 px = mul4(mul4(add4(load4(x + skeleton.left_hip * s + p), load4(x + skeleton.right_hip * s + p)), half), asp);
+            const f32x4 py = mul4(add4(load4(y + skeleton.left_hip * s + p), load4(y + skeleton.right_hip * s + p)), half);
+            const f32x4 sx = mul4(mul4(add4(load4(x + skeleton.left_shoulder * s + p), load4(x + skeleton.right_shoulder * s + p)), half), asp);
+            const f32x4 sy = mul4(add4(load4(y + skeleton.left_shoulder * s + p), load4(y + skeleton.right_shoulder * s + p)), half);
+            const f32x4 tx = sub4(sx, px);
+            const f32x4 ty = sub4(sy, py);
+            const f32x4 torso_sq = madd4(mul4(tx, tx), ty, ty);
+
+            // nx = a * dx + b * dy, ny = a * dy - b * dx: scaling by the torso length and,
+            // when rotating, turning the torso to (0, -1)
+            f32x4 a, b;
+            if (config.rotate) {
+                const f32x4 inv = div4(one, max4(torso_sq, min_torso));
+                a = mul4(sub4(zero, ty), inv);
+                b = mul4(tx, inv);
+            } else {
+                a = div4(one, sqrt4(max4(torso_sq, min_torso)));
+                b = zero;
+            }
+
+            // x sign: flipped for poses seen from the back, and once more when mirroring
+            f32x4 side = one;
+            if (config.face_camera) {
+                const f32x4 ldx = sub4(mul4(load4(x + skeleton.left_shoulder * s + p), asp), px);
+                const f32x4 ldy = sub4(load4(y + skeleton.left_shoulder * s + p), py);
+                const f32x4 rdx = sub4(mul4(load4(x + skeleton.right_shoulder * s + p), asp), px);
+                const f32x4 rdy = sub4(load4(y + skeleton.right_shoulder * s + p), py);
+                side = madd4(mul4(a, sub4(ldx, rdx)), b, sub4(ldy, rdy));
+            }
+            store4(hx + i, px);
+            store4(hy + i, py);
+            store4(ca + i, a);
+            store4(cb + i, b);
+            store4(sign + i, mul4(select4(lt4(side, zero), set4(-1.0f), one), mirror_sign));
+
+            // output masks, 0 for poses that can't be normalized
+            float lane_torso[4];
+            store4(lane_torso, torso_sq);
+            for (size_t l = 0; l < 4; l++) {
+                uint32_t mask = p + l < poses.num_poses ? poses.valid_masks[p + l] : 0;
+                if ((mask & reference) != reference || !(lane_torso[l] >= MIN_TORSO_SQ)) {
+                    mask = 0;
+                } else if (config.mirror) {
+                    uint32_t mirrored = 0;
+                    for (unsigned int j = 0; j < num_joints; j++) {
+                        mirrored |= ((mask >> skeleton.reflected[j]) & 1u) << j;
+                    }
+                    mask = mirrored;
+                }
+                if (p + l < poses.num_poses) {
+                    out.valid_masks[p + l] = mask;
+                    if (mask != 0) normalized++;
+                }
+                masks[i + l] = mask;
+            }
+        }
+
+        for (unsigned int j = 0; j < num_joints; j++) {
+            const size_t src = (config.mirror ? skeleton.reflected[j] : j) * s + c;
+            float* out_x = out.data + (j * 2) * out.stride + c;
+            float* out_y = out.data + (j * 2 + 1) * out.stride + c;
+            for (size_t i = 0; i < m; i += 4) {
+                const f32x4 dx = sub4(mul4(load4(x + src + i), asp), load4(hx + i));
+                const f32x4 dy = sub4(load4(y + src + i), load4(hy + i));
+                const f32x4 a = load4(ca + i), b = load4(cb + i);
+                const f32x4 nx = mul4(madd4(mul4(a, dx), b, dy), load4(sign + i));
+                const f32x4 ny = sub4(mul4(a, dy), mul4(b, dx));
+                const float lane_valid[4] = { (float) ((masks[i] >> j) & 1u), (float) ((masks[i + 1] >> j) & 1u),
+                                              (float) ((masks[i + 2] >> j) & 1u), (float) ((masks[i + 3] >> j) & 1u) };
+                const m32x4 keep = gt4(load4(lane_valid), half);
+                store4(out_x + i, select4(keep, nx, zero));
+                store4(out_y + i, select4(keep, ny, zero));
+            }
+        }
+    }
+    return normalized;
+}
+
+// Records [first, end) of track, TRACK_BLOCK at a time. first is a multiple of 4.
+static size_t normalizeRecords(const PoseTrackReader& track, size_t first, size_t end,
+                               const NormalizerSkeleton& skeleton, const NormalizeConfig& config,
+                               const FeatureMatrix& out, float aspect) {
+    const unsigned int num_joints = track.numJoints();
+    std::vector<float> x(num_joints * TRACK_BLOCK), y(num_joints * TRACK_BLOCK);
+    std::vector<uint32_t> masks(TRACK_BLOCK);
+    size_t normalized = 0;
+    for (size_t b = first; b < end; b += TRACK_BLOCK) {
+        const size_t count = std::min(TRACK_BLOCK, end - b);
+        for (size_t i = 0; i < count; i++) {
+            const PoseTrackRecord* r = track.record(b + i);
+            const float* joints = poseTrackJoints(r);
+            for (unsigned int j = 0; j < num_joints; j++) {
+                x[j * TRACK_BLOCK + i] = joints[j * 2];
+                y[j * TRACK_BLOCK + i] = joints[j * 2 + 1];
+            }
+            masks[i] = r->valid_mask;
+        }
+        // padding poses of the last step must not be garbage the SIMD pass trips over
+        for (size_t i = count; i < ((count + 3) & ~(size_t) 3); i++) {
+            for (unsigned int j = 0; j < num_joints; j++) x[j * TRACK_BLOCK + i] = y[j * TRACK_BLOCK + i] = 0.0f;
+        }
+
+        const PoseBatch batch = { x.data(), y.data(), masks.data(), count, TRACK_BLOCK };
+        const FeatureMatrix block = { out.data + b, out.valid_masks + b, out.stride };
+        normalized += normalizeSkeletons(skeleton, config, batch, block, aspect);
+    }
+    return normalized;
+}
+
+size_t normalizeTrack(const PoseTrackReader& track, const NormalizerSkeleton& skeleton,
+                      const NormalizeConfig& config, const FeatureMatrix& out, float aspect,
+                      unsigned int num_threads) {
+    const size_t total = track.numRecords();
+    // a multiple of 4 records per thread, so no two threads write the same 4 columns
+    const size_t threads = std::max<size_t>(1, std::min<size_t>(num_threads, (total + TRACK_BLOCK - 1) / TRACK_BLOCK));
+    const size_t per_thread = ((total + threads - 1) / threads + 3) & ~(size_t) 3;
+
+    std::vector<size_t> counts(threads, 0);
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) {
+        const size_t first = std::min(t * per_thread, total);
+        const size_t end = std::min(first + per_thread, total);
+        workers.emplace_back([&, t, first, end] {
+            counts[t] = normalizeRecords(track, first, end, skeleton, config, out, aspect);
+        });
+    }
+    counts[0] = normalizeRecords(track, 0, std::min(per_thread, total), skeleton, config, out, aspect);
+    for (std::thread& w : workers) w.join();
+
+    size_t normalized = 0;
+    for (size_t c : counts) normalized += c;
+    return normalized;
+}
@@ -0,0 +1,56 @@
+#ifndef SKELETON_NORMALIZER_H
+#define SKELETON_NORMALIZER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pose-track.h"
+#include "skeleton-kernels.h"
+
+// Normalized joint coordinates as feature vectors, for everything that compares poses
+// independently of where and how large the person is in the image.
+//
+// Each pose is moved so the middle of its hips is the origin and scaled so the torso (hip
+// middle to shoulder middle) has unit length; optionally it is also rotated so the torso
+// points straight up. face_camera flips x of poses seen from the back (left shoulder left of
+// the right one), so they match the same pose seen from the front. mirror swaps left and
+// right (wrJointDefinition_ReflectedIndexOverY) and flips x, so a movement done with the
+// left arm matches one done with the right.
+//
+// Input is a PoseBatch (see skeleton-kernels.h) and the output a feature-major matrix in
+// the same layout: x of joint j at row 2j, y at row 2j + 1, one column per pose. Invalid
+// joints are 0. Poses lacking a hip or shoulder, or with a degenerate torso, are all 0 with
+// a zero mask. Like the other kernels, 4 poses are done per step and padding poses are
+// written too.
+
+struct NormalizeConfig {
+    bool rotate = true;
+    bool face_camera = false;
+    bool mirror = false;
+};
+
+// Joints of the skeleton the normalization refers to.
+struct NormalizerSkeleton {
+    unsigned int num_joints;
+    int left_hip, right_hip;
+    int left_shoulder, right_shoulder;
+    int reflected[32];              // joint mirrored over the vertical axis, itself if none
+};
+
+struct FeatureMatrix {
+    float* data;                    // 2 * num_joints rows of stride
+    uint32_t* valid_masks;          // per pose, after mirroring
+    size_t stride;
+};
+
+// Returns the number of poses that could be normalized.
+size_t normalizeSkeletons(const NormalizerSkeleton& skeleton, const NormalizeConfig& config,
+                          const PoseBatch& poses, const FeatureMatrix& out, float aspect);
+
+// Normalizes every record of a recorded track, column i of out for record i, on up to
+// num_threads threads. out.stride must be at least numRecords() rounded up to 4.
+size_t normalizeTrack(const PoseTrackReader& track, const NormalizerSkeleton& skeleton,
+                      const NormalizeConfig& config, const FeatureMatrix& out, float aspect,
+                      unsigned int num_threads);
+
+#endif // SKELETON_NORMALIZER_H
@@ -0,0 +1,280 @@
+#include "skeleton-raster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include "simd4.h"
+
+static const uint64_t HASH_PRIME = 0x100000001b3ull;
+
+// a * b / 255, rounded
+static inline uint32_t mul255(uint32_t a, uint32_t b) {
+    const uint32_t t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+void rasterCoverageScalar(float ax, float ay, float bx, float by, float inv_len_sq, float radius,
+                          int x, int y, int count, uint8_t* coverage) {
+    const float ex = bx - ax, ey = by - ay;
+    const float dy = (y + 0.5f) - ay;
+    for (int i = 0; i < count; i++) {
+        const float dx = ((float) (x + i) + 0.5f) - ax;
+        const float t = std::min(std::max((dx * ex + dy * ey) * inv_len_sq, 0.0f), 1.0f);
+        const float qx = dx - t * ex, qy = dy - t * ey;
+        const float c = std::min(std::max(radius + 0.5f - std::sqrt(qx * qx + qy * qy), 0.0f), 1.0f);
+        coverage[i] = (uint8_t) (c * 255.0f + 0.5f);
+    }
+}
+
+void rasterCoverage(float ax, float ay, float bx, float by, float inv_len_sq, float radius,
+                    int x, int y, int count, uint8_t* coverage) {
+    const f32x4 ex = set4(bx - ax), ey = set4(by - ay);
+    const f32x4 dy = set4((y + 0.5f) - ay);
+    const f32x4 edy = mul4(dy, ey);
+    const f32x4 inv = set4(inv_len_sq);
+    const f32x4 zero = set4(0.0f), one = set4(1.0f);
+    const f32x4 edge = set4(radius + 0.5f);
+    const f32x4 scale = set4(255.0f), half = set4(0.5f);
+    const f32x4 a = set4(ax);
+    const float first[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
+    f32x4 px = add4(load4(first), set4((float) x));
+    const f32x4 step = set4(4.0f);
+
+    int i = 0;
+    float lanes[4];
+    for (; i < count; i += 4) {
+        const f32x4 dx = sub4(px, a);
+        const f32x4 t = min4(max4(mul4(madd4(edy, dx, ex), inv), zero), one);
+        const f32x4 qx = sub4(dx, mul4(t, ex));
+        const f32x4 qy = sub4(dy, mul4(t, ey));
+        const f32x4 d = sqrt4(madd4(mul4(qx, qx), qy, qy));
+        const f32x4 c = min4(max4(sub4(edge, d), zero), one);
+        store4(lanes, madd4(half, c, scale));
+        const int n = std::min(4, count - i);
+        for (int l = 0; l < n; l++) coverage[i + l] = (uint8_t) lanes[l];
+        px = add4(px, step);
+    }
+}
+
+void rasterBlend(const uint8_t* coverage, uint32_t color, int count, uint8_t* dst) {
+    const uint32_t cr = color & 0xff, cg = (color >> 8) & 0xff, cb = (color >> 16) & 0xff, ca = color >> 24;
+    for (int i = 0; i < count; i++) {
+        const uint32_t c = coverage[i];
+        if (c == 0) continue;
+        uint8_t* p = dst + i * 4;
+        if (c == 255 && ca == 255) {
+            memcpy(p, &color, 4);
+            continue;
+        }
+        const uint32_t sa = mul255(ca, c);
+        const uint32_t keep = 255 - sa;
+        p[0] = (uint8_t) (mul255(cr, c) + mul255(p[0], keep));
+        p[1] = (uint8_t) (mul255(cg, c) + mul255(p[1], keep));
+        p[2] = (uint8_t) (mul255(cb, c) + mul255(p[2], keep));
+        p[3] = (uint8_t) (sa + mul255(p[3], keep));
+    }
+}
+
+static void addShape(float ax, float ay, float bx, float by, float radius, uint32_t color, int width, int height,
+                     std::vector<RasterShape>& shapes) {
+    // far off screen or not a number: nothing to draw, and the bounds below would overflow
+    if (!(std::fabs(ax) < 1e6f && std::fabs(ay) < 1e6f && std::fabs(bx) < 1e6f && std::fabs(by) < 1e6f)) return;
+
+    RasterShape s;
+    s.ax = ax;
+    s.ay = ay;
+    s.bx = bx;
+    s.by = by;
+    const float len_sq = (bx - ax) * (bx - ax) + (by - ay) * (by - ay);
+    s.inv_len_sq = len_sq > 0.0f ? 1.0f / len_sq : 0.0f;
+    s.radius = radius;
+    s.color = color;
+    // one pixel of antialiasing beyond the radius
+    const float reach = radius + 1.0f;
+    s.x0 = std::max((int) std::floor(std::min(ax, bx) - reach), 0);
+    s.y0 = std::max((int) std::floor(std::min(ay, by) - reach), 0);
+    s.x1 = std::min((int) std::ceil(std::max(ax, bx) + reach), width);
+    s.y1 = std::min((int) std::ceil(std::max(ay, by) + reach), height);
+    if (s.x1 <= s.x0 || s.y1 <= s.y0 || !(color >> 24)) return;
+    shapes.push_back(s);
+}
+
+void rasterSkeletons(const float* joints, const uint32_t* valid_masks, size_t num_people, unsigned int num_joints,
+                     const unsigned int* bone_pairs, size_t num_bones, const RasterStyle& style,
+                     const RasterTransform& transform, int width, int height, std::vector<RasterShape>& shapes) {
+    const float joint_radius = style.joint_radius, bone_radius = style.bone_width * 0.5f;
+    for (size_t p = 0; p < num_people; p++) {
+        const float* person = joints + p * num_joints * 2;
+        const uint32_t mask = valid_masks[p];
+        // joints first and bones on top, as the Canvas overlay draws them
+        for (unsigned int j = 0; j < num_joints; j++) {
+            if (!(mask & (1u << j))) continue;
+            const float x = person[j * 2] * transform.scale_x + transform.offset_x;
+            const float y = person[j * 2 + 1] * transform.scale_y + transform.offset_y;
+            addShape(x, y, x, y, joint_radius, style.joint_color, width, height, shapes);
+        }
+        for (size_t b = 0; b < num_bones; b++) {
+            const unsigned int j0 = bone_pairs[b * 2], j1 = bone_pairs[b * 2 + 1];
+            if (j0 >= num_joints || j1 >= num_joints || !(mask & (1u << j0)) || !(mask & (1u << j1))) continue;
+            addShape(person[j0 * 2] * transform.scale_x + transform.offset_x,
+                     person[j0 * 2 + 1] * transform.scale_y + transform.offset_y,
+                     person[j1 * 2] * transform.scale_x + transform.offset_x,
+                     person[j1 * 2 + 1] * transform.scale_y + transform.offset_y,
+                     bone_radius, style.bone_color, width, height, shapes);
+        }
+    }
+}
+
+bool rasterRowSpan(const RasterShape& s, int y, int clip_x0, int clip_x1, int* x0, int* x1) {
+    const float ex = s.bx - s.ax, ey = s.by - s.ay;
+    const float reach = s.radius + 1.0f;
+    const float cy = y + 0.5f;
+    float t0 = 0.0f, t1 = 1.0f;
+    if (ey != 0.0f) {
+        t0 = (cy - reach - s.ay) / ey;
+        t1 = (cy + reach - s.ay) / ey;
+        if (t0 > t1) std::swap(t0, t1);
+        t0 = std::max(t0, 0.0f);
+        t1 = std::min(t1, 1.0f);
+        if (t0 > t1) return false;
+    }
+    const float xa = s.ax + ex * t0, xb = s.ax + ex * t1;
+    *x0 = std::max(clip_x0, (int) std::floor(std::min(xa, xb) - reach));
+    *x1 = std::min(clip_x1, (int) std::ceil(std::max(xa, xb) + reach));
+    return *x1 > *x0;
+}
+
+SkeletonRasterizer::SkeletonRasterizer()
+        : width_(0), height_(0), tiles_x_(0), tiles_y_(0), all_dirty_(true), dirty_bounds_{ 0, 0, 0, 0 } {}
+
+void SkeletonRasterizer::configure(int width, int height, const unsigned int* bone_pairs, size_t num_bones) {
+    width_ = std::max(width, 0);
+    height_ = std::max(height, 0);
+    tiles_x_ = (width_ + TILE - 1) / TILE;
+    tiles_y_ = (height_ + TILE - 1) / TILE;
+    bones_.assign(bone_pairs, bone_pairs + num_bones * 2);
+    frame_hash_.assign(tiles_x_ * tiles_y_, 0);
+    drawn_hash_.assign(tiles_x_ * tiles_y_, 0);
+    tile_start_.assign(tiles_x_ * tiles_y_ + 1, 0);
+    tile_shapes_.clear();
+    shapes_.clear();
+    invalidate();
+}
+
+void SkeletonRasterizer::setStyle(const RasterStyle& style) {
+    style_ = style;
+}
+
+void SkeletonRasterizer::invalidate() {
+    all_dirty_ = true;
+    dirty_bounds_ = { 0, 0, width_, height_ };
+}
+
+void SkeletonRasterizer::beginFrame(const float* joints, const uint32_t* valid_masks, size_t num_people,
+                                    unsigned int num_joints, const RasterTransform& transform) {
+    shapes_.clear();
+    rasterSkeletons(joints, valid_masks, num_people, num_joints, bones_.data(), bones_.size() / 2, style_, transform,
+                    width_, height_, shapes_);
+
+    // per tile, an order dependent hash of the shapes overlapping it and their indices,
+    // bucketed by tile (counted first, then filled in shape order)
+    std::fill(frame_hash_.begin(), frame_hash_.end(), 0);
+    std::fill(tile_start_.begin(), tile_start_.end(), 0);
+    for (const RasterShape& s : shapes_) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        const uint32_t* words = reinterpret_cast<const uint32_t*>(&s);
+        for (size_t w = 0; w < offsetof(RasterShape, x0) / sizeof(uint32_t); w++) {
+            h = (h ^ words[w]) * HASH_PRIME;
+        }
+        for (int ty = s.y0 / TILE; ty <= (s.y1 - 1) / TILE; ty++) {
+            for (int tx = s.x0 / TILE; tx <= (s.x1 - 1) / TILE; tx++) {
+                uint64_t& tile = frame_hash_[ty * tiles_x_ + tx];
+                tile = (tile ^ h) * HASH_PRIME + 1;
+                tile_start_[ty * tiles_x_ + tx + 1]++;
+            }
+        }
+    }
+    for (size_t t = 1; t < tile_start_.size(); t++) {
+        tile_start_[t] += tile_start_[t - 1];
+    }
+    tile_shapes_.resize(tile_start_.back());
+    tile_fill_.assign(tile_start_.begin(), tile_start_.end() - 1);
+    for (size_t i = 0; i < shapes_.size(); i++) {
+        const RasterShape& s = shapes_[i];
+        for (int ty = s.y0 / TILE; ty <= (s.y1 - 1) / TILE; ty++) {
+            for (int tx = s.x0 / TILE; tx <= (s.x1 - 1) / TILE; tx++) {
+                tile_shapes_[tile_fill_[ty * tiles_x_ + tx]++] = (uint32_t) i;
+            }
+        }
+    }
+
+    if (all_dirty_) {
+        dirty_bounds_ = { 0, 0, width_, height_ };
+        return;
+    }
+    int tx0 = tiles_x_, ty0 = tiles_y_, tx1 = 0, ty1 = 0;
+    for (int ty = 0; ty < tiles_y_; ty++) {
+        for (int tx = 0; tx < tiles_x_; tx++) {
+            if (frame_hash_[ty * tiles_x_ + tx] == drawn_hash_[ty * tiles_x_ + tx]) continue;
+            tx0 = std::min(tx0, tx);
+            ty0 = std::min(ty0, ty);
+            tx1 = std::max(tx1, tx + 1);
+            ty1 = std::max(ty1, ty + 1);
+        }
+    }
+    if (tx1 == 0) {
+        dirty_bounds_ = { 0, 0, 0, 0 };
+    } else {
+        dirty_bounds_ = { tx0 * TILE, ty0 * TILE, std::min(tx1 * TILE, width_), std::min(ty1 * TILE, height_) };
+    }
+}
+
+void SkeletonRasterizer::drawTile(uint8_t* rgba, size_t stride, int tx, int ty) const {
+    const int x0 = tx * TILE, y0 = ty * TILE;
+    const int x1 = std::min(x0 + TILE, width_), y1 = std::min(y0 + TILE, height_);
+    for (int y = y0; y < y1; y++) {
+        memset(rgba + y * stride + x0 * 4, 0, (x1 - x0) * 4);
+    }
+
+    uint8_t coverage[TILE];
+    const size_t tile = ty * tiles_x_ + tx;
+    for (uint32_t k = tile_start_[tile]; k < tile_start_[tile + 1]; k++) {
+        const RasterShape& s = shapes_[tile_shapes_[k]];
+        const int sx0 = std::max(s.x0, x0), sx1 = std::min(s.x1, x1);
+        const int sy0 = std::max(s.y0, y0), sy1 = std::min(s.y1, y1);
+        if (sx1 <= sx0 || sy1 <= sy0) continue;
+        for (int y = sy0; y < sy1; y++) {
+            int rx0, rx1;
+            if (!rasterRowSpan(s, y, sx0, sx1, &rx0, &rx1)) continue;
+            rasterCoverage(s.ax, s.ay, s.bx, s.by, s.inv_len_sq, s.radius, rx0, y, rx1 - rx0, coverage);
+            rasterBlend(coverage, s.color, rx1 - rx0, rgba + y * stride + rx0 * 4);
+        }
+    }
+}
+
+size_t SkeletonRasterizer::draw(uint8_t* rgba, size_t stride, const RasterRect* invalid) {
+    int ix0 = 0, iy0 = 0, ix1 = 0, iy1 = 0;
+    if (invalid && !invalid->empty()) {
+        ix0 = std::max(invalid->left, 0) / TILE;
+        iy0 = std::max(invalid->top, 0) / TILE;
+        ix1 = (std::min(invalid->right, width_) + TILE - 1) / TILE;
+        iy1 = (std::min(invalid->bottom, height_) + TILE - 1) / TILE;
+    }
+
+    size_t drawn = 0;
+    for (int ty = 0; ty < tiles_y_; ty++) {
+        for (int tx = 0; tx < tiles_x_; tx++) {
+            const size_t t = ty * tiles_x_ + tx;
+            const bool forced = all_dirty_ || (tx >= ix0 && tx < ix1 && ty >= iy0 && ty < iy1);
+            if (!forced && frame_hash_[t] == drawn_hash_[t]) continue;
+            drawTile(rgba, stride, tx, ty);
+            drawn_hash_[t] = frame_hash_[t];
+            drawn++;
+        }
+    }
+    all_dirty_ = false;
+    dirty_bounds_ = { 0, 0, 0, 0 };
+    return drawn;
+}
@@ -0,0 +1,117 @@
+#ifndef SKELETON_RASTER_H
+#define SKELETON_RASTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Antialiased skeleton overlay drawn straight into an RGBA pixel buffer (premultiplied, R
+// first in memory, the layout of an ARGB_8888 bitmap and of an RGBA_8888 window buffer).
+//
+// Joints are discs and bones capsules of the configured widths; a pixel's coverage is its
+// distance to the shape's edge, so edges get one pixel of antialiasing. The image is split
+// into TILE x TILE tiles and a frame only touches the tiles whose shapes changed: every
+// frame each tile gets a hash of the shapes overlapping it, and tiles whose hash differs
+// from what was last drawn are cleared and redrawn, everything else is left alone. That
+// relies on the buffer still holding the last drawn frame; a caller that can't promise that
+// for some region (a window buffer that was not preserved) passes it to draw() as invalid.
+
+struct RasterStyle {
+    uint32_t joint_color = 0xffff0000;  // premultiplied RGBA as packed in memory, opaque blue
+    uint32_t bone_color = 0xffff0000;
+    float joint_radius = 10.0f;         // pixels
+    float bone_width = 3.0f;
+};
+
+// Pixel rectangle, right and bottom exclusive.
+struct RasterRect {
+    int left, top, right, bottom;
+
+    bool empty() const { return right <= left || bottom <= top; }
+};
+
+// Maps normalized joint coordinates to pixels: x * scale_x + offset_x.
+struct RasterTransform {
+    float scale_x, scale_y;
+    float offset_x, offset_y;
+};
+
+// A disc (a == b) or capsule of a skeleton, with the pixels it covers.
+struct RasterShape {
+    float ax, ay, bx, by;       // segment, a == b for a disc
+    float inv_len_sq;           // 1 / |b - a|^2, 0 for a disc
+    float radius;
+    uint32_t color;
+    int x0, y0, x1, y1;         // covered pixels, clipped to the image
+};
+
+class SkeletonRasterizer {
+public:
+    static const int TILE = 32;
+
+    SkeletonRasterizer();
+
+    // Image size and bones (joint index pairs); the next draw() redraws everything.
+    void configure(int width, int height, const unsigned int* bone_pairs, size_t num_bones);
+    void setStyle(const RasterStyle& style);
+
+    // Sets up a frame of num_people skeletons, num_joints * 2 normalized coordinates each, x,y
+    // interleaved, drawn where their valid mask is set.
+    void beginFrame(const float* joints, const uint32_t* valid_masks, size_t num_people, unsigned int num_joints,
+                    const RasterTransform& transform);
+
+    // Bounding box of the tiles the next draw() changes, empty if none.
+    RasterRect dirtyBounds() const { return dirty_bounds_; }
+
+    // Clears and redraws the changed tiles and every tile overlapping invalid (if not null)
+    // into rgba, whose rows are stride bytes apart. Returns the number of tiles drawn.
+    size_t draw(uint8_t* rgba, size_t stride, const RasterRect* invalid);
+
+    // The buffer no longer holds the last frame; the next draw() redraws everything.
+    void invalidate();
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+private:
+    void drawTile(uint8_t* rgba, size_t stride, int tx, int ty) const;
+
+    int width_;
+    int height_;
+    int tiles_x_;
+    int tiles_y_;
+    std::vector<unsigned int> bones_;
+    RasterStyle style_;
+    std::vector<RasterShape> shapes_;
+    std::vector<uint64_t> frame_hash_;  // per tile, shapes of the frame set up by beginFrame
+    std::vector<uint64_t> drawn_hash_;  // per tile, shapes the buffer holds
+    // shapes overlapping tile t: tile_shapes_[tile_start_[t] .. tile_start_[t + 1])
+    std::vector<uint32_t> tile_start_;
+    std::vector<uint32_t> tile_shapes_;
+    std::vector<uint32_t> tile_fill_;
+    bool all_dirty_;
+    RasterRect dirty_bounds_;
+};
+
+// Appends the joint discs and bone capsules of num_people skeletons (as for beginFrame())
+// that are visible in a width x height image to shapes, in drawing order.
+void rasterSkeletons(const float* joints, const uint32_t* valid_masks, size_t num_people, unsigned int num_joints,
+                     const unsigned int* bone_pairs, size_t num_bones, const RasterStyle& style,
+                     const RasterTransform& transform, int width, int height, std::vector<RasterShape>& shapes);
+
+// Pixels [*x0, *x1) of row y within reach of shape, clipped to [clip_x0, clip_x1); false if
+// there are none. Long diagonal bones only walk the part of their bounding box near the row.
+bool rasterRowSpan(const RasterShape& shape, int y, int clip_x0, int clip_x1, int* x0, int* x1);
+
+// Coverage of shape pixels [x, x + count) of row y as 0..255, scalar reference for the
+// vectorized version draw() uses. Exposed for the benchmark.
+void rasterCoverageScalar(float ax, float ay, float bx, float by, float inv_len_sq, float radius,
+                          int x, int y, int count, uint8_t* coverage);
+void rasterCoverage(float ax, float ay, float bx, float by, float inv_len_sq, float radius,
+                    int x, int y, int count, uint8_t* coverage);
+
+// Blends color (premultiplied RGBA as packed in memory) over count pixels of dst with the
+// given coverage.
+void rasterBlend(const uint8_t* coverage, uint32_t color, int count, uint8_t* dst);
+
+#endif // SKELETON_RASTER_H
@@ -0,0 +1,66 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free bounded single producer / single consumer FIFO.
+//
+// A ring of Capacity slots (a power of two) with a free running head and tail: the producer
+// only writes tail_, the consumer only head_, so neither ever waits for the other. When the
+// ring is full the newest item is dropped and counted, so a consumer that stalls costs the
+// producer nothing but the events it did not pick up.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : head_(0), tail_(0), dropped_(0) {}
+
+    // Producer side. False if the queue was full and item was dropped.
+    bool push(const T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: moves up to max items to out, oldest first.
+    size_t pop(T* out, size_t max) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t available = tail_.load(std::memory_order_acquire) - head;
+        const size_t n = available < max ? available : max;
+        for (size_t i = 0; i < n; i++) {
+            out[i] = items_[(head + i) & (Capacity - 1)];
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Items pushed and not popped yet; exact only from one of the two sides.
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Only while neither side is active.
+    void reset() {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+        dropped_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    T items_[Capacity];
+    std::atomic<size_t> head_;      // written by the consumer only
+    std::atomic<size_t> tail_;      // written by the producer only
+    std::atomic<uint64_t> dropped_;
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,101 @@
+#ifndef STAGE_WORKER_H
+#define STAGE_WORKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// Runs a pipeline stage on its own thread, fed through a single pending-job slot.
+//
+// submit() never waits for the stage: it copies the job into the slot, replacing (and
+// counting as dropped) a job the worker has not picked up yet. The worker swaps the slot
+// with its own job object, so with a Job that keeps its buffers (vectors assigned in place)
+// the steady state does not allocate.
+template <typename Job>
+class StageWorker {
+public:
+    using Handler = std::function<void(Job&)>;
+
+    StageWorker() : running_(false), pending_(false), submitted_(0), dropped_(0) {}
+
+    ~StageWorker() {
+        stop();
+    }
+
+    void start(Handler handler) {
+        stop();
+        {
+            // the frame thread reads running_ under the lock in isRunning() and submit()
+            std::lock_guard<std::mutex> lock(mutex_);
+            handler_ = std::move(handler);
+            running_ = true;
+        }
+        thread_ = std::thread(&StageWorker::run, this);
+    }
+
+    // Lets the job in flight finish, discards a pending one.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            running_ = false;
+            pending_ = false;
+        }
+        cond_.notify_one();
+        thread_.join();
+    }
+
+    bool isRunning() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return running_;
+    }
+
+    // fill(job) writes the new job into the pending slot under the lock.
+    template <typename Fill>
+    void submit(Fill fill) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            if (pending_) dropped_++;
+            fill(next_);
+            pending_ = true;
+            submitted_++;
+        }
+        cond_.notify_one();
+    }
+
+    long submitted() const { return submitted_; }
+    long dropped() const { return dropped_; }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cond_.wait(lock, [this] { return pending_ || !running_; });
+            if (!running_) break;
+
+            std::swap(next_, current_);
+            pending_ = false;
+
+            lock.unlock();
+            handler_(current_);
+            lock.lock();
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::thread thread_;
+    Handler handler_;
+    bool running_;
+    bool pending_;
+    Job next_;
+    Job current_;
+    std::atomic<long> submitted_;
+    std::atomic<long> dropped_;
+};
+
+#endif // STAGE_WORKER_H
@@ -0,0 +1,274 @@
+#include "video-annotator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// a * b / 255, rounded
+static inline uint32_t mul255(uint32_t a, uint32_t b) {
+    const uint32_t t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static inline uint8_t lerp255(uint32_t d, uint32_t p, uint32_t a) {
+    const uint32_t t = d * (255 - a) + p * a + 128;
+    return (uint8_t) ((t + (t >> 8)) >> 8);
+}
+
+void videoBlendScalar(const uint8_t* alpha, const uint8_t* pattern, size_t count, uint8_t* dst) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = lerp255(dst[i], pattern[i & 15], alpha[i]);
+    }
+}
+
+void videoBlend(const uint8_t* alpha, const uint8_t* pattern, size_t count, uint8_t* dst) {
+    size_t i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint8x16_t p = vld1q_u8(pattern);
+    const uint8x8_t p_lo = vget_low_u8(p), p_hi = vget_high_u8(p);
+    const uint8x16_t full = vdupq_n_u8(255);
+    const uint16x8_t round = vdupq_n_u16(128);
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t d = vld1q_u8(dst + i);
+        const uint8x16_t a = vld1q_u8(alpha + i);
+        const uint8x16_t keep = vsubq_u8(full, a);
+        uint16x8_t lo = vmull_u8(vget_low_u8(d), vget_low_u8(keep));
+        uint16x8_t hi = vmull_u8(vget_high_u8(d), vget_high_u8(keep));
+        lo = vaddq_u16(vmlal_u8(lo, p_lo, vget_low_u8(a)), round);
+        hi = vaddq_u16(vmlal_u8(hi, p_hi, vget_high_u8(a)), round);
+        const uint8x8_t r_lo = vshrn_n_u16(vaddq_u16(lo, vshrq_n_u16(lo, 8)), 8);
+        const uint8x8_t r_hi = vshrn_n_u16(vaddq_u16(hi, vshrq_n_u16(hi, 8)), 8);
+        vst1q_u8(dst + i, vcombine_u8(r_lo, r_hi));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+    const __m128i p_lo = _mm_unpacklo_epi8(p, zero), p_hi = _mm_unpackhi_epi8(p, zero);
+    const __m128i full = _mm_set1_epi16(255), round = _mm_set1_epi16(128);
+    for (; i + 16 <= count; i += 16) {
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha + i));
+        const __m128i a_lo = _mm_unpacklo_epi8(a, zero), a_hi = _mm_unpackhi_epi8(a, zero);
+        // at most 255 * 255 + 128 + 255, so 16 bit lanes hold it unsigned
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, a_lo)),
+                                   _mm_mullo_epi16(p_lo, a_lo));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, a_hi)),
+                                   _mm_mullo_epi16(p_hi, a_hi));
+        lo = _mm_add_epi16(lo, round);
+        hi = _mm_add_epi16(hi, round);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = lerp255(dst[i], pattern[i & 15], alpha[i]);
+    }
+}
+
+// Buffers of one annotate() call; a few allocations per frame, nothing next to its pixels.
+struct BlendScratch {
+    std::vector<uint8_t> coverage;
+    std::vector<uint8_t> alpha;
+    std::vector<RasterShape> shapes;
+    std::vector<float> joints;
+    std::vector<uint32_t> masks;
+};
+
+// Blends shapes into a plane of channels bytes per pixel: bone or joint color, and
+// pick(color) its channels bytes of this plane.
+template <typename Pick>
+static void blendShapes(const std::vector<RasterShape>& shapes, int width, uint8_t* plane, size_t stride, int channels,
+                        uint32_t joint_packed, const VideoColor& joint, const VideoColor& bone, Pick pick,
+                        BlendScratch& scratch) {
+    scratch.coverage.resize(width);
+    scratch.alpha.resize(width * channels);
+    uint8_t* coverage = scratch.coverage.data();
+    uint8_t* alpha = scratch.alpha.data();
+    uint8_t pattern[16];
+    for (const RasterShape& s : shapes) {
+        const VideoColor& color = s.color == joint_packed ? joint : bone;
+        const uint8_t* values = pick(color);
+        for (int i = 0; i < 16; i++) pattern[i] = values[i % channels];
+        for (int y = s.y0; y < s.y1; y++) {
+            int x0, x1;
+            if (!rasterRowSpan(s, y, s.x0, s.x1, &x0, &x1)) continue;
+            const int n = x1 - x0;
+            rasterCoverage(s.ax, s.ay, s.bx, s.by, s.inv_len_sq, s.radius, x0, y, n, coverage);
+            for (int i = 0; i < n; i++) {
+                const uint8_t a = (uint8_t) mul255(coverage[i], color.alpha);
+                for (int c = 0; c < channels; c++) alpha[i * channels + c] = a;
+            }
+            videoBlend(alpha, pattern, (size_t) n * channels, plane + y * stride + (size_t) x0 * channels);
+        }
+    }
+}
+
+VideoAnnotator::VideoAnnotator(const PoseTrackReader& track) : track_(track) {
+    updateColors();
+}
+
+void VideoAnnotator::configure(const AnnotateConfig& config) {
+    config_ = config;
+    updateColors();
+}
+
+void VideoAnnotator::setStyle(const RasterStyle& style) {
+    style_ = style;
+    updateColors();
+}
+
+void VideoAnnotator::updateColors() {
+    const bool bt709 = config_.color_matrix == VIDEO_BT709;
+    const float kr = bt709 ? 0.2126f : 0.299f, kb = bt709 ? 0.0722f : 0.114f;
+    VideoColor* colors[2] = { &joint_, &bone_ };
+    const uint32_t packed[2] = { style_.joint_color, style_.bone_color };
+    for (int k = 0; k < 2; k++) {
+        VideoColor& c = *colors[k];
+        const uint32_t a = packed[k] >> 24;
+        float rgb[3];
+        for (int ch = 0; ch < 3; ch++) {
+            const uint32_t premultiplied = (packed[k] >> (ch * 8)) & 0xff;
+            const uint32_t straight = a ? std::min<uint32_t>((premultiplied * 255 + a / 2) / a, 255) : 0;
+            c.rgba[ch] = (uint8_t) straight;
+            rgb[ch] = straight / 255.0f;
+        }
+        c.rgba[3] = 255;
+        c.alpha = (uint8_t) a;
+        const float luma = kr * rgb[0] + (1.0f - kr - kb) * rgb[1] + kb * rgb[2];
+        const float cb = (rgb[2] - luma) / (2.0f * (1.0f - kb)), cr = (rgb[0] - luma) / (2.0f * (1.0f - kr));
+        c.yuv[0] = (uint8_t) std::lround(16.0f + 219.0f * luma);
+        c.yuv[1] = (uint8_t) std::lround(128.0f + 224.0f * cb);
+        c.yuv[2] = (uint8_t) std::lround(128.0f + 224.0f * cr);
+        c.vu[0] = c.yuv[2];
+        c.vu[1] = c.yuv[1];
+    }
+}
+
+size_t VideoAnnotator::annotate(VideoFrame& frame) const {
+    if (!track_.isOpen() || frame.width <= 0 || frame.height <= 0) return 0;
+    const int64_t t = frame.timestamp_us + config_.offset_us;
+    const long f = track_.findFrame(t);
+    if (f < 0) return 0;
+    const PoseTrackReader::Frame poses = track_.frame(f);
+    if (t - poses.timestamp_us > config_.max_pose_age_us) return 0;
+
+    BlendScratch scratch;
+    const unsigned int num_joints = track_.numJoints();
+    const size_t record_size = poseTrackRecordSize(num_joints);
+    scratch.joints.clear();
+    scratch.masks.clear();
+    for (size_t r = 0; r < poses.count; r++) {
+        const PoseTrackRecord* record = reinterpret_cast<const PoseTrackRecord*>(
+                reinterpret_cast<const char*>(poses.first) + r * record_size);
+        if (config_.main_only && !(record->flags & POSE_TRACK_FLAG_MAIN)) continue;
+        const float* joints = poseTrackJoints(record);
+        scratch.joints.insert(scratch.joints.end(), joints, joints + num_joints * 2);
+        scratch.masks.push_back(record->valid_mask);
+    }
+    const size_t num_people = scratch.masks.size();
+    if (!num_people) return 0;
+
+    const int width = frame.width, height = frame.height;
+    const RasterTransform full = { (float) width, (float) height, 0.0f, 0.0f };
+    scratch.shapes.clear();
+    rasterSkeletons(scratch.joints.data(), scratch.masks.data(), num_people, num_joints, track_.bonePairs(),
+                    track_.numBones(), style_, full, width, height, scratch.shapes);
+
+    const uint32_t joint_packed = style_.joint_color;
+    if (frame.format == VIDEO_FRAME_RGBA) {
+        blendShapes(scratch.shapes, width, frame.planes[0], frame.strides[0], 4, joint_packed, joint_, bone_,
+                    [](const VideoColor& c) { return c.rgba; }, scratch);
+        return num_people;
+    }
+    blendShapes(scratch.shapes, width, frame.planes[0], frame.strides[0], 1, joint_packed, joint_, bone_,
+                [](const VideoColor& c) { return c.yuv; }, scratch);
+
+    // the same shapes at chroma resolution
+    const int chroma_width = (width + 1) / 2, chroma_height = (height + 1) / 2;
+    const RasterTransform half = { width * 0.5f, height * 0.5f, 0.0f, 0.0f };
+    RasterStyle chroma_style = style_;
+    chroma_style.joint_radius *= 0.5f;
+    chroma_style.bone_width *= 0.5f;
+    scratch.shapes.clear();
+    rasterSkeletons(scratch.joints.data(), scratch.masks.data(), num_people, num_joints, track_.bonePairs(),
+                    track_.numBones(), chroma_style, half, chroma_width, chroma_height, scratch.shapes);
+
+    uint8_t* u = frame.planes[1];
+    uint8_t* v = frame.planes[2];
+    if (frame.chroma_step == 1) {
+        blendShapes(scratch.shapes, chroma_width, u, frame.strides[1], 1, joint_packed, joint_, bone_,
+                    [](const VideoColor& c) { return c.yuv + 1; }, scratch);
+        blendShapes(scratch.shapes, chroma_width, v, frame.strides[2], 1, joint_packed, joint_, bone_,
+                    [](const VideoColor& c) { return c.yuv + 2; }, scratch);
+    } else if (frame.chroma_step == 2 && v == u + 1) {
+        // NV12, one plane blended as pixels of two channels
+        blendShapes(scratch.shapes, chroma_width, u, frame.strides[1], 2, joint_packed, joint_, bone_,
+                    [](const VideoColor& c) { return c.yuv + 1; }, scratch);
+    } else if (frame.chroma_step == 2 && u == v + 1) {
+        blendShapes(scratch.shapes, chroma_width, v, frame.strides[2], 2, joint_packed, joint_, bone_,
+                    [](const VideoColor& c) { return c.vu; }, scratch);
+    } else {
+        // any other layout, sample by sample
+        const int step = std::max(frame.chroma_step, 1);
+        scratch.coverage.resize(chroma_width);
+        uint8_t* coverage = scratch.coverage.data();
+        for (const RasterShape& s : scratch.shapes) {
+            const VideoColor& c = s.color == joint_packed ? joint_ : bone_;
+            for (int y = s.y0; y < s.y1; y++) {
+                int x0, x1;
+                if (!rasterRowSpan(s, y, s.x0, s.x1, &x0, &x1)) continue;
+                rasterCoverage(s.ax, s.ay, s.bx, s.by, s.inv_len_sq, s.radius, x0, y, x1 - x0, coverage);
+                uint8_t* u_row = u + y * frame.strides[1] + (size_t) x0 * step;
+                uint8_t* v_row = v + y * frame.strides[2] + (size_t) x0 * step;
+                for (int i = 0; i < x1 - x0; i++) {
+                    const uint32_t a = mul255(coverage[i], c.alpha);
+                    u_row[i * step] = lerp255(u_row[i * step], c.yuv[1], a);
+                    v_row[i * step] = lerp255(v_row[i * step], c.yuv[2], a);
+                }
+            }
+        }
+    }
+    return num_people;
+}
+
+void annotateFrames(const VideoAnnotator& annotator, VideoFrame* frames, size_t count, unsigned int num_threads,
+                    const std::function<void(const VideoFrame&)>& sink) {
+    const size_t threads = std::max<size_t>(1, std::min<size_t>(num_threads, count));
+    std::atomic<size_t> next(0);
+    std::vector<char> done(count, 0);
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                annotator.annotate(frames[i]);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done[i] = 1;
+                }
+                finished.notify_one();
+            }
+        });
+    }
+    for (size_t i = 0; i < count; i++) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&]() { return done[i] != 0; });
+        }
+        if (sink) sink(frames[i]);
+    }
+    for (std::thread& w : workers) w.join();
+}
@@ -0,0 +1,96 @@
+#ifndef VIDEO_ANNOTATOR_H
+#define VIDEO_ANNOTATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "pose-track.h"
+#include "skeleton-raster.h"
+
+// Burns the skeletons of a recorded pose track into decoded video frames, for exporting
+// annotated clips.
+//
+// A frame gets the people of the last track frame at or before its timestamp, unless that
+// is older than max_pose_age_us, drawn in the overlay's style straight into its planes:
+// RGBA frames, or YUV 4:2:0 frames with planar (I420, YV12) or interleaved (NV12, NV21)
+// chroma. Shapes are those of the overlay rasterizer with its coverage kernel; in YUV the
+// luma plane gets coverage at full resolution and the chroma planes coverage of the shapes
+// at half scale (chroma sited at the center of its 2x2 luma block), so edges stay
+// antialiased in both. Pixels are blended towards the color, converted to video range YUV
+// once, with a vectorized lerp.
+//
+// annotate() only reads the track and the annotator, so any number of threads may
+// annotate frames at once; annotateFrames() spreads a batch over threads and hands the
+// frames on in order.
+
+enum VideoFrameFormat {
+    VIDEO_FRAME_YUV420 = 0,
+    VIDEO_FRAME_RGBA = 1,
+};
+
+enum VideoColorMatrix {
+    VIDEO_BT601 = 0,
+    VIDEO_BT709 = 1,
+};
+
+struct VideoFrame {
+    int format;                 // VideoFrameFormat
+    int width, height;
+    // YUV420: Y, U and V, chroma samples chroma_step bytes apart within a row (1 planar,
+    // 2 interleaved). RGBA: planes[0] only.
+    uint8_t* planes[3];
+    size_t strides[3];
+    int chroma_step;
+    int64_t timestamp_us;
+};
+
+struct AnnotateConfig {
+    bool main_only = false;             // only the person flagged main
+    int64_t offset_us = 0;              // track time of frame timestamp 0
+    int64_t max_pose_age_us = 200000;   // older track frames are not drawn
+    int color_matrix = VIDEO_BT601;     // VideoColorMatrix of YUV frames
+};
+
+// A style color as the bytes pixels are blended towards.
+struct VideoColor {
+    uint8_t rgba[4];            // straight alpha, opaque
+    uint8_t yuv[3];
+    uint8_t vu[2];              // chroma in NV21 order
+    uint8_t alpha;
+};
+
+class VideoAnnotator {
+public:
+    // The track must stay open while the annotator is used.
+    explicit VideoAnnotator(const PoseTrackReader& track);
+
+    // Not while annotate() runs.
+    void configure(const AnnotateConfig& config);
+    void setStyle(const RasterStyle& style);
+
+    // Draws the people of the track at the frame's timestamp into it; returns how many.
+    size_t annotate(VideoFrame& frame) const;
+
+private:
+    void updateColors();
+
+    const PoseTrackReader& track_;
+    AnnotateConfig config_;
+    RasterStyle style_;
+    VideoColor joint_;
+    VideoColor bone_;
+};
+
+// Annotates frames[0 .. count) on num_threads worker threads while the calling thread
+// passes each finished frame to sink (if any) in order, so writing overlaps annotating.
+void annotateFrames(const VideoAnnotator& annotator, VideoFrame* frames, size_t count, unsigned int num_threads,
+                    const std::function<void(const VideoFrame&)>& sink);
+
+// dst[i] += (pattern[i % 16] - dst[i]) * alpha[i] / 255, rounded, over count bytes: the
+// blend of one row span, pattern holding the channel values of consecutive pixels. Scalar
+// reference for the vectorized version annotate() uses; exposed for the benchmark.
+void videoBlendScalar(const uint8_t* alpha, const uint8_t* pattern, size_t count, uint8_t* dst);
+void videoBlend(const uint8_t* alpha, const uint8_t* pattern, size_t count, uint8_t* dst);
+
+#endif // VIDEO_ANNOTATOR_H
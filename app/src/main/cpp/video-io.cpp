@@ -0,0 +1,203 @@
+#include "video-io.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static const size_t IO_BUFFER_SIZE = 1 << 20;
+
+static FILE* openStream(const char* path, bool write) {
+    if (strcmp(path, "-") == 0) return write ? stdout : stdin;
+    FILE* file = fopen(path, write ? "wb" : "rb");
+    if (file) setvbuf(file, nullptr, _IOFBF, IO_BUFFER_SIZE);
+    return file;
+}
+
+static bool closeStream(FILE* file) {
+    if (file == stdin) return true;
+    if (file == stdout) return fflush(file) == 0;
+    return fclose(file) == 0;
+}
+
+// Reads up to and excluding the next newline; false at the end of the stream or on a line
+// longer than max - 1.
+static bool readLine(FILE* file, char* line, size_t max) {
+    size_t n = 0;
+    for (int c = fgetc(file); c != '\n'; c = fgetc(file)) {
+        if (c == EOF || n + 1 >= max) return false;
+        line[n++] = (char) c;
+    }
+    line[n] = 0;
+    return true;
+}
+
+Y4mReader::Y4mReader() : file_(nullptr), width_(0), height_(0), fps_num_(30), fps_den_(1), frames_read_(0) {}
+
+Y4mReader::~Y4mReader() {
+    close();
+}
+
+bool Y4mReader::open(const char* path) {
+    close();
+    file_ = openStream(path, false);
+    if (!file_) return false;
+
+    char header[512];
+    if (!readLine(file_, header, sizeof(header)) || strncmp(header, "YUV4MPEG2 ", 10) != 0) {
+        close();
+        return false;
+    }
+    width_ = height_ = 0;
+    fps_num_ = 30;
+    fps_den_ = 1;
+    frames_read_ = 0;
+    bool is_420 = true;
+    for (char* token = strtok(header + 10, " "); token; token = strtok(nullptr, " ")) {
+        switch (token[0]) {
+            case 'W': width_ = atoi(token + 1); break;
+            case 'H': height_ = atoi(token + 1); break;
+            case 'F': {
+                int num = 0, den = 0;
+                if (sscanf(token + 1, "%d:%d", &num, &den) == 2 && num > 0 && den > 0) {
+                    fps_num_ = num;
+                    fps_den_ = den;
+                }
+                break;
+            }
+            // 8 bit 4:2:0 only; these differ in chroma siting, while 420p10 and the like
+            // take two bytes per sample
+            case 'C':
+                is_420 = strcmp(token + 1, "420") == 0 || strcmp(token + 1, "420jpeg") == 0 ||
+                         strcmp(token + 1, "420mpeg2") == 0 || strcmp(token + 1, "420paldv") == 0;
+                break;
+            default: break;
+        }
+    }
+    if (width_ <= 0 || height_ <= 0 || !is_420) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void Y4mReader::close() {
+    if (file_) closeStream(file_);
+    file_ = nullptr;
+}
+
+size_t Y4mReader::frameSize() const {
+    const size_t chroma = (size_t) ((width_ + 1) / 2) * ((height_ + 1) / 2);
+    return (size_t) width_ * height_ + chroma * 2;
+}
+
+bool Y4mReader::read(uint8_t* data, VideoFrame* frame) {
+    if (!file_) return false;
+    char line[256];
+    if (!readLine(file_, line, sizeof(line)) || strncmp(line, "FRAME", 5) != 0) return false;
+    if (fread(data, frameSize(), 1, file_) != 1) return false;
+
+    const size_t luma = (size_t) width_ * height_;
+    const size_t chroma = (size_t) ((width_ + 1) / 2) * ((height_ + 1) / 2);
+    frame->format = VIDEO_FRAME_YUV420;
+    frame->width = width_;
+    frame->height = height_;
+    frame->planes[0] = data;
+    frame->planes[1] = data + luma;
+    frame->planes[2] = data + luma + chroma;
+    frame->strides[0] = width_;
+    frame->strides[1] = frame->strides[2] = (width_ + 1) / 2;
+    frame->chroma_step = 1;
+    frame->timestamp_us = frames_read_ * 1000000 * fps_den_ / fps_num_;
+    frames_read_++;
+    return true;
+}
+
+Y4mWriter::Y4mWriter() : file_(nullptr), width_(0), height_(0) {}
+
+Y4mWriter::~Y4mWriter() {
+    close();
+}
+
+bool Y4mWriter::open(const char* path, int width, int height, int fps_num, int fps_den) {
+    close();
+    if (width <= 0 || height <= 0 || fps_num <= 0 || fps_den <= 0) return false;
+    file_ = openStream(path, true);
+    if (!file_) return false;
+    width_ = width;
+    height_ = height;
+    row_.resize((width + 1) / 2);
+    // C420jpeg: chroma sited at the center of its 2x2 luma block, as the annotator draws it
+    if (fprintf(file_, "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C420jpeg\n", width, height, fps_num, fps_den) < 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool Y4mWriter::write(const VideoFrame& frame) {
+    if (!file_ || frame.format != VIDEO_FRAME_YUV420 || frame.width != width_ || frame.height != height_) {
+        return false;
+    }
+    if (fputs("FRAME\n", file_) < 0) return false;
+    for (int y = 0; y < height_; y++) {
+        if (fwrite(frame.planes[0] + y * frame.strides[0], width_, 1, file_) != 1) return false;
+    }
+    const int chroma_width = (width_ + 1) / 2, chroma_height = (height_ + 1) / 2;
+    for (int p = 1; p <= 2; p++) {
+        for (int y = 0; y < chroma_height; y++) {
+            const uint8_t* src = frame.planes[p] + y * frame.strides[p];
+            if (frame.chroma_step != 1) {
+                for (int x = 0; x < chroma_width; x++) row_[x] = src[x * frame.chroma_step];
+                src = row_.data();
+            }
+            if (fwrite(src, chroma_width, 1, file_) != 1) return false;
+        }
+    }
+    return true;
+}
+
+bool Y4mWriter::close() {
+    if (!file_) return true;
+    const bool ok = closeStream(file_);
+    file_ = nullptr;
+    return ok;
+}
+
+RgbWriter::RgbWriter() : file_(nullptr), width_(0), height_(0) {}
+
+RgbWriter::~RgbWriter() {
+    close();
+}
+
+bool RgbWriter::open(const char* path, int width, int height) {
+    close();
+    if (width <= 0 || height <= 0) return false;
+    file_ = openStream(path, true);
+    if (!file_) return false;
+    width_ = width;
+    height_ = height;
+    row_.resize((size_t) width * 3);
+    return true;
+}
+
+bool RgbWriter::write(const VideoFrame& frame) {
+    if (!file_ || frame.format != VIDEO_FRAME_RGBA || frame.width != width_ || frame.height != height_) {
+        return false;
+    }
+    for (int y = 0; y < height_; y++) {
+        const uint8_t* src = frame.planes[0] + y * frame.strides[0];
+        for (int x = 0; x < width_; x++) {
+            row_[x * 3] = src[x * 4];
+            row_[x * 3 + 1] = src[x * 4 + 1];
+            row_[x * 3 + 2] = src[x * 4 + 2];
+        }
+        if (fwrite(row_.data(), row_.size(), 1, file_) != 1) return false;
+    }
+    return true;
+}
+
+bool RgbWriter::close() {
+    if (!file_) return true;
+    const bool ok = closeStream(file_);
+    file_ = nullptr;
+    return ok;
+}
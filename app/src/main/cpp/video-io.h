@@ -0,0 +1,75 @@
+#ifndef VIDEO_IO_H
+#define VIDEO_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "video-annotator.h"
+
+// Raw video streams for batch export: YUV4MPEG2 (.y4m, 4:2:0 only), which ffmpeg and most
+// encoders read and write, and headerless packed RGB for tools that take raw frames.
+
+class Y4mReader {
+public:
+    Y4mReader();
+    ~Y4mReader();
+
+    // "-" reads stdin.
+    bool open(const char* path);
+    void close();
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int fpsNum() const { return fps_num_; }
+    int fpsDen() const { return fps_den_; }
+    // Bytes of one I420 frame.
+    size_t frameSize() const;
+
+    // Reads the next frame into data (frameSize() bytes) and sets frame up as I420 over it,
+    // timestamped from its index and the frame rate. False at the end of the stream.
+    bool read(uint8_t* data, VideoFrame* frame);
+
+private:
+    FILE* file_;
+    int width_, height_;
+    int fps_num_, fps_den_;
+    int64_t frames_read_;
+};
+
+class Y4mWriter {
+public:
+    Y4mWriter();
+    ~Y4mWriter();
+
+    // "-" writes stdout.
+    bool open(const char* path, int width, int height, int fps_num, int fps_den);
+    // YUV420 frames of the opened size, planar or interleaved chroma.
+    bool write(const VideoFrame& frame);
+    bool close();
+
+private:
+    FILE* file_;
+    int width_, height_;
+    std::vector<uint8_t> row_;
+};
+
+class RgbWriter {
+public:
+    RgbWriter();
+    ~RgbWriter();
+
+    // "-" writes stdout. Frames are width * height * 3 bytes, R first.
+    bool open(const char* path, int width, int height);
+    // RGBA frames of the opened size.
+    bool write(const VideoFrame& frame);
+    bool close();
+
+private:
+    FILE* file_;
+    int width_, height_;
+    std::vector<uint8_t> row_;
+};
+
+#endif // VIDEO_IO_H
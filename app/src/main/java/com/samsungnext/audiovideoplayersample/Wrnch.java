@@ -2,15 +2,20 @@ package com.samsungnext.audiovideoplayersample;
 
 import android.content.Context;
 import android.content.res.AssetManager;
+import android.graphics.Bitmap;
 import android.graphics.Point;
+import android.graphics.Rect;
 import android.util.Log;
 import android.util.Pair;
+import android.view.Surface;
 
 import java.io.File;
 import java.io.FileOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.util.Arrays;
 
 public class Wrnch {
     private static final boolean DEBUG = false;
@@ -20,7 +25,191 @@ public class Wrnch {
     }
 
     static native int[] initWrnchJNI(String dir);
-    static native float[] processWrnchJNI(byte[] pic, int cols, int rows);
+    static native float[] processWrnchJNI(byte[] pic, int cols, int rows, long timestampUs);
+    static native void setJointScoreThresholdJNI(float threshold);
+    static native void setSmoothingJNI(int mode);
+    static native void setGapFillingJNI(boolean enabled, int interpolation, int delayFrames,
+                                        int lookBackFrames, float maxGapMs);
+    static native boolean setPredictionJNI(boolean enabled, int model, float processNoise, float measurementNoise);
+    static native float[] predictPoseJNI(long timeUs);
+    static native boolean samplePoseJNI(long timeUs, long maxExtrapolationUs, float[] out);
+    static native int getJointIndexJNI(String name);
+    static native boolean setFeatureExtractionJNI(boolean enabled, boolean rotate, boolean faceCamera, boolean mirror);
+    static native int getFrameFeaturesJNI(float[] data, int[] ids, int[] masks);
+    static native boolean configureRepCounterJNI(int[] angles, int combine, boolean restHigh,
+                                                 float minAmplitudeDeg, float minPeriodS, float maxPeriodS);
+    static native int drainRepEventsJNI(long[] startUs, long[] endUs, float[] confidence);
+    static native int getRepCountJNI();
+    static native boolean configureMotionEventsJNI(boolean enabled, float spikeSpeed, float impactAccel,
+            float fallSpeed, float fallDrop, float release, float fallRelease, float refractoryS);
+    static native int drainMotionEventsJNI(int[] types, int[] ids, int[] joints, long[] timestampsUs, float[] values);
+    static native long getDroppedMotionEventsJNI();
+    static native boolean setPoseIndexJNI(String path);
+    static native String[] getPoseIndexLabelsJNI();
+    static native int getPoseMatchesJNI(int[] labels, int[] ids, float[] distances);
+    static native boolean configureDtwJNI(int[] angles, int band, float pruneRatio);
+    static native int addDtwTemplateJNI(float[] features, int frames, float fps);
+    static native void startDtwJNI();
+    static native int getDtwScoresJNI(float[] out);
+    static native int computeSkeletonFeaturesJNI(int id, int count, int[] angles,
+            float[] boneLengths, float[] angleOut, int[] masks);
+    static native boolean setJointFilterParamsJNI(float[] minCutoff, float[] beta, float dCutoff);
+    static native int getPoseWindowByTimeJNI(int id, long fromUs, long toUs,
+            long[] timestamps, float[] joints, float[] scores, float[] boxes, int[] masks);
+    static native int getPoseWindowByCountJNI(int id, int count,
+            long[] timestamps, float[] joints, float[] scores, float[] boxes, int[] masks);
+    static native int getTrackIdsJNI(int[] ids);
+    static native boolean startRecordingJNI(String path);
+    static native boolean stopRecordingJNI();
+    static native int openReplayJNI(String path);
+    static native float[] replayFrameJNI(long timestampUs);
+    static native void closeReplayJNI();
+    static native int[] getOutputLayoutJNI();
+    static native void setFaceEnabledJNI(boolean enabled);
+    static native float[] getProcessTimingJNI();
+    static native void recordStageLatencyJNI(int stage, long nanos);
+    static native float[] getStatsJNI();
+    static native void resetStatsJNI();
+    static native void setNativeTrackingJNI(boolean enabled);
+    static native float[] getTrackerTimingJNI();
+    static native boolean set3dEnabledJNI(boolean enabled, boolean useIk, int stride);
+    static native float[] get3dPosesJNI(long[] timestampOut);
+    static native float[] get3dTimingJNI();
+    static native boolean setActivityEnabledJNI(boolean enabled, String modelPath, int stride);
+    static native float[] getActivityJNI(long[] timestampOut);
+    static native String[] getActivityClassesJNI();
+    static native float[] getActivityTimingJNI();
+    static native boolean setMaskEnabledJNI(boolean enabled);
+    static native int[] getMaskDimsJNI();
+    static native ByteBuffer getMaskViewJNI();
+    static native boolean renderMaskOverlayJNI(ByteBuffer rgba, int width, int height, int stride, int threshold, int color);
+    static native void setSkeletonOverlayJNI(boolean enabled, int jointColor, int boneColor, float jointRadius, float boneWidth);
+    static native int renderSkeletonOverlayJNI(Bitmap bitmap, float left, float top, float scaleX, float scaleY);
+    static native boolean setOverlaySurfaceJNI(Surface surface, int width, int height);
+    static native int renderSkeletonOverlayToSurfaceJNI(float left, float top, float scaleX, float scaleY);
+
+    private static int numJoints = 0;
+    private static int numFaceLandmarks = 0;
+
+    /**
+     * Main person pose in view coordinates. Joint validity is decided natively against
+     * the joint score threshold, see {@link #setJointScoreThreshold(float)}.
+     */
+    static public class Pose {
+        public final Point[] points;
+        public final float[] scores;
+        public final int validMask;
+        public final int filledMask;
+        public final int id;
+        /**
+         * Frame time the pose belongs to. With gap filling on it is {@code delayFrames} behind
+         * the frame passed to {@link #process}; a predicted pose has the time asked for.
+         */
+        public final long timestampUs;
+        public final Face face;
+
+        Pose(Point[] points, float[] scores, int validMask, int filledMask, int id, long timestampUs, Face face) {
+            this.points = points;
+            this.scores = scores;
+            this.validMask = validMask;
+            this.filledMask = filledMask;
+            this.id = id;
+            this.timestampUs = timestampUs;
+            this.face = face;
+        }
+
+        public boolean isValid(int joint) {
+            return (validMask & (1 << joint)) != 0;
+        }
+
+        /** Whether a valid joint was interpolated by gap filling rather than detected. */
+        public boolean isFilled(int joint) {
+            return (filledMask & (1 << joint)) != 0;
+        }
+    }
+
+    static public final Pose EMPTY_POSE = new Pose(new Point[0], new float[0], 0, 0, -1, 0, null);
+
+    /**
+     * Face of the main person in view coordinates, present only while the face stage is enabled,
+     * gap filling is off and a face was found for that person.
+     */
+    static public class Face {
+        public final Point[] landmarks;
+        public final Point arrowTip;
+        public final Point arrowBase;
+        public final Rect box;
+
+        Face(Point[] landmarks, Point arrowTip, Point arrowBase, Rect box) {
+            this.landmarks = landmarks;
+            this.arrowTip = arrowTip;
+            this.arrowBase = arrowBase;
+            this.box = box;
+        }
+    }
+
+    /**
+     * Reusable buffer for pose history queries, holding up to {@code capacity} frames.
+     * Joints are normalized, {@code numJoints * 2} floats per frame, oldest frame first.
+     */
+    static public class PoseWindow {
+        public final int numJoints;
+        public final long[] timestampsUs;
+        public final float[] joints;
+        public final float[] scores;
+        public final float[] boxes;
+        public final int[] validMasks;
+        public int size;
+
+        public PoseWindow(int numJoints, int capacity) {
+            this.numJoints = numJoints;
+            timestampsUs = new long[capacity];
+            joints = new float[capacity * numJoints * 2];
+            scores = new float[capacity * numJoints];
+            boxes = new float[capacity * 4];
+            validMasks = new int[capacity];
+        }
+    }
+
+    /**
+     * Reusable buffer for {@link #samplePose}. Joints are normalized, {@code numJoints * 2}
+     * floats, followed by the validity mask and person id as raw int bits.
+     */
+    static public class DisplayPose {
+        public final int numJoints;
+        public final float[] joints;
+        public int validMask;
+        public int id;
+
+        public DisplayPose(int numJoints) {
+            this.numJoints = numJoints;
+            joints = new float[numJoints * 2 + 2];
+        }
+
+        public boolean isValid(int joint) {
+            return (validMask & (1 << joint)) != 0;
+        }
+    }
+
+    /**
+     * Reusable buffer for {@link #getFrameFeatures}, for up to {@code capacity} people.
+     * Feature {@code f} of person {@code i} is {@code data[f * count + i]}: the normalized x
+     * of joint {@code j} at {@code f = 2j}, y at {@code 2j + 1}.
+     */
+    static public class FrameFeatures {
+        public final int numJoints;
+        public final float[] data;
+        public final int[] ids;
+        public final int[] validMasks;
+        public int count;
+
+        public FrameFeatures(int numJoints, int capacity) {
+            this.numJoints = numJoints;
+            data = new float[numJoints * 2 * capacity];
+            ids = new int[capacity];
+            validMasks = new int[capacity];
+        }
+    }
 
     static public Pair<Integer,Integer>[] init(Context context) throws IOException {
         final File files = context.getFilesDir();
@@ -43,28 +232,697 @@ public class Wrnch {
             result[i] = new Pair<>(bones[i*2], bones[i*2+1]);
         }
 
+        final int[] layout = getOutputLayoutJNI();
+        numJoints = layout[0];
+        numFaceLandmarks = layout[1];
+
         return result;
     }
 
-    static public Point[] process(byte[] img, int cols, int rows, int origWidth, int origHeight) {
-        final float[] joints = processWrnchJNI(img, cols, rows);
+    /**
+     * Turns face landmark estimation on or off for this session, from the next processed
+     * frame on.
+     */
+    static public void setFaceEnabled(boolean enabled) {
+        setFaceEnabledJNI(enabled);
+    }
+
+    /**
+     * Mean estimator time per frame in microseconds and number of frames measured, with the
+     * face stage off ({@code [0], [1]}) and on ({@code [2], [3]}).
+     */
+    static public float[] getProcessTiming() {
+        return getProcessTimingJNI();
+    }
 
-        if (DEBUG) Log.v("WRNCH", "GOT JOINTS: " + Integer.toString(joints.length / 2));
+    /** Frame path stages of {@link #getStats}, see native-lib.cpp. */
+    static public final int STAGE_INGEST = 0;
+    static public final int STAGE_CONVERSION = 1;
+    static public final int STAGE_PROCESS = 2;
+    static public final int STAGE_EXTRACTION = 3;
+    static public final int STAGE_MARSHAL = 4;
+    static public final int NUM_STAGES = 5;
 
-        Point[] result = new Point[joints.length / 2];
-        for (int i = 0; i < result.length; ++i) {
+    /** Values per stage in {@link #getStats}: samples, mean, p50, p90, p99, p99.9, max. */
+    static public final int STATS_PER_STAGE = 7;
+    /** Offsets of the counters in {@link #getStats}, after the stages. */
+    static public final int STATS_FRAMES = NUM_STAGES * STATS_PER_STAGE;
+    static public final int STATS_FRAMES_FAILED = STATS_FRAMES + 1;
+    static public final int STATS_MOTION_QUEUED = STATS_FRAMES + 2;
+    static public final int STATS_MOTION_DROPPED = STATS_FRAMES + 3;
+    static public final int STATS_3D_SUBMITTED = STATS_FRAMES + 4;
+    static public final int STATS_3D_DROPPED = STATS_FRAMES + 5;
+    static public final int STATS_ACTIVITY_SUBMITTED = STATS_FRAMES + 6;
+    static public final int STATS_ACTIVITY_DROPPED = STATS_FRAMES + 7;
+
+    /**
+     * Adds a sample to a stage timed on the Java side, {@link #STAGE_INGEST} or
+     * {@link #STAGE_CONVERSION}. Only from the thread that calls {@link #process}.
+     */
+    static public void recordStageLatency(int stage, long nanos) {
+        recordStageLatencyJNI(stage, nanos);
+    }
+
+    /**
+     * Latency percentiles of every frame stage in microseconds,
+     * {@code [stage * STATS_PER_STAGE + i]}, followed by frame, queue and drop counters at
+     * the {@code STATS_*} offsets. Cheap enough to poll every frame.
+     */
+    static public float[] getStats() {
+        return getStatsJNI();
+    }
+
+    /** Clears the latency histograms and frame counters. */
+    static public void resetStats() {
+        resetStatsJNI();
+    }
+
+    /**
+     * Assigns person ids with the native tracker instead of the estimator's own. Takes effect
+     * with the next processed frame, where the estimator is reconfigured; person ids start over
+     * and the pose history and filters are cleared at the switch.
+     */
+    static public void setNativeTracking(boolean enabled) {
+        setNativeTrackingJNI(enabled);
+    }
+
+    /**
+     * Mean native tracker time per frame in microseconds and number of frames measured.
+     */
+    static public float[] getTrackerTiming() {
+        return getTrackerTimingJNI();
+    }
+
+    /**
+     * Reusable buffer for {@link #drainMotionEvents}, for up to {@code capacity} events.
+     * {@code joints[i]} is the fastest joint of a velocity spike, -1 for other events;
+     * {@code values[i]} the speed, acceleration or drop that triggered it, in torso lengths.
+     */
+    static public class MotionEvents {
+        public final int[] types;
+        public final int[] ids;
+        public final int[] joints;
+        public final long[] timestampsUs;
+        public final float[] values;
+        public int count;
+
+        public MotionEvents(int capacity) {
+            types = new int[capacity];
+            ids = new int[capacity];
+            joints = new int[capacity];
+            timestampsUs = new long[capacity];
+            values = new float[capacity];
+        }
+    }
+
+    /**
+     * 3D poses produced by the 3D stage, one entry per person keyed by the 2D tracker id.
+     * Positions are {@code numJoints * 3} and rotations {@code numJoints * 4} (quaternions)
+     * floats per person.
+     */
+    static public class Poses3d {
+        public final long timestampUs;
+        public final int numJoints;
+        public final int[] ids;
+        public final float[][] positions;
+        public final float[][] rotations;
+
+        Poses3d(long timestampUs, int numJoints, int[] ids, float[][] positions, float[][] rotations) {
+            this.timestampUs = timestampUs;
+            this.numJoints = numJoints;
+            this.ids = ids;
+            this.positions = positions;
+            this.rotations = rotations;
+        }
+    }
+
+    /**
+     * Class probabilities per person, labelled with the 2D tracker id (-1 if unmatched).
+     */
+    static public class Activities {
+        public final long timestampUs;
+        public final int[] ids;
+        public final float[][] probabilities;
+
+        Activities(long timestampUs, int[] ids, float[][] probabilities) {
+            this.timestampUs = timestampUs;
+            this.ids = ids;
+            this.probabilities = probabilities;
+        }
+    }
+
+    /**
+     * Runs 3D estimation on a separate estimator and thread, fed every {@code stride}-th frame.
+     * The 2D path never waits for it; results are picked up with {@link #get3dPoses()}.
+     */
+    static public boolean set3dEnabled(boolean enabled, boolean useIk, int stride) {
+        return set3dEnabledJNI(enabled, useIk, stride);
+    }
+
+    /**
+     * Latest 3D results, or null before the 3D stage has produced any.
+     */
+    static public Poses3d get3dPoses() {
+        final long[] timestamp = new long[1];
+        final float[] out = get3dPosesJNI(timestamp);
+        if (out.length == 0) {
+            return null;
+        }
+
+        final int numPeople = Float.floatToRawIntBits(out[0]);
+        final int numJoints = Float.floatToRawIntBits(out[1]);
+        final int stride = 1 + numJoints * 7;
+
+        int[] ids = new int[numPeople];
+        float[][] positions = new float[numPeople][];
+        float[][] rotations = new float[numPeople][];
+        for (int p = 0; p < numPeople; ++p) {
+            final int base = 2 + p * stride;
+            ids[p] = Float.floatToRawIntBits(out[base]);
+            positions[p] = Arrays.copyOfRange(out, base + 1, base + 1 + numJoints * 3);
+            rotations[p] = Arrays.copyOfRange(out, base + 1 + numJoints * 3, base + stride);
+        }
+
+        return new Poses3d(timestamp[0], numJoints, ids, positions, rotations);
+    }
+
+    /**
+     * 3D stage mean time per processed frame in microseconds, frames processed and frames
+     * dropped while the stage was busy.
+     */
+    static public float[] get3dTiming() {
+        return get3dTimingJNI();
+    }
+
+    /**
+     * Runs the activity model at {@code modelPath} on every {@code stride}-th frame on its own
+     * estimator and thread. The 2D path never waits for it; results are picked up with
+     * {@link #getActivity()}.
+     */
+    static public boolean setActivityEnabled(boolean enabled, File modelPath, int stride) {
+        return setActivityEnabledJNI(enabled, modelPath.getAbsolutePath(), stride);
+    }
+
+    /**
+     * Latest activity probabilities, or null before the activity stage has produced any.
+     * Call from one thread only.
+     */
+    static public Activities getActivity() {
+        final long[] timestamp = new long[1];
+        final float[] out = getActivityJNI(timestamp);
+        if (out.length == 0) {
+            return null;
+        }
+
+        final int numPeople = Float.floatToRawIntBits(out[0]);
+        final int numClasses = Float.floatToRawIntBits(out[1]);
+
+        int[] ids = new int[numPeople];
+        float[][] probabilities = new float[numPeople][];
+        for (int p = 0; p < numPeople; ++p) {
+            final int base = 2 + p * (1 + numClasses);
+            ids[p] = Float.floatToRawIntBits(out[base]);
+            probabilities[p] = Arrays.copyOfRange(out, base + 1, base + 1 + numClasses);
+        }
+
+        return new Activities(timestamp[0], ids, probabilities);
+    }
+
+    /**
+     * Activity class names, in the order of {@link Activities#probabilities}.
+     */
+    static public String[] getActivityClasses() {
+        return getActivityClassesJNI();
+    }
+
+    /**
+     * Activity stage mean time per processed frame in microseconds, frames processed and
+     * frames dropped while the stage was busy.
+     */
+    static public float[] getActivityTiming() {
+        return getActivityTimingJNI();
+    }
+
+    /**
+     * Turns segmentation mask estimation on or off from the next processed frame on. Returns
+     * false if the model has no mask.
+     */
+    static public boolean setMaskEnabled(boolean enabled) {
+        return setMaskEnabledJNI(enabled);
+    }
+
+    /**
+     * Mask width, height and number of planes; all 0 while the mask is off.
+     */
+    static public int[] getMaskDims() {
+        return getMaskDimsJNI();
+    }
+
+    /**
+     * Direct buffer over the estimator's mask without copying: planes of width * height bytes
+     * (body first), or null while the mask is off. The buffer aliases memory the estimator
+     * reuses or frees: it is valid only until the next {@link #process},
+     * {@code setMaskEnabled(false)}, {@link #setNativeTracking} taking effect or
+     * {@link #init}, and reading it afterwards reads freed memory. Fetch it again for every
+     * frame, on the thread that calls {@link #process}, and never keep it.
+     */
+    static public ByteBuffer getMaskView() {
+        return getMaskViewJNI();
+    }
+
+    /**
+     * Upsamples the body mask of the last processed frame into {@code rgba}, a direct buffer of
+     * {@code height} rows of {@code stride} bytes in ARGB_8888 bitmap layout, ready for
+     * {@link android.graphics.Bitmap#copyPixelsFromBuffer}. Pixels with mask &gt;= threshold
+     * get {@code color} (an Android color int), the rest are transparent. Returns false if
+     * nothing was drawn: the mask is off or empty, the size is not positive or the buffer is
+     * too small.
+     */
+    static public boolean renderMaskOverlay(ByteBuffer rgba, int width, int height, int stride, int threshold, int color) {
+        return renderMaskOverlayJNI(rgba, width, height, stride, threshold, color);
+    }
+
+    /**
+     * Keeps the skeletons of every person of each processed frame for drawing natively with
+     * {@link #renderSkeletonOverlay} or {@link #renderSkeletonOverlayToSurface}: joints as
+     * discs of {@code jointRadius}, bones {@code boneWidth} wide, both in pixels.
+     */
+    static public void setSkeletonOverlay(boolean enabled, int jointColor, int boneColor, float jointRadius, float boneWidth) {
+        setSkeletonOverlayJNI(enabled, jointColor, boneColor, jointRadius, boneWidth);
+    }
+
+    /**
+     * Draws the skeletons of the newest processed frame, antialiased, into an ARGB_8888
+     * {@code bitmap}, a normalized joint at {@code (x * scaleX + left, y * scaleY + top)}.
+     * Draw into the same bitmap every time: only the regions that changed are redrawn.
+     * Returns the number of 32x32 tiles drawn, -1 on error.
+     */
+    static public int renderSkeletonOverlay(Bitmap bitmap, float left, float top, float scaleX, float scaleY) {
+        return renderSkeletonOverlayJNI(bitmap, left, top, scaleX, scaleY);
+    }
+
+    /**
+     * Directs {@link #renderSkeletonOverlayToSurface} to {@code surface} (e.g. of a
+     * transparent SurfaceView over the video) with {@code width x height} buffers; null
+     * releases it.
+     */
+    static public boolean setOverlaySurface(Surface surface, int width, int height) {
+        return setOverlaySurfaceJNI(surface, width, height);
+    }
+
+    /**
+     * Like {@link #renderSkeletonOverlay} into the overlay surface, posting only the region
+     * that changed. Returns the number of tiles drawn, 0 if nothing changed, -1 on error.
+     */
+    static public int renderSkeletonOverlayToSurface(float left, float top, float scaleX, float scaleY) {
+        return renderSkeletonOverlayToSurfaceJNI(left, top, scaleX, scaleY);
+    }
+
+    /**
+     * Minimum estimator score (default 0.3) for a joint to count as detected. It decides the
+     * valid mask of every person and so everything downstream of it: which joints
+     * {@link Pose#isValid} reports, which gaps {@link #setGapFilling} fills, which joints the
+     * native tracker matches people on, and what the other native stages and recordings see.
+     */
+    static public void setJointScoreThreshold(float threshold) {
+        setJointScoreThresholdJNI(threshold);
+    }
+
+    /** Joint smoothing flags for {@link #setSmoothing}. */
+    static public final int SMOOTHING_NONE = 0;
+    static public final int SMOOTHING_LIBRARY = 1;
+    static public final int SMOOTHING_NATIVE = 2;
+
+    /**
+     * Selects the estimator's own joint smoothing, the native One-Euro filter or both.
+     */
+    static public void setSmoothing(int mode) {
+        setSmoothingJNI(mode);
+    }
+
+    /** Gap filling interpolation for {@link #setGapFilling}. */
+    static public final int GAP_LINEAR = 0;
+    static public final int GAP_HERMITE = 1;
+
+    /**
+     * Fills short dropouts of the main person's joints from the frames around them. The pose
+     * is then reported {@code delayFrames} frames late; a joint is filled if it was seen at
+     * most {@code lookBackFrames} frames before and {@code delayFrames} after the gap, no more
+     * than {@code maxGapMs} apart. Filled joints are valid and flagged in {@link Pose#filledMask},
+     * and {@link Pose#timestampUs} is the time of the delayed frame. No face is reported
+     * meanwhile, since the face stage only sees the live frame.
+     */
+    static public void setGapFilling(boolean enabled, int interpolation, int delayFrames,
+                                     int lookBackFrames, float maxGapMs) {
+        setGapFillingJNI(enabled, interpolation, delayFrames, lookBackFrames, maxGapMs);
+    }
+
+    /**
+     * One-Euro parameters for the native smoothing: per joint minimum cut-off in Hz (lower is
+     * smoother when still) and beta (higher is less lag when moving), plus the cut-off used
+     * for the speed estimate.
+     */
+    static public boolean setJointFilterParams(float[] minCutoff, float[] beta, float dCutoff) {
+        return setJointFilterParamsJNI(minCutoff, beta, dCutoff);
+    }
+
+    /**
+     * Frames of person {@code id} with {@code fromUs <= timestamp <= toUs}. If the window does
+     * not fit, the most recent frames are kept.
+     */
+    static public PoseWindow poseWindowByTime(int id, long fromUs, long toUs, PoseWindow out) {
+        out.size = getPoseWindowByTimeJNI(id, fromUs, toUs, out.timestampsUs, out.joints, out.scores, out.boxes, out.validMasks);
+        return out;
+    }
+
+    /**
+     * Last {@code count} frames of person {@code id}; count 1 gives the latest pose.
+     */
+    static public PoseWindow poseWindowByCount(int id, int count, PoseWindow out) {
+        out.size = getPoseWindowByCountJNI(id, count, out.timestampsUs, out.joints, out.scores, out.boxes, out.validMasks);
+        return out;
+    }
+
+    static public int getTrackIds(int[] ids) {
+        return getTrackIdsJNI(ids);
+    }
+
+    /**
+     * Records the raw estimator output of every following frame to a binary pose track.
+     */
+    static public boolean startRecording(File path) {
+        return startRecordingJNI(path.getAbsolutePath());
+    }
+
+    static public boolean stopRecording() {
+        return stopRecordingJNI();
+    }
+
+    /**
+     * Opens a recorded pose track for {@link #replay}. Returns the number of frames, or -1.
+     */
+    static public int openReplay(File path) {
+        return openReplayJNI(path.getAbsolutePath());
+    }
+
+    /**
+     * Feeds the recorded frame at or before {@code timestampUs} through the same post-processing
+     * as {@link #process} and returns its main person.
+     */
+    static public Pose replay(long timestampUs, int origWidth, int origHeight) {
+        return toPose(replayFrameJNI(timestampUs), origWidth, origHeight);
+    }
+
+    static public void closeReplay() {
+        closeReplayJNI();
+    }
+
+    /** Motion models for {@link #setPrediction}. */
+    static public final int PREDICTION_CONSTANT_VELOCITY = 0;
+    static public final int PREDICTION_CONSTANT_ACCELERATION = 1;
+
+    /**
+     * Turns Kalman tracking of the joints on or off, for {@link #predict}. Noise values
+     * &lt;= 0 keep the defaults.
+     */
+    static public boolean setPrediction(boolean enabled, int model, float processNoise, float measurementNoise) {
+        return setPredictionJNI(enabled, model, processNoise, measurementNoise);
+    }
+
+    /**
+     * The main person of the last frame extrapolated to {@code timeUs}, in the time base of
+     * the frame timestamps, to draw it where it is at display time rather than where it was
+     * when the frame was captured. EMPTY_POSE if prediction is off.
+     */
+    static public Pose predict(long timeUs, int origWidth, int origHeight) {
+        return toPose(predictPoseJNI(timeUs), origWidth, origHeight);
+    }
+
+    /**
+     * The main person at {@code timeUs}, in the time base of the frame timestamps, smoothly
+     * interpolated between the last frames or extrapolated past the newest one by at most
+     * {@code maxExtrapolationUs}. Meant to be called once per vsync: it takes no lock and
+     * allocates nothing. Subtracting a frame interval or so from the display time keeps it
+     * interpolating. False if there is no main person.
+     */
+    static public boolean samplePose(long timeUs, long maxExtrapolationUs, DisplayPose out) {
+        if (!samplePoseJNI(timeUs, maxExtrapolationUs, out.joints)) {
+            return false;
+        }
+        out.validMask = Float.floatToRawIntBits(out.joints[out.numJoints * 2]);
+        out.id = Float.floatToRawIntBits(out.joints[out.numJoints * 2 + 1]);
+        return true;
+    }
+
+    /**
+     * Normalizes every person of every frame natively: centered on the hips, scaled to unit
+     * torso length and, if {@code rotate}, turned so the torso points up. {@code faceCamera}
+     * flips people seen from the back so they match the front view; {@code mirror} swaps left
+     * and right. Read with {@link #getFrameFeatures}.
+     */
+    static public boolean setFeatureExtraction(boolean enabled, boolean rotate, boolean faceCamera, boolean mirror) {
+        return setFeatureExtractionJNI(enabled, rotate, faceCamera, mirror);
+    }
+
+    /**
+     * Feature vectors of the people of the last frame. People who could not be normalized
+     * (no hips or shoulders) have a zero mask. False if {@code out} is too small.
+     */
+    static public boolean getFrameFeatures(FrameFeatures out) {
+        final int count = getFrameFeaturesJNI(out.data, out.ids, out.validMasks);
+        out.count = Math.max(count, 0);
+        return count >= 0;
+    }
+
+    /** Exercises with a built-in rep counter setup, for {@link #startRepCounter(int)}. */
+    static public final int EXERCISE_JUMPING_JACKS = 0;
+    static public final int EXERCISE_LUNGES = 1;
+
+    /**
+     * Counts repetitions of the main person: arm abduction at the shoulders for jumping
+     * jacks, the more bent knee for lunges.
+     */
+    static public boolean startRepCounter(int exercise) {
+        if (exercise == EXERCISE_LUNGES) {
+            final int[] angles = jointTriples("RHIP", "RKNEE", "RANKLE", "LHIP", "LKNEE", "LANKLE");
+            return angles != null && configureRepCounterJNI(angles, 1, true, 35.0f, 0.4f, 6.0f);
+        }
+        final int[] angles = jointTriples("RHIP", "RSHOULDER", "RELBOW", "LHIP", "LSHOULDER", "LELBOW");
+        return angles != null && configureRepCounterJNI(angles, 0, false, 60.0f, 0.4f, 6.0f);
+    }
+
+    /**
+     * Counts repetitions of the signal combined ({@code combine} 0 mean, 1 min, 2 max) from
+     * the angles at joint {@code b} of each {@code a, b, c} triple in {@code angles}.
+     * {@code restHigh} says the signal rests at its high end.
+     */
+    static public boolean startRepCounter(int[] angles, int combine, boolean restHigh,
+                                          float minAmplitudeDeg, float minPeriodS, float maxPeriodS) {
+        return configureRepCounterJNI(angles, combine, restHigh, minAmplitudeDeg, minPeriodS, maxPeriodS);
+    }
+
+    static public void stopRepCounter() {
+        configureRepCounterJNI(new int[0], 0, false, 0, 0, 0);
+    }
+
+    /**
+     * Moves repetitions finished since the last call into the arrays (frame timestamps of the
+     * start and end of each and a confidence from 0 to 1) and returns how many there were.
+     */
+    static public int drainRepEvents(long[] startUs, long[] endUs, float[] confidence) {
+        return drainRepEventsJNI(startUs, endUs, confidence);
+    }
+
+    static public int getRepCount() {
+        return getRepCountJNI();
+    }
+
+    /** Motion event types, see {@link #startMotionEvents}. */
+    static public final int MOTION_VELOCITY_SPIKE = 0;
+    static public final int MOTION_IMPACT = 1;
+    static public final int MOTION_FALL = 2;
+
+    /**
+     * Watches every person for falls, impacts and sudden joint movements with default
+     * thresholds. False if the skeleton lacks hips or shoulders.
+     */
+    static public boolean startMotionEvents() {
+        return configureMotionEventsJNI(true, 8.0f, 60.0f, 2.0f, 0.8f, 0.5f, 0.3f, 0.5f);
+    }
+
+    /**
+     * Like {@link #startMotionEvents()} with explicit thresholds, all in torso lengths: a
+     * spike is a joint faster than {@code spikeSpeed} per second, an impact a center of mass
+     * acceleration above {@code impactAccel} per second squared, a fall a descent faster
+     * than {@code fallSpeed} per second ending {@code fallDrop} below standing height.
+     * Spikes and impacts re-arm below {@code release} times their threshold and after
+     * {@code refractoryS}, falls once the person is back within {@code fallRelease}.
+     */
+    static public boolean startMotionEvents(float spikeSpeed, float impactAccel, float fallSpeed, float fallDrop,
+                                            float release, float fallRelease, float refractoryS) {
+        return configureMotionEventsJNI(true, spikeSpeed, impactAccel, fallSpeed, fallDrop,
+                release, fallRelease, refractoryS);
+    }
+
+    static public void stopMotionEvents() {
+        configureMotionEventsJNI(false, 0, 0, 0, 0, 0, 0, 0);
+    }
+
+    /**
+     * Moves motion events detected since the last call into {@code out}, oldest first. Never
+     * waits for frame processing, so it can be polled from any one thread.
+     */
+    static public int drainMotionEvents(MotionEvents out) {
+        out.count = drainMotionEventsJNI(out.types, out.ids, out.joints, out.timestampsUs, out.values);
+        return out.count;
+    }
+
+    /** Events lost because they were not drained in time. */
+    static public long getDroppedMotionEvents() {
+        return getDroppedMotionEventsJNI();
+    }
+
+    /**
+     * Looks up the main person of every processed frame in the reference pose index at
+     * {@code index} (built offline, see bench/pose-index-bench.cpp); null stops the lookups.
+     */
+    static public boolean setPoseIndex(File index) {
+        return setPoseIndexJNI(index == null ? null : index.getAbsolutePath());
+    }
+
+    static public String[] getPoseIndexLabels() {
+        return getPoseIndexLabelsJNI();
+    }
+
+    /**
+     * Nearest reference poses to the last main person, closest first: label indices into
+     * {@link #getPoseIndexLabels()}, positions in the reference library and distances between
+     * the translation and scale normalized skeletons. Returns how many were written.
+     */
+    static public int getPoseMatches(int[] labels, int[] ids, float[] distances) {
+        return getPoseMatchesJNI(labels, ids, distances);
+    }
+
+    static public final int DTW_WAITING = 0;
+    static public final int DTW_ACTIVE = 1;
+    static public final int DTW_PRUNED = 2;
+    static public final int DTW_FINISHED = 3;
+
+    /**
+     * Matches the main person's angles at joint {@code b} of each {@code a, b, c} triple in
+     * {@code angles} against reference templates, warping at most {@code band} template
+     * frames from real time. Templates whose lower bound exceeds {@code pruneRatio} times the
+     * best cost are dropped (0 keeps all). Drops any templates added before.
+     */
+    static public boolean configureDtw(int[] angles, int band, float pruneRatio) {
+        return configureDtwJNI(angles, band, pruneRatio);
+    }
+
+    static public void stopDtw() {
+        configureDtwJNI(new int[0], 0, 0);
+    }
+
+    /**
+     * Adds a reference of {@code frames} rows of angles in radians, one per configured triple,
+     * sampled at {@code fps}. Returns its index, -1 on error.
+     */
+    static public int addDtwTemplate(float[] features, int frames, float fps) {
+        return addDtwTemplateJNI(features, frames, fps);
+    }
+
+    /** Starts following every template from its first frame with the next processed frame. */
+    static public void startDtw() {
+        startDtwJNI();
+    }
+
+    /**
+     * Fills {@code out} with three values per template: its DTW_* state as raw int bits, the
+     * mean squared angle distance per frame so far and the progress through it from 0 to 1.
+     * Returns the best matching template, -1 if none.
+     */
+    static public int getDtwScores(float[] out) {
+        return getDtwScoresJNI(out);
+    }
+
+    /**
+     * Bone lengths and joint angles (radians, at joint {@code b} of each {@code a, b, c}
+     * triple in {@code angles}) of the last {@code count} frames of track {@code id}, oldest
+     * first. Bone {@code k} of frame {@code i} lands at {@code boneLengths[k * count + i]},
+     * angles likewise, in units of the frame height. Returns the number of frames written.
+     */
+    static public int computeSkeletonFeatures(int id, int count, int[] angles,
+                                              float[] boneLengths, float[] angleOut, int[] masks) {
+        return computeSkeletonFeaturesJNI(id, count, angles, boneLengths, angleOut, masks);
+    }
+
+    private static int[] jointTriples(String... names) {
+        int[] indices = new int[names.length];
+        for (int i = 0; i < names.length; ++i) {
+            indices[i] = getJointIndexJNI(names[i]);
+            if (indices[i] < 0) {
+                Log.e("WRNCH", "No joint " + names[i]);
+                return null;
+            }
+        }
+        return indices;
+    }
+
+    static public Pose process(byte[] img, int cols, int rows, long timestampUs, int origWidth, int origHeight) {
+        return toPose(processWrnchJNI(img, cols, rows, timestampUs), origWidth, origHeight);
+    }
+
+    private static Pose toPose(float[] joints, int origWidth, int origHeight) {
+        if (joints.length == 0) {
+            return EMPTY_POSE;
+        }
+
+        // joints x,y, then scores, validity mask, person id, filled mask, timestamp and face, see native-lib.cpp
+        final int validMask = Float.floatToRawIntBits(joints[numJoints * 3]);
+        final int id = Float.floatToRawIntBits(joints[numJoints * 3 + 1]);
+        final int filledMask = Float.floatToRawIntBits(joints[numJoints * 3 + 2]);
+        final long timestampUs = (Float.floatToRawIntBits(joints[numJoints * 3 + 3]) & 0xffffffffL)
+                | ((long) Float.floatToRawIntBits(joints[numJoints * 3 + 4]) << 32);
+
+        if (DEBUG) Log.v("WRNCH", "GOT JOINTS: " + Integer.toString(numJoints) + " mask " + Integer.toHexString(validMask));
+
+        Point[] points = new Point[numJoints];
+        float[] scores = new float[numJoints];
+        for (int i = 0; i < numJoints; ++i) {
             float x = joints[i * 2];
             float y = joints[i * 2 + 1];
 
             int xx = (int) (x * (float) origWidth);
             int yy = (int) (y * (float) origHeight);
 
-            result[i] = new Point(xx, yy);
+            points[i] = new Point(xx, yy);
+            scores[i] = joints[numJoints * 2 + i];
 
-            if (DEBUG) Log.v("WRNCH", "Joint: " + Integer.toString(result[i].x) + "," + Integer.toString(result[i].y));
+            if (DEBUG) Log.v("WRNCH", "Joint: " + Integer.toString(points[i].x) + "," + Integer.toString(points[i].y));
         }
 
-        return result;
+        return new Pose(points, scores, validMask, filledMask, id, timestampUs,
+                toFace(joints, numJoints * 3 + 5, origWidth, origHeight));
+    }
+
+    private static Face toFace(float[] out, int offset, int origWidth, int origHeight) {
+        final int count = Float.floatToRawIntBits(out[offset]);
+        if (count == 0) {
+            return null;
+        }
+
+        Point[] landmarks = new Point[count];
+        for (int i = 0; i < count; ++i) {
+            landmarks[i] = new Point((int) (out[offset + 1 + i * 2] * origWidth), (int) (out[offset + 2 + i * 2] * origHeight));
+        }
+
+        final int tail = offset + 1 + numFaceLandmarks * 2;
+        final Point tip = new Point((int) (out[tail] * origWidth), (int) (out[tail + 1] * origHeight));
+        final Point base = new Point((int) (out[tail + 2] * origWidth), (int) (out[tail + 3] * origHeight));
+        final int left = (int) (out[tail + 4] * origWidth);
+        final int top = (int) (out[tail + 5] * origHeight);
+        final Rect box = new Rect(left, top, left + (int) (out[tail + 6] * origWidth), top + (int) (out[tail + 7] * origHeight));
+
+        return new Face(landmarks, tip, base, box);
     }
 
 
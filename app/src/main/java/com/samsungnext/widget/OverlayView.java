@@ -1,6 +1,7 @@
 package com.samsungnext.widget;
 
 import android.content.Context;
+import android.graphics.Bitmap;
 import android.graphics.Canvas;
 import android.graphics.Color;
 import android.graphics.Paint;
@@ -9,47 +10,105 @@ import android.util.AttributeSet;
 import android.util.Pair;
 import android.view.View;
 
+import com.samsungnext.audiovideoplayersample.Wrnch;
+
 public class OverlayView extends View {
     final private Paint paint = new Paint();
-    private Point[] points;
+    private Wrnch.Pose pose;
     private Pair<Integer,Integer>[] bones;
     private int horizPadding = 0;
+    // latency compensation: frame timestamp minus System.nanoTime() at its arrival, in us
+    private boolean predict = false;
+    private long clockOffsetUs = 0;
+    private int frameWidth = 0;
+    private int frameHeight = 0;
+    // skeletons of everyone drawn natively into a bitmap the size of the view
+    private boolean nativeRendering = false;
+    private Bitmap overlayBitmap;
 
     public OverlayView(Context context, AttributeSet attrs) {
         super(context, attrs);
-        points = new Point[0];
+        pose = Wrnch.EMPTY_POSE;
         paint.setColor(Color.BLUE);
         paint.setStrokeWidth(3);
     }
 
-    public void drawPoints(Point[] points, int horizPadding) {
-        this.points = points;
+    public void drawPose(Wrnch.Pose pose, int horizPadding) {
+        this.pose = pose;
         this.horizPadding = horizPadding;
         invalidate();
     }
 
+    /**
+     * Like {@link #drawPose(Wrnch.Pose, int)}, with what is needed to draw the pose predicted
+     * for the time of drawing when latency compensation is on.
+     */
+    public void drawPose(Wrnch.Pose pose, int horizPadding, long clockOffsetUs, int frameWidth, int frameHeight) {
+        this.clockOffsetUs = clockOffsetUs;
+        this.frameWidth = frameWidth;
+        this.frameHeight = frameHeight;
+        drawPose(pose, horizPadding);
+    }
+
+    public void setLatencyCompensation(boolean enabled) {
+        predict = enabled;
+        Wrnch.setPrediction(enabled, Wrnch.PREDICTION_CONSTANT_VELOCITY, 0, 0);
+    }
+
+    /**
+     * Draws the skeletons of every person natively instead of the main person through
+     * Canvas. Needs the frame size from {@link #drawPose(Wrnch.Pose, int, long, int, int)};
+     * latency compensation does not apply.
+     */
+    public void setNativeRendering(boolean enabled) {
+        nativeRendering = enabled;
+        Wrnch.setSkeletonOverlay(enabled, Color.BLUE, Color.BLUE, 10, 3);
+        if (!enabled) {
+            overlayBitmap = null;
+        }
+        invalidate();
+    }
+
     public void setBones(Pair<Integer,Integer>[] bones) {
         this.bones = bones;
     }
 
     @Override
     protected void onDraw(Canvas canvas) {
+        if (nativeRendering && frameWidth > 0 && getWidth() > 0 && getHeight() > 0) {
+            if (overlayBitmap == null || overlayBitmap.getWidth() != getWidth() || overlayBitmap.getHeight() != getHeight()) {
+                overlayBitmap = Bitmap.createBitmap(getWidth(), getHeight(), Bitmap.Config.ARGB_8888);
+            }
+            if (Wrnch.renderSkeletonOverlay(overlayBitmap, horizPadding, 0, frameWidth, frameHeight) >= 0) {
+                canvas.drawBitmap(overlayBitmap, 0, 0, null);
+                return;
+            }
+        }
+
+        Wrnch.Pose pose = this.pose;
+        if (predict && pose != Wrnch.EMPTY_POSE) {
+            final Wrnch.Pose predicted = Wrnch.predict(System.nanoTime() / 1000 + clockOffsetUs, frameWidth, frameHeight);
+            if (predicted != Wrnch.EMPTY_POSE) {
+                pose = predicted;
+            }
+        }
+        final Point[] points = pose.points;
+
         for (int i = 0; i < points.length; i++) {
             //			Log.v(TAG, Float.toString(points[i].x) + "," + Float.toString(points[i].y));
-            if (points[i].x > 0 && points[i].y > 0) {
+            if (pose.isValid(i)) {
                 canvas.drawCircle(points[i].x + horizPadding, points[i].y, 10, paint);
             }
         }
 
         if (points.length > 0) {
             for (int i = 0; i < bones.length; i++) {
-                final float x1 = (float) points[bones[i].first.intValue()].x;
-                final float y1 = (float) points[bones[i].first.intValue()].y;
-                final float x2 = (float) points[bones[i].second.intValue()].x;
-                final float y2 = (float) points[bones[i].second.intValue()].y;
+                final int first = bones[i].first.intValue();
+                final int second = bones[i].second.intValue();
 
-                if (x1 > 0 && y1 > 0 && x2 > 0 && y2 > 0) {
-                    canvas.drawLine(x1 + horizPadding, y1, x2 + horizPadding, y2, paint);
+                if (pose.isValid(first) && pose.isValid(second)) {
+                    canvas.drawLine(points[first].x + horizPadding, points[first].y,
+                            points[second].x + horizPadding, points[second].y, paint);
                 }
             }
         }
@@ -2,7 +2,6 @@ package com.samsungnext.widget;
 
 import android.content.Context;
 import android.graphics.Bitmap;
-import android.graphics.Point;
 import android.graphics.SurfaceTexture;
 import android.util.AttributeSet;
 import android.view.Surface;
@@ -129,12 +128,16 @@ public class PlayerTextureView extends TextureView
 
 	@Override
 	public void onSurfaceTextureUpdated(SurfaceTexture surface) {
+		final long frameUs = surface.getTimestamp() / 1000;
+		final long arrivalNs = System.nanoTime();
+		final long arrivalUs = arrivalNs / 1000;
 		final Bitmap bitmap = getBitmap(244, 128);
 
 		int bytes = bitmap.getByteCount();
 
 		ByteBuffer buffer = ByteBuffer.allocate(bytes); // Create a new buffer
 		bitmap.copyPixelsToBuffer(buffer); // Move the byte data to the buffer
+		final long ingestedNs = System.nanoTime();
 
 		byte[] temp = buffer.array(); // Get the underlying array containing the data.
 		byte[] pixels = new byte[(temp.length / 4) * 3]; // Allocate for 3 byte BGR
@@ -145,9 +148,11 @@ public class PlayerTextureView extends TextureView
 			pixels[i * 3 + 1] = temp[i * 4 + 2]; // G
 			pixels[i * 3 + 2] = temp[i * 4 + 1]; // R
 		}
+		Wrnch.recordStageLatency(Wrnch.STAGE_INGEST, ingestedNs - arrivalNs);
+		Wrnch.recordStageLatency(Wrnch.STAGE_CONVERSION, System.nanoTime() - ingestedNs);
 
-		final Point[] points = Wrnch.process(pixels, 244, 128, width, height);
-		overlayView.drawPoints(points, horizPadding / 2);
+		final Wrnch.Pose pose = Wrnch.process(pixels, 244, 128, frameUs, width, height);
+		overlayView.drawPose(pose, horizPadding / 2, frameUs - arrivalUs, width, height);
 	}
 
 	public Surface getSurface() {